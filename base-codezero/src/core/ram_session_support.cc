@@ -27,14 +27,20 @@ void Ram_session_component::_export_ram_ds(Dataspace_component *ds) { }
 void Ram_session_component::_revoke_ram_ds(Dataspace_component *ds) { }
 
 void Ram_session_component::_clear_ds (Dataspace_component *ds)
+{
+	clear_ram(ds->phys_addr(), ds->size());
+}
+
+
+bool Genode::clear_ram(addr_t phys_addr, size_t size)
 {
 	using namespace Codezero;
 
 	/*
-	 * Map dataspace core-locally, memset, unmap dataspace
+	 * Map memory core-locally, memset, unmap memory
 	 */
 
-	size_t page_rounded_size = (ds->size() + get_page_size() - 1) & get_page_mask();
+	size_t page_rounded_size = (size + get_page_size() - 1) & get_page_mask();
 	size_t num_pages         = page_rounded_size >> get_page_size_log2();
 
 	/* allocate range in core's virtual address space */
@@ -42,24 +48,25 @@ void Ram_session_component::_clear_ds (Dataspace_component *ds)
 	if (!platform()->region_alloc()->alloc(page_rounded_size, &virt_addr)) {
 		PERR("Could not allocate virtual address range in core of size %zd\n",
 		     page_rounded_size);
-		return;
+		return false;
 	}
 
-	/* map the dataspace's physical pages to corresponding virtual addresses */
-	if (!map_local(ds->phys_addr(), (addr_t)virt_addr, num_pages)) {
+	/* map the physical pages to corresponding virtual addresses */
+	if (!map_local(phys_addr, (addr_t)virt_addr, num_pages)) {
 		PERR("core-local memory mapping failed\n");
-		return;
+		return false;
 	}
 
-	memset(virt_addr, 0, ds->size());
+	memset(virt_addr, 0, size);
 
-	/* unmap dataspace from core */
+	/* unmap memory from core */
 	if (!unmap_local((addr_t)virt_addr, num_pages)) {
 		PERR("could not unmap %zd pages from virtual address range at %p",
 		     num_pages, virt_addr);
-		return;
+		return false;
 	}
 
 	/* free core's virtual address space */
 	platform()->region_alloc()->free(virt_addr, page_rounded_size);
+	return true;
 }
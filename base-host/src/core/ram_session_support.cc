@@ -27,3 +27,5 @@ void Ram_session_component::_clear_ds (Dataspace_component *ds)
 {
 	PWRN("not implemented");
 }
+
+bool Genode::clear_ram(addr_t, size_t) { return false; }
@@ -170,6 +170,16 @@ namespace Genode
 			 * Block on any signal that is triggered at one of our contexts
 			 */
 			Signal wait_for_signal();
+
+			/**
+			 * Block on signals and fetch up to 'max' of them at once
+			 *
+			 * The kernel delivers one signal per call, so this
+			 * function returns at most one signal.
+			 *
+			 * \return  number of signals written to 'out'
+			 */
+			unsigned wait_for_signals(Signal *out, unsigned max);
 	};
 }
 
@@ -121,6 +121,14 @@ Signal Signal_receiver::wait_for_signal()
 }
 
 
+unsigned Signal_receiver::wait_for_signals(Signal *out, unsigned max)
+{
+	if (!max) return 0;
+	out[0] = wait_for_signal();
+	return 1;
+}
+
+
 bool Signal_receiver::pending() { return Kernel::signal_pending(_cap.dst()); }
 
 
@@ -17,6 +17,26 @@
 #include <base/ipc_generic.h>
 
 
+namespace Genode {
+
+	/**
+	 * Enable the shared-memory transport for RPC calls of this process
+	 *
+	 * When enabled, each client thread sets up a shared-memory area per
+	 * entrypoint it calls. Requests and replies without capability
+	 * arguments are then exchanged via the shared-memory area rather than
+	 * copied through the socket. Calls that transfer capabilities always
+	 * use the socket.
+	 */
+	void ipc_enable_shm_fast_path();
+
+	/**
+	 * Release the RPC reply channel of a thread
+	 */
+	void destroy_reply_channel(Native_reply_channel &);
+}
+
+
 inline void Genode::Ipc_ostream::_marshal_capability(Genode::Native_capability const &cap)
 {
 	_write_to_buf(cap.local_name());
@@ -61,6 +61,37 @@ namespace Genode {
 	};
 
 	struct Thread_meta_data;
+	struct Ipc_shm_client_channels;
+	struct Ipc_shm_server_channels;
+
+	/**
+	 * Reply channel used by a thread when acting as RPC client
+	 *
+	 * The socket pair is created lazily on the first RPC call of the thread
+	 * and reused for all subsequent calls. The remote socket is passed to the
+	 * server along with each request. Because the channel outlives a single
+	 * call, a reply to a canceled call may still arrive at the local socket.
+	 * Each call is therefore tagged with a sequence number, which the server
+	 * echoes in its reply, so that stale replies can be identified and
+	 * dropped.
+	 */
+	struct Native_reply_channel
+	{
+		int           local_sd;
+		int           remote_sd;
+		unsigned long call_seq;
+
+		/**
+		 * Shared-memory channels to entrypoints, used by the optional
+		 * shared-memory transport
+		 */
+		Ipc_shm_client_channels *shm_channels;
+
+		Native_reply_channel()
+		: local_sd(-1), remote_sd(-1), call_seq(0), shm_channels(0) { }
+
+		bool valid() const { return local_sd != -1; }
+	};
 
 	/**
 	 * Native thread contains more thread-local data than just the ID
@@ -86,6 +117,11 @@ namespace Genode {
 		 */
 		Thread_meta_data *meta_data;
 
+		/**
+		 * Reply channel for RPC calls issued by the thread
+		 */
+		Native_reply_channel reply_channel;
+
 		Native_thread() : is_ipc_server(false), meta_data(0) { }
 	};
 
@@ -129,7 +165,19 @@ namespace Genode {
 		int server_sd;
 		int client_sd;
 
-		Native_connection_state() : server_sd(-1), client_sd(-1) { }
+		/**
+		 * Shared-memory channels registered by clients at the entrypoint
+		 */
+		Ipc_shm_server_channels *shm_channels;
+
+		/**
+		 * True if the connection state is borrowed from another activation
+		 * of the same entrypoint
+		 */
+		bool adopted;
+
+		Native_connection_state()
+		: server_sd(-1), client_sd(-1), shm_channels(0), adopted(false) { }
 	};
 
 	enum { PARENT_SOCKET_HANDLE = 100 };
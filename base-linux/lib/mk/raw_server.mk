@@ -0,0 +1,5 @@
+SRC_CC = server.cc common.cc pool.cc
+
+vpath server.cc $(BASE_DIR)/src/base/server
+vpath common.cc $(BASE_DIR)/src/base/server
+vpath pool.cc   $(REP_DIR)/src/base/server
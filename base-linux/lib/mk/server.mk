@@ -0,0 +1,3 @@
+LIBS = thread
+
+include $(REP_DIR)/lib/mk/raw_server.mk
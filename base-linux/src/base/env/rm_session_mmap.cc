@@ -13,12 +13,47 @@
 
 #include <base/platform_env.h>
 #include <base/thread.h>
+#include <util/arg_string.h>
 #include <linux_dataspace/client.h>
 #include <linux_syscalls.h>
 
 using namespace Genode;
 
 
+/**
+ * List of Unix environment variables, initialized by the startup code
+ */
+extern char **lx_environ;
+
+
+/**
+ * Return minimum size of mappings backed by transparent huge pages
+ *
+ * The size is configured by the 'huge_dataspace_size' environment variable
+ * of core, which passes it to all components. If not configured, huge pages
+ * are not used.
+ */
+static size_t huge_dataspace_size()
+{
+	struct Config
+	{
+		size_t size;
+
+		Config() : size(0)
+		{
+			for (char **curr = lx_environ; curr && *curr; curr++) {
+				Arg arg = Arg_string::find_arg(*curr, "huge_dataspace_size");
+				if (arg.valid())
+					size = arg.ulong_value(0);
+			}
+		}
+	};
+
+	static Config config;
+	return config.size;
+}
+
+
 static bool is_sub_rm_session(Dataspace_capability ds)
 {
 	if (ds.valid())
@@ -59,6 +94,13 @@ Platform_env_base::Rm_session_mmap::_map_local(Dataspace_capability ds,
 		throw Rm_session::Region_conflict();
 	}
 
+	/*
+	 * Ask for transparent huge pages for large mappings. The advice takes
+	 * effect only if the kernel supports huge pages for shared memory.
+	 */
+	if (huge_dataspace_size() && size >= huge_dataspace_size())
+		lx_madvise(addr_out, size, LX_MADV_HUGEPAGE);
+
 	return addr_out;
 }
 
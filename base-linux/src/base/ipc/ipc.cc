@@ -6,16 +6,24 @@
  *
  * The current request message layout is:
  *
+ *   Ipc_call_header header;
  *   long  server_local_name;
  *   int   opcode;
  *   ...payload...
  *
  * Response messages look like this:
  *
- *   long  scratch_word;
+ *   long  call_seq;
  *   int   exc_code;
  *   ...payload...
  *
+ * The header of a request is received separately from the message buffer.
+ * Its 'call_seq' is echoed by the server in the reply and enables the client
+ * to drop stale replies arriving at its persistent reply channel. If the
+ * optional shared-memory transport is used, the message buffer resides in a
+ * shared-memory area and the datagram carries the header only (see
+ * 'shm_channel.h').
+ *
  * All fields are naturally aligned, i.e., aligend on 4 or 8 byte boundaries on
  * 32-bit resp. 64-bit systems.
  */
@@ -36,6 +44,7 @@
 
 /* local includes */
 #include <socket_descriptor_registry.h>
+#include <shm_channel.h>
 
 /* Linux includes */
 #include <linux_syscalls.h>
@@ -85,6 +94,8 @@ Genode::Ep_socket_descriptor_registry *Genode::ep_sd_registry()
 
 enum {
 	LX_EINTR        = 4,
+	LX_EAGAIN       = 11,
+	LX_ETIMEDOUT    = 110,
 	LX_ECONNREFUSED = 111
 };
 
@@ -165,14 +176,25 @@ namespace {
 
 			msghdr      _msg;
 			sockaddr_un _addr;
-			iovec       _iovec;
+			iovec       _iovec[2];
 			char        _cmsg_buf[CMSG_SPACE(MAX_SDS_PER_MSG*sizeof(int))];
 
 			unsigned _num_sds;
 
 		public:
 
-			Message(void *buffer, size_t buffer_len) : _num_sds(0)
+			/**
+			 * Constructor
+			 *
+			 * \param buffer      message buffer
+			 * \param buffer_len  size of message buffer
+			 * \param header      optional header transferred in front of
+			 *                    the message buffer
+			 * \param header_len  size of header
+			 */
+			Message(void *buffer, size_t buffer_len,
+			        void *header = 0, size_t header_len = 0)
+			: _num_sds(0)
 			{
 				Genode::memset(&_msg, 0, sizeof(_msg));
 
@@ -189,11 +211,18 @@ namespace {
 				_msg.msg_controllen  = cmsg->cmsg_len;     /* actual cmsg length */
 
 				/* initialize iovec */
-				_msg.msg_iov    = &_iovec;
-				_msg.msg_iovlen = 1;
-
-				_iovec.iov_base = buffer;
-				_iovec.iov_len  = buffer_len;
+				_msg.msg_iov    = _iovec;
+				_msg.msg_iovlen = 0;
+
+				if (header) {
+					_iovec[_msg.msg_iovlen].iov_base = header;
+					_iovec[_msg.msg_iovlen].iov_len  = header_len;
+					_msg.msg_iovlen++;
+				}
+
+				_iovec[_msg.msg_iovlen].iov_base = buffer;
+				_iovec[_msg.msg_iovlen].iov_len  = buffer_len;
+				_msg.msg_iovlen++;
 			}
 
 			msghdr * msg() { return &_msg; }
@@ -265,6 +294,279 @@ static void extract_sds_from_message(unsigned start_index, Message const &msg,
 }
 
 
+/**
+ * Utility: Return reply channel of the calling thread
+ *
+ * The socket pair of the reply channel is created on the first call.
+ */
+static Genode::Native_reply_channel &reply_channel_of_myself()
+{
+	Thread_base *thread = Thread_base::myself();
+
+	/* the main thread has no 'Thread_base' object */
+	static Genode::Native_reply_channel main_reply_channel;
+
+	Genode::Native_reply_channel &reply_channel =
+		thread ? thread->tid().reply_channel : main_reply_channel;
+
+	if (reply_channel.valid())
+		return reply_channel;
+
+	int sd[2];
+	int ret = lx_socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sd);
+	if (ret < 0) {
+		PRAW("[%d] lx_socketpair failed with %d", lx_getpid(), ret);
+		throw Genode::Ipc_error();
+	}
+
+	reply_channel.local_sd  = sd[0];
+	reply_channel.remote_sd = sd[1];
+
+	return reply_channel;
+}
+
+
+/**
+ * Opt-in flag for the shared-memory transport
+ */
+static bool shm_fast_path_enabled;
+
+
+void Genode::ipc_enable_shm_fast_path() { shm_fast_path_enabled = true; }
+
+
+void Genode::destroy_reply_channel(Native_reply_channel &reply_channel)
+{
+	if (reply_channel.shm_channels)
+		ipc_shm_free_meta_data(reply_channel.shm_channels);
+
+	if (reply_channel.valid()) {
+		lx_close(reply_channel.local_sd);
+		lx_close(reply_channel.remote_sd);
+	}
+
+	reply_channel = Native_reply_channel();
+}
+
+
+/**
+ * Utility: Return shared-memory channel to use for a call
+ *
+ * \return  channel, or 0 if the call must be performed via the socket
+ */
+static Genode::Ipc_shm_client_channels::Channel *
+shm_channel_for_call(Genode::Native_reply_channel &reply_channel, int dst_sd,
+                     Genode::Msgbuf_base &send_msgbuf, Genode::size_t send_msg_len)
+{
+	using namespace Genode;
+
+	if (!shm_fast_path_enabled || send_msgbuf.used_caps())
+		return 0;
+
+	if (send_msg_len > Ipc_shm_area::capacity())
+		return 0;
+
+	if (!reply_channel.shm_channels) {
+		reply_channel.shm_channels = ipc_shm_alloc_meta_data<Ipc_shm_client_channels>();
+		if (!reply_channel.shm_channels)
+			return 0;
+	}
+
+	/* the socket descriptor may get reused, the ID of the entrypoint not */
+	int const ep_id = ep_sd_registry()->lookup_global_id(dst_sd);
+	if (ep_id < 0)
+		return 0;
+
+	Ipc_shm_client_channels::Channel *channel =
+		reply_channel.shm_channels->lookup(ep_id);
+
+	return (channel && channel->area) ? channel : 0;
+}
+
+
+/**
+ * Receive reply to call 'call_seq' via the reply channel
+ */
+static void lx_recv_reply(Genode::Native_reply_channel &reply_channel,
+                          long call_seq, Genode::Msgbuf_base &recv_msgbuf)
+{
+	for (;;) {
+
+		Message recv_msg(recv_msgbuf.buf, recv_msgbuf.size());
+		recv_msg.accept_sockets(Message::MAX_SDS_PER_MSG);
+
+		int ret = lx_recvmsg(reply_channel.local_sd, recv_msg.msg(), 0);
+
+		/* system call got interrupted by a signal */
+		if (ret == -LX_EINTR)
+			throw Genode::Blocking_canceled();
+
+		if (ret < 0) {
+			PRAW("[%d] lx_recvmsg failed with %d in lx_call()", lx_getpid(), ret);
+			throw Genode::Ipc_error();
+		}
+
+		/*
+		 * Drop stale reply to a call that got canceled earlier, including
+		 * the socket descriptors that came with it
+		 */
+		if ((Genode::size_t)ret >= sizeof(long)
+		 && *(long *)recv_msgbuf.buf != call_seq) {
+
+			for (unsigned i = 0; i < recv_msg.num_sockets(); i++)
+				lx_close(recv_msg.socket_at_index(i));
+			continue;
+		}
+
+		extract_sds_from_message(0, recv_msg, recv_msgbuf);
+		return;
+	}
+}
+
+
+enum Probe_result { CHANNEL_KNOWN, CHANNEL_UNKNOWN, REPLY_RECEIVED };
+
+
+/**
+ * Ask server whether it knows the shared-memory channel of a pending call
+ *
+ * The probe is answered via the reply channel. The reply to the pending call
+ * may arrive at the reply channel too, in which case it is taken from there.
+ *
+ * \return  'CHANNEL_UNKNOWN' if 'recv_msgbuf' contains the error reply of
+ *          the server, 'REPLY_RECEIVED' if it contains the reply to the
+ *          pending call
+ */
+static Probe_result lx_probe_shm(int dst_sd, Genode::Native_reply_channel &reply_channel,
+                         long token, long call_seq, Genode::Msgbuf_base &recv_msgbuf)
+{
+	long const probe_seq = ++reply_channel.call_seq;
+
+	Genode::Ipc_call_header header(probe_seq, token, Genode::Ipc_call_header::PROBE_SHM);
+	Message send_msg(0, 0, &header, sizeof(header));
+	send_msg.marshal_socket(reply_channel.remote_sd);
+
+	int ret = lx_sendmsg(dst_sd, send_msg.msg(), 0);
+	if (ret < 0) {
+		PRAW("[%d] lx_sendmsg to sd %d failed with %d in lx_probe_shm()",
+		     lx_getpid(), dst_sd, ret);
+		throw Genode::Ipc_error();
+	}
+
+	for (;;) {
+
+		Message recv_msg(recv_msgbuf.buf, recv_msgbuf.size());
+		recv_msg.accept_sockets(Message::MAX_SDS_PER_MSG);
+
+		ret = lx_recvmsg(reply_channel.local_sd, recv_msg.msg(), 0);
+
+		if (ret == -LX_EINTR)
+			throw Genode::Blocking_canceled();
+
+		if (ret < 0) {
+			PRAW("[%d] lx_recvmsg failed with %d in lx_probe_shm()", lx_getpid(), ret);
+			throw Genode::Ipc_error();
+		}
+
+		long const seq = (Genode::size_t)ret >= sizeof(long) ? *(long *)recv_msgbuf.buf : 0;
+
+		/* reply to the pending call sent via the socket */
+		if (seq == call_seq) {
+			extract_sds_from_message(0, recv_msg, recv_msgbuf);
+			return REPLY_RECEIVED;
+		}
+
+		/* drop stale replies including the socket descriptors */
+		if (seq != probe_seq) {
+			for (unsigned i = 0; i < recv_msg.num_sockets(); i++)
+				lx_close(recv_msg.socket_at_index(i));
+			continue;
+		}
+
+		recv_msgbuf.reset_caps();
+
+		Genode::size_t const exc_offset = sizeof(long);
+		if ((Genode::size_t)ret >= exc_offset + sizeof(int)
+		 && *(int *)(recv_msgbuf.buf + exc_offset) == Genode::ERR_INVALID_OBJECT) {
+			PRAW("[%d] server does not know the shared-memory channel", lx_getpid());
+			return CHANNEL_UNKNOWN;
+		}
+		return CHANNEL_KNOWN;
+	}
+}
+
+
+/**
+ * Send request via shared memory to server and wait for reply
+ */
+static inline void lx_call_shm(int dst_sd,
+                               Genode::Native_reply_channel &reply_channel,
+                               Genode::Ipc_shm_client_channels::Channel &channel,
+                               long call_seq,
+                               Genode::Msgbuf_base &send_msgbuf, Genode::size_t send_msg_len,
+                               Genode::Msgbuf_base &recv_msgbuf)
+{
+	Genode::Ipc_shm_area &area = *channel.area;
+
+	Genode::memcpy(area.msg(), send_msgbuf.buf, send_msg_len);
+	area.msg_len = send_msg_len;
+
+	/* wake up server with a datagram that carries the call header only */
+	Genode::Ipc_call_header header(call_seq, area.token);
+	Message send_msg(0, 0, &header, sizeof(header));
+
+	int ret = lx_sendmsg(dst_sd, send_msg.msg(), 0);
+	if (ret < 0) {
+		PRAW("[%d] lx_sendmsg to sd %d failed with %d in lx_call_shm()",
+		     lx_getpid(), dst_sd, ret);
+		throw Genode::Ipc_error();
+	}
+
+	bool probed = false;
+
+	for (int seq; (seq = area.reply_seq) != (int)call_seq; ) {
+
+		struct timespec const timeout = { Genode::Ipc_shm_area::PROBE_TIMEOUT_MS/1000,
+		                                  (Genode::Ipc_shm_area::PROBE_TIMEOUT_MS%1000)*1000*1000 };
+
+		ret = lx_futex(&area.reply_seq, FUTEX_WAIT, seq, probed ? 0 : &timeout);
+
+		/*
+		 * System call got interrupted by a signal
+		 *
+		 * The server may still respond to the canceled call. To prevent the
+		 * late reply from interfering with subsequent calls, we abandon the
+		 * shared-memory area.
+		 */
+		if (ret == -LX_EINTR) {
+			channel.release();
+			throw Genode::Blocking_canceled();
+		}
+
+		if (ret != -LX_ETIMEDOUT)
+			continue;
+
+		/* no reply for a while, make sure that the server knows the token */
+		probed = true;
+		switch (lx_probe_shm(dst_sd, reply_channel, area.token, call_seq, recv_msgbuf)) {
+		case CHANNEL_KNOWN:   continue;
+		case CHANNEL_UNKNOWN: channel.release(); return;
+		case REPLY_RECEIVED:  return;
+		}
+	}
+	__sync_synchronize();
+
+	if (area.reply_via_socket) {
+		lx_recv_reply(reply_channel, call_seq, recv_msgbuf);
+		return;
+	}
+
+	Genode::memcpy(recv_msgbuf.buf, area.msg(),
+	               Genode::min(area.msg_len, recv_msgbuf.size()));
+	recv_msgbuf.reset_caps();
+}
+
+
 /**
  * Send request to server and wait for reply
  */
@@ -273,45 +575,38 @@ static inline void lx_call(int dst_sd,
                            Genode::Msgbuf_base &recv_msgbuf)
 {
 	int ret;
-	Message send_msg(send_msgbuf.buf, send_msg_len);
 
-	/*
-	 * Create reply channel
-	 *
-	 * The reply channel will be closed when leaving the scope of 'lx_call'.
-	 */
-	struct Reply_channel
-	{
-		enum { LOCAL_SOCKET = 0, REMOTE_SOCKET = 1 };
-		int sd[2];
+	Genode::Native_reply_channel &reply_channel = reply_channel_of_myself();
 
-		Reply_channel()
-		{
-			sd[LOCAL_SOCKET] = -1; sd[REMOTE_SOCKET] = -1;
+	/* tag request with new call sequence number */
+	long const call_seq = ++reply_channel.call_seq;
 
-			int ret = lx_socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sd);
-			if (ret < 0) {
-				PRAW("[%d] lx_socketpair failed with %d", lx_getpid(), ret);
-				throw Genode::Ipc_error();
-			}
-		}
+	Genode::Ipc_shm_client_channels::Channel *shm_channel =
+		shm_channel_for_call(reply_channel, dst_sd, send_msgbuf, send_msg_len);
 
-		~Reply_channel()
-		{
-			for (unsigned i = 0; i < 2; i++)
-			if (sd[0] != -1)
-				lx_close(sd[i]);
-		}
+	if (shm_channel && shm_channel->registered()) {
+		lx_call_shm(dst_sd, reply_channel, *shm_channel, call_seq,
+		            send_msgbuf, send_msg_len, recv_msgbuf);
+		return;
+	}
 
-		int local_socket()  const { return sd[LOCAL_SOCKET];  }
-		int remote_socket() const { return sd[REMOTE_SOCKET]; }
+	/* register shared-memory area along with the call if not done yet */
+	bool const register_shm = shm_channel && shm_channel->shm_fd != -1;
 
-	} reply_channel;
+	Genode::Ipc_call_header header(call_seq, 0, register_shm
+	                               ? Genode::Ipc_call_header::REGISTER_SHM : 0);
+	Message send_msg(send_msgbuf.buf, send_msg_len, &header, sizeof(header));
 
 	/* assemble message */
 
 	/* marshal reply capability */
-	send_msg.marshal_socket(reply_channel.remote_socket());
+	send_msg.marshal_socket(reply_channel.remote_sd);
+
+	/* marshal shared-memory area and the read end of the liveness pipe */
+	if (register_shm) {
+		send_msg.marshal_socket(shm_channel->shm_fd);
+		send_msg.marshal_socket(shm_channel->hangup_fd);
+	}
 
 	/* marshal capabilities contained in 'send_msgbuf' */
 	for (unsigned i = 0; i < send_msgbuf.used_caps(); i++)
@@ -324,64 +619,152 @@ static inline void lx_call(int dst_sd,
 		throw Genode::Ipc_error();
 	}
 
-	/* receive reply */
-
-	Message recv_msg(recv_msgbuf.buf, recv_msgbuf.size());
-	recv_msg.accept_sockets(Message::MAX_SDS_PER_MSG);
-
-	ret = lx_recvmsg(reply_channel.local_socket(), recv_msg.msg(), 0);
+	/* the server holds its own references to the area and the pipe now */
+	if (register_shm)
+		shm_channel->registration_sent();
 
-	/* system call got interrupted by a signal */
-	if (ret == -LX_EINTR)
-		throw Genode::Blocking_canceled();
+	/* receive reply */
+	lx_recv_reply(reply_channel, call_seq, recv_msgbuf);
 
-	if (ret < 0) {
-		PRAW("[%d] lx_recvmsg failed with %d in lx_call()", lx_getpid(), ret);
-		throw Genode::Ipc_error();
+	/* stay on the socket path if the server refused the registration */
+	if (register_shm && !shm_channel->registered()) {
+		Genode::Ipc_shm_area::unmap(shm_channel->area);
+		shm_channel->area = 0;
 	}
-
-	extract_sds_from_message(0, recv_msg, recv_msgbuf);
 }
 
 
 /**
  * for request from client
  *
+ * \param call_seq  call sequence number of the request, to be echoed in
+ *                  the reply
+ *
  * \return  socket descriptor of reply capability
  */
 static inline int lx_wait(Genode::Native_connection_state &cs,
-                          Genode::Msgbuf_base &recv_msgbuf)
+                          Genode::Msgbuf_base &recv_msgbuf, long &call_seq)
 {
-	Message msg(recv_msgbuf.buf, recv_msgbuf.size());
+	using namespace Genode;
 
-	msg.accept_sockets(Message::MAX_SDS_PER_MSG);
+	for (;;) {
 
-	int ret = lx_recvmsg(cs.server_sd, msg.msg(), 0);
+		Ipc_call_header header;
+		Message msg(recv_msgbuf.buf, recv_msgbuf.size(), &header, sizeof(header));
 
-	/* system call got interrupted by a signal */
-	if (ret == -LX_EINTR)
-		throw Genode::Blocking_canceled();
+		msg.accept_sockets(Message::MAX_SDS_PER_MSG);
 
-	if (ret < 0) {
-		PRAW("lx_recvmsg failed with %d in lx_wait(), sd=%d", ret, cs.server_sd);
-		throw Genode::Ipc_error();
-	}
+		int ret = lx_recvmsg(cs.server_sd, msg.msg(), 0);
+
+		/* system call got interrupted by a signal */
+		if (ret == -LX_EINTR)
+			throw Genode::Blocking_canceled();
+
+		if (ret < 0) {
+			PRAW("lx_recvmsg failed with %d in lx_wait(), sd=%d", ret, cs.server_sd);
+			throw Genode::Ipc_error();
+		}
+
+		call_seq = header.call_seq;
+
+		/* answer probe of a client waiting for a shared-memory reply */
+		if (header.flags & Ipc_call_header::PROBE_SHM) {
+
+			bool const known = cs.shm_channels
+			                && cs.shm_channels->known(header.shm_token);
+
+			struct { long call_seq; int exc_code; } reply =
+				{ call_seq, known ? 0 : ERR_INVALID_OBJECT };
+
+			Message reply_msg(&reply, sizeof(reply));
+			if (msg.num_sockets())
+				lx_sendmsg(msg.socket_at_index(0), reply_msg.msg(), 0);
+
+			for (unsigned i = 0; i < msg.num_sockets(); i++)
+				lx_close(msg.socket_at_index(i));
+			continue;
+		}
 
-	int const reply_socket = msg.socket_at_index(0);
+		/* request resides in shared memory */
+		if (header.shm_token) {
 
-	extract_sds_from_message(1, msg, recv_msgbuf);
+			Ipc_shm_server_channels::Channel *channel =
+				cs.shm_channels ? cs.shm_channels->lookup(header.shm_token) : 0;
 
-	return reply_socket;
+			/* the client gets an error reply when probing the token */
+			if (!channel) {
+				PRAW("lx_wait: request with unknown shared-memory token");
+				continue;
+			}
+
+			Ipc_shm_area &area = *channel->area;
+			Genode::memcpy(recv_msgbuf.buf, area.msg(),
+			               Genode::min(area.msg_len, recv_msgbuf.size()));
+			recv_msgbuf.reset_caps();
+
+			return channel->reply_sd;
+		}
+
+		int const reply_socket = msg.socket_at_index(0);
+
+		if (!(header.flags & Ipc_call_header::REGISTER_SHM)) {
+			extract_sds_from_message(1, msg, recv_msgbuf);
+			return reply_socket;
+		}
+
+		/* a registering call carries no capabilities */
+		if (msg.num_sockets() != 3) {
+			extract_sds_from_message(1, msg, recv_msgbuf);
+			return reply_socket;
+		}
+
+		/* register shared-memory area of client, keep reply socket cached */
+		int const shm_fd    = msg.socket_at_index(1);
+		int const hangup_fd = msg.socket_at_index(2);
+
+		if (!cs.shm_channels
+		 || !cs.shm_channels->register_channel(shm_fd, hangup_fd, reply_socket, call_seq))
+			lx_close(hangup_fd);
+
+		lx_close(shm_fd);
+
+		recv_msgbuf.reset_caps();
+		return reply_socket;
+	}
 }
 
 
 /**
  * Send reply to client
  */
-static inline void lx_reply(int reply_socket,
+static inline void lx_reply(Genode::Native_connection_state &cs,
+                            int reply_socket, long call_seq,
                             Genode::Msgbuf_base &send_msgbuf,
                             Genode::size_t msg_len)
 {
+	/*
+	 * Reply socket may be cached for a shared-memory channel, the pending
+	 * request keeps the channel valid until 'replied' is called
+	 */
+	Genode::Ipc_shm_server_channels::Channel *cached =
+		cs.shm_channels ? cs.shm_channels->lookup_by_reply_sd(reply_socket) : 0;
+
+	/* the registering call is replied via the socket only */
+	Genode::Ipc_shm_server_channels::Channel *channel =
+		(cached && cached->register_seq != call_seq) ? cached : 0;
+
+	/* reply via shared memory if the reply carries no capabilities */
+	if (channel && !send_msgbuf.used_caps()
+	 && msg_len <= Genode::Ipc_shm_area::capacity()) {
+
+		Genode::memcpy(channel->area->msg(), send_msgbuf.buf, msg_len);
+		channel->area->msg_len = msg_len;
+		channel->area->signal_reply(call_seq, false);
+
+		cs.shm_channels->replied(*cached);
+		return;
+	}
+
 	Message msg(send_msgbuf.buf, msg_len);
 
 	/*
@@ -392,9 +775,17 @@ static inline void lx_reply(int reply_socket,
 
 	int ret = lx_sendmsg(reply_socket, msg.msg(), 0);
 
+	/* tell client blocking on the shared-memory area to fetch the reply */
+	if (channel)
+		channel->area->signal_reply(call_seq, true);
+
+	if (cached)
+		cs.shm_channels->replied(*cached);
+
 	/* ignore reply send error caused by disappearing client */
 	if (ret >= 0 || ret == -LX_ECONNREFUSED) {
-		lx_close(reply_socket);
+		if (!cached)
+			lx_close(reply_socket);
 		return;
 	}
 
@@ -466,6 +857,15 @@ Ipc_istream::~Ipc_istream()
 	 *
 	 * IPC clients have -1 as client_sd and need no disassociation.
 	 */
+	if (_rcv_cs.adopted) {
+		Thread_base *thread = Thread_base::myself();
+		if (thread)
+			thread->tid().is_ipc_server = false;
+
+		_rcv_cs = Native_connection_state();
+		return;
+	}
+
 	if (_rcv_cs.client_sd != -1) {
 		Genode::ep_sd_registry()->disassociate(_rcv_cs.client_sd);
 
@@ -478,9 +878,13 @@ Ipc_istream::~Ipc_istream()
 			thread->tid().is_ipc_server = false;
 	}
 
+	if (_rcv_cs.shm_channels)
+		ipc_shm_free_meta_data(_rcv_cs.shm_channels);
+
 	destroy_server_socket_pair(_rcv_cs);
-	_rcv_cs.client_sd = -1;
-	_rcv_cs.server_sd = -1;
+	_rcv_cs.client_sd    = -1;
+	_rcv_cs.server_sd    = -1;
+	_rcv_cs.shm_channels =  0;
 }
 
 
@@ -532,7 +936,7 @@ void Ipc_server::_prepare_next_reply_wait()
 	/* prepare next reply */
 	_write_offset   = 0;
 	long local_name = Ipc_ostream::_dst.local_name();
-	_write_to_buf(local_name);  /* XXX unused, needed by de/marshaller */
+	_write_to_buf(local_name);  /* echo call sequence number to client */
 
 	/* leave space for exc code at the beginning of the msgbuf */
 	_write_offset += align_natural(sizeof(int));
@@ -556,18 +960,20 @@ void Ipc_server::_wait()
 	}
 
 	try {
-		int const reply_socket = lx_wait(_rcv_cs, *_rcv_msg);
+		long call_seq = 0;
+		int const reply_socket = lx_wait(_rcv_cs, *_rcv_msg, call_seq);
 
 		/*
 		 * Remember reply capability
 		 *
 		 * The 'local_name' of a capability is meaningful for addressing server
 		 * objects only. Because a reply capabilities does not address a server
-		 * object, the 'local_name' is meaningless.
+		 * object, we use the 'local_name' to hold the call sequence number.
+		 * It is written to the scratch word of the reply message by
+		 * '_prepare_next_reply_wait'.
 		 */
-		enum { DUMMY_LOCAL_NAME = -1 };
 		typedef Native_capability::Dst Dst;
-		Ipc_ostream::_dst = Native_capability(Dst(reply_socket), DUMMY_LOCAL_NAME);
+		Ipc_ostream::_dst = Native_capability(Dst(reply_socket), call_seq);
 
 		_prepare_next_reply_wait();
 	} catch (Blocking_canceled) { }
@@ -577,7 +983,8 @@ void Ipc_server::_wait()
 void Ipc_server::_reply()
 {
 	try {
-		lx_reply(Ipc_ostream::_dst.dst().socket, *_snd_msg, _write_offset); }
+		lx_reply(_rcv_cs, Ipc_ostream::_dst.dst().socket,
+		         Ipc_ostream::_dst.local_name(), *_snd_msg, _write_offset); }
 	catch (Ipc_error) { }
 
 	_prepare_next_reply_wait();
@@ -588,7 +995,8 @@ void Ipc_server::_reply_wait()
 {
 	/* when first called, there was no request yet */
 	if (_reply_needed)
-		lx_reply(Ipc_ostream::_dst.dst().socket, *_snd_msg, _write_offset);
+		lx_reply(_rcv_cs, Ipc_ostream::_dst.dst().socket,
+		         Ipc_ostream::_dst.local_name(), *_snd_msg, _write_offset);
 
 	_wait();
 }
@@ -616,6 +1024,7 @@ Ipc_server::Ipc_server(Msgbuf_base *snd_msg, Msgbuf_base *rcv_msg)
 
 	if (thread) {
 		_rcv_cs = server_socket_pair();
+		_rcv_cs.shm_channels = ipc_shm_alloc_meta_data<Ipc_shm_server_channels>();
 		thread->tid().is_ipc_server = true;
 	}
 
@@ -625,3 +1034,34 @@ Ipc_server::Ipc_server(Msgbuf_base *snd_msg, Msgbuf_base *rcv_msg)
 
 	_prepare_next_reply_wait();
 }
+
+
+Ipc_server::Ipc_server(Msgbuf_base *snd_msg, Msgbuf_base *rcv_msg,
+                       Ipc_server &server)
+:
+	Ipc_istream(rcv_msg),
+	Ipc_ostream(Native_capability(), snd_msg), _reply_needed(false)
+{
+	Thread_base *thread = Thread_base::myself();
+
+	if (!thread || thread->tid().is_ipc_server) {
+		PRAW("[%d] invalid thread for additional Ipc_server activation",
+		     lx_gettid());
+		struct Ipc_server_invalid_activation { };
+		throw Ipc_server_invalid_activation();
+	}
+
+	/*
+	 * Multiple threads can receive from the same datagram socket. Each
+	 * request is delivered to exactly one of them.
+	 */
+	_rcv_cs         = server._rcv_cs;
+	_rcv_cs.adopted = true;
+
+	thread->tid().is_ipc_server = true;
+
+	*static_cast<Native_capability *>(this) =
+		Native_capability(Native_capability::Dst(_rcv_cs.client_sd), 0);
+
+	_prepare_next_reply_wait();
+}
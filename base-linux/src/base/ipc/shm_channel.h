@@ -0,0 +1,439 @@
+/*
+ * \brief  Shared-memory transport for small RPC messages on Linux
+ * \author Genode Labs
+ * \date   2013-01-21
+ *
+ * For each pair of client thread and entrypoint, the client creates a
+ * shared-memory area, which it registers at the entrypoint with a regular
+ * socket-based call. From then on, requests without capability arguments are
+ * written to the area and the entrypoint is merely woken up by a datagram
+ * carrying the call header. The entrypoint writes the reply to the area and
+ * wakes up the client via a futex. Replies that carry capabilities are
+ * delivered via the client's reply channel, which the entrypoint keeps open
+ * for the registered client. The cached reply socket thereby identifies the
+ * channel of a reply capability, which enables the deferred replying of
+ * requests via 'Rpc_entrypoint::explicit_reply'.
+ *
+ * Along with the area, the client registers the read end of a pipe whose
+ * write end it keeps open as long as it uses the channel. Once the client
+ * terminates, also when it crashes, the pipe hangs up. This way, the
+ * entrypoint reclaims the channels of vanished clients.
+ *
+ * The client identifies the entrypoint by its global ID rather than by the
+ * socket descriptor, which may get reused for another entrypoint. Tokens are
+ * unique within the process of the entrypoint. If the entrypoint does not
+ * know the token of a request, it cannot wake up the client. Therefore, a
+ * client that waits for a reply for longer than 'PROBE_TIMEOUT_MS' probes its
+ * channel via the socket. The entrypoint answers the probe with an error
+ * reply if the token is unknown.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _BASE__IPC__SHM_CHANNEL_H_
+#define _BASE__IPC__SHM_CHANNEL_H_
+
+/* Genode includes */
+#include <util/string.h>
+#include <base/native_types.h>
+#include <base/lock.h>
+
+/* Linux includes */
+#include <linux_syscalls.h>
+#include <sys/mman.h>
+
+
+namespace Genode {
+
+	/**
+	 * Header preceding each request message
+	 */
+	struct Ipc_call_header
+	{
+		enum Flags { REGISTER_SHM = 1, PROBE_SHM = 2 };
+
+		long call_seq;   /* echoed by the server in the reply */
+		long shm_token;  /* non-zero if request resides in shared memory */
+		long flags;
+
+		Ipc_call_header(long call_seq = 0, long shm_token = 0, long flags = 0)
+		: call_seq(call_seq), shm_token(shm_token), flags(flags) { }
+	};
+
+
+	/**
+	 * Layout of the shared-memory area of one client/entrypoint pair
+	 */
+	struct Ipc_shm_area
+	{
+		enum { SIZE = 4096, PROBE_TIMEOUT_MS = 1000 };
+
+		volatile int reply_seq;         /* futex word, sequence of last reply */
+		volatile int reply_via_socket;  /* reply was sent via reply channel */
+		volatile int closed;            /* area got abandoned by the client */
+		long         token;             /* assigned by entrypoint at registration */
+		size_t       msg_len;
+
+		char *msg() { return (char *)(this + 1); }
+
+		static size_t capacity() { return SIZE - sizeof(Ipc_shm_area); }
+
+		/**
+		 * Map area backed by file descriptor 'fd'
+		 *
+		 * \return  pointer to area, or 0 on error
+		 */
+		static Ipc_shm_area *map(int fd)
+		{
+			void *addr = lx_mmap(0, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (((long)addr < 0) && ((long)addr > -4095))
+				return 0;
+
+			return (Ipc_shm_area *)addr;
+		}
+
+		static void unmap(Ipc_shm_area *area) { lx_munmap(area, SIZE); }
+
+		/**
+		 * Publish reply and wake up the client
+		 */
+		void signal_reply(long call_seq, bool via_socket)
+		{
+			reply_via_socket = via_socket;
+			__sync_synchronize();
+			reply_seq = (int)call_seq;
+			lx_futex(&reply_seq, FUTEX_WAKE, 1);
+		}
+	};
+
+
+	/**
+	 * Anonymous memory used for the book keeping of shared-memory channels
+	 *
+	 * We cannot use the heap here because allocating from the heap may
+	 * involve RPC calls.
+	 */
+	template <typename T>
+	static inline T *ipc_shm_alloc_meta_data()
+	{
+		void *addr = lx_mmap(0, sizeof(T), PROT_READ | PROT_WRITE,
+		                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (((long)addr < 0) && ((long)addr > -4095))
+			return 0;
+
+		struct Placeable : T
+		{
+			void *operator new (size_t, void *addr) { return addr; }
+		};
+
+		return new (addr) Placeable;
+	}
+
+	template <typename T>
+	static inline void ipc_shm_free_meta_data(T *meta_data)
+	{
+		meta_data->~T();
+		lx_munmap(meta_data, sizeof(T));
+	}
+
+
+	/**
+	 * Client-side shared-memory channels of one thread
+	 */
+	struct Ipc_shm_client_channels
+	{
+		enum { MAX_CHANNELS = 8 };
+
+		struct Channel
+		{
+			int           ep_id;      /* global ID of entrypoint, -1 if unused */
+			Ipc_shm_area *area;       /* 0 if entrypoint refused registration */
+			int           shm_fd;     /* valid until registration is complete */
+			int           hangup_fd;  /* valid until registration is complete */
+			int           alive_fd;   /* write end of the pipe of 'hangup_fd' */
+
+			Channel() : ep_id(-1), area(0), shm_fd(-1), hangup_fd(-1), alive_fd(-1) { }
+
+			bool registered() const { return area && area->token; }
+
+			/**
+			 * Abandon area, the entrypoint reclaims it lazily
+			 */
+			void release()
+			{
+				if (area) {
+					area->closed = 1;
+					Ipc_shm_area::unmap(area);
+				}
+				if (shm_fd != -1)
+					lx_close(shm_fd);
+				if (hangup_fd != -1)
+					lx_close(hangup_fd);
+				if (alive_fd != -1)
+					lx_close(alive_fd);
+
+				*this = Channel();
+			}
+
+			/**
+			 * Close the descriptors handed over to the entrypoint
+			 */
+			void registration_sent()
+			{
+				lx_close(shm_fd);
+				lx_close(hangup_fd);
+				shm_fd = hangup_fd = -1;
+			}
+		} channel[MAX_CHANNELS];
+
+		~Ipc_shm_client_channels()
+		{
+			for (unsigned i = 0; i < MAX_CHANNELS; i++)
+				channel[i].release();
+		}
+
+		/**
+		 * Return channel for entrypoint, create it if needed
+		 *
+		 * \return  channel, or 0 if no channel is available
+		 */
+		Channel *lookup(int ep_id)
+		{
+			Channel *free = 0;
+			for (unsigned i = 0; i < MAX_CHANNELS; i++) {
+				if (channel[i].ep_id == ep_id)
+					return &channel[i];
+				if (!free && channel[i].ep_id == -1)
+					free = &channel[i];
+			}
+
+			if (!free)
+				return 0;
+
+			free->ep_id = ep_id;
+
+			/* if no area can be created, the channel stays on the slow path */
+			int const fd = lx_memfd_create("ipc_shm", 1 /* MFD_CLOEXEC */);
+			if (fd < 0)
+				return free;
+
+			int pipe_fd[2];
+			if (lx_ftruncate(fd, Ipc_shm_area::SIZE) < 0 || lx_pipe(pipe_fd) < 0) {
+				lx_close(fd);
+				return free;
+			}
+
+			free->area = Ipc_shm_area::map(fd);
+			if (!free->area) {
+				lx_close(fd);
+				lx_close(pipe_fd[0]);
+				lx_close(pipe_fd[1]);
+				return free;
+			}
+
+			free->shm_fd    = fd;
+			free->hangup_fd = pipe_fd[0];
+			free->alive_fd  = pipe_fd[1];
+			return free;
+		}
+	};
+
+
+	/**
+	 * Entrypoint-side shared-memory channels
+	 *
+	 * The channels are shared by all activations of an entrypoint. Each
+	 * request received via a channel holds a reference to the channel until
+	 * it is replied. A channel abandoned by its client is reclaimed only if
+	 * no request refers to it anymore. Hence, the area and the cached reply
+	 * socket stay valid while an activation works with them. A channel counts
+	 * as abandoned if the client released it or if the client is gone.
+	 */
+	struct Ipc_shm_server_channels
+	{
+		enum { MAX_CHANNELS = 64 };
+
+		struct Channel
+		{
+			long          token;
+			Ipc_shm_area *area;
+			int           reply_sd;      /* cached reply socket of the client */
+			int           hangup_fd;     /* hangs up once the client is gone */
+			long          register_seq;  /* call that registered the channel */
+			unsigned      pending;       /* requests that await their reply */
+
+			Channel()
+			:
+				token(0), area(0), reply_sd(-1), hangup_fd(-1),
+				register_seq(0), pending(0)
+			{ }
+
+			bool abandoned() const
+			{
+				if (area->closed)
+					return true;
+
+				struct pollfd pfd;
+				pfd.fd      = hangup_fd;
+				pfd.events  = 0;
+				pfd.revents = 0;
+				return lx_poll(&pfd, 1, 0) == 1
+				    && (pfd.revents & (POLLHUP | POLLERR));
+			}
+
+			void release()
+			{
+				if (area)
+					Ipc_shm_area::unmap(area);
+				if (reply_sd != -1)
+					lx_close(reply_sd);
+				if (hangup_fd != -1)
+					lx_close(hangup_fd);
+
+				*this = Channel();
+			}
+		} channel[MAX_CHANNELS];
+
+		Lock lock;
+
+		/**
+		 * Return token that is unique among all entrypoints of the process
+		 */
+		static long _new_token(unsigned index)
+		{
+			static unsigned long generation;
+
+			unsigned long const g = __sync_add_and_fetch(&generation, 1);
+			return (long)((g << 8) | (index + 1));
+		}
+
+		Channel *_lookup(long token)
+		{
+			unsigned const index = (token & 0xff) - 1;
+
+			if (!token || index >= MAX_CHANNELS || channel[index].token != token)
+				return 0;
+
+			return &channel[index];
+		}
+
+		~Ipc_shm_server_channels()
+		{
+			for (unsigned i = 0; i < MAX_CHANNELS; i++)
+				channel[i].release();
+		}
+
+		/**
+		 * Register shared-memory area of a client
+		 *
+		 * The area is abandoned if no channel is available. In this case,
+		 * the client observes a zero token and stays on the socket path.
+		 *
+		 * \param hangup_fd  read end of the client's liveness pipe, owned by
+		 *                   the channel if the registration succeeds
+		 * \param call_seq   sequence number of the registering call, which
+		 *                   is replied via the socket
+		 *
+		 * \return  true if the channel got registered
+		 */
+		bool register_channel(int shm_fd, int hangup_fd, int reply_sd, long call_seq)
+		{
+			Lock::Guard guard(lock);
+
+			Channel *free = 0;
+			for (unsigned i = 0; i < MAX_CHANNELS && !free; i++) {
+
+				/* reclaim channels abandoned by their clients */
+				if (channel[i].area && !channel[i].pending && channel[i].abandoned())
+					channel[i].release();
+
+				if (!channel[i].area)
+					free = &channel[i];
+			}
+
+			Ipc_shm_area *area = Ipc_shm_area::map(shm_fd);
+			if (!area)
+				return false;
+
+			if (!free) {
+				Ipc_shm_area::unmap(area);
+				return false;
+			}
+
+			unsigned const index = free - channel;
+
+			free->area         = area;
+			free->reply_sd     = reply_sd;
+			free->hangup_fd    = hangup_fd;
+			free->register_seq = call_seq;
+			free->pending      = 1;  /* registering call */
+			free->token        = _new_token(index);
+			area->token        = free->token;
+			return true;
+		}
+
+		/**
+		 * Look up channel by token for a request received via the channel
+		 *
+		 * The request refers to the channel until 'replied' is called.
+		 *
+		 * \return  channel, or 0 if the token is unknown
+		 */
+		Channel *lookup(long token)
+		{
+			Lock::Guard guard(lock);
+
+			Channel *c = _lookup(token);
+			if (c)
+				c->pending++;
+
+			return c;
+		}
+
+		/**
+		 * Return true if a channel with the specified token exists
+		 */
+		bool known(long token)
+		{
+			Lock::Guard guard(lock);
+
+			return _lookup(token) != 0;
+		}
+
+		/**
+		 * Look up channel of a pending request by cached reply socket
+		 *
+		 * The returned channel stays valid until 'replied' is called.
+		 *
+		 * \return  channel, or 0 if the socket is not cached by a channel
+		 */
+		Channel *lookup_by_reply_sd(int reply_sd)
+		{
+			Lock::Guard guard(lock);
+
+			for (unsigned i = 0; i < MAX_CHANNELS; i++)
+				if (channel[i].area && channel[i].reply_sd == reply_sd)
+					return &channel[i];
+
+			return 0;
+		}
+
+		/**
+		 * Drop reference of a replied request to its channel
+		 */
+		void replied(Channel &channel)
+		{
+			Lock::Guard guard(lock);
+
+			if (channel.pending)
+				channel.pending--;
+		}
+	};
+}
+
+#endif /* _BASE__IPC__SHM_CHANNEL_H_ */
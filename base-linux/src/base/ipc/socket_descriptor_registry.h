@@ -102,6 +102,22 @@ class Genode::Socket_descriptor_registry
 
 	public:
 
+		/**
+		 * Lookup global ID associated with the specified socket descriptor
+		 *
+		 * \return global ID or -1 if the socket descriptor is not associated
+		 */
+		int lookup_global_id(int sd) const
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			for (unsigned i = 0; i < MAX_FDS; i++)
+				if (!_entries[i].is_free() && _entries[i].fd == sd)
+					return _entries[i].global_id;
+
+			return -1;
+		}
+
 		void disassociate(int sd)
 		{
 			Genode::Lock::Guard guard(_lock);
@@ -0,0 +1,220 @@
+/*
+ * \brief  Linux-specific RPC entrypoint pool
+ * \author Genode Labs
+ * \date   2013-02-04
+ *
+ * On Linux, an entrypoint is a Unix-domain datagram socket. Any number of
+ * threads can wait for requests on the socket whereas each request is
+ * delivered to exactly one of them.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/rpc_server.h>
+#include <base/env.h>
+
+using namespace Genode;
+
+
+/**
+ * Additional activation of an entrypoint pool
+ */
+class Rpc_entrypoint_pool::Worker : public Genode::Thread_base
+{
+	private:
+
+		enum { SND_BUF_SIZE = 1024, RCV_BUF_SIZE = 1024 };
+
+		Rpc_entrypoint_pool &_pool;
+		Msgbuf<SND_BUF_SIZE> _snd_buf;
+		Msgbuf<RCV_BUF_SIZE> _rcv_buf;
+
+	public:
+
+		Ipc_server      *ipc_server;
+		Rpc_object_base *curr_obj;       /* currently dispatched RPC object   */
+		Lock             curr_obj_lock;  /* for the protection of 'curr_obj'  */
+		bool volatile    exit;           /* set by 'Worker_exit_handler'    */
+
+		/*
+		 * Object locked by the worker, in contrast to 'curr_obj_lock',
+		 * 'locked_obj_lock' is never held while blocking
+		 */
+		Rpc_object_base *locked_obj;
+		Lock             locked_obj_lock;
+
+		Worker(Rpc_entrypoint_pool &pool, size_t stack_size, char const *name)
+		:
+			Thread_base(name, stack_size), _pool(pool),
+			ipc_server(0), curr_obj(0), exit(false), locked_obj(0)
+		{ }
+
+		void locked(Rpc_object_base *obj)
+		{
+			Lock::Guard lock_guard(locked_obj_lock);
+			locked_obj = obj;
+		}
+
+		/**
+		 * Thread interface
+		 */
+		void entry()
+		{
+			Ipc_server srv(&_snd_buf, &_rcv_buf, *_pool._ipc_server);
+			ipc_server = &srv;
+
+			while (!exit) {
+
+				int opcode = 0;
+
+				srv >> IPC_REPLY_WAIT >> opcode;
+
+				/* set default return value */
+				srv.ret(ERR_INVALID_OBJECT);
+
+				/* atomically lookup and lock referenced object */
+				{
+					Lock::Guard lock_guard(curr_obj_lock);
+
+					curr_obj = _pool.obj_by_id(srv.badge());
+					if (!curr_obj)
+						continue;
+
+					curr_obj->lock();
+					locked(curr_obj);
+				}
+
+				/* dispatch request */
+				try { srv.ret(curr_obj->dispatch(opcode, srv, srv)); }
+				catch (Blocking_canceled) { }
+
+				Lock::Guard lock_guard(curr_obj_lock);
+
+				locked(0);
+				curr_obj->unlock();
+				curr_obj = 0;
+			}
+
+			/* answer exit call, thereby wake up '~Rpc_entrypoint_pool' */
+			srv << IPC_REPLY;
+
+			ipc_server = 0;
+		}
+};
+
+
+void Rpc_entrypoint_pool::Worker_exit_handler::_exit()
+{
+	/* the exit request affects the worker that happens to receive it */
+	for (unsigned i = 0; i < pool._num_workers; i++)
+		if (pool._workers[i] == Genode::Thread_base::myself()) {
+			pool._workers[i]->exit = true;
+
+			/* make the flag visible to the thread of '~Rpc_entrypoint_pool' */
+			__sync_synchronize();
+		}
+}
+
+
+void Rpc_entrypoint_pool::_leave_server_object(Rpc_object_base *obj)
+{
+	/*
+	 * Cancel the blocking of all workers that dispatch 'obj' before
+	 * waiting for workers that are about to lock 'obj'. Otherwise, we would
+	 * wait for a worker that waits for a blocking dispatch of 'obj' by
+	 * another worker. Hence, we must not acquire 'curr_obj_lock' here.
+	 */
+	for (unsigned i = 0; i < _num_workers; i++) {
+		Lock::Guard lock_guard(_workers[i]->locked_obj_lock);
+
+		if (_workers[i]->locked_obj == obj)
+			_workers[i]->cancel_blocking();
+	}
+
+	Rpc_entrypoint::_leave_server_object(obj);
+
+	for (unsigned i = 0; i < _num_workers; i++) {
+		Lock::Guard lock_guard(_workers[i]->curr_obj_lock);
+
+		if (_workers[i]->curr_obj == obj)
+			_workers[i]->cancel_blocking();
+	}
+}
+
+
+Ipc_server *Rpc_entrypoint_pool::_current_ipc_server()
+{
+	for (unsigned i = 0; i < _num_workers; i++)
+		if (_workers[i] == Genode::Thread_base::myself())
+			return _workers[i]->ipc_server;
+
+	return Rpc_entrypoint::_current_ipc_server();
+}
+
+
+void Rpc_entrypoint_pool::activate()
+{
+	for (unsigned i = 0; i < _num_workers; i++)
+		_workers[i]->start();
+
+	Rpc_entrypoint::activate();
+}
+
+
+Rpc_entrypoint_pool::Rpc_entrypoint_pool(Cap_session *cap_session,
+                                         size_t stack_size, char const *name,
+                                         unsigned num_threads,
+                                         bool start_on_construction)
+:
+	Rpc_entrypoint(cap_session, stack_size, name, false),
+	_num_workers(0), _worker_exit_handler(*this)
+{
+	if (num_threads > MAX_WORKERS + 1) {
+		PWRN("%s: limit number of threads to %d", name, MAX_WORKERS + 1);
+		num_threads = MAX_WORKERS + 1;
+	}
+
+	for (; _num_workers + 1 < num_threads; _num_workers++)
+		_workers[_num_workers] = new (env()->heap())
+			Worker(*this, stack_size, name);
+
+	_worker_exit_cap = manage(&_worker_exit_handler);
+
+	if (start_on_construction)
+		activate();
+}
+
+
+Rpc_entrypoint_pool::~Rpc_entrypoint_pool()
+{
+	/*
+	 * Issue exit calls until each worker has received one. Exit calls
+	 * received by the entrypoint thread have no effect.
+	 */
+	for (;;) {
+
+		unsigned num_exited = 0;
+		__sync_synchronize();
+		for (unsigned i = 0; i < _num_workers; i++)
+			if (_workers[i]->exit)
+				num_exited++;
+
+		if (num_exited == _num_workers)
+			break;
+
+		_worker_exit_cap.call<Worker_exit::Rpc_exit>();
+	}
+
+	for (unsigned i = 0; i < _num_workers; i++) {
+		_workers[i]->join();
+		destroy(env()->heap(), _workers[i]);
+	}
+
+	dissolve(&_worker_exit_handler);
+}
@@ -104,6 +104,9 @@ void Thread_base::_deinit_platform_thread()
 		lx_nanosleep(&ts, 0);
 	}
 
+	/* release reply channel used by the thread for RPC calls */
+	destroy_reply_channel(_tid.reply_channel);
+
 	/* inform core about the killed thread */
 	env()->cpu_session()->kill_thread(_thread_cap);
 }
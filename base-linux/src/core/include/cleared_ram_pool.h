@@ -0,0 +1,176 @@
+/*
+ * \brief  Pool of files for RAM dataspaces
+ * \author Genode Labs
+ * \date   2013-03-05
+ *
+ * On Linux, a RAM dataspace is a file, which is zero-filled by the kernel.
+ * Instead of clearing memory, the time spent at allocation is the creation
+ * of the file. Therefore, the pool keeps files created in advance by a core
+ * thread.
+ *
+ * Files are preferably anonymous memory files, which do not involve the
+ * file system. If the kernel does not support them, a file is created in
+ * the resource directory and unlinked right away.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+#define _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+
+/* glibc includes */
+#include <fcntl.h>
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/semaphore.h>
+#include <base/thread.h>
+#include <base/snprintf.h>
+
+/* core includes */
+#include <resource_path.h>
+#include <dataspace_component.h>
+
+/* Linux syscall bindings */
+#include <core_linux_syscalls.h>
+
+namespace Genode {
+
+	class Cleared_ram_pool : Thread<2048*sizeof(addr_t)>
+	{
+		public:
+
+			/**
+			 * Allocation counters
+			 */
+			struct Stats
+			{
+				unsigned long fast;        /* files taken from the pool  */
+				unsigned long slow;        /* files created at allocation */
+				size_t        slow_bytes;  /* always 0 on Linux           */
+				size_t        held;        /* always 0 on Linux           */
+			};
+
+		private:
+
+			enum { MAX_FILES = 16 };
+
+			Lock      _lock;
+			Semaphore _refill;
+			int       _files[MAX_FILES];
+			unsigned  _num_files;
+			Stats     _stats;
+
+			void entry()
+			{
+				for (;;) {
+					_refill.down();
+
+					for (;;) {
+						{
+							Lock::Guard lock_guard(_lock);
+							if (_num_files == MAX_FILES)
+								break;
+						}
+
+						int const fd = create_file();
+						if (fd < 0)
+							break;
+
+						Lock::Guard lock_guard(_lock);
+						_files[_num_files++] = fd;
+					}
+				}
+			}
+
+		public:
+
+			Cleared_ram_pool(Range_allocator *)
+			:
+				Thread<2048*sizeof(addr_t)>("cleared_ram"), _num_files(0)
+			{
+				_stats.fast = 0, _stats.slow = 0, _stats.slow_bytes = 0;
+				_stats.held = 0;
+			}
+
+			/**
+			 * Create empty file for a dataspace
+			 *
+			 * \return  file descriptor, or a negative value on error
+			 */
+			static int create_file()
+			{
+				enum { MFD_CLOEXEC = 1 };
+
+				int const memfd = lx_memfd_create("dataspace", MFD_CLOEXEC);
+				if (memfd >= 0)
+					return memfd;
+
+				static Lock lock;
+				static int  cnt = 0;  /* for creating unique file names */
+
+				char fname[Linux_dataspace::FNAME_LEN];
+				{
+					Lock::Guard lock_guard(lock);
+					snprintf(fname, sizeof(fname), "%s/ds-%d", resource_path(), cnt++);
+				}
+
+				lx_unlink(fname);
+				int const fd = lx_open(fname, O_CREAT|O_RDWR|O_TRUNC|LX_O_CLOEXEC, S_IRWXU);
+
+				/*
+				 * Wipe the file from the Linux file system. The kernel will
+				 * still keep the then unnamed file around until the last
+				 * reference to the file will be gone (i.e., an open file
+				 * descriptor referring to the file). A process w/o the right
+				 * file descriptor won't be able to open and access the file.
+				 */
+				lx_unlink(fname);
+				return fd;
+			}
+
+			/**
+			 * Return file created in advance, or create a new file
+			 */
+			int take_file()
+			{
+				{
+					Lock::Guard lock_guard(_lock);
+					if (_num_files) {
+						_stats.fast++;
+						_refill.up();
+						return _files[--_num_files];
+					}
+					_stats.slow++;
+				}
+				_refill.up();
+				return create_file();
+			}
+
+			void start()
+			{
+				Thread<2048*sizeof(addr_t)>::start();
+				_refill.up();
+			}
+
+			/**
+			 * Interface used for the physical memory of other platforms
+			 */
+			bool alloc(size_t, void **) { return false; }
+			void record_slow(size_t)    { }
+			void drain()                { }
+
+			Stats stats()
+			{
+				Lock::Guard lock_guard(_lock);
+				return _stats;
+			}
+	};
+}
+
+#endif /* _CORE__INCLUDE__CLEARED_RAM_POOL_H_ */
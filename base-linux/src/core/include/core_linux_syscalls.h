@@ -29,12 +29,6 @@ inline int lx_mkdir(char const *pathname, mode_t mode)
 }
 
 
-inline int lx_ftruncate(int fd, unsigned long length)
-{
-	return lx_syscall(SYS_ftruncate, fd, length);
-}
-
-
 inline int lx_unlink(const char *fname)
 {
 	return lx_syscall(SYS_unlink, fname);
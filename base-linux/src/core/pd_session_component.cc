@@ -377,7 +377,7 @@ void Pd_session_component::start(Capability<Dataspace> binary)
 
 	/* pass parent capability as environment variable to the child */
 	enum { ENV_STR_LEN = 256 };
-	static char envbuf[5][ENV_STR_LEN];
+	static char envbuf[6][ENV_STR_LEN];
 	Genode::snprintf(envbuf[1], ENV_STR_LEN, "parent_local_name=%lu",
 	                 _parent.local_name());
 	Genode::snprintf(envbuf[2], ENV_STR_LEN, "DISPLAY=%s",
@@ -386,9 +386,11 @@ void Pd_session_component::start(Capability<Dataspace> binary)
 	                 get_env("HOME"));
 	Genode::snprintf(envbuf[4], ENV_STR_LEN, "LD_LIBRARY_PATH=%s",
 	                 get_env("LD_LIBRARY_PATH"));
+	Genode::snprintf(envbuf[5], ENV_STR_LEN, "huge_dataspace_size=%s",
+	                 get_env("huge_dataspace_size"));
 
 	char *env[] = { &envbuf[0][0], &envbuf[1][0], &envbuf[2][0],
-	                &envbuf[3][0], &envbuf[4][0], 0 };
+	                &envbuf[3][0], &envbuf[4][0], &envbuf[5][0], 0 };
 
 	/* prefix name of Linux program (helps killing some zombies) */
 	char const *prefix = "[Genode] ";
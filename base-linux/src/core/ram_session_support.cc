@@ -11,15 +11,8 @@
  * under the terms of the GNU General Public License version 2.
  */
 
-/* glibc includes */
-#include <fcntl.h>
-
-/* Genode includes */
-#include <base/snprintf.h>
-
 /* local includes */
 #include <ram_session_component.h>
-#include <resource_path.h>
 
 /* Linux syscall bindings */
 #include <core_linux_syscalls.h>
@@ -28,28 +21,15 @@
 using namespace Genode;
 
 
-static int ram_ds_cnt = 0;  /* counter for creating unique dataspace IDs */
-
 void Ram_session_component::_export_ram_ds(Dataspace_component *ds)
 {
-	char fname[Linux_dataspace::FNAME_LEN];
-
-	/* create file using a unique file name in the resource path */
-	snprintf(fname, sizeof(fname), "%s/ds-%d", resource_path(), ram_ds_cnt++);
-	lx_unlink(fname);
-	int const fd = lx_open(fname, O_CREAT|O_RDWR|O_TRUNC|LX_O_CLOEXEC, S_IRWXU);
+	/* use file created in advance if available */
+	int const fd = _cleared_pool ? _cleared_pool->take_file()
+	                             : Cleared_ram_pool::create_file();
 	lx_ftruncate(fd, ds->size());
 
 	/* remember file descriptor in dataspace component object */
 	ds->fd(fd);
-
-	/*
-	 * Wipe the file from the Linux file system. The kernel will still keep the
-	 * then unnamed file around until the last reference to the file will be
-	 * gone (i.e., an open file descriptor referring to the file). A process
-	 * w/o the right file descriptor won't be able to open and access the file.
-	 */
-	lx_unlink(fname);
 }
 
 
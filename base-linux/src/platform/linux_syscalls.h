@@ -162,6 +162,52 @@ inline int lx_getpeername(int sockfd, struct sockaddr *name, socklen_t *namelen)
 #endif /* SYS_socketcall */
 
 
+/*
+ * The following system calls are used by the shared-memory transport of the
+ * IPC framework.
+ */
+
+#include <linux/futex.h>
+
+inline int lx_futex(const volatile int *uaddr, int op, int val,
+                    const struct timespec *timeout = 0)
+{
+	return lx_syscall(SYS_futex, uaddr, op, val, timeout, 0, 0);
+}
+
+
+inline int lx_memfd_create(char const *name, unsigned flags)
+{
+#ifdef SYS_memfd_create
+	return lx_syscall(SYS_memfd_create, name, flags);
+#else
+	enum { LX_ENOSYS = 38 };
+	return -LX_ENOSYS;
+#endif
+}
+
+
+inline int lx_ftruncate(int fd, unsigned long length)
+{
+	return lx_syscall(SYS_ftruncate, fd, length);
+}
+
+
+inline int lx_pipe(int fd[2])
+{
+	enum { LX_O_CLOEXEC = 02000000 };
+	return lx_syscall(SYS_pipe2, fd, LX_O_CLOEXEC);
+}
+
+
+#include <poll.h>
+
+inline int lx_poll(struct pollfd *fds, unsigned long nfds, int timeout)
+{
+	return lx_syscall(SYS_poll, fds, nfds, timeout);
+}
+
+
 /*******************************************
  ** Functions used by the process library **
  *******************************************/
@@ -202,6 +248,15 @@ inline int lx_munmap(void *addr, size_t length)
 }
 
 
+/* MADV_HUGEPAGE is missing in the headers of older distributions */
+enum { LX_MADV_HUGEPAGE = 14 };
+
+inline int lx_madvise(void *addr, size_t length, int advice)
+{
+	return lx_syscall(SYS_madvise, addr, length, advice);
+}
+
+
 /**
  * Exclude local virtual memory area from being used by mmap
  *
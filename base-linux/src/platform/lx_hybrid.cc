@@ -97,6 +97,7 @@ int    genode_argc = 1;
 /* Genode includes */
 #include <base/thread.h>
 #include <base/env.h>
+#include <base/ipc.h>
 
 /* libc includes */
 #include <pthread.h>
@@ -349,6 +350,9 @@ Thread_base::~Thread_base()
 			     ret, errno);
 	}
 
+	/* release reply channel used by the thread for RPC calls */
+	destroy_reply_channel(_tid.reply_channel);
+
 	destroy(env()->heap(), _tid.meta_data);
 	_tid.meta_data = 0;
 
@@ -0,0 +1,160 @@
+/*
+ * \brief  Benchmark for measuring the RPC round-trip rate on Linux
+ * \author Genode Labs
+ * \date   2013-01-14
+ *
+ * The test calls a trivial RPC object served by a local entrypoint and
+ * reports the number of calls per second. Besides the empty call, a call
+ * with a small payload and a call transferring a capability are measured.
+ * All measurements are performed via the socket transport first and via the
+ * shared-memory transport second.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/ipc.h>
+#include <base/rpc_server.h>
+#include <base/rpc_client.h>
+#include <cap_session/connection.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+/***************
+ ** Interface **
+ ***************/
+
+namespace Test {
+
+	struct Bench
+	{
+		virtual ~Bench() { }
+
+		virtual void nop() = 0;
+
+		virtual long add(long a, long b) = 0;
+
+		virtual Native_capability cap(Native_capability cap) = 0;
+
+		GENODE_RPC(Rpc_nop, void, nop);
+		GENODE_RPC(Rpc_add, long, add, long, long);
+		GENODE_RPC(Rpc_cap, Native_capability, cap, Native_capability);
+		GENODE_RPC_INTERFACE(Rpc_nop, Rpc_add, Rpc_cap);
+	};
+
+
+	struct Bench_client : Rpc_client<Bench>
+	{
+		Bench_client(Capability<Bench> cap) : Rpc_client<Bench>(cap) { }
+
+		void nop() { call<Rpc_nop>(); }
+
+		long add(long a, long b) { return call<Rpc_add>(a, b); }
+
+		Native_capability cap(Native_capability cap) {
+			return call<Rpc_cap>(cap); }
+	};
+
+
+	struct Bench_component : Rpc_object<Bench, Bench_component>
+	{
+		void nop() { }
+
+		long add(long a, long b) { return a + b; }
+
+		Native_capability cap(Native_capability cap) { return cap; }
+	};
+}
+
+
+/**
+ * Execute 'fn' for the given number of rounds and print the call rate
+ */
+template <typename FUNC>
+static void measure(Timer::Session &timer, char const *name,
+                    unsigned long rounds, FUNC const &fn)
+{
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	for (unsigned long i = 0; i < rounds; i++)
+		fn(i);
+
+	unsigned long const duration_ms = timer.elapsed_ms() - start_ms;
+
+	printf("%-8s %lu calls in %lu ms -> %lu calls/s\n", name, rounds,
+	       duration_ms, duration_ms ? (rounds*1000)/duration_ms : 0);
+}
+
+
+struct Nop_call
+{
+	Test::Bench_client &client;
+
+	Nop_call(Test::Bench_client &client) : client(client) { }
+
+	void operator () (unsigned long) const { client.nop(); }
+};
+
+
+struct Add_call
+{
+	Test::Bench_client &client;
+
+	Add_call(Test::Bench_client &client) : client(client) { }
+
+	void operator () (unsigned long i) const
+	{
+		if (client.add(i, 1) != (long)i + 1)
+			PERR("unexpected result of add call");
+	}
+};
+
+
+struct Cap_call
+{
+	Test::Bench_client &client;
+	Native_capability   cap;
+
+	Cap_call(Test::Bench_client &client, Native_capability cap)
+	: client(client), cap(cap) { }
+
+	void operator () (unsigned long) const { client.cap(cap); }
+};
+
+
+int main(int argc, char **argv)
+{
+	printf("--- Linux RPC benchmark ---\n");
+
+	enum { STACK_SIZE = 8*1024, ROUNDS = 100*1000, CAP_ROUNDS = 10*1000 };
+
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "bench_ep");
+	static Timer::Connection timer;
+
+	static Test::Bench_component component;
+	Test::Bench_client client(ep.manage(&component));
+
+	printf("socket transport:\n");
+	measure(timer, "nop", ROUNDS,     Nop_call(client));
+	measure(timer, "add", ROUNDS,     Add_call(client));
+	measure(timer, "cap", CAP_ROUNDS, Cap_call(client, env()->ram_session_cap()));
+
+	ipc_enable_shm_fast_path();
+
+	printf("shared-memory transport:\n");
+	measure(timer, "nop", ROUNDS,     Nop_call(client));
+	measure(timer, "add", ROUNDS,     Add_call(client));
+	measure(timer, "cap", CAP_ROUNDS, Cap_call(client, env()->ram_session_cap()));
+
+	printf("--- finished Linux RPC benchmark ---\n");
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * \brief  Test for reclaiming the shared-memory channels of killed clients
+ * \author Genode Labs
+ * \date   2013-01-28
+ *
+ * The test serves an RPC object via the shared-memory transport. Forked
+ * client processes register a channel with the entrypoint and get killed
+ * while holding it. As the killed clients cannot release their channels,
+ * the entrypoint must detect their disappearance. Otherwise, the channels
+ * and their file descriptors leak and clients run out of channels after
+ * 'Ipc_shm_server_channels::MAX_CHANNELS' kills.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/ipc.h>
+#include <base/rpc_server.h>
+#include <base/rpc_client.h>
+#include <cap_session/connection.h>
+
+/* libc includes */
+#include <dirent.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Genode;
+
+
+namespace Test {
+
+	struct Adder
+	{
+		virtual ~Adder() { }
+
+		virtual long add(long a, long b) = 0;
+
+		GENODE_RPC(Rpc_add, long, add, long, long);
+		GENODE_RPC_INTERFACE(Rpc_add);
+	};
+
+
+	struct Adder_client : Rpc_client<Adder>
+	{
+		Adder_client(Capability<Adder> cap) : Rpc_client<Adder>(cap) { }
+
+		long add(long a, long b) { return call<Rpc_add>(a, b); }
+	};
+
+
+	struct Adder_component : Rpc_object<Adder, Adder_component>
+	{
+		long add(long a, long b) { return a + b; }
+	};
+}
+
+
+/**
+ * Return number of open file descriptors of the process
+ */
+static unsigned num_open_fds()
+{
+	DIR *dir = opendir("/proc/self/fd");
+	if (!dir)
+		return 0;
+
+	unsigned num = 0;
+	while (readdir(dir))
+		num++;
+
+	closedir(dir);
+	return num;
+}
+
+
+/**
+ * Start client that calls the entrypoint and wait until it got killed
+ *
+ * \return  false if the client did not get its calls answered
+ */
+static bool run_and_kill_client(Test::Adder_client &client)
+{
+	enum { CALLS = 4 };
+
+	int ready[2];
+	if (pipe(ready) < 0)
+		return false;
+
+	pid_t const pid = fork();
+	if (pid < 0)
+		return false;
+
+	if (pid == 0) {
+
+		/* the first call registers the channel, the others use it */
+		char result = 1;
+		for (long i = 0; i < CALLS; i++)
+			if (client.add(i, 1) != i + 1)
+				result = 0;
+
+		/* keep holding the channel until being killed */
+		if (write(ready[1], &result, 1) != 1)
+			_exit(1);
+		for (;;)
+			pause();
+	}
+
+	char result = 0;
+	bool const ok = read(ready[0], &result, 1) == 1 && result;
+
+	kill(pid, SIGKILL);
+	waitpid(pid, 0, 0);
+
+	close(ready[0]);
+	close(ready[1]);
+	return ok;
+}
+
+
+int main(int, char **)
+{
+	printf("--- shared-memory channel reclaim test ---\n");
+
+	enum {
+		STACK_SIZE  = 8*1024,
+		NUM_CLIENTS = 3*64,  /* exceeds the channels of an entrypoint */
+		MAX_LEAKED_FDS = 4,
+	};
+
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "reclaim_ep");
+
+	static Test::Adder_component component;
+	Test::Adder_client client(ep.manage(&component));
+
+	ipc_enable_shm_fast_path();
+
+	unsigned const fds_before = num_open_fds();
+
+	for (unsigned i = 0; i < NUM_CLIENTS; i++) {
+		if (!run_and_kill_client(client)) {
+			PERR("client %u did not get its calls answered", i);
+			return -1;
+		}
+	}
+
+	unsigned const fds_after = num_open_fds();
+
+	printf("%u clients killed, open file descriptors %u -> %u\n",
+	       (unsigned)NUM_CLIENTS, fds_before, fds_after);
+
+	if (fds_after > fds_before + MAX_LEAKED_FDS) {
+		PERR("channels of killed clients got not reclaimed");
+		return -1;
+	}
+
+	printf("--- finished shared-memory channel reclaim test ---\n");
+	return 0;
+}
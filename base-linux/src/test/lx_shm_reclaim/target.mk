@@ -0,0 +1,3 @@
+TARGET = test-lx_shm_reclaim
+SRC_CC = main.cc
+LIBS   = env cxx server lx_hybrid
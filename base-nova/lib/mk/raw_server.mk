@@ -1,4 +1,5 @@
-SRC_CC     = server.cc
+SRC_CC     = server.cc pool.cc
 INC_DIR    = $(REP_DIR)/src/platform
 
-vpath %.cc $(REP_DIR)/src/base/server
+vpath server.cc $(REP_DIR)/src/base/server
+vpath pool.cc   $(BASE_DIR)/src/base/server
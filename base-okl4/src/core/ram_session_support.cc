@@ -34,21 +34,27 @@ void Ram_session_component::_revoke_ram_ds(Dataspace_component *ds) { }
 
 void Ram_session_component::_clear_ds (Dataspace_component *ds)
 {
-	size_t page_rounded_size = (ds->size() + get_page_size() - 1) & get_page_mask();
+	clear_ram(ds->phys_addr(), ds->size());
+}
+
+
+bool Genode::clear_ram(addr_t phys_addr, size_t size)
+{
+	size_t page_rounded_size = (size + get_page_size() - 1) & get_page_mask();
 
 	/* allocate range in core's virtual address space */
 	void *virt_addr;
 	if (!platform()->region_alloc()->alloc(page_rounded_size, &virt_addr)) {
 		PERR("could not allocate virtual address range in core of size %zd\n",
 		     page_rounded_size);
-		return;
+		return false;
 	}
 
 	/* map the dataspace's physical pages to corresponding virtual addresses */
 	size_t num_pages = page_rounded_size >> get_page_size_log2();
-	if (!map_local(ds->phys_addr(), (addr_t)virt_addr, num_pages)) {
+	if (!map_local(phys_addr, (addr_t)virt_addr, num_pages)) {
 		PERR("core-local memory mapping failed, Error Code=%d\n", (int)Okl4::L4_ErrorCode());
-		return;
+		return false;
 	}
 
 	/* clear dataspace */
@@ -63,4 +69,5 @@ void Ram_session_component::_clear_ds (Dataspace_component *ds)
 
 	/* free core's virtual address space */
 	platform()->region_alloc()->free(virt_addr, page_rounded_size);
+	return true;
 }
@@ -23,5 +23,11 @@ void Ram_session_component::_revoke_ram_ds(Dataspace_component *ds) { }
 
 void Ram_session_component::_clear_ds(Dataspace_component *ds)
 {
-	memset((void *)ds->phys_addr(), 0, ds->size());
+	clear_ram(ds->phys_addr(), ds->size());
+}
+
+bool Genode::clear_ram(addr_t phys_addr, size_t size)
+{
+	memset((void *)phys_addr, 0, size);
+	return true;
 }
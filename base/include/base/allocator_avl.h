@@ -19,13 +19,14 @@
 #define _INCLUDE__BASE__ALLOCATOR_AVL_H_
 
 #include <base/allocator.h>
+#include <base/allocator_stats.h>
 #include <base/tslab.h>
 #include <util/avl_tree.h>
 #include <util/misc_math.h>
 
 namespace Genode {
 
-	class Allocator_avl_base : public Range_allocator
+	class Allocator_avl_base : public Range_allocator, public Allocator_stats
 	{
 		private:
 
@@ -123,6 +124,11 @@ namespace Genode {
 					 */
 					size_t avail_in_subtree(void);
 
+					/**
+					 * Return number of free blocks in subtree
+					 */
+					size_t free_blocks_in_subtree();
+
 					/**
 					 * Debug hooks
 					 */
@@ -188,6 +194,7 @@ namespace Genode {
 			 * we can attach custom information to block meta data.
 			 */
 			Allocator_avl_base(Allocator *md_alloc, size_t md_entry_size) :
+				Allocator_stats("avl"),
 				_md_alloc(md_alloc), _md_entry_size(md_entry_size) { }
 
 		public:
@@ -208,6 +215,19 @@ namespace Genode {
 			 */
 			void dump_addr_tree(Block *addr_node = 0);
 
+			/**
+			 * Return number of free blocks
+			 *
+			 * The number of free blocks is a measure of fragmentation.
+			 * Determining it requires a traversal of the whole tree.
+			 */
+			size_t num_free_blocks();
+
+			/**
+			 * Return size of largest free block
+			 */
+			size_t largest_free_block();
+
 
 			/*******************************
 			 ** Range allocator interface **
@@ -0,0 +1,177 @@
+/*
+ * \brief  Instrumentation of allocators
+ * \author Genode Labs
+ * \date   2013-03-04
+ *
+ * An allocator that inherits 'Allocator_stats' records a histogram of its
+ * allocation sizes, the number of live bytes and their peak, and the number
+ * of contended lock acquisitions. The statistics of all instrumented
+ * allocators can be written to the log or rendered as XML report.
+ *
+ * The statistics are recorded only if the framework is built with the
+ * 'alloc_stats' spec, which defines 'GENODE_ALLOC_STATS' for all
+ * components. Otherwise, 'Allocator_stats' is an empty class with empty
+ * inline functions, which adds neither memory nor code to an allocator.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _INCLUDE__BASE__ALLOCATOR_STATS_H_
+#define _INCLUDE__BASE__ALLOCATOR_STATS_H_
+
+#include <base/stdint.h>
+#include <base/lock.h>
+
+#ifdef GENODE_ALLOC_STATS
+#include <util/list.h>
+#endif
+
+namespace Genode {
+
+#ifdef GENODE_ALLOC_STATS
+
+	class Allocator_stats : public List<Allocator_stats>::Element
+	{
+		public:
+
+			/*
+			 * Bucket 'i' counts allocations of up to '2^(i + 4)' bytes,
+			 * the last bucket counts all larger allocations.
+			 */
+			enum { NUM_SIZE_BUCKETS = 16 };
+
+			/**
+			 * Lock guard that counts contended acquisitions
+			 */
+			class Guard
+			{
+				private:
+
+					Lock            &_lock;
+					Allocator_stats &_stats;
+
+				public:
+
+					Guard(Lock &lock, Allocator_stats &stats)
+					: _lock(lock), _stats(stats)
+					{
+						_stats._enter();
+						_lock.lock();
+					}
+
+					~Guard()
+					{
+						_lock.unlock();
+						_stats._leave();
+					}
+			};
+
+		private:
+
+			struct Counters
+			{
+				unsigned long histogram[NUM_SIZE_BUCKETS];
+				unsigned long allocs;
+				unsigned long frees;
+				unsigned long contended;
+				size_t        live;
+				size_t        peak;
+			};
+
+			char const   *_name;
+			Lock          _lock;        /* protects the counters      */
+			Counters      _counters;
+			volatile int  _lock_users;  /* threads holding or waiting */
+
+			void _enter();
+			void _leave();
+
+			/**
+			 * Print statistics into 'dst'
+			 *
+			 * \return  number of characters written
+			 */
+			size_t _report(char *dst, size_t dst_len);
+
+		protected:
+
+			/**
+			 * Determine fragmentation of free memory
+			 *
+			 * \return  false if the allocator does not track free blocks
+			 *
+			 * This function is called while dumping the statistics and must
+			 * acquire the locks needed for inspecting the allocator.
+			 */
+			virtual bool _fragmentation(size_t &free_blocks, size_t &largest) {
+				return false; }
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param name  type of allocator, used for labeling the output
+			 */
+			Allocator_stats(char const *name);
+
+			virtual ~Allocator_stats();
+
+			void record_alloc(size_t size);
+			void record_free(size_t size);
+
+			/**
+			 * Print statistics to the log
+			 */
+			void dump_stats();
+
+			/**
+			 * Print statistics of all instrumented allocators to the log
+			 */
+			static void dump_all();
+
+			/**
+			 * Render statistics of all instrumented allocators as XML
+			 *
+			 * \return  length of the report without the terminating zero
+			 *
+			 * The report is truncated if it does not fit into 'dst'.
+			 */
+			static size_t report_all(char *dst, size_t dst_len);
+	};
+
+#else /* GENODE_ALLOC_STATS */
+
+	class Allocator_stats
+	{
+		public:
+
+			struct Guard : Lock::Guard
+			{
+				Guard(Lock &lock, Allocator_stats &) : Lock::Guard(lock) { }
+			};
+
+			Allocator_stats(char const *) { }
+
+			void record_alloc(size_t) { }
+			void record_free(size_t)  { }
+			void dump_stats()         { }
+
+			static void dump_all() { }
+
+			static size_t report_all(char *dst, size_t dst_len)
+			{
+				if (dst_len) *dst = 0;
+				return 0;
+			}
+	};
+
+#endif /* GENODE_ALLOC_STATS */
+}
+
+#endif /* _INCLUDE__BASE__ALLOCATOR_STATS_H_ */
@@ -14,10 +14,13 @@
 #ifndef _INCLUDE__BASE__HEAP_H_
 #define _INCLUDE__BASE__HEAP_H_
 
+#include <util/avl_tree.h>
 #include <util/list.h>
 #include <ram_session/ram_session.h>
 #include <rm_session/rm_session.h>
 #include <base/allocator_avl.h>
+#include <base/allocator_stats.h>
+#include <base/slab.h>
 #include <base/lock.h>
 
 namespace Genode {
@@ -27,8 +30,20 @@ namespace Genode {
 	 *
 	 * The heap class provides an allocator that uses a list of dataspaces of a ram
 	 * session as backing store. One dataspace may be used for holding multiple blocks.
+	 *
+	 * Small blocks are served by a slab allocator per size class. Freed small
+	 * blocks are kept in magazines, from which subsequent allocations of the
+	 * same size class are satisfied without taking the heap lock and without
+	 * searching the AVL tree. The magazines form a fixed number of striped
+	 * caches, each protected by its own lock. Threads are spread over the
+	 * stripes by their identity, so threads that share a stripe still contend
+	 * for its lock. Larger blocks are allocated from the AVL allocator.
+	 *
+	 * Dataspaces that become completely unused are returned to the RAM session
+	 * once the unused dataspaces exceed the amount of memory in use. The
+	 * 'trim' function returns all unused memory immediately.
 	 */
-	class Heap : public Allocator
+	class Heap : public Allocator, public Allocator_stats
 	{
 		private:
 
@@ -37,15 +52,101 @@ namespace Genode {
 				MAX_CHUNK_SIZE = 1024*1024
 			};
 
-			class Dataspace : public List<Dataspace>::Element
+			enum {
+				NUM_SIZE_CLASSES  = 8,
+				SLAB_ENTRIES      = 16,  /* entries per slab block              */
+				MAGAZINE_SIZE     = 8,   /* cached blocks per size class        */
+				MAGAZINE_BATCH    = 4,   /* blocks moved between slab and cache */
+				NUM_CACHE_STRIPES = 4,
+			};
+
+			/*
+			 * Unused dataspaces are kept as long as they do not exceed
+			 * this threshold or the amount of memory in use.
+			 */
+			enum { TRIM_THRESHOLD = 64*1024 };
+
+			/**
+			 * Cached free blocks of one size class
+			 */
+			struct Magazine
+			{
+				unsigned  num;
+				void     *blocks[MAGAZINE_SIZE];
+
+				Magazine() : num(0) { }
+			};
+
+			/**
+			 * Cache stripe, magazines of all size classes shared by the
+			 * threads mapped to the stripe
+			 */
+			struct Cache
+			{
+				Lock     lock;
+				Magazine magazines[NUM_SIZE_CLASSES];
+			};
+
+			/**
+			 * Allocator for slab blocks, which are taken from the AVL allocator
+			 *
+			 * The heap lock must be held when calling this allocator.
+			 */
+			class Slab_backing_store : public Allocator
+			{
+				private:
+
+					Heap &_heap;
+
+				public:
+
+					Slab_backing_store(Heap &heap) : _heap(heap) { }
+
+					bool alloc(size_t size, void **out_addr) {
+						return _heap._unsynchronized_alloc(size, out_addr); }
+
+					void free(void *addr, size_t size) {
+						_heap._unsynchronized_free(addr, size); }
+
+					size_t consumed() { return 0; }
+					size_t overhead(size_t) { return 0; }
+					bool   need_size_for_free() const { return true; }
+			};
+
+			class Dataspace : public List<Dataspace>::Element,
+			                  public Avl_node<Dataspace>
 			{
 				public:
 
 					Ram_dataspace_capability cap;
 					void  *local_addr;
+					size_t size;
+					size_t used;  /* bytes allocated within the dataspace */
 
-					Dataspace(Ram_dataspace_capability c, void *a)
-					: cap(c), local_addr(a) {}
+					Dataspace(Ram_dataspace_capability c, void *a, size_t s)
+					: cap(c), local_addr(a), size(s), used(0) {}
+
+					bool contains(void const *addr) const {
+						return (addr_t)addr - (addr_t)local_addr < size; }
+
+					/**
+					 * AVL node comparison function, dataspaces are ordered
+					 * by their local address
+					 */
+					bool higher(Dataspace *ds) {
+						return (addr_t)ds->local_addr > (addr_t)local_addr; }
+
+					/**
+					 * Return dataspace of subtree that contains 'addr'
+					 */
+					Dataspace *find_by_address(void const *addr)
+					{
+						if (contains(addr))
+							return this;
+
+						Dataspace *ds = child((addr_t)addr > (addr_t)local_addr);
+						return ds ? ds->find_by_address(addr) : 0;
+					}
 
 					inline void * operator new(Genode::size_t, void* addr) {
 						return addr; }
@@ -56,8 +157,9 @@ namespace Genode {
 			{
 				private:
 
-					Ram_session *_ram_session;  /* ram session for backing store */
-					Rm_session  *_rm_session;   /* region manager                */
+					Ram_session         *_ram_session;  /* ram session for backing store */
+					Rm_session          *_rm_session;   /* region manager                */
+					Avl_tree<Dataspace>  _tree;         /* dataspaces by local address   */
 
 				public:
 
@@ -72,6 +174,23 @@ namespace Genode {
 					 */
 					~Dataspace_pool();
 
+					/*
+					 * Besides the list, the dataspaces are kept in a tree
+					 * for looking them up by address on each allocation.
+					 */
+
+					void insert(Dataspace *ds)
+					{
+						List<Dataspace>::insert(ds);
+						_tree.insert(ds);
+					}
+
+					void remove(Dataspace *ds)
+					{
+						List<Dataspace>::remove(ds);
+						_tree.remove(ds);
+					}
+
 					/**
 					 * Expand dataspace by specified size
 					 *
@@ -81,25 +200,121 @@ namespace Genode {
 					 *                  being successfully expanded).
 					 * \throw           Rm_session::Invalid_dataspace,
 					 *                  Rm_session::Region_conflict
-					 * \return          0 on success or negative error code
+					 * \return          new dataspace, or 0 on error
+					 *
+					 * The 'Dataspace' structure is preferably placed at the
+					 * beginning of the new dataspace.
+					 */
+					Dataspace *expand(size_t size, Range_allocator *alloc);
+
+					/**
+					 * Create 'Dataspace' structure for attached dataspace
+					 *
+					 * \return  'Dataspace' structure, or 0 if no meta data
+					 *          could be allocated
+					 */
+					Dataspace *add(Ram_dataspace_capability cap, void *local_addr,
+					               size_t size, Range_allocator *alloc);
+
+					/**
+					 * Allocate and attach dataspace without adding it to the pool
+					 *
+					 * \return  'Dataspace' structure placed at the beginning of
+					 *          the dataspace, or 0 on error
+					 */
+					Dataspace *attach(size_t size);
+
+					/**
+					 * Detach dataspace and return it to the RAM session
+					 */
+					void release(Ram_dataspace_capability cap, void *local_addr);
+
+					/**
+					 * Return dataspace that contains 'addr'
 					 */
-					int expand(size_t size, Range_allocator *alloc);
+					Dataspace *lookup(void const *addr);
 
 					void reassign_resources(Ram_session *ram, Rm_session *rm) {
 						_ram_session = ram, _rm_session = rm; }
 			};
 
+			/**
+			 * Allocator for meta data of the AVL allocator
+			 *
+			 * Meta-data blocks are kept in dedicated dataspaces. Otherwise,
+			 * they would be scattered over the dataspaces of the heap and
+			 * keep them from becoming unused. If no dedicated dataspace
+			 * can be obtained, the blocks are taken from the AVL allocator
+			 * itself.
+			 *
+			 * Dedicated dataspaces are used not before the heap is expanded
+			 * by a dataspace. Until then, meta data comes from the initial
+			 * memory of the heap, as for a heap that never grows.
+			 */
+			class Metadata_backing_store : public Allocator
+			{
+				private:
+
+					enum {
+						BLOCK_SIZE     = 256*sizeof(addr_t), /* of 'Allocator_avl' */
+						DATASPACE_SIZE = 16*1024
+					};
+
+					struct Block { Block *next; };
+
+					Heap            &_heap;
+					List<Dataspace>  _dataspaces;
+					Block           *_free;
+					bool             _enabled;  /* use dedicated dataspaces */
+
+					/**
+					 * Add dataspace with unused meta-data blocks
+					 */
+					bool _grow();
+
+				public:
+
+					Metadata_backing_store(Heap &heap)
+					: _heap(heap), _free(0), _enabled(false) { }
+
+					/**
+					 * Start using dedicated dataspaces for meta data
+					 */
+					void enable() { _enabled = true; }
+
+					~Metadata_backing_store();
+
+					bool alloc(size_t size, void **out_addr);
+					void free(void *addr, size_t size);
+
+					size_t consumed() { return 0; }
+					size_t overhead(size_t) { return 0; }
+					bool   need_size_for_free() const { return true; }
+			};
+
 			/*
 			 * NOTE: The order of the member variables is important for
 			 *       the calling order of the destructors!
 			 */
 
-			Lock           _lock;
-			Dataspace_pool _ds_pool;      /* list of dataspaces */
-			Allocator_avl  _alloc;        /* local allocator    */
-			size_t         _quota_limit;
-			size_t         _quota_used;
-			size_t         _chunk_size;
+			Lock                   _lock;
+			Dataspace_pool         _ds_pool;      /* list of dataspaces */
+			Metadata_backing_store _md_backing_store;
+			Allocator_avl          _alloc;        /* local allocator    */
+			size_t                 _quota_limit;
+			size_t                 _quota_used;
+			size_t                 _chunk_size;
+			size_t                 _attached;     /* size of all dataspaces    */
+			size_t                 _unused;       /* size of unused dataspaces */
+			size_t                 _returned;     /* size of freed dataspaces  */
+
+			/* dataspace range that must not receive new meta data */
+			addr_t _releasing_base;
+			size_t _releasing_size;
+
+			Slab_backing_store _slab_backing_store;
+			Slab              *_slabs[NUM_SIZE_CLASSES]; /* created on demand */
+			Cache              _cache_stripes[NUM_CACHE_STRIPES];
 
 			/**
 			 * Try to allocate block at our local allocator
@@ -111,25 +326,107 @@ namespace Genode {
 			 */
 			bool _try_local_alloc(size_t size, void **out_addr);
 
+			/**
+			 * Allocate block from the AVL allocator, expanding the heap if needed
+			 *
+			 * The heap lock must be held by the caller.
+			 */
+			bool _unsynchronized_alloc(size_t size, void **out_addr);
+
+			/**
+			 * Free block to the AVL allocator
+			 *
+			 * The heap lock must be held by the caller.
+			 */
+			void _unsynchronized_free(void *addr, size_t size);
+
+			/**
+			 * Account allocation or release of block to its dataspace
+			 */
+			void _account(void const *addr, size_t size, bool alloc);
+
+			bool _alloc_metadata(size_t size, void **out_addr);
+			void _free_metadata(void *addr, size_t size);
+
+			/**
+			 * Return unused dataspace to the RAM session
+			 *
+			 * \return  false if the dataspace could not be removed from the
+			 *          AVL allocator
+			 */
+			bool _release(Dataspace *ds);
+
+			/**
+			 * Release unused dataspaces until at most 'keep' bytes are unused
+			 */
+			void _release_unused(size_t keep);
+
+			/**
+			 * Return slab allocator of size class, create it if needed
+			 *
+			 * The heap lock must be held by the caller.
+			 *
+			 * \return  slab allocator, or 0 if no backing store is available
+			 */
+			Slab *_slab(unsigned size_class);
+
+			/**
+			 * Return cache stripe of the calling thread
+			 */
+			Cache &_cache_stripe();
+
+			bool _alloc_small(unsigned size_class, void **out_addr);
+			void _free_small(unsigned size_class, void *addr);
+
+#ifdef GENODE_ALLOC_STATS
+			/**
+			 * Allocator_stats interface
+			 */
+			bool _fragmentation(size_t &free_blocks, size_t &largest);
+#endif
+
 		public:
 
 			enum { UNLIMITED = ~0 };
 
+			/**
+			 * Memory statistics
+			 */
+			struct Stats
+			{
+				size_t in_use;    /* bytes allocated from the heap          */
+				size_t cached;    /* attached bytes not allocated           */
+				size_t returned;  /* bytes given back to the RAM session    */
+			};
+
 			Heap(Ram_session *ram_session,
 			     Rm_session  *rm_session,
 			     size_t       quota_limit = UNLIMITED,
 			     void        *static_addr = 0,
 			     size_t       static_size = 0)
 			:
+				Allocator_stats("heap"),
 				_ds_pool(ram_session, rm_session),
-				_alloc(0),
+				_md_backing_store(*this),
+				_alloc(&_md_backing_store),
 				_quota_limit(quota_limit), _quota_used(0),
-				_chunk_size(MIN_CHUNK_SIZE)
+				_chunk_size(MIN_CHUNK_SIZE),
+				_attached(0), _unused(0), _returned(0),
+				_releasing_base(0), _releasing_size(0),
+				_slab_backing_store(*this)
 			{
+				for (unsigned i = 0; i < NUM_SIZE_CLASSES; i++)
+					_slabs[i] = 0;
+
 				if (static_addr)
 					_alloc.add_range((addr_t)static_addr, static_size);
 			}
 
+			/**
+			 * Destructor
+			 */
+			~Heap();
+
 			/**
 			 * Reconfigure quota limit
 			 *
@@ -144,6 +441,22 @@ namespace Genode {
 			void reassign_resources(Ram_session *ram, Rm_session *rm) {
 				_ds_pool.reassign_resources(ram, rm); }
 
+			/**
+			 * Return all unused memory to the RAM session
+			 *
+			 * Cached blocks of the size classes are given back to their slab
+			 * allocators, unused slab blocks are freed, and all dataspaces
+			 * without allocated blocks are detached and freed.
+			 *
+			 * \return  number of bytes returned to the RAM session
+			 */
+			size_t trim();
+
+			/**
+			 * Return memory statistics
+			 */
+			Stats stats();
+
 
 			/*************************
 			 ** Allocator interface **
@@ -152,18 +465,24 @@ namespace Genode {
 			bool   alloc(size_t, void **);
 			void   free(void *, size_t);
 			size_t consumed() { return _quota_used; }
-			size_t overhead(size_t size) { return _alloc.overhead(size); }
+			size_t overhead(size_t size);
 			bool   need_size_for_free() const { return false; }
 	};
 
 
 	/**
 	 * Heap that allocates each block at a separate dataspace
+	 *
+	 * Optionally, the dataspaces of freed blocks are kept attached and are
+	 * reused for subsequent allocations of the same size, which saves the
+	 * interaction with the RAM session and the RM session.
 	 */
-	class Sliced_heap : public Allocator
+	class Sliced_heap : public Allocator, public Allocator_stats
 	{
 		private:
 
+			enum { MAX_CACHED_PAGES = 8 };  /* largest cached dataspace */
+
 			class Block;
 
 			Ram_session    *_ram_session;  /* ram session for backing store */
@@ -172,18 +491,43 @@ namespace Genode {
 			List<Block>     _block_list;   /* list of allocated blocks      */
 			Lock            _lock;         /* serialize allocations         */
 
+			List<Block>     _cache[MAX_CACHED_PAGES]; /* by number of pages */
+			size_t const    _cache_limit;
+			size_t          _cached;       /* size of cached dataspaces     */
+
+			/**
+			 * Detach dataspace of block and free it
+			 */
+			void _release(Block *b);
+
 		public:
 
 			/**
 			 * Constructor
+			 *
+			 * \param cache_limit  maximum number of bytes kept in
+			 *                     dataspaces of freed blocks
+			 *
+			 * The cached dataspaces remain accounted to the RAM session.
+			 * A server that uses the sliced heap as meta-data allocator
+			 * for its sessions must therefore possess 'cache_limit' bytes
+			 * of quota in addition to the quota donated by its clients.
 			 */
-			Sliced_heap(Ram_session *ram_session, Rm_session *rm_session);
+			Sliced_heap(Ram_session *ram_session, Rm_session *rm_session,
+			            size_t cache_limit = 0);
 
 			/**
 			 * Destructor
 			 */
 			~Sliced_heap();
 
+			/**
+			 * Free all cached dataspaces
+			 *
+			 * \return  number of bytes returned to the RAM session
+			 */
+			size_t trim();
+
 
 			/*************************
 			 ** Allocator interface **
@@ -555,6 +555,17 @@ namespace Genode {
 			 */
 			Ipc_server(Msgbuf_base *snd_msg, Msgbuf_base *rcv_msg);
 
+			/**
+			 * Constructor for an additional activation of 'server'
+			 *
+			 * The new 'Ipc_server' receives the requests addressed to the
+			 * capability of 'server'. This constructor is implemented only
+			 * on platforms where multiple threads can receive requests via
+			 * the same capability (see 'Rpc_entrypoint_pool').
+			 */
+			Ipc_server(Msgbuf_base *snd_msg, Msgbuf_base *rcv_msg,
+			           Ipc_server &server);
+
 			/**
 			 * Set return value of server call
 			 */
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2012 Genode Labs GmbH
+ * Copyright (C) 2006-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -82,21 +82,47 @@ namespace Genode {
 
 		private:
 
-			Avl_tree<Entry> _tree;
-			Lock            _lock;
+			/*
+			 * The objects are distributed over several trees, each protected
+			 * by a lock of its own. So lookups performed concurrently by
+			 * multiple threads, e.g., the threads of an entrypoint pool,
+			 * contend for the same lock only if the objects happen to reside
+			 * in the same bucket.
+			 *
+			 * Lookups are not lock-free on purpose. The owner of an object
+			 * destructs it right after calling 'remove'. A lookup that walks
+			 * a tree without the lock could hence touch freed memory unless
+			 * 'remove' waited for a grace period of all readers. Such a
+			 * scheme would require each lookup to announce itself, which
+			 * costs about as much as taking an uncontended bucket lock.
+			 */
+			enum { NUM_BUCKETS = 16 };
+
+			struct Bucket
+			{
+				Avl_tree<Entry> tree;
+				Lock            lock;
+			};
+
+			Bucket _buckets[NUM_BUCKETS];
+
+			Bucket &_bucket(long obj_id) {
+				return _buckets[(unsigned long)obj_id % NUM_BUCKETS]; }
 
 		public:
 
 			void insert(OBJ_TYPE *obj)
 			{
-				Lock::Guard lock_guard(_lock);
-				_tree.insert(obj);
+				Bucket &bucket = _bucket(obj->_obj_id());
+				Lock::Guard lock_guard(bucket.lock);
+				bucket.tree.insert(obj);
 			}
 
 			void remove(OBJ_TYPE *obj)
 			{
-				Lock::Guard lock_guard(_lock);
-				_tree.remove(obj);
+				Bucket &bucket = _bucket(obj->_obj_id());
+				Lock::Guard lock_guard(bucket.lock);
+				bucket.tree.remove(obj);
 			}
 
 			/**
@@ -104,8 +130,9 @@ namespace Genode {
 			 */
 			OBJ_TYPE *obj_by_id(long obj_id)
 			{
-				Lock::Guard lock_guard(_lock);
-				Entry *obj = _tree.first();
+				Bucket &bucket = _bucket(obj_id);
+				Lock::Guard lock_guard(bucket.lock);
+				Entry *obj = bucket.tree.first();
 				return (OBJ_TYPE *)(obj ? obj->find_by_obj_id(obj_id) : 0);
 			}
 
@@ -121,8 +148,12 @@ namespace Genode {
 			 */
 			OBJ_TYPE *first()
 			{
-				Lock::Guard lock_guard(_lock);
-				return (OBJ_TYPE *)_tree.first();
+				for (unsigned i = 0; i < NUM_BUCKETS; i++) {
+					Lock::Guard lock_guard(_buckets[i].lock);
+					if (Entry *obj = _buckets[i].tree.first())
+						return (OBJ_TYPE *)obj;
+				}
+				return 0;
 			}
 	};
 }
@@ -310,13 +310,22 @@ namespace Genode {
 			/**
 			 * Force activation to cancel dispatching the specified server object
 			 */
-			void _leave_server_object(Rpc_object_base *obj);
+			virtual void _leave_server_object(Rpc_object_base *obj);
 
 			/**
 			 * Wait until the entrypoint activation is initialized
 			 */
 			void _block_until_cap_valid();
 
+			/**
+			 * Return IPC server of the activation that executes the caller
+			 *
+			 * If called by a thread other than an activation of the
+			 * entrypoint, the IPC server of the entrypoint thread is
+			 * returned.
+			 */
+			virtual Ipc_server *_current_ipc_server() { return _ipc_server; }
+
 			/**
 			 * Thread interface
 			 */
@@ -405,6 +414,84 @@ namespace Genode {
 			 */
 			bool is_myself() const;
 	};
+
+
+	/**
+	 * RPC entrypoint served by a pool of threads
+	 *
+	 * In addition to the entrypoint thread, a number of worker threads wait
+	 * for requests addressed to the entrypoint's capability. Requests for
+	 * different RPC objects are dispatched concurrently. Requests for the
+	 * same RPC object are serialized by the object's dispatch lock.
+	 *
+	 * Worker threads are supported only on platforms where multiple threads
+	 * can receive requests via the same capability. On all other platforms,
+	 * the pool consists of the entrypoint thread only.
+	 */
+	class Rpc_entrypoint_pool : public Rpc_entrypoint
+	{
+		private:
+
+			class Worker;
+
+			enum { MAX_WORKERS = 16 };
+
+			Worker  *_workers[MAX_WORKERS];
+			unsigned _num_workers;
+
+			struct Worker_exit
+			{
+				GENODE_RPC(Rpc_exit, void, _exit);
+				GENODE_RPC_INTERFACE(Rpc_exit);
+			};
+
+			struct Worker_exit_handler : Rpc_object<Worker_exit, Worker_exit_handler>
+			{
+				Rpc_entrypoint_pool &pool;
+
+				Worker_exit_handler(Rpc_entrypoint_pool &pool) : pool(pool) { }
+
+				void _exit();
+			};
+
+			Worker_exit_handler     _worker_exit_handler;
+			Capability<Worker_exit> _worker_exit_cap;
+
+		protected:
+
+			void _leave_server_object(Rpc_object_base *obj);
+
+			Ipc_server *_current_ipc_server();
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param cap_session  'Cap_session' for creating capabilities
+			 *                     for the RPC objects managed by this entry
+			 *                     point
+			 * \param stack_size   stack size of each thread
+			 * \param name         name of entrypoint thread
+			 * \param num_threads  number of threads including the
+			 *                     entrypoint thread
+			 */
+			Rpc_entrypoint_pool(Cap_session *cap_session, size_t stack_size,
+			                    char const *name, unsigned num_threads,
+			                    bool start_on_construction = true);
+
+			~Rpc_entrypoint_pool();
+
+			/**
+			 * Activate entrypoint, start processing RPC requests by all threads
+			 */
+			void activate();
+
+			/**
+			 * Return number of threads serving the entrypoint
+			 */
+			unsigned num_threads() const { return _num_workers + 1; }
+	};
 }
 
 #endif /* _INCLUDE__BASE__RPC_SERVER_H_ */
@@ -18,6 +18,7 @@
 #define _INCLUDE__BASE__SIGNAL_H__
 
 #include <base/semaphore.h>
+#include <util/fifo.h>
 #include <signal_session/signal_session.h>
 
 namespace Genode {
@@ -50,6 +51,7 @@ namespace Genode {
 
 			friend class Signal_receiver;
 			friend class Signal_context;
+			friend class Signal_transmitter;
 
 			Signal_context *_context;
 			int             _num;
@@ -95,6 +97,29 @@ namespace Genode {
 	 */
 	class Signal_context
 	{
+		public:
+
+			/**
+			 * Signal statistics of a context
+			 *
+			 * The difference of 'submitted' and 'coalesced' corresponds to
+			 * the number of signals delivered or pending.
+			 *
+			 * Local submissions coalesce at the receiver while the context
+			 * is pending. Submissions from other processes go through core,
+			 * which merges them while the context is queued at the signal
+			 * source of the receiving process. Both count as 'coalesced'.
+			 */
+			struct Stats
+			{
+				unsigned long submitted;  /* notifications received         */
+				unsigned long coalesced;  /* merged into a pending signal    */
+				unsigned long delivered;  /* signals picked up by receiver   */
+				unsigned long local;      /* submitted without involving core */
+
+				Stats() : submitted(0), coalesced(0), delivered(0), local(0) { }
+			};
+
 		private:
 
 			/**
@@ -107,6 +132,16 @@ namespace Genode {
 			 */
 			List_element<Signal_context> _registry_le;
 
+			/**
+			 * Element in the receiver's queue of pending contexts
+			 */
+			Fifo_element<Signal_context> _pending_fe;
+
+			/**
+			 * List element in process-global registry, indexed by capability
+			 */
+			List_element<Signal_context> _cap_le;
+
 			/**
 			 * Receiver to which the context is associated with
 			 *
@@ -118,6 +153,7 @@ namespace Genode {
 			Lock   _lock;          /* protect '_curr_signal'         */
 			Signal _curr_signal;   /* most-currently received signal */
 			bool   _pending;       /* current signal is valid        */
+			Stats  _stats;
 
 			/**
 			 * Capability assigned to this context after being assocated with
@@ -129,6 +165,7 @@ namespace Genode {
 
 			friend class Signal_receiver;
 			friend class Signal_context_registry;
+			friend class Signal_transmitter;
 
 		public:
 
@@ -136,8 +173,8 @@ namespace Genode {
 			 * Constructor
 			 */
 			Signal_context()
-			: _receiver_le(this), _registry_le(this),
-			  _receiver(0), _pending(0) { }
+			: _receiver_le(this), _registry_le(this), _pending_fe(this),
+			  _cap_le(this), _receiver(0), _pending(0) { }
 
 			/**
 			 * Destructor
@@ -148,6 +185,11 @@ namespace Genode {
 			 */
 			virtual ~Signal_context() { }
 
+			/**
+			 * Return signal statistics
+			 */
+			Stats stats();
+
 			/*
 			 * Signal contexts are never invoked but only used as arguments for
 			 * 'Signal_session' functions. Hence, there exists a capability
@@ -190,6 +232,11 @@ namespace Genode {
 			 * Trigger signal submission to context
 			 *
 			 * \param cnt  number of signals to submit at once
+			 *
+			 * If the context is managed by a receiver of the same process,
+			 * the signal is delivered directly without a call to core.
+			 * While the context has an undelivered signal, the submission
+			 * merely increments the counter of the pending signal.
 			 */
 			void submit(int cnt = 1);
 	};
@@ -210,6 +257,16 @@ namespace Genode {
 			Lock                                _contexts_lock;
 			List<List_element<Signal_context> > _contexts;
 
+			/**
+			 * Queue of contexts with pending signals
+			 *
+			 * A context is enqueued by 'local_submit' when it becomes
+			 * pending, which lets 'wait_for_signal' pick up the signal
+			 * without looking at the other contexts.
+			 */
+			Lock                                _pending_lock;
+			Fifo<Fifo_element<Signal_context> > _pending_contexts;
+
 			/**
 			 * Helper to dissolve given context
 			 *
@@ -268,6 +325,18 @@ namespace Genode {
 			 */
 			Signal wait_for_signal();
 
+			/**
+			 * Block until signals are received and return all of them
+			 *
+			 * \param out  array for storing the signals, one per context
+			 * \param max  capacity of 'out'
+			 * \return     number of signals stored at 'out'
+			 *
+			 * In contrast to calling 'wait_for_signal' repeatedly, the
+			 * signals of all pending contexts are picked up at once.
+			 */
+			unsigned wait_for_signals(Signal *out, unsigned max);
+
 			/**
 			 * Locally submit signal to the receiver
 			 */
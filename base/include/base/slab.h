@@ -15,6 +15,7 @@
 #define _INCLUDE__BASE__SLAB_H_
 
 #include <base/allocator.h>
+#include <base/allocator_stats.h>
 #include <base/stdint.h>
 
 namespace Genode {
@@ -89,6 +90,11 @@ namespace Genode {
 			 */
 			void slab(Slab *slab);
 
+			/**
+			 * Return slab allocator that manages the block
+			 */
+			Slab *slab() const { return _slab; }
+
 			/**
 			 * Request number of available entries in block
 			 */
@@ -147,6 +153,11 @@ namespace Genode {
 
 			void *addr() { return _data; }
 
+			/**
+			 * Return slab block of a used entry
+			 */
+			Slab_block *slab_block() const { return _sb; }
+
 			/**
 			 * Lookup Slab_entry by given address
 			 *
@@ -160,7 +171,7 @@ namespace Genode {
 	/**
 	 * Slab allocator
 	 */
-	class Slab : public Allocator
+	class Slab : public Allocator, public Allocator_stats
 	{
 		private:
 
@@ -231,6 +242,14 @@ namespace Genode {
 			 */
 			void *first_used_elem();
 
+			/**
+			 * Free completely unused slab blocks to the backing store
+			 *
+			 * The initial slab block is retained, as is one block if all
+			 * blocks are unused.
+			 */
+			void free_empty_blocks();
+
 			/**
 			 * Return true if number of free slab entries is higher than n
 			 */
@@ -145,6 +145,27 @@ namespace Genode {
 				return result;
 			}
 	};
+
+
+	/**
+	 * Helper for using member variables as FIFO elements
+	 *
+	 * \param T  type of compound object to be organized in a FIFO
+	 *
+	 * This helper allows the creation of FIFO queues of objects that are
+	 * also organized in other lists or queues.
+	 */
+	template <typename T>
+	class Fifo_element : public Fifo<Fifo_element<T> >::Element
+	{
+		T *_object;
+
+		public:
+
+			Fifo_element(T *object) : _object(object) { }
+
+			T *object() { return _object; }
+	};
 }
 
 #endif /* _INCLUDE__UTIL__FIFO_H_ */
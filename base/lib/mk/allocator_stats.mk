@@ -0,0 +1,3 @@
+SRC_CC = allocator_stats.cc
+
+vpath % $(REP_DIR)/src/base/allocator
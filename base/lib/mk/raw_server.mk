@@ -1,3 +1,3 @@
-SRC_CC   = server.cc common.cc
+SRC_CC   = server.cc common.cc pool.cc
 
 vpath %.cc $(REP_DIR)/src/base/server
@@ -1,3 +1,4 @@
 SRC_CC = slab.cc
+LIBS   = allocator_stats
 
 vpath % $(REP_DIR)/src/base/allocator
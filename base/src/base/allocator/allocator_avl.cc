@@ -88,6 +88,18 @@ size_t Allocator_avl_base::Block::avail_in_subtree(void)
 }
 
 
+size_t Allocator_avl_base::Block::free_blocks_in_subtree()
+{
+	size_t ret = avail() ? 1 : 0;
+
+	for (int i = 0; i < 2; i++)
+		if (child(i))
+			ret += child(i)->free_blocks_in_subtree();
+
+	return ret;
+}
+
+
 void Allocator_avl_base::Block::recompute()
 {
 	_max_avail = max(_child_max_avail(0), _child_max_avail(1));
@@ -276,6 +288,7 @@ Range_allocator::Alloc_return Allocator_avl_base::alloc_aligned(size_t size, voi
 		return Alloc_return(Alloc_return::OUT_OF_METADATA);
 	}
 	_add_block(new_block, new_addr, size, Block::USED);
+	record_alloc(size);
 
 	*out_addr = reinterpret_cast<void *>(new_addr);
 	return Alloc_return(Alloc_return::OK);
@@ -314,6 +327,7 @@ Range_allocator::Alloc_return Allocator_avl_base::alloc_addr(size_t size, addr_t
 		return Alloc_return(Alloc_return::OUT_OF_METADATA);
 	}
 	_add_block(new_block, addr, size, Block::USED);
+	record_alloc(size);
 
 	return Alloc_return(Alloc_return::OK);
 }
@@ -334,6 +348,7 @@ void Allocator_avl_base::free(void *addr)
 		     __PRETTY_FUNCTION__, addr, new_addr);
 
 	_destroy_block(b);
+	record_free(new_size);
 
 	add_range(new_addr, new_size);
 }
@@ -355,6 +370,20 @@ size_t Allocator_avl_base::avail()
 }
 
 
+size_t Allocator_avl_base::num_free_blocks()
+{
+	Block *b = _addr_tree.first();
+	return b ? b->free_blocks_in_subtree() : 0;
+}
+
+
+size_t Allocator_avl_base::largest_free_block()
+{
+	Block *b = _addr_tree.first();
+	return b ? b->max_avail() : 0;
+}
+
+
 bool Allocator_avl_base::valid_addr(addr_t addr)
 {
 	Block *b = _find_by_address(addr);
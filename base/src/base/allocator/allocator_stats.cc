@@ -0,0 +1,182 @@
+/*
+ * \brief  Instrumentation of allocators
+ * \author Genode Labs
+ * \date   2013-03-04
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifdef GENODE_ALLOC_STATS
+
+#include <base/allocator_stats.h>
+#include <base/printf.h>
+#include <base/snprintf.h>
+#include <util/string.h>
+#include <cpu/atomic.h>
+
+using namespace Genode;
+
+
+/**
+ * Registry of all instrumented allocators
+ */
+static List<Allocator_stats> *registry()
+{
+	static List<Allocator_stats> inst;
+	return &inst;
+}
+
+
+static Lock *registry_lock()
+{
+	static Lock inst;
+	return &inst;
+}
+
+
+static size_t bucket_limit(unsigned i) { return (size_t)16 << i; }
+
+
+Allocator_stats::Allocator_stats(char const *name)
+:
+	_name(name), _lock_users(0)
+{
+	memset(&_counters, 0, sizeof(_counters));
+
+	Lock::Guard lock_guard(*registry_lock());
+	registry()->insert(this);
+}
+
+
+Allocator_stats::~Allocator_stats()
+{
+	Lock::Guard lock_guard(*registry_lock());
+	registry()->remove(this);
+}
+
+
+void Allocator_stats::_enter()
+{
+	int users;
+	do { users = _lock_users; }
+	while (!cmpxchg(&_lock_users, users, users + 1));
+
+	if (!users)
+		return;
+
+	Lock::Guard lock_guard(_lock);
+	_counters.contended++;
+}
+
+
+void Allocator_stats::_leave()
+{
+	int users;
+	do { users = _lock_users; }
+	while (!cmpxchg(&_lock_users, users, users - 1));
+}
+
+
+void Allocator_stats::record_alloc(size_t size)
+{
+	unsigned i = 0;
+	for (; i + 1 < NUM_SIZE_BUCKETS && size > bucket_limit(i); i++);
+
+	Lock::Guard lock_guard(_lock);
+
+	_counters.histogram[i]++;
+	_counters.allocs++;
+	_counters.live += size;
+	_counters.peak  = max(_counters.peak, _counters.live);
+}
+
+
+void Allocator_stats::record_free(size_t size)
+{
+	Lock::Guard lock_guard(_lock);
+
+	_counters.frees++;
+	_counters.live -= min(size, _counters.live);
+}
+
+
+size_t Allocator_stats::_report(char *dst, size_t dst_len)
+{
+	/*
+	 * The counters are copied before inspecting the fragmentation because
+	 * the allocator records its operations while holding its own lock.
+	 */
+	Counters c;
+	{
+		Lock::Guard lock_guard(_lock);
+		c = _counters;
+	}
+
+	size_t free_blocks = 0, largest = 0;
+	bool const fragmentation = _fragmentation(free_blocks, largest);
+
+	size_t len = 0;
+
+	len += snprintf(dst + len, dst_len - len,
+	                "<%s addr=\"%p\" allocs=\"%lu\" frees=\"%lu\" "
+	                "live=\"%zd\" peak=\"%zd\" contended=\"%lu\"",
+	                _name, this, c.allocs, c.frees, c.live, c.peak, c.contended);
+
+	if (fragmentation)
+		len += snprintf(dst + len, dst_len - len,
+		                " free_blocks=\"%zd\" largest_free=\"%zd\"",
+		                free_blocks, largest);
+
+	len += snprintf(dst + len, dst_len - len, ">\n");
+
+	/* the last bucket has no upper limit, which is denoted as zero */
+	for (unsigned i = 0; i < NUM_SIZE_BUCKETS; i++)
+		if (c.histogram[i])
+			len += snprintf(dst + len, dst_len - len,
+			                "\t<sizes max=\"%zd\" count=\"%lu\"/>\n",
+			                i + 1 < NUM_SIZE_BUCKETS ? bucket_limit(i) : 0,
+			                c.histogram[i]);
+
+	len += snprintf(dst + len, dst_len - len, "</%s>\n", _name);
+	return len;
+}
+
+
+void Allocator_stats::dump_stats()
+{
+	char buf[1024];
+	_report(buf, sizeof(buf));
+	printf("%s", buf);
+}
+
+
+void Allocator_stats::dump_all()
+{
+	Lock::Guard lock_guard(*registry_lock());
+
+	for (Allocator_stats *a = registry()->first(); a; a = a->next())
+		a->dump_stats();
+}
+
+
+size_t Allocator_stats::report_all(char *dst, size_t dst_len)
+{
+	if (!dst_len)
+		return 0;
+
+	Lock::Guard lock_guard(*registry_lock());
+
+	size_t len = snprintf(dst, dst_len, "<allocators>\n");
+
+	for (Allocator_stats *a = registry()->first(); a; a = a->next())
+		len += a->_report(dst + len, dst_len - len);
+
+	return len + snprintf(dst + len, dst_len - len, "</allocators>\n");
+}
+
+#endif /* GENODE_ALLOC_STATS */
@@ -85,6 +85,8 @@ void Slab_block::inc_avail(Slab_entry *e)
 	state(idx, FREE);
 	_avail++;
 
+	_slab->record_free(_slab->slab_size());
+
 	/* search previous block with higher avail value than this' */
 	Slab_block *at = prev;
 
@@ -127,7 +129,8 @@ void Slab_block::dec_avail()
 
 Slab::Slab(size_t slab_size, size_t block_size, Slab_block *initial_sb,
                                                 Allocator *backing_store)
-: _slab_size(slab_size),
+: Allocator_stats("slab"),
+  _slab_size(slab_size),
   _block_size(block_size),
   _first_sb(initial_sb),
   _initial_sb(initial_sb),
@@ -213,6 +216,25 @@ void Slab::insert_sb(Slab_block *sb, Slab_block *at)
 }
 
 
+void Slab::free_empty_blocks()
+{
+	if (!_backing_store)
+		return;
+
+	for (Slab_block *sb = _first_sb; sb; ) {
+
+		Slab_block *next = sb->next;
+
+		if (sb->avail() == _num_elem && sb != _initial_sb
+		 && (sb->prev || sb->next)) {
+			remove_sb(sb);
+			_backing_store->free(sb, _block_size);
+		}
+		sb = next;
+	}
+}
+
+
 bool Slab::num_free_entries_higher_than(int n)
 {
 	int cnt = 0;
@@ -257,7 +279,11 @@ bool Slab::alloc(size_t size, void **out_addr)
 	}
 
 	*out_addr = _first_sb->alloc();
-	return *out_addr == 0 ? false : true;
+	if (!*out_addr)
+		return false;
+
+	record_alloc(_slab_size);
+	return true;
 }
 
 
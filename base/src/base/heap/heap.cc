@@ -16,10 +16,52 @@
 #include <rm_session/rm_session.h>
 #include <base/heap.h>
 #include <base/lock.h>
+#include <base/thread.h>
 
 using namespace Genode;
 
 
+inline void *operator new(size_t, void *at) { return at; }
+
+
+/*
+ * Blocks of a size class are slab entries, which are preceded by the pointer
+ * to their slab block. Blocks of the AVL allocator are preceded by a header
+ * word that holds the size of the block including the header, shifted by one
+ * bit with the lowest bit set. Because slab blocks are word-aligned, the
+ * lowest bit of the word in front of a block tells both kinds apart without
+ * taking the heap lock.
+ */
+enum { HEADER_SIZE = sizeof(umword_t) };
+
+static umword_t *header(void *addr) { return (umword_t *)addr - 1; }
+
+static bool   header_large(umword_t h) { return h & 1; }
+static size_t header_size(umword_t h)  { return h >> 1; }
+
+
+/**
+ * Usable sizes of the size classes
+ */
+static size_t const class_sizes[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+
+
+/**
+ * Return size class for a block of 'size' bytes
+ *
+ * \return  size class, or the number of size classes if the block is too
+ *          large for the size classes
+ */
+static unsigned size_class(size_t size)
+{
+	unsigned const num = sizeof(class_sizes)/sizeof(class_sizes[0]);
+
+	unsigned i = 0;
+	for (; i < num && class_sizes[i] < size; i++);
+	return i;
+}
+
+
 Heap::Dataspace_pool::~Dataspace_pool()
 {
 	/* free all ram_dataspaces */
@@ -41,36 +83,167 @@ Heap::Dataspace_pool::~Dataspace_pool()
 }
 
 
-int Heap::Dataspace_pool::expand(size_t size, Range_allocator *alloc)
+Heap::Dataspace *Heap::Dataspace_pool::expand(size_t size, Range_allocator *alloc)
 {
 	Ram_dataspace_capability new_ds_cap;
-	void *local_addr, *ds_addr = 0;
+	void *local_addr;
 
 	/* make new ram dataspace available at our local address space */
 	try {
 		new_ds_cap = _ram_session->alloc(size);
 		local_addr = _rm_session->attach(new_ds_cap);
 	} catch (Ram_session::Alloc_failed) {
-		return -2;
+		return 0;
 	} catch (Rm_session::Attach_failed) {
 		_ram_session->free(new_ds_cap);
-		return -3;
+		return 0;
 	}
 
 	/* add new local address range to our local allocator */
 	alloc->add_range((addr_t)local_addr, size);
 
 	/* now that we have new backing store, allocate Dataspace structure */
-	if (alloc->alloc_aligned(sizeof(Dataspace), &ds_addr, 2).is_error()) {
+	Dataspace *ds = add(new_ds_cap, local_addr, size, alloc);
+	if (!ds)
 		PWRN("could not allocate meta data - this should never happen");
-		return -1;
-	}
+
+	return ds;
+}
+
+
+Heap::Dataspace *Heap::Dataspace_pool::add(Ram_dataspace_capability cap,
+                                           void *local_addr, size_t size,
+                                           Range_allocator *alloc)
+{
+	/*
+	 * Allocating the 'Dataspace' structure may allocate meta data within
+	 * the dataspace. Hence, the dataspace must already be known while
+	 * allocating its structure.
+	 */
+	Dataspace tmp(cap, local_addr, size);
+	insert(&tmp);
+
+	/*
+	 * Placing the 'Dataspace' structure inside the dataspace lets the
+	 * dataspace become unused independent of other dataspaces.
+	 */
+	void *ds_addr = local_addr;
+	bool const ok = alloc->alloc_addr(sizeof(Dataspace), (addr_t)local_addr).is_ok()
+	             || alloc->alloc_aligned(sizeof(Dataspace), &ds_addr, 2).is_ok();
+
+	remove(&tmp);
+	if (!ok)
+		return 0;
 
 	/* add dataspace information to list of dataspaces */
-	Dataspace *ds  = new (ds_addr) Dataspace(new_ds_cap, local_addr);
+	Dataspace *ds = new (ds_addr) Dataspace(cap, local_addr, size);
+	ds->used = tmp.used;
 	insert(ds);
 
-	return 0;
+	return ds;
+}
+
+
+Heap::Dataspace *Heap::Dataspace_pool::attach(size_t size)
+{
+	Ram_dataspace_capability ds_cap;
+	void *local_addr;
+
+	try {
+		ds_cap     = _ram_session->alloc(size);
+		local_addr = _rm_session->attach(ds_cap);
+	} catch (Ram_session::Alloc_failed) {
+		return 0;
+	} catch (Rm_session::Attach_failed) {
+		_ram_session->free(ds_cap);
+		return 0;
+	}
+
+	return new (local_addr) Dataspace(ds_cap, local_addr, size);
+}
+
+
+void Heap::Dataspace_pool::release(Ram_dataspace_capability cap, void *local_addr)
+{
+	_rm_session->detach(local_addr);
+	_ram_session->free(cap);
+}
+
+
+Heap::Dataspace *Heap::Dataspace_pool::lookup(void const *addr)
+{
+	Dataspace *ds = _tree.first();
+	return ds ? ds->find_by_address(addr) : 0;
+}
+
+
+Heap::Metadata_backing_store::~Metadata_backing_store()
+{
+	for (Dataspace *ds; (ds = _dataspaces.first()); ) {
+		_dataspaces.remove(ds);
+		_heap._ds_pool.release(ds->cap, ds->local_addr);
+	}
+}
+
+
+bool Heap::Metadata_backing_store::_grow()
+{
+	Dataspace *ds = _heap._ds_pool.attach(DATASPACE_SIZE);
+	if (!ds)
+		return false;
+
+	_dataspaces.insert(ds);
+	_heap._attached += ds->size;
+
+	addr_t const end = (addr_t)ds->local_addr + ds->size;
+	addr_t       a   = align_addr((addr_t)(ds + 1), log2(sizeof(addr_t)));
+	for (; a + BLOCK_SIZE <= end; a += BLOCK_SIZE) {
+		Block *b = (Block *)a;
+		b->next = _free;
+		_free   = b;
+	}
+	return true;
+}
+
+
+bool Heap::Metadata_backing_store::alloc(size_t size, void **out_addr)
+{
+	if (size > BLOCK_SIZE || !_enabled || (!_free && !_grow()))
+		return _heap._alloc_metadata(size, out_addr);
+
+	Block *b  = _free;
+	_free     = b->next;
+	*out_addr = b;
+	return true;
+}
+
+
+void Heap::Metadata_backing_store::free(void *addr, size_t size)
+{
+	for (Dataspace *ds = _dataspaces.first(); ds; ds = ds->next()) {
+		if (!ds->contains(addr))
+			continue;
+
+		Block *b = (Block *)addr;
+		b->next  = _free;
+		_free    = b;
+		return;
+	}
+
+	_heap._free_metadata(addr, size);
+}
+
+
+Heap::~Heap()
+{
+	for (unsigned i = 0; i < NUM_SIZE_CLASSES; i++) {
+		if (!_slabs[i])
+			continue;
+
+		/* release slab blocks before the AVL allocator goes away */
+		_slabs[i]->~Slab();
+		_unsynchronized_free(_slabs[i], sizeof(Slab));
+	}
 }
 
 
@@ -82,21 +255,136 @@ int Heap::quota_limit(size_t new_quota_limit)
 }
 
 
+void Heap::_account(void const *addr, size_t size, bool alloc)
+{
+	Dataspace *ds = _ds_pool.lookup(addr);
+	if (!ds)
+		return;
+
+	if (alloc) {
+		if (!ds->used)
+			_unused -= ds->size;
+
+		ds->used += size;
+	} else {
+		ds->used -= size;
+
+		if (!ds->used)
+			_unused += ds->size;
+	}
+}
+
+
+bool Heap::_alloc_metadata(size_t size, void **out_addr)
+{
+	if (_alloc.alloc_aligned(size, out_addr).is_error())
+		return false;
+
+	/*
+	 * Refuse meta data located in the dataspace that is about to be
+	 * released. This makes the release fail before the AVL allocator
+	 * is modified.
+	 */
+	if ((addr_t)*out_addr - _releasing_base < _releasing_size) {
+		_alloc.free(*out_addr);
+		return false;
+	}
+
+	_account(*out_addr, size, true);
+	return true;
+}
+
+
+void Heap::_free_metadata(void *addr, size_t size)
+{
+	_alloc.free(addr);
+	_account(addr, size, false);
+}
+
+
 bool Heap::_try_local_alloc(size_t size, void **out_addr)
 {
 	if (_alloc.alloc_aligned(size, out_addr, 2).is_error())
 		return false;
 
+	_account(*out_addr, size, true);
 	_quota_used += size;
 	return true;
 }
 
 
-bool Heap::alloc(size_t size, void **out_addr)
+bool Heap::_release(Dataspace *ds)
 {
-	/* serialize access of heap functions */
-	Lock::Guard lock_guard(_lock);
+	Ram_dataspace_capability const cap        = ds->cap;
+	void                   * const local_addr = ds->local_addr;
+	size_t                   const size       = ds->size;
+	bool                     const inside     = ds->contains(ds);
+
+	/* free 'Dataspace' structure */
+	_ds_pool.remove(ds);
+	_alloc.free(ds);
+	if (!inside)
+		_account(ds, sizeof(Dataspace), false);
+
+	_releasing_base = (addr_t)local_addr;
+	_releasing_size = size;
+
+	int const ret = _alloc.remove_range((addr_t)local_addr, size);
+
+	_releasing_base = 0;
+	_releasing_size = 0;
+
+	/* no meta data was available for removing the range, keep dataspace */
+	if (ret == -2) {
+		ds = _ds_pool.add(cap, local_addr, size, &_alloc);
+		if (ds && !ds->contains(ds))
+			_account(ds, sizeof(Dataspace), true);
+
+		if (!ds)
+			PWRN("could not re-create meta data of unused dataspace");
+
+		return false;
+	}
+
+	/*
+	 * Once the range is cut out of the AVL allocator, the removal may
+	 * still fail to allocate meta data for checking for further
+	 * overlapping blocks (-4). An overlapping used block (-3) must never
+	 * exist because all blocks are accounted to their dataspace.
+	 */
+	if (ret == -3) {
+		PERR("unused dataspace at %p contains used blocks", local_addr);
+		return false;
+	}
 
+	_ds_pool.release(cap, local_addr);
+
+	_attached -= size;
+	_unused   -= size;
+	_returned += size;
+
+	/* shrink the size of subsequently allocated dataspaces */
+	_chunk_size = max(_chunk_size/2, (size_t)MIN_CHUNK_SIZE);
+	return true;
+}
+
+
+void Heap::_release_unused(size_t keep)
+{
+	for (Dataspace *ds = _ds_pool.first(); ds && _unused > keep; ) {
+
+		Dataspace *next = ds->next();
+
+		if (!ds->used && !_release(ds))
+			return;
+
+		ds = next;
+	}
+}
+
+
+bool Heap::_unsynchronized_alloc(size_t size, void **out_addr)
+{
 	/* check requested allocation against quota limit */
 	if (size + _quota_used > _quota_limit)
 		return false;
@@ -122,28 +410,291 @@ bool Heap::alloc(size_t size, void **out_addr)
 		_chunk_size = min(2*_chunk_size, (size_t)MAX_CHUNK_SIZE);
 	}
 
-	if (_ds_pool.expand(align_addr(request_size, 12), &_alloc) < 0) {
+	size_t const ds_size = align_addr(request_size, 12);
+
+	/* meta data of a growing heap goes to dedicated dataspaces */
+	_md_backing_store.enable();
+
+	/* account new dataspace as unused before meta data gets allocated in it */
+	_attached += ds_size;
+	_unused   += ds_size;
+
+	Dataspace *ds = _ds_pool.expand(ds_size, &_alloc);
+	if (!ds) {
+		_attached -= ds_size;
+		_unused   -= ds_size;
 		PWRN("could not expand dataspace pool");
 		return 0;
 	}
 
+	if (!ds->contains(ds))
+		_account(ds, sizeof(Dataspace), true);
+
 	/* allocate originally requested block */
 	return _try_local_alloc(size, out_addr);
 }
 
 
-void Heap::free(void *addr, size_t size)
+void Heap::_unsynchronized_free(void *addr, size_t size)
 {
-	/* serialize access of heap functions */
-	Lock::Guard lock_guard(_lock);
-
 	/* forward request to our local allocator */
 	_alloc.free(addr, size);
 
+	_account(addr, size, false);
 	_quota_used -= size;
 
 	/*
-	 * We could check for completely unused dataspaces...
-	 * Yes, we could...
+	 * Return unused dataspaces once they exceed the memory in use. Keeping
+	 * half of the memory in use avoids allocating new dataspaces right away.
 	 */
+	if (_unused > max(_quota_used, (size_t)TRIM_THRESHOLD))
+		_release_unused(_quota_used/2);
+}
+
+
+Slab *Heap::_slab(unsigned size_class)
+{
+	if (_slabs[size_class])
+		return _slabs[size_class];
+
+	void *addr = 0;
+	if (!_unsynchronized_alloc(sizeof(Slab), &addr))
+		return 0;
+
+	size_t const entry_size = sizeof(Slab_entry) + class_sizes[size_class];
+	size_t const block_size = sizeof(Slab_block) + sizeof(umword_t)
+	                        + SLAB_ENTRIES*(entry_size + 1);
+
+	/* the slab allocator obtains its first block at construction time */
+	Slab *slab = new (addr) Slab(class_sizes[size_class], block_size, 0,
+	                             &_slab_backing_store);
+	if (!slab->consumed()) {
+		slab->~Slab();
+		_unsynchronized_free(addr, sizeof(Slab));
+		return 0;
+	}
+	return _slabs[size_class] = slab;
+}
+
+
+Heap::Cache &Heap::_cache_stripe()
+{
+	addr_t const t = (addr_t)Thread_base::myself();
+	return _cache_stripes[(t ^ (t >> 6) ^ (t >> 12)) % NUM_CACHE_STRIPES];
+}
+
+
+bool Heap::_alloc_small(unsigned size_class, void **out_addr)
+{
+	Cache &cache = _cache_stripe();
+
+	/* fast path, take block from the magazine of the cache stripe */
+	{
+		Lock::Guard lock_guard(cache.lock);
+
+		Magazine &magazine = cache.magazines[size_class];
+		if (magazine.num) {
+			*out_addr = magazine.blocks[--magazine.num];
+			return true;
+		}
+	}
+
+	/* take a batch of blocks from the slab allocator */
+	void    *blocks[MAGAZINE_BATCH];
+	unsigned num = 0;
+	{
+		Allocator_stats::Guard lock_guard(_lock, *this);
+
+		Slab *slab = _slab(size_class);
+		if (!slab)
+			return false;
+
+		for (; num < MAGAZINE_BATCH
+		    && slab->alloc(class_sizes[size_class], &blocks[num]); num++);
+	}
+
+	if (!num)
+		return false;
+
+	*out_addr = blocks[--num];
+
+	/* keep the remaining blocks for subsequent allocations */
+	{
+		Lock::Guard lock_guard(cache.lock);
+
+		Magazine &magazine = cache.magazines[size_class];
+		while (num && magazine.num < MAGAZINE_SIZE)
+			magazine.blocks[magazine.num++] = blocks[--num];
+	}
+
+	/* the magazine was filled by another thread in the meantime */
+	if (num) {
+		Allocator_stats::Guard lock_guard(_lock, *this);
+		while (num)
+			Slab::free(blocks[--num]);
+	}
+	return true;
+}
+
+
+void Heap::_free_small(unsigned size_class, void *addr)
+{
+	Cache &cache = _cache_stripe();
+
+	void    *blocks[MAGAZINE_BATCH];
+	unsigned num = 0;
+	{
+		Lock::Guard lock_guard(cache.lock);
+
+		Magazine &magazine = cache.magazines[size_class];
+
+		/* make room by returning a batch of blocks to the slab allocator */
+		if (magazine.num == MAGAZINE_SIZE)
+			while (num < MAGAZINE_BATCH)
+				blocks[num++] = magazine.blocks[--magazine.num];
+
+		magazine.blocks[magazine.num++] = addr;
+	}
+
+	if (num) {
+		Allocator_stats::Guard lock_guard(_lock, *this);
+		while (num)
+			Slab::free(blocks[--num]);
+	}
+}
+
+
+bool Heap::alloc(size_t size, void **out_addr)
+{
+	/*
+	 * If no slab block can be obtained for the size class, the block may
+	 * still fit into the AVL allocator.
+	 */
+	unsigned const c = size_class(size);
+	if (c < NUM_SIZE_CLASSES && _alloc_small(c, out_addr)) {
+		record_alloc(class_sizes[c]);
+		return true;
+	}
+
+	size_t const block_size = size + HEADER_SIZE;
+
+	/* serialize access of heap functions */
+	Allocator_stats::Guard lock_guard(_lock, *this);
+
+	void *block = 0;
+	if (!_unsynchronized_alloc(block_size, &block))
+		return false;
+
+	*(umword_t *)block = (block_size << 1) | 1;
+	*out_addr = (umword_t *)block + 1;
+
+	record_alloc(block_size);
+	return true;
+}
+
+
+void Heap::free(void *addr, size_t)
+{
+	if (!addr)
+		return;
+
+	umword_t const h = *header(addr);
+
+	if (!header_large(h)) {
+		Slab_block * const sb   = Slab_entry::slab_entry(addr)->slab_block();
+		size_t       const size = sb->slab()->slab_size();
+
+		record_free(size);
+		_free_small(size_class(size), addr);
+		return;
+	}
+
+	record_free(header_size(h));
+
+	/* serialize access of heap functions */
+	Allocator_stats::Guard lock_guard(_lock, *this);
+
+	_unsynchronized_free(header(addr), header_size(h));
+}
+
+
+size_t Heap::overhead(size_t size)
+{
+	unsigned const c = size_class(size);
+	if (c < NUM_SIZE_CLASSES)
+		return class_sizes[c] - size + sizeof(Slab_entry);
+
+	return _alloc.overhead(size) + HEADER_SIZE;
+}
+
+
+size_t Heap::trim()
+{
+	/* give cached blocks back to the slab allocators */
+	for (unsigned i = 0; i < NUM_CACHE_STRIPES; i++) {
+		for (unsigned c = 0; c < NUM_SIZE_CLASSES; c++) {
+
+			void    *blocks[MAGAZINE_SIZE];
+			unsigned num = 0;
+			{
+				Lock::Guard lock_guard(_cache_stripes[i].lock);
+
+				Magazine &magazine = _cache_stripes[i].magazines[c];
+				while (magazine.num)
+					blocks[num++] = magazine.blocks[--magazine.num];
+			}
+
+			Lock::Guard lock_guard(_lock);
+			while (num)
+				Slab::free(blocks[--num]);
+		}
+	}
+
+	Lock::Guard lock_guard(_lock);
+
+	/* freeing slab blocks may already release dataspaces */
+	size_t const returned = _returned;
+
+	/* free unused slab blocks, and slab allocators without used blocks */
+	for (unsigned c = 0; c < NUM_SIZE_CLASSES; c++) {
+		if (!_slabs[c])
+			continue;
+
+		if (_slabs[c]->first_used_elem()) {
+			_slabs[c]->free_empty_blocks();
+			continue;
+		}
+
+		Slab *slab = _slabs[c];
+		_slabs[c] = 0;
+		slab->~Slab();
+		_unsynchronized_free(slab, sizeof(Slab));
+	}
+
+	_release_unused(0);
+	return _returned - returned;
+}
+
+
+Heap::Stats Heap::stats()
+{
+	Lock::Guard lock_guard(_lock);
+
+	Stats stats;
+	stats.in_use   = _quota_used;
+	stats.cached   = _attached > _quota_used ? _attached - _quota_used : 0;
+	stats.returned = _returned;
+	return stats;
+}
+
+
+#ifdef GENODE_ALLOC_STATS
+bool Heap::_fragmentation(size_t &free_blocks, size_t &largest)
+{
+	Lock::Guard lock_guard(_lock);
+
+	free_blocks = _alloc.num_free_blocks();
+	largest     = _alloc.largest_free_block();
+	return true;
 }
+#endif
@@ -13,6 +13,7 @@
 
 #include <base/heap.h>
 #include <base/printf.h>
+#include <util/string.h>
 
 namespace Genode {
 
@@ -57,25 +58,77 @@ namespace Genode {
 using namespace Genode;
 
 
-Sliced_heap::Sliced_heap(Ram_session *ram_session, Rm_session *rm_session):
+Sliced_heap::Sliced_heap(Ram_session *ram_session, Rm_session *rm_session,
+                         size_t cache_limit)
+:
+	Allocator_stats("sliced_heap"),
 	_ram_session(ram_session), _rm_session(rm_session),
-	_consumed(0) { }
+	_consumed(0), _cache_limit(cache_limit), _cached(0)
+{ }
 
 
 Sliced_heap::~Sliced_heap()
 {
 	for (Block *b; (b = _block_list.first()); )
-		free(b->data_start(), b->size()); }
+		free(b->data_start(), b->size());
+
+	trim();
+}
+
+
+void Sliced_heap::_release(Block *b)
+{
+	Ram_dataspace_capability ds_cap = b->ds_cap();
+	delete b;
+	_rm_session->detach(b);
+	_ram_session->free(ds_cap);
+}
+
+
+size_t Sliced_heap::trim()
+{
+	Lock::Guard lock_guard(_lock);
+
+	size_t const cached = _cached;
+
+	for (unsigned i = 0; i < MAX_CACHED_PAGES; i++)
+		for (Block *b; (b = _cache[i].first()); ) {
+			_cache[i].remove(b);
+			_release(b);
+		}
+
+	_cached = 0;
+	return cached;
+}
 
 
 bool Sliced_heap::alloc(size_t size, void **out_addr)
 {
 	/* serialize access to block list */
-	Lock::Guard lock_guard(_lock);
+	Allocator_stats::Guard lock_guard(_lock, *this);
 
 	/* allocation includes space for block meta data and is page-aligned */
 	size = align_addr(size + sizeof(Block), 12);
 
+	/* reuse cached dataspace of the same size */
+	size_t const pages = size >> 12;
+	if (pages <= MAX_CACHED_PAGES) {
+		Block *b = _cache[pages - 1].first();
+		if (b) {
+			_cache[pages - 1].remove(b);
+			_cached -= size;
+
+			/* provide the same zeroed memory as a new dataspace */
+			memset(b->data_start(), 0, size - sizeof(Block));
+
+			_consumed += size;
+			_block_list.insert(b);
+			*out_addr = b->data_start();
+			record_alloc(size);
+			return true;
+		}
+	}
+
 	Ram_dataspace_capability ds_cap;
 	void *local_addr;
 
@@ -95,6 +148,7 @@ bool Sliced_heap::alloc(size_t size, void **out_addr)
 	_consumed += size;
 	_block_list.insert(b);
 	*out_addr = b->data_start();
+	record_alloc(size);
 	return true;
 }
 
@@ -102,15 +156,22 @@ bool Sliced_heap::alloc(size_t size, void **out_addr)
 void Sliced_heap::free(void *addr, size_t size)
 {
 	/* serialize access to block list */
-	Lock::Guard lock_guard(_lock);
+	Allocator_stats::Guard lock_guard(_lock, *this);
 
 	Block *b = Block::block(addr);
 	_block_list.remove(b);
 	_consumed -= b->size();
-	Ram_dataspace_capability ds_cap = b->ds_cap();
-	delete b;
-	_rm_session->detach(b);
-	_ram_session->free(ds_cap);
+	record_free(b->size());
+
+	/* keep dataspace for reuse if the cache limit permits */
+	size_t const pages = b->size() >> 12;
+	if (pages <= MAX_CACHED_PAGES && _cached + b->size() <= _cache_limit) {
+		_cache[pages - 1].insert(b);
+		_cached += b->size();
+		return;
+	}
+
+	_release(b);
 }
 
 
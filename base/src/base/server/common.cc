@@ -57,31 +57,37 @@ void Rpc_entrypoint::_block_until_cap_valid()
 
 Untyped_capability Rpc_entrypoint::reply_dst()
 {
-	return _ipc_server ? _ipc_server->dst() : Untyped_capability();
+	Ipc_server *ipc_server = _current_ipc_server();
+
+	return ipc_server ? ipc_server->dst() : Untyped_capability();
 }
 
 
 void Rpc_entrypoint::omit_reply()
 {
+	Ipc_server *ipc_server = _current_ipc_server();
+
 	/* set current destination to an invalid capability */
-	if (_ipc_server) _ipc_server->dst(Untyped_capability());
+	if (ipc_server) ipc_server->dst(Untyped_capability());
 }
 
 
 void Rpc_entrypoint::explicit_reply(Untyped_capability reply_cap, int return_value)
 {
-	if (!_ipc_server) return;
+	Ipc_server *ipc_server = _current_ipc_server();
+
+	if (!ipc_server) return;
 
 	/* backup reply capability of current request */
-	Untyped_capability last_reply_cap = _ipc_server->dst();
+	Untyped_capability last_reply_cap = ipc_server->dst();
 
 	/* direct ipc server to the specified reply destination */
-	_ipc_server->ret(return_value);
-	_ipc_server->dst(reply_cap);
-	*_ipc_server << IPC_REPLY;
+	ipc_server->ret(return_value);
+	ipc_server->dst(reply_cap);
+	*ipc_server << IPC_REPLY;
 
 	/* restore reply capability of the original request */
-	_ipc_server->dst(last_reply_cap);
+	ipc_server->dst(last_reply_cap);
 }
 
 
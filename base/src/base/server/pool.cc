@@ -0,0 +1,60 @@
+/*
+ * \brief  Default version of the RPC entrypoint pool
+ * \author Genode Labs
+ * \date   2013-02-04
+ *
+ * This version is used on platforms where a capability designates exactly
+ * one receiving thread. The pool consists of the entrypoint thread only.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/rpc_server.h>
+
+using namespace Genode;
+
+
+void Rpc_entrypoint_pool::Worker_exit_handler::_exit() { }
+
+
+void Rpc_entrypoint_pool::_leave_server_object(Rpc_object_base *obj)
+{
+	Rpc_entrypoint::_leave_server_object(obj);
+}
+
+
+Ipc_server *Rpc_entrypoint_pool::_current_ipc_server()
+{
+	return Rpc_entrypoint::_current_ipc_server();
+}
+
+
+void Rpc_entrypoint_pool::activate()
+{
+	Rpc_entrypoint::activate();
+}
+
+
+Rpc_entrypoint_pool::Rpc_entrypoint_pool(Cap_session *cap_session,
+                                         size_t stack_size, char const *name,
+                                         unsigned num_threads,
+                                         bool start_on_construction)
+:
+	Rpc_entrypoint(cap_session, stack_size, name, false),
+	_num_workers(0), _worker_exit_handler(*this)
+{
+	if (num_threads > 1)
+		PWRN("%s: entrypoint is served by one thread only", name);
+
+	if (start_on_construction)
+		activate();
+}
+
+
+Rpc_entrypoint_pool::~Rpc_entrypoint_pool() { }
@@ -108,39 +108,97 @@ namespace Genode {
 	 * Because we cannot trust the signal imprint to represent a valid pointer,
 	 * we need an associative data structure to validate the value. That is the
 	 * role of the 'Signal_context_registry'.
+	 *
+	 * In addition, the registry maps the capabilities of contexts to the
+	 * contexts, which enables transmitters to submit signals to contexts of
+	 * the same process directly.
 	 */
 	class Signal_context_registry
 	{
 		private:
 
 			/*
-			 * Currently, the registry is just a linked list. If this becomes a
-			 * scalability problem, we might introduce a more sophisticated
-			 * associative data structure.
+			 * The registry is a hash table indexed by the context address,
+			 * which keeps the costs of the lookup for each incoming signal
+			 * independent from the number of contexts.
 			 */
+			enum { NUM_BUCKETS = 64 };
+
 			Lock mutable                        _lock;
-			List<List_element<Signal_context> > _list;
+			List<List_element<Signal_context> > _buckets[NUM_BUCKETS];
+			List<List_element<Signal_context> > _cap_buckets[NUM_BUCKETS];
+
+			static unsigned _hash(addr_t a) {
+				return (a ^ (a >> 6) ^ (a >> 12)) % NUM_BUCKETS; }
+
+			static unsigned _bucket(Signal_context const *context) {
+				return _hash((addr_t)context); }
+
+			static unsigned _cap_bucket(Signal_context_capability cap) {
+				return _hash((addr_t)cap.local_name()); }
 
 		public:
 
 			void insert(List_element<Signal_context> *le)
 			{
 				Lock::Guard guard(_lock);
-				_list.insert(le);
+				_buckets[_bucket(le->object())].insert(le);
+			}
+
+			/**
+			 * Register capability of context
+			 *
+			 * Must be called after the capability is assigned to the context.
+			 */
+			void insert_cap(List_element<Signal_context> *le)
+			{
+				Lock::Guard guard(_lock);
+				_cap_buckets[_cap_bucket(le->object()->_cap)].insert(le);
 			}
 
-			void remove(List_element<Signal_context> *le)
+			/**
+			 * Unregister context
+			 *
+			 * Must be called before the capability of the context is reset.
+			 */
+			void remove(Signal_context *context)
 			{
 				Lock::Guard guard(_lock);
-				_list.remove(le);
+				_buckets[_bucket(context)].remove(&context->_registry_le);
+				_cap_buckets[_cap_bucket(context->_cap)].remove(&context->_cap_le);
+			}
+
+			/**
+			 * Look up context by capability
+			 *
+			 * \return  locked context, or 0 if the capability does not refer
+			 *          to a context of this process
+			 */
+			Signal_context *lookup_and_lock(Signal_context_capability cap) const
+			{
+				if (!cap.valid())
+					return 0;
+
+				Lock::Guard guard(_lock);
+
+				List_element<Signal_context> *le = _cap_buckets[_cap_bucket(cap)].first();
+				for ( ; le; le = le->next()) {
+
+					Signal_context *context = le->object();
+					if (context->_cap.local_name() == cap.local_name()) {
+						context->_lock.lock();
+						return context;
+					}
+				}
+				return 0;
 			}
 
 			bool test_and_lock(Signal_context *context) const
 			{
 				Lock::Guard guard(_lock);
 
-				/* search list for context */
-				List_element<Signal_context> *le = _list.first();
+				/* search bucket for context */
+				List_element<Signal_context> *le = _buckets[_bucket(context)].first();
 				for ( ; le; le = le->next()) {
 
 					if (context == le->object()) {
@@ -181,7 +239,28 @@ void Signal_transmitter::context(Signal_context_capability context)
 
 void Signal_transmitter::submit(int cnt)
 {
-	signal_connection()->submit(_context, cnt);
+	Signal_context *context = signal_context_registry()->lookup_and_lock(_context);
+	if (!context) {
+		signal_connection()->submit(_context, cnt);
+		return;
+	}
+
+	context->_stats.local += cnt;
+	context->_receiver->local_submit(Signal(context, cnt));
+
+	/* free context lock that was taken by 'lookup_and_lock' */
+	context->_lock.unlock();
+}
+
+
+/********************
+ ** Signal context **
+ ********************/
+
+Signal_context::Stats Signal_context::stats()
+{
+	Lock::Guard lock_guard(_lock);
+	return _stats;
 }
 
 
@@ -194,15 +273,27 @@ void Signal_receiver::_unsynchronized_dissolve(Signal_context *context)
 	/* tell core to stop sending signals referring to the context */
 	signal_connection()->free_context(context->_cap);
 
+	/* unregister context from process-wide registry */
+	signal_context_registry()->remove(context);
+
+	/* drop signal that is still pending */
+	{
+		Lock::Guard lock_guard(context->_lock);
+
+		context->_pending     = false;
+		context->_curr_signal = Signal(0, 0);
+
+		Lock::Guard pending_guard(_pending_lock);
+		if (context->_pending_fe.is_enqueued())
+			_pending_contexts.remove(&context->_pending_fe);
+	}
+
 	/* restore default initialization of signal context */
 	context->_receiver = 0;
 	context->_cap      = Signal_context_capability();
 
 	/* remove context from context list */
 	_contexts.remove(&context->_receiver_le);
-
-	/* unregister context from process-wide registry */
-	signal_context_registry()->remove(&context->_registry_le);
 }
 
 
@@ -245,6 +336,9 @@ Signal_context_capability Signal_receiver::manage(Signal_context *context)
 
 			/* use signal context as imprint */
 			context->_cap = signal_connection()->alloc_context((long)context);
+			if (context->_cap.valid())
+				signal_context_registry()->insert_cap(&context->_cap_le);
+
 			return context->_cap;
 
 		} catch (Signal_session::Out_of_metadata) {
@@ -275,24 +369,24 @@ void Signal_receiver::dissolve(Signal_context *context)
 
 bool Signal_receiver::pending()
 {
-	Lock::Guard list_lock_guard(_contexts_lock);
-
-	/* look up the contexts for the pending signal */
-	for (List_element<Signal_context> *le = _contexts.first(); le; le = le->next()) {
-
-		Signal_context *context = le->object();
+	Lock::Guard pending_guard(_pending_lock);
+	return !_pending_contexts.empty();
+}
 
-		Lock::Guard lock_guard(context->_lock);
 
-		if (context->_pending)
-			return true;
-	}
-	return false;
+Signal Signal_receiver::wait_for_signal()
+{
+	Signal signal;
+	wait_for_signals(&signal, 1);
+	return signal;
 }
 
 
-Signal Signal_receiver::wait_for_signal()
+unsigned Signal_receiver::wait_for_signals(Signal *out, unsigned max)
 {
+	if (!max)
+		return 0;
+
 	for (;;) {
 
 		/* block until the receiver has received a signal */
@@ -300,41 +394,61 @@ Signal Signal_receiver::wait_for_signal()
 
 		Lock::Guard list_lock_guard(_contexts_lock);
 
-		/* look up the contexts for the pending signal */
-		for (List_element<Signal_context> *le = _contexts.first(); le; le = le->next()) {
+		unsigned num = 0;
+		for (bool first = true; num < max; first = false) {
+
+			/* take the context that became pending first */
+			Fifo_element<Signal_context> *fe;
+			{
+				Lock::Guard pending_guard(_pending_lock);
+				fe = _pending_contexts.dequeue();
+			}
+
+			/*
+			 * Normally, the queue is never empty after the wake-up because
+			 * that would mean, the '_signal_available' semaphore was
+			 * increased without registering the signal in any context
+			 * associated to the receiver.
+			 *
+			 * However, if a context gets dissolved right after submitting a
+			 * signal, we may have increased the semaphore already. In this
+			 * case the signal-causing context is absent from the queue.
+			 */
+			if (!fe)
+				break;
 
-			Signal_context *context = le->object();
+			/*
+			 * Each enqueued context increases the semaphore. Consume the
+			 * count of each context beyond the first one, which does not
+			 * block because the context was enqueued already.
+			 */
+			if (!first)
+				_signal_available.down();
+
+			Signal_context *context = fe->object();
 
 			Lock::Guard lock_guard(context->_lock);
 
-			/* check if context has a pending signal */
 			if (!context->_pending)
 				continue;
 
 			context->_pending = false;
-			Signal result = context->_curr_signal;
+			out[num] = context->_curr_signal;
 
 			/* invalidate current signal in context */
 			context->_curr_signal = Signal(0, 0);
+			context->_stats.delivered++;
 
-			if (result.num() == 0)
+			if (out[num].num() == 0)
 				PWRN("returning signal with num == 0");
 
-			/* return last received signal */
-			return result;
+			num++;
 		}
 
-		/*
-		 * Normally, we should never arrive at this point because that would
-		 * mean, the '_signal_available' semaphore was increased without
-		 * registering the signal in any context associated to the receiver.
-		 *
-		 * However, if a context gets dissolved right after submitting a
-		 * signal, we may have increased the semaphore already. In this case
-		 * the signal-causing context is absent from the list.
-		 */
+		if (num)
+			return num;
 	}
-	return Signal(0, 0); /* unreachable */
+	return 0; /* unreachable */
 }
 
 
@@ -350,9 +464,18 @@ void Signal_receiver::local_submit(Signal ns)
 	int num = context->_curr_signal.num() + ns.num();
 	context->_curr_signal = Signal(context, num);
 
+	context->_stats.submitted += ns.num();
+	if (context->_pending)
+		context->_stats.coalesced += ns.num();
+
 	/* wake up the receiver if the context becomes pending */
 	if (!context->_pending) {
 		context->_pending = true;
+
+		{
+			Lock::Guard pending_guard(_pending_lock);
+			_pending_contexts.enqueue(&context->_pending_fe);
+		}
 		_signal_available.up();
 	}
 }
@@ -371,6 +494,13 @@ void Signal_receiver::dispatch_signals(Signal_source *signal_source)
 			continue;
 		}
 
+		/*
+		 * Core merges the submissions to a context that is queued at the
+		 * signal source into one signal. Account those as coalesced too.
+		 */
+		if (source_signal.num() > 1)
+			context->_stats.coalesced += source_signal.num() - 1;
+
 		/* construct and locally submit signal object */
 		Signal signal(context, source_signal.num());
 		context->_receiver->local_submit(signal);
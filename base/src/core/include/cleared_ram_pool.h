@@ -0,0 +1,257 @@
+/*
+ * \brief  Pool of cleared physical memory
+ * \author Genode Labs
+ * \date   2013-03-05
+ *
+ * Clearing a RAM dataspace at allocation time stalls the client for the
+ * time needed to write the whole dataspace. The pool keeps naturally aligned
+ * physical ranges of a few sizes, which are cleared in advance by a core
+ * thread. The allocation of a cached dataspace takes the smallest range
+ * that fits and returns the remainder to the physical-memory allocator.
+ * Because the allocator frees whole blocks only, the range is freed as a
+ * whole and the used part is allocated again at its address.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+#define _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/semaphore.h>
+#include <base/thread.h>
+#include <util/misc_math.h>
+
+namespace Genode {
+
+	/**
+	 * Zero-out physical memory range
+	 *
+	 * This function is implemented by the platform-specific part of core.
+	 * It is called by the thread of the pool, not by an entrypoint.
+	 *
+	 * \return  false if the platform cannot clear memory independent of a
+	 *          dataspace, which disables the pool
+	 */
+	bool clear_ram(addr_t phys_addr, size_t size);
+
+
+	class Cleared_ram_pool : Thread<2048*sizeof(addr_t)>
+	{
+		public:
+
+			/**
+			 * Allocation counters
+			 *
+			 * Allocations on the slow path are delayed by clearing the
+			 * dataspace, which takes time proportional to 'slow_bytes'.
+			 */
+			struct Stats
+			{
+				unsigned long fast;        /* served by cleared ranges */
+				unsigned long slow;        /* cleared at allocation    */
+				size_t        slow_bytes;  /* cleared at allocation    */
+				size_t        held;        /* bytes kept by the pool   */
+			};
+
+		private:
+
+			enum {
+				NUM_SIZES  = 5,  /* 16K, 64K, 256K, 1M, 4M */
+				MAX_RANGES = 8,
+
+				/* fraction of available memory the pool may keep */
+				LIMIT_SHARE = 16,
+			};
+
+			static size_t _size(unsigned i) { return (16*1024) << (2*i); }
+
+			struct Range_list
+			{
+				addr_t   ranges[MAX_RANGES];
+				unsigned num;
+				unsigned target;
+			};
+
+			Range_allocator *_ram_alloc;
+			Lock             _lock;
+			Semaphore        _refill;
+			Range_list       _lists[NUM_SIZES];
+			size_t           _target_bytes;
+			bool             _disabled;
+			Stats            _stats;
+
+			/**
+			 * Fill all range lists up to their target
+			 */
+			void _fill()
+			{
+				for (unsigned i = 0; i < NUM_SIZES; i++) {
+					for (;;) {
+						{
+							Lock::Guard lock_guard(_lock);
+							if (_disabled || _lists[i].num >= _lists[i].target)
+								break;
+						}
+
+						/* leave enough memory for allocations on the slow path */
+						if (_ram_alloc->avail() < 4*_target_bytes)
+							return;
+
+						size_t const size = _size(i);
+						void *addr = 0;
+						if (_ram_alloc->alloc_aligned(size, &addr, log2(size)).is_error())
+							return;
+
+						if (!clear_ram((addr_t)addr, size)) {
+							_ram_alloc->free(addr, size);
+							Lock::Guard lock_guard(_lock);
+							_disabled = true;
+							return;
+						}
+
+						Lock::Guard lock_guard(_lock);
+						_lists[i].ranges[_lists[i].num++] = (addr_t)addr;
+						_stats.held += size;
+					}
+				}
+			}
+
+			void entry()
+			{
+				for (;;) {
+					_refill.down();
+					_fill();
+				}
+			}
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param ram_alloc  allocator of physical memory
+			 */
+			Cleared_ram_pool(Range_allocator *ram_alloc)
+			:
+				Thread<2048*sizeof(addr_t)>("cleared_ram"),
+				_ram_alloc(ram_alloc), _target_bytes(0), _disabled(false)
+			{
+				static unsigned const targets[NUM_SIZES] = { 8, 4, 2, 2, 1 };
+				for (unsigned i = 0; i < NUM_SIZES; i++) {
+					_lists[i].num    = 0;
+					_lists[i].target = targets[i];
+				}
+
+				_stats.fast = 0, _stats.slow = 0, _stats.slow_bytes = 0;
+				_stats.held = 0;
+			}
+
+			/**
+			 * Start filling the pool
+			 *
+			 * The pool must be started after the physical memory has been
+			 * handed out as quota. Otherwise, the memory kept by the pool
+			 * would be missing from the quota. The largest sizes are not
+			 * kept if the pool would exceed its share of physical memory.
+			 */
+			void start()
+			{
+				size_t const limit = _ram_alloc->avail() / LIMIT_SHARE;
+
+				for (unsigned i = 0; i < NUM_SIZES; i++) {
+					size_t const bytes = _size(i)*_lists[i].target;
+
+					if (_target_bytes + bytes > limit)
+						_lists[i].target = 0;
+					else
+						_target_bytes += bytes;
+				}
+
+				Thread<2048*sizeof(addr_t)>::start();
+				_refill.up();
+			}
+
+			/**
+			 * Allocate cleared physical memory
+			 *
+			 * \return  false if no cleared range of a suitable size is
+			 *          available
+			 */
+			bool alloc(size_t size, void **out_addr)
+			{
+				Lock::Guard lock_guard(_lock);
+
+				/* take ranges of the smallest fitting size only */
+				unsigned i = 0;
+				for (; i < NUM_SIZES && _size(i) < size; i++);
+
+				if (i == NUM_SIZES || 4*size <= _size(i) || !_lists[i].num)
+					return false;
+
+				addr_t const addr = _lists[i].ranges[--_lists[i].num];
+				_stats.held -= _size(i);
+
+				/*
+				 * Return remainder, which stays cleared but is not tracked.
+				 * Another thread may allocate the freed range before it is
+				 * reserved again, in which case the range is given up.
+				 */
+				if (size < _size(i)) {
+					_ram_alloc->free((void *)addr, _size(i));
+
+					if (_ram_alloc->alloc_addr(size, addr).is_error()) {
+						_refill.up();
+						return false;
+					}
+				}
+
+				_stats.fast++;
+
+				*out_addr = (void *)addr;
+				_refill.up();
+				return true;
+			}
+
+			/**
+			 * Account allocation that had to be cleared by the caller
+			 */
+			void record_slow(size_t size)
+			{
+				Lock::Guard lock_guard(_lock);
+				_stats.slow++;
+				_stats.slow_bytes += size;
+			}
+
+			/**
+			 * Return all kept ranges to the physical-memory allocator
+			 *
+			 * This function is called if the physical memory is exhausted.
+			 */
+			void drain()
+			{
+				Lock::Guard lock_guard(_lock);
+
+				for (unsigned i = 0; i < NUM_SIZES; i++)
+					while (_lists[i].num)
+						_ram_alloc->free((void *)_lists[i].ranges[--_lists[i].num],
+						                 _size(i));
+
+				_stats.held = 0;
+			}
+
+			Stats stats()
+			{
+				Lock::Guard lock_guard(_lock);
+				return _stats;
+			}
+	};
+}
+
+#endif /* _CORE__INCLUDE__CLEARED_RAM_POOL_H_ */
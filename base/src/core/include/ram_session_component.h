@@ -22,6 +22,7 @@
 
 /* core includes */
 #include <dataspace_component.h>
+#include <cleared_ram_pool.h>
 
 namespace Genode {
 
@@ -43,6 +44,7 @@ namespace Genode {
 			Rpc_entrypoint         *_ds_ep;
 			Rpc_entrypoint         *_ram_session_ep;
 			Range_allocator        *_ram_alloc;
+			Cleared_ram_pool       *_cleared_pool; /* may be 0                  */
 			size_t                  _quota_limit;
 			size_t                  _payload;      /* quota used for payload      */
 			Allocator_guard         _md_alloc;     /* guarded meta-data allocator */
@@ -75,6 +77,15 @@ namespace Genode {
 			size_t used_quota() {
 				return _ds_slab.consumed() + _payload + sizeof(*this); }
 
+			/**
+			 * Allocate physical backing store for dataspace
+			 *
+			 * \param cleared  set to true if the memory is already cleared
+			 * \return         false if physical memory is exhausted
+			 */
+			bool _alloc_phys(size_t size, bool cached, void **out_addr,
+			                 bool &cleared);
+
 			/**
 			 * Free dataspace
 			 */
@@ -102,6 +113,9 @@ namespace Genode {
 
 			/**
 			 * Zero-out content of dataspace
+			 *
+			 * This function is not called for dataspaces backed by memory
+			 * of the cleared-RAM pool.
 			 */
 			void _clear_ds(Dataspace_component *ds);
 
@@ -119,6 +133,7 @@ namespace Genode {
 			 * \param md_alloc        meta-data allocator
 			 * \param md_ram_quota    limit of meta-data backing store
 			 * \param quota_limit     initial quota limit
+			 * \param cleared_pool    pool of cleared memory, or 0
 			 *
 			 * The 'quota_limit' parameter is only used for the very
 			 * first ram session in the system. All other ram session
@@ -129,7 +144,8 @@ namespace Genode {
 			                      Range_allocator *ram_alloc,
 			                      Allocator       *md_alloc,
 			                      const char      *args,
-			                      size_t           quota_limit = 0);
+			                      size_t           quota_limit = 0,
+			                      Cleared_ram_pool *cleared_pool = 0);
 
 			/**
 			 * Destructor
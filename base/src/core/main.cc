@@ -160,11 +160,17 @@ int main()
 	/*
 	 * Allocate session meta data on distinct dataspaces to enable independent
 	 * destruction (to enable quota trading) of session component objects.
+	 * The dataspaces of closed sessions are reused for new sessions.
 	 */
-	static Sliced_heap sliced_heap(env()->ram_session(), env()->rm_session());
+	static Sliced_heap sliced_heap(env()->ram_session(), env()->rm_session(),
+	                               256*1024);
+
+	/* physical memory cleared in advance of RAM allocations */
+	static Cleared_ram_pool cleared_ram_pool(platform()->ram_alloc());
 
 	static Cap_root     cap_root     (e, &sliced_heap);
-	static Ram_root     ram_root     (e, e, platform()->ram_alloc(), &sliced_heap);
+	static Ram_root     ram_root     (e, e, platform()->ram_alloc(), &sliced_heap,
+	                                  &cleared_ram_pool);
 	static Rom_root     rom_root     (e, e, platform()->rom_fs(), &sliced_heap);
 	static Rm_root      rm_root      (e, e, e, &sliced_heap, core_env()->cap_session(),
 	                                  platform()->vm_start(), platform()->vm_size());
@@ -226,6 +232,13 @@ int main()
 	env()->ram_session()->transfer_quota(init_ram_session_cap, init_quota);
 	PDBG("transferred %zd MB to init", init_quota / (1024*1024));
 
+	/*
+	 * Start filling the pool not before init's quota is determined from
+	 * the available memory. If physical memory runs out, the pool returns
+	 * its memory.
+	 */
+	cleared_ram_pool.start();
+
 	Core_child *init = new (env()->heap())
 		Core_child(Rom_session_client(init_rom_session_cap).dataspace(),
 		           core_env()->cap_session(), init_ram_session_cap,
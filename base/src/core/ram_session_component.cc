@@ -60,6 +60,31 @@ void Ram_session_component::_free_ds(Dataspace_component *ds)
 }
 
 
+bool Ram_session_component::_alloc_phys(size_t size, bool cached,
+                                        void **out_addr, bool &cleared)
+{
+	/*
+	 * Memory of the pool is cleared via cached mappings. Hence, it is not
+	 * used for non-cached dataspaces, whose cache lines must be flushed.
+	 */
+	cleared = cached && _cleared_pool && _cleared_pool->alloc(size, out_addr);
+	if (cleared)
+		return true;
+
+	/*
+	 * As an optimization for the use of large mapping sizes, we try to
+	 * align the dataspace in physical memory naturally (size-aligned).
+	 * If this does not work, we subsequently weaken the alignment constraint
+	 * until the allocation succeeds.
+	 */
+	for (size_t align_log2 = log2(size); align_log2 >= 12; align_log2--)
+		if (_ram_alloc->alloc_aligned(size, out_addr, align_log2).is_ok())
+			return true;
+
+	return false;
+}
+
+
 int Ram_session_component::_transfer_quota(Ram_session_component *dst, size_t amount)
 {
 	/* check if recipient is a valid Ram_session_component */
@@ -134,21 +159,15 @@ Ram_dataspace_capability Ram_session_component::alloc(size_t ds_size, bool cache
 		throw Quota_exceeded();
 	}
 
-	/*
-	 * Allocate physical backing store
-	 *
-	 * As an optimization for the use of large mapping sizes, we try to
-	 * align the dataspace in physical memory naturally (size-aligned).
-	 * If this does not work, we subsequently weaken the alignment constraint
-	 * until the allocation succeeds.
-	 */
+	/* allocate physical backing store */
 	void *ds_addr = 0;
-	bool alloc_succeeded = false;
-	for (size_t align_log2 = log2(ds_size); align_log2 >= 12; align_log2--) {
-		if (_ram_alloc->alloc_aligned(ds_size, &ds_addr, align_log2).is_ok()) {
-			alloc_succeeded = true;
-			break;
-		}
+	bool  cleared = false;
+	bool  alloc_succeeded = _alloc_phys(ds_size, cached, &ds_addr, cleared);
+
+	/* use the memory kept by the cleared-RAM pool as last resort */
+	if (!alloc_succeeded && _cleared_pool) {
+		_cleared_pool->drain();
+		alloc_succeeded = _alloc_phys(ds_size, cached, &ds_addr, cleared);
 	}
 
 	/*
@@ -181,7 +200,12 @@ Ram_dataspace_capability Ram_session_component::alloc(size_t ds_size, bool cache
 	 * function must also make sure to flush all cache lines related to the
 	 * address range used by the dataspace.
 	 */
-	_clear_ds(ds);
+	if (!cleared) {
+		_clear_ds(ds);
+
+		if (_cleared_pool)
+			_cleared_pool->record_slow(ds_size);
+	}
 
 	/* keep track of the used quota for actual payload */
 	_payload += ds_size;
@@ -190,6 +214,12 @@ Ram_dataspace_capability Ram_session_component::alloc(size_t ds_size, bool cache
 		PDBG("ds_size=%zd, used_quota=%zd quota_limit=%zd",
 		     ds_size, used_quota(), _quota_limit);
 
+	if (verbose && _cleared_pool) {
+		Cleared_ram_pool::Stats const s = _cleared_pool->stats();
+		PDBG("cleared ds: %lu, cleared at alloc: %lu (%zd bytes), pool: %zd bytes",
+		     s.fast, s.slow, s.slow_bytes, s.held);
+	}
+
 	Dataspace_capability result = _ds_ep->manage(ds);
 
 	/* create native shared memory representation of dataspace */
@@ -243,9 +273,11 @@ Ram_session_component::Ram_session_component(Rpc_entrypoint  *ds_ep,
                                              Range_allocator *ram_alloc,
                                              Allocator       *md_alloc,
                                              const char      *args,
-                                             size_t           quota_limit)
+                                             size_t           quota_limit,
+                                             Cleared_ram_pool *cleared_pool)
 :
 	_ds_ep(ds_ep), _ram_session_ep(ram_session_ep), _ram_alloc(ram_alloc),
+	_cleared_pool(cleared_pool),
 	_quota_limit(quota_limit), _payload(0),
 	_md_alloc(md_alloc, Arg_string::find_arg(args, "ram_quota").long_value(0)),
 	_ds_slab(&_md_alloc), _ref_account(0)
@@ -32,7 +32,8 @@ void Signal_source_component::submit(Signal_context_component *context,
 	/*
 	 * If the client does not block in 'wait_for_signal', the
 	 * signal will be delivered as result of the next
-	 * 'wait_for_signal' call.
+	 * 'wait_for_signal' call. Further submissions until then
+	 * coalesce into the counter of the already queued context.
 	 */
 	context->increment_signal_cnt(cnt);
 
@@ -0,0 +1,163 @@
+/*
+ * \brief  Test for returning unused memory of the heap
+ * \author Genode Labs
+ * \date   2013-02-27
+ *
+ * The heap uses a RAM session of its own, which lets the test compare the
+ * statistics of the heap with the dataspaces actually allocated.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/heap.h>
+#include <base/printf.h>
+#include <ram_session/connection.h>
+
+using namespace Genode;
+
+
+enum {
+	QUOTA      = 8*1024*1024,
+	MAX_BLOCKS = 8*1024,
+};
+
+
+static void *blocks[MAX_BLOCKS];
+
+
+/**
+ * Check that the dataspaces of the RAM session match the heap statistics
+ *
+ * \return  true if the check succeeded
+ */
+static bool check_ram(char const *step, Heap &heap, Ram_session &ram)
+{
+	Heap::Stats const s = heap.stats();
+
+	printf("%s: %zu bytes in use, %zu cached, %zu returned, RAM used %zu\n",
+	       step, s.in_use, s.cached, s.returned, ram.used());
+
+	if (ram.used() != s.in_use + s.cached) {
+		PERR("%s: RAM session does not match heap statistics", step);
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Allocate burst of blocks and free them again
+ *
+ * \param keep  number of blocks allocated first that are not freed
+ */
+static bool burst(Heap &heap, size_t size, unsigned num, unsigned keep)
+{
+	for (unsigned i = 0; i < num; i++)
+		if (!heap.alloc(size, &blocks[i])) {
+			PERR("allocation of %zu bytes failed", size);
+			return false;
+		}
+
+	for (unsigned i = keep; i < num; i++) {
+		heap.free(blocks[i], size);
+		blocks[i] = 0;
+	}
+
+	return true;
+}
+
+
+static void free_kept(Heap &heap, size_t size)
+{
+	for (unsigned i = 0; i < MAX_BLOCKS; i++)
+		if (blocks[i]) {
+			heap.free(blocks[i], size);
+			blocks[i] = 0;
+		}
+}
+
+
+static int test()
+{
+	static Ram_connection ram;
+	ram.ref_account(env()->ram_session_cap());
+	env()->ram_session()->transfer_quota(ram.cap(), QUOTA);
+
+	Heap heap(&ram, env()->rm_session());
+
+	/*
+	 * Large blocks come from the AVL allocator. Their dataspaces are
+	 * returned while the blocks are freed.
+	 */
+	if (!burst(heap, 2000, 1024, 0))
+		return -1;
+
+	if (!heap.stats().returned) {
+		PERR("no dataspace returned after freeing large blocks");
+		return -2;
+	}
+
+	size_t returned = heap.stats().returned;
+	size_t trimmed  = heap.trim();
+
+	if (heap.stats().returned != returned + trimmed) {
+		PERR("trim result %zu does not match statistics", trimmed);
+		return -3;
+	}
+
+	if (!check_ram("large blocks", heap, ram))
+		return -4;
+
+	/*
+	 * Small blocks are held by the slab allocators and the magazines.
+	 * Only 'trim' gives them back.
+	 */
+	if (!burst(heap, 24, MAX_BLOCKS, 256))
+		return -5;
+
+	returned = heap.stats().returned;
+	trimmed  = heap.trim();
+
+	if (!trimmed || heap.stats().returned != returned + trimmed) {
+		PERR("trim with partially used slab blocks returned %zu bytes", trimmed);
+		return -6;
+	}
+
+	if (!check_ram("partially freed small blocks", heap, ram))
+		return -7;
+
+	free_kept(heap, 24);
+	trimmed = heap.trim();
+
+	if (!trimmed || heap.stats().in_use) {
+		PERR("trim of unused heap returned %zu bytes, %zu bytes still in use",
+		     trimmed, heap.stats().in_use);
+		return -8;
+	}
+
+	if (!check_ram("small blocks", heap, ram))
+		return -9;
+
+	return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- heap trim test ---\n");
+
+	if (test()) {
+		printf("Test ended faulty.\n");
+		return -1;
+	}
+
+	printf("Test ended successfully.\n");
+	return 0;
+}
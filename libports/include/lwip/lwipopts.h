@@ -58,6 +58,8 @@
 
 #define PBUF_POOL_SIZE             32
 
+#define LWIP_SUPPORT_CUSTOM_PBUF    1  /* rx pbufs refer to the nic rx buffer */
+
 /*
  * We reduce the maximum segment lifetime from one minute to one second to
  * avoid queuing up PCBs in TIME-WAIT state. This is the state, PCBs end up
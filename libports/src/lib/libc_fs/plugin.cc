@@ -15,7 +15,9 @@
 #include <base/env.h>
 #include <base/printf.h>
 #include <file_system_session/connection.h>
+#include <os/config.h>
 #include <os/path.h>
+#include <util/list.h>
 
 /* libc includes */
 #include <errno.h>
@@ -47,10 +49,73 @@ enum { PATH_MAX_LEN = 256 };
 typedef Genode::Path<PATH_MAX_LEN> Canonical_path;
 
 
+/**
+ * Tunables of the plugin, defined by the '<libc_fs>' config node
+ */
+struct Plugin_config
+{
+	enum { MAX_IN_FLIGHT = 16 };
+
+	Genode::size_t buffer_size;  /* size of the bulk buffer */
+	Genode::size_t packet_size;  /* maximum payload of one packet */
+	unsigned       queue_size;   /* number of packet-queue slots */
+	unsigned       in_flight;    /* maximum number of reads per fd */
+	Genode::size_t read_ahead;   /* prefetched bytes of sequential reads */
+	Genode::size_t ds_quota;     /* donated for file dataspaces of 'mmap' */
+
+	/**
+	 * Maximum number of packets in flight, a queue holds one descriptor
+	 * less than its number of slots
+	 */
+	unsigned max_packets() const { return queue_size - 1; }
+
+	Plugin_config()
+	{
+		using namespace Genode;
+
+		Number_of_bytes buffer     = 128*1024;
+		Number_of_bytes packet     = 16*1024;
+		Number_of_bytes ahead      = 32*1024;
+		Number_of_bytes mmap_quota = 0;
+		unsigned        queue      = File_system::Session::TX_QUEUE_SIZE;
+		unsigned        max_reads  = 4;
+
+		try {
+			Xml_node node = config()->xml_node().sub_node("libc_fs");
+
+			try { node.attribute("buffer_size").value(&buffer);   } catch (...) { }
+			try { node.attribute("packet_size").value(&packet);   } catch (...) { }
+			try { node.attribute("queue_size").value(&queue);     } catch (...) { }
+			try { node.attribute("in_flight").value(&max_reads);  } catch (...) { }
+			try { node.attribute("read_ahead").value(&ahead);     } catch (...) { }
+			try { node.attribute("mmap_quota").value(&mmap_quota); } catch (...) { }
+		} catch (...) { }
+
+		/* the server rounds the queue size down to a power of two */
+		queue_size  = Packet_stream_base::normalized_queue_size(queue);
+		buffer_size = max((size_t)buffer, (size_t)4096);
+		packet_size = max((size_t)1, min((size_t)packet, buffer_size / 2));
+		in_flight   = max(1U, min(max_reads, min(max_packets(), (unsigned)MAX_IN_FLIGHT)));
+		read_ahead  = ahead;
+		ds_quota    = mmap_quota;
+	}
+};
+
+
+static Plugin_config const &plugin_config()
+{
+	static Plugin_config inst;
+	return inst;
+}
+
+
 static File_system::Session *file_system()
 {
 	static Genode::Allocator_avl tx_buffer_alloc(Genode::env()->heap());
-	static File_system::Connection fs(tx_buffer_alloc);
+	static File_system::Connection fs(tx_buffer_alloc,
+	                                  plugin_config().buffer_size, "",
+	                                  plugin_config().queue_size,
+	                                  plugin_config().ds_quota);
 	return &fs;
 }
 
@@ -66,8 +131,33 @@ struct Node_handle_guard
 
 
 class Plugin_context : public Libc::Plugin_context,
-                       public File_system::Packet_ref
+                       public File_system::Packet_ref,
+                       public Genode::List<Plugin_context>::Element
 {
+	public:
+
+		/**
+		 * Read request in flight or acknowledged but not yet consumed
+		 */
+		struct Read
+		{
+			File_system::Packet_descriptor packet;
+			Genode::size_t                 length;    /* requested length */
+			Genode::size_t                 consumed;  /* bytes returned to the caller */
+			bool                           acked;
+
+			/**
+			 * Return true if the server returned less than requested
+			 */
+			bool end_of_file() const { return packet.length() < length; }
+
+			/**
+			 * Return true if the read has nothing left to return
+			 */
+			bool exhausted() const {
+				return consumed >= Genode::min(packet.length(), length); }
+		};
+
 	private:
 
 		enum Type { TYPE_FILE, TYPE_DIR, TYPE_SYMLINK };
@@ -84,24 +174,129 @@ class Plugin_context : public Libc::Plugin_context,
 		 */
 		off_t _seek_offset;
 
+		/**
+		 * Ring of reads in the order of their file positions
+		 */
+		Read     _reads[Plugin_config::MAX_IN_FLIGHT];
+		unsigned _reads_head;
+		unsigned _num_reads;
+
+		/**
+		 * End of the last read, used for detecting sequential access
+		 */
+		off_t _read_end;
+
+		/**
+		 * Contexts that hold reads, used for reclaiming bulk-buffer space
+		 */
+		static Genode::List<Plugin_context> *_with_reads()
+		{
+			static Genode::List<Plugin_context> inst;
+			return &inst;
+		}
+
 	public:
 
-		bool in_flight;
+		/**
+		 * Number of packets in flight
+		 */
+		unsigned in_flight;
+
+		/**
+		 * Number of memory-mapped ranges of the file
+		 */
+		unsigned mappings;
+
+		/**
+		 * True if the file descriptor got closed while the file is mapped
+		 */
+		bool closed;
 
 		Plugin_context(File_system::File_handle handle)
 		: _type(TYPE_FILE), _node_handle(handle), _fd_flags(0),
-		  _status_flags(0), _seek_offset(~0), in_flight(false) { }
+		  _status_flags(0), _seek_offset(~0), _reads_head(0), _num_reads(0),
+		  _read_end(0), in_flight(0), mappings(0), closed(false) { }
 
 		Plugin_context(File_system::Dir_handle handle)
 		: _type(TYPE_DIR), _node_handle(handle), _fd_flags(0),
-		  _status_flags(0), _seek_offset(0), in_flight(false) { }
+		  _status_flags(0), _seek_offset(0), _reads_head(0), _num_reads(0),
+		  _read_end(0), in_flight(0), mappings(0), closed(false) { }
 
 		Plugin_context(File_system::Symlink_handle handle)
 		: _type(TYPE_SYMLINK), _node_handle(handle), _fd_flags(0),
-		  _status_flags(0), _seek_offset(~0), in_flight(false) { }
+		  _status_flags(0), _seek_offset(~0), _reads_head(0), _num_reads(0),
+		  _read_end(0), in_flight(0), mappings(0), closed(false) { }
 
 		File_system::Node_handle node_handle() const { return _node_handle; }
 
+		bool is_file() const { return _type == TYPE_FILE; }
+
+		/**
+		 * Return first context that holds reads, or 0
+		 */
+		static Plugin_context *first_with_reads() { return _with_reads()->first(); }
+
+		unsigned num_reads() const { return _num_reads; }
+
+		/**
+		 * Return read at index 'i', starting with the oldest
+		 */
+		Read &read(unsigned i) {
+			return _reads[(_reads_head + i) % Plugin_config::MAX_IN_FLIGHT]; }
+
+		/**
+		 * Return file position following the last read
+		 */
+		off_t reads_end()
+		{
+			Read &last = read(_num_reads - 1);
+			return last.packet.position() + last.length;
+		}
+
+		void push_read(File_system::Packet_descriptor packet, Genode::size_t length)
+		{
+			if (!_num_reads)
+				_with_reads()->insert(this);
+
+			Read &r = read(_num_reads++);
+			r.packet   = packet;
+			r.length   = length;
+			r.consumed = 0;
+			r.acked    = false;
+		}
+
+		void pop_read()
+		{
+			_reads_head = (_reads_head + 1) % Plugin_config::MAX_IN_FLIGHT;
+
+			if (--_num_reads == 0)
+				_with_reads()->remove(this);
+		}
+
+		/**
+		 * Record acknowledgement of a read
+		 *
+		 * \return  true if the packet belongs to a read of the context
+		 */
+		bool read_acked(File_system::Packet_descriptor const &packet)
+		{
+			if (packet.operation() != File_system::Packet_descriptor::READ)
+				return false;
+
+			for (unsigned i = 0; i < _num_reads; i++) {
+				Read &r = read(i);
+				if (!r.acked && r.packet.offset() == packet.offset()) {
+					r.packet = packet;
+					r.acked  = true;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		off_t read_end() const { return _read_end; }
+		void read_end(off_t end) { _read_end = end; }
+
 		/**
 		 * Set/get file descriptor flags
 		 */
@@ -155,6 +350,12 @@ static inline Plugin_context *context(Libc::File_descriptor *fd)
 }
 
 
+/**
+ * Total number of packets in flight
+ */
+static unsigned packets_in_flight;
+
+
 static void wait_for_acknowledgement(File_system::Session::Tx::Source &source)
 {
 	::File_system::Packet_descriptor packet = source.get_acked_packet();
@@ -162,7 +363,14 @@ static void wait_for_acknowledgement(File_system::Session::Tx::Source &source)
 	if (verbose)
 		PDBG("got acknowledgement for packet of size %zd", packet.size());
 
-	static_cast<Plugin_context *>(packet.ref())->in_flight = false;
+	Plugin_context *context = static_cast<Plugin_context *>(packet.ref());
+
+	context->in_flight--;
+	packets_in_flight--;
+
+	/* keep the payload of reads until it is consumed */
+	if (context->read_acked(packet))
+		return;
 
 	source.release_packet(packet);
 }
@@ -182,6 +390,199 @@ static void collect_acknowledgements(File_system::Session::Tx::Source &source)
 }
 
 
+/**
+ * Submit packet to the server
+ *
+ * The number of packets in flight is limited to what a queue can hold. Hence,
+ * the server never blocks on a full acknowledgement queue while the client
+ * blocks on a full submit queue.
+ */
+static void submit_packet(File_system::Session::Tx::Source &source,
+                          File_system::Packet_descriptor packet)
+{
+	while (packets_in_flight >= plugin_config().max_packets())
+		wait_for_acknowledgement(source);
+
+	static_cast<Plugin_context *>(packet.ref())->in_flight++;
+	packets_in_flight++;
+
+	source.submit_packet(packet);
+}
+
+
+/**
+ * Drop the reads of a context, e.g., prefetched data after a seek
+ */
+static void discard_reads(File_system::Session::Tx::Source &source,
+                          Plugin_context &context)
+{
+	while (context.num_reads()) {
+		while (!context.read(0).acked)
+			wait_for_acknowledgement(source);
+
+		source.release_packet(context.read(0).packet);
+		context.pop_read();
+	}
+}
+
+
+/**
+ * Drop the reads of all contexts
+ *
+ * File descriptors cannot tell whether they refer to the same file. Hence,
+ * a modification via one of them may outdate the data prefetched for any
+ * other.
+ */
+static void discard_all_reads(File_system::Session::Tx::Source &source)
+{
+	while (Plugin_context *context = Plugin_context::first_with_reads())
+		discard_reads(source, *context);
+}
+
+
+/**
+ * Wait for the completion of all operations of a context
+ */
+static void sync(File_system::Session::Tx::Source &source,
+                 Plugin_context &context)
+{
+	discard_reads(source, context);
+
+	while (context.in_flight)
+		wait_for_acknowledgement(source);
+}
+
+
+/**
+ * Free space in the bulk buffer after a failed packet allocation
+ *
+ * \return  false if there is nothing to free
+ */
+static bool free_bulk_buffer_space(File_system::Session::Tx::Source &source)
+{
+	if (packets_in_flight) {
+		wait_for_acknowledgement(source);
+		return true;
+	}
+
+	/* reclaim the space occupied by data prefetched for other fds */
+	Plugin_context *context = Plugin_context::first_with_reads();
+	if (!context)
+		return false;
+
+	discard_reads(source, *context);
+	return true;
+}
+
+
+/**
+ * Submit reads for the range of the seek offset up to 'end'
+ *
+ * The range is split into packets, which are appended to the reads
+ * already held by the context.
+ */
+static void request_reads(File_system::Session::Tx::Source &source,
+                          Plugin_context &context, off_t end, unsigned max_reads)
+{
+	off_t pos = context.num_reads() ? context.reads_end() : context.seek_offset();
+
+	while (pos < end && context.num_reads() < max_reads) {
+
+		size_t const length = Genode::min((off_t)plugin_config().packet_size,
+		                                  end - pos);
+		File_system::Packet_descriptor packet;
+		try {
+			packet = File_system::Packet_descriptor(
+				source.alloc_packet(length),
+				static_cast<File_system::Packet_ref *>(&context),
+				context.node_handle(),
+				File_system::Packet_descriptor::READ, length, pos);
+		} catch (File_system::Session::Tx::Source::Packet_alloc_failed) {
+
+			/* consume the reads of the context first */
+			if (context.num_reads() || !free_bulk_buffer_space(source))
+				return;
+
+			continue;
+		}
+
+		context.push_read(packet, length);
+		submit_packet(source, packet);
+		pos += length;
+	}
+}
+
+
+/**
+ * Memory-mapped range of a file
+ */
+struct Mapping : Genode::List<Mapping>::Element
+{
+	void           *addr;
+	Genode::size_t  length;
+	off_t           offset;
+	Plugin_context &context;
+
+	/*
+	 * A mapping either refers to the dataspace provided by the file
+	 * system or to a copy of the file content, which is written back to
+	 * the file at 'munmap' if the mapping is shared and writeable.
+	 */
+	bool attached;
+	bool write_back;
+
+	Mapping(void *addr, Genode::size_t length, off_t offset,
+	        Plugin_context &context, bool attached, bool write_back)
+	:
+		addr(addr), length(length), offset(offset), context(context),
+		attached(attached), write_back(write_back)
+	{ }
+};
+
+
+static Genode::List<Mapping> *mappings()
+{
+	static Genode::List<Mapping> inst;
+	return &inst;
+}
+
+
+/**
+ * Attach dataspace with the file content provided by the file system
+ *
+ * \return  local address, or 0 if the file system cannot provide the
+ *          content as dataspace
+ */
+static void *attach_file(Plugin_context &context, Genode::size_t length,
+                         off_t offset, bool writeable, bool executable)
+{
+	using namespace Genode;
+
+	if (!context.is_file() || (offset & ((1 << PAGE_SHIFT) - 1)))
+		return 0;
+
+	/* the dataspace must reflect writes that are still in flight */
+	sync(*file_system()->tx(), context);
+
+	File_system::Node_handle node_handle = context.node_handle();
+	File_system::File_handle &file_handle =
+	    static_cast<File_system::File_handle&>(node_handle);
+
+	try {
+		Dataspace_capability ds =
+			file_system()->dataspace(file_handle, offset + length, writeable);
+
+		if (!ds.valid())
+			return 0;
+
+		return env()->rm_session()->attach(ds, align_addr(length, PAGE_SHIFT),
+		                                   offset, false, (addr_t)0, executable);
+	} catch (...) { }
+
+	return 0;
+}
+
+
 static void obtain_stat_for_node(File_system::Node_handle node_handle,
                                  struct stat *buf)
 {
@@ -225,6 +626,95 @@ class Plugin : public Libc::Plugin
 			return stat_buf.st_size;
 		}
 
+		/**
+		 * Complete all operations of the context and close its node
+		 */
+		void _release(Plugin_context *context)
+		{
+			sync(*file_system()->tx(), *context);
+
+			file_system()->close(context->node_handle());
+
+			Genode::destroy(Genode::env()->heap(), context);
+		}
+
+		/**
+		 * Write copied content of a mapping back to the file
+		 *
+		 * The file is not enlarged by the part of the mapping beyond the
+		 * end of the file.
+		 */
+		void _write_back(Mapping &mapping)
+		{
+			Plugin_context &ctx = mapping.context;
+
+			sync(*file_system()->tx(), ctx);
+
+			File_system::file_size_t const size =
+				file_system()->status(ctx.node_handle()).size;
+
+			if ((File_system::file_size_t)mapping.offset >= size)
+				return;
+
+			off_t const seek_offset = ctx.seek_offset();
+
+			ctx.seek_offset(mapping.offset);
+			_write(ctx, mapping.addr,
+			       Genode::min((File_system::file_size_t)mapping.length,
+			                   size - mapping.offset));
+			ctx.seek_offset(seek_offset);
+		}
+
+		ssize_t _write(Plugin_context &ctx, const void *buf, ::size_t count)
+		{
+			File_system::Session::Tx::Source &source = *file_system()->tx();
+
+			size_t const max_packet_size = plugin_config().packet_size;
+
+			size_t remaining_count = count;
+
+			/* prefetched data may be outdated by the write */
+			discard_all_reads(source);
+
+			while (remaining_count) {
+
+				collect_acknowledgements(source);
+
+				size_t curr_packet_size = Genode::min(remaining_count, max_packet_size);
+
+				try {
+					File_system::Packet_descriptor
+						packet(source.alloc_packet(curr_packet_size),
+							   static_cast<File_system::Packet_ref *>(&ctx),
+							   ctx.node_handle(),
+							   File_system::Packet_descriptor::WRITE,
+							   curr_packet_size,
+							   ctx.seek_offset());
+
+					/* copy-in payload into packet */
+					memcpy(source.packet_content(packet), buf, curr_packet_size);
+
+					/* pass packet to server side */
+					submit_packet(source, packet);
+
+					/* prepare next iteration */
+					ctx.advance_seek_offset(curr_packet_size);
+					buf = (void *)((Genode::addr_t)buf + curr_packet_size);
+					remaining_count -= curr_packet_size;
+				} catch (File_system::Session::Tx::Source::Packet_alloc_failed) {
+					if (!free_bulk_buffer_space(source)) {
+						PERR("could not allocate packet for write");
+						errno = EIO;
+						return -1;
+					}
+				}
+			}
+
+			if (verbose)
+				PDBG("write returns %zd", count);
+			return count;
+		}
+
 	public:
 
 		/**
@@ -287,18 +777,17 @@ class Plugin : public Libc::Plugin
 
 		int close(Libc::File_descriptor *fd)
 		{
-			/* wait for the completion of all operations of the context */
-			while (context(fd)->in_flight) {
-				if (verbose)
-					PDBG("wait_for_acknowledgement");
-				wait_for_acknowledgement(*file_system()->tx());
-			}
-
-			file_system()->close(context(fd)->node_handle());
+			Plugin_context *ctx = context(fd);
 
-			Genode::destroy(Genode::env()->heap(), context(fd));
 			Libc::file_descriptor_allocator()->free(fd);
 
+			/* keep the node open until the last mapping is removed */
+			if (ctx->mappings) {
+				ctx->closed = true;
+				return 0;
+			}
+
+			_release(ctx);
 			return 0;
 		}
 
@@ -346,6 +835,10 @@ class Plugin : public Libc::Plugin
 			File_system::File_handle &file_handle =
 			    static_cast<File_system::File_handle&>(node_handle);
 
+			/* apply pending writes and drop prefetched data */
+			sync(*file_system()->tx(), *context(fd));
+			discard_all_reads(*file_system()->tx());
+
 			try {
 				file_system()->truncate(file_handle, length);
 			} catch (File_system::Invalid_handle) {
@@ -549,68 +1042,80 @@ class Plugin : public Libc::Plugin
 		{
 			File_system::Session::Tx::Source &source = *file_system()->tx();
 
-			size_t const max_packet_size = source.bulk_buffer_size() / 2;
+			Plugin_config const &cfg = plugin_config();
+			Plugin_context      &ctx = *context(fd);
 
-			size_t remaining_count = count;
+			if (ctx.seek_offset() == ~0)
+				ctx.seek_offset(0);
 
-			if (context(fd)->seek_offset() == ~0)
-				context(fd)->seek_offset(0);
+			off_t const offset = ctx.seek_offset();
 
-			while (remaining_count) {
+			/* drop prefetched data that does not continue at the seek offset */
+			if (ctx.num_reads()) {
+				Plugin_context::Read &r = ctx.read(0);
+				if ((off_t)(r.packet.position() + r.consumed) != offset)
+					discard_reads(source, ctx);
+			}
 
-				collect_acknowledgements(source);
+			/*
+			 * Keep several reads in flight and prefetch the data following
+			 * the requested range if the file is read sequentially.
+			 * Directories and symlinks are read one packet at a time.
+			 */
+			bool const sequential = ctx.is_file() && offset == ctx.read_end();
 
-				size_t curr_packet_size = Genode::min(remaining_count, max_packet_size);
+			off_t const    end       = offset + count + (sequential ? cfg.read_ahead : 0);
+			unsigned const max_reads = ctx.is_file() ? cfg.in_flight : 1;
 
-				/*
-				 * XXX handle 'Packet_alloc_failed' exception'
-				 */
-				File_system::Packet_descriptor
-					packet(source.alloc_packet(curr_packet_size),
-					       static_cast<File_system::Packet_ref *>(context(fd)),
-					       context(fd)->node_handle(),
-					       File_system::Packet_descriptor::READ,
-					       curr_packet_size,
-					       context(fd)->seek_offset());
+			char  *dst             = (char *)buf;
+			size_t remaining_count = count;
 
-				/* mark context as having an operation in flight */
-				context(fd)->in_flight = true;
+			while (remaining_count) {
 
-				/* pass packet to server side */
-				source.submit_packet(packet);
+				collect_acknowledgements(source);
 
-				do {
-					packet = source.get_acked_packet();
-					static_cast<Plugin_context *>(packet.ref())->in_flight = false;
-				} while (context(fd)->in_flight);
+				request_reads(source, ctx, end, max_reads);
 
-				context(fd)->in_flight = false;
+				if (!ctx.num_reads()) {
+					PERR("could not allocate packet for read");
+					break;
+				}
 
-				/*
-				 * XXX check if acked packet belongs to request,
-				 *     needed for thread safety
-				 */
+				/* reassemble the acknowledged reads in order */
+				Plugin_context::Read &r = ctx.read(0);
+				while (!r.acked)
+					wait_for_acknowledgement(source);
 
-				size_t read_num_bytes = Genode::min(packet.length(), curr_packet_size);
+				size_t const avail =
+					Genode::min(r.packet.length(), r.length) - r.consumed;
+				size_t const n = Genode::min(avail, remaining_count);
 
 				/* copy-out payload into destination buffer */
-				memcpy(buf, source.packet_content(packet), read_num_bytes);
+				memcpy(dst, source.packet_content(r.packet) + r.consumed, n);
 
-				source.release_packet(packet);
+				r.consumed += n;
+				ctx.advance_seek_offset(n);
+				dst             += n;
+				remaining_count -= n;
 
-				/* prepare next iteration */
-				context(fd)->advance_seek_offset(read_num_bytes);
-				buf = (void *)((Genode::addr_t)buf + read_num_bytes);
-				remaining_count -= read_num_bytes;
+				if (!r.exhausted())
+					continue;
 
 				/*
 				 * If we received less bytes than requested, we reached the end
-				 * of the file.
+				 * of the file. The reads following the end are dropped.
 				 */
-				if (read_num_bytes < curr_packet_size)
+				if (r.end_of_file()) {
+					discard_reads(source, ctx);
 					break;
+				}
+
+				source.release_packet(r.packet);
+				ctx.pop_read();
 			}
 
+			ctx.read_end(ctx.seek_offset());
+
 			return count - remaining_count;
 		}
 
@@ -729,86 +1234,90 @@ class Plugin : public Libc::Plugin
 
 		ssize_t write(Libc::File_descriptor *fd, const void *buf, ::size_t count)
 		{
-			File_system::Session::Tx::Source &source = *file_system()->tx();
-
-			size_t const max_packet_size = source.bulk_buffer_size() / 2;
-
-			size_t remaining_count = count;
-
-			while (remaining_count) {
-
-				collect_acknowledgements(source);
-
-				size_t curr_packet_size = Genode::min(remaining_count, max_packet_size);
-
-				try {
-					File_system::Packet_descriptor
-						packet(source.alloc_packet(curr_packet_size),
-							   static_cast<File_system::Packet_ref *>(context(fd)),
-							   context(fd)->node_handle(),
-							   File_system::Packet_descriptor::WRITE,
-							   curr_packet_size,
-							   context(fd)->seek_offset());
-
-					/* mark context as having an operation in flight */
-					context(fd)->in_flight = true;
-
-					/* copy-in payload into packet */
-					memcpy(source.packet_content(packet), buf, curr_packet_size);
-
-					/* pass packet to server side */
-					source.submit_packet(packet);
-
-					/* prepare next iteration */
-					context(fd)->advance_seek_offset(curr_packet_size);
-					buf = (void *)((Genode::addr_t)buf + curr_packet_size);
-					remaining_count -= curr_packet_size;
-				} catch (File_system::Session::Tx::Source::Packet_alloc_failed) {
-					do {
-						wait_for_acknowledgement(source);
-					} while (context(fd)->in_flight);
-				}
-			}
-
-			if (verbose)
-				PDBG("write returns %zd", count);
-			return count;
+			return _write(*context(fd), buf, count);
 		}
 
 		void *mmap(void *addr_in, ::size_t length, int prot, int flags,
 		           Libc::File_descriptor *fd, ::off_t offset)
 		{
-			if (prot != PROT_READ) {
-				PERR("mmap for prot=%x not supported", prot);
-				errno = EACCES;
-				return (void *)-1;
-			}
-
 			if (addr_in != 0) {
 				PERR("mmap for predefined address not supported");
 				errno = EINVAL;
 				return (void *)-1;
 			}
 
-			void *addr = Libc::mem_alloc()->alloc(length, PAGE_SHIFT);
-			if (addr == (void *)-1) {
-				errno = ENOMEM;
-				return (void *)-1;
-			}
+			Plugin_context &ctx = *context(fd);
 
-			if (::pread(fd->libc_fd, addr, length, offset) < 0) {
-				PERR("mmap could not obtain file content");
-				::munmap(addr, length);
+			bool const writeable = (prot & PROT_WRITE) != 0;
+			bool const shared    = (flags & MAP_SHARED) != 0;
+
+			if (writeable && shared
+			 && (ctx.status_flags() & O_ACCMODE) == O_RDONLY) {
 				errno = EACCES;
 				return (void *)-1;
 			}
 
+			/*
+			 * Map the storage of the file system directly if possible. A
+			 * private writeable mapping needs a copy of the content.
+			 */
+			void *addr = 0;
+			if (!writeable || shared)
+				addr = attach_file(ctx, length, offset, writeable,
+				                   (prot & PROT_EXEC) != 0);
+
+			bool const attached = (addr != 0);
+
+			if (!attached) {
+				addr = Libc::mem_alloc()->alloc(length, PAGE_SHIFT);
+				if (addr == (void *)-1) {
+					errno = ENOMEM;
+					return (void *)-1;
+				}
+
+				if (::pread(fd->libc_fd, addr, length, offset) < 0) {
+					PERR("mmap could not obtain file content");
+					Libc::mem_alloc()->free(addr);
+					errno = EACCES;
+					return (void *)-1;
+				}
+			}
+
+			mappings()->insert(new (Genode::env()->heap())
+			                   Mapping(addr, length, offset, ctx, attached,
+			                           !attached && writeable && shared));
+			ctx.mappings++;
+
 			return addr;
 		}
 
 		int munmap(void *addr, ::size_t)
 		{
-			Libc::mem_alloc()->free(addr);
+			Mapping *mapping = mappings()->first();
+			for (; mapping && mapping->addr != addr; mapping = mapping->next());
+
+			if (!mapping) {
+				errno = EINVAL;
+				return -1;
+			}
+
+			if (mapping->attached)
+				Genode::env()->rm_session()->detach(addr);
+			else {
+				if (mapping->write_back)
+					_write_back(*mapping);
+
+				Libc::mem_alloc()->free(addr);
+			}
+
+			Plugin_context *ctx = &mapping->context;
+
+			mappings()->remove(mapping);
+			Genode::destroy(Genode::env()->heap(), mapping);
+
+			if (--ctx->mappings == 0 && ctx->closed)
+				_release(ctx);
+
 			return 0;
 		}
 };
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2009-2012 Genode Labs GmbH
+ * Copyright (C) 2009-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -33,6 +33,22 @@ extern "C" {
 #include <nic_session/connection.h>
 
 
+class Nic_receiver_thread;
+
+
+/*
+ * Custom pbuf that refers to a packet of the rx packet stream
+ *
+ * The packet is acknowledged not before lwIP frees the pbuf.
+ */
+struct Rx_pbuf
+{
+	struct pbuf_custom   p;   /* must be the first member */
+	Packet_descriptor    packet;
+	Nic_receiver_thread *thread;
+};
+
+
 /*
  * Thread, that receives packets by the nic-session interface.
  */
@@ -40,16 +56,37 @@ class Nic_receiver_thread : public Genode::Thread<8192>
 {
 	private:
 
+		/*
+		 * lwIP may keep received pbufs for a long time, e.g., until the
+		 * application reads the socket. Only a part of the rx buffer is
+		 * passed to lwIP without copying so that the driver can always
+		 * deliver further packets.
+		 */
+		enum { MAX_RX_PBUFS = Nic::Session::RX_QUEUE_SIZE / 2 };
+
 		Nic::Connection  *_nic;       /* nic-session */
 		Packet_descriptor _rx_packet; /* actual packet received */
 		struct netif     *_netif;     /* LwIP network interface structure */
 
+		/*
+		 * Pbufs are freed by the tcpip thread as well as by application
+		 * threads. The lock protects the pool of rx pbufs and the ack queue.
+		 */
+		Genode::Lock _rx_lock;
+		Rx_pbuf      _rx_pbufs[MAX_RX_PBUFS];
+		Rx_pbuf     *_free_rx_pbufs[MAX_RX_PBUFS];
+		unsigned     _num_free_rx_pbufs;
+
 		void _tx_ack(bool block = false)
 		{
+			enum { MAX_ACKS = 32 };
+			Packet_descriptor acked_packets[MAX_ACKS];
+
 			/* check for acknowledgements */
 			while (nic()->tx()->ack_avail() || block) {
-				Packet_descriptor acked_packet = nic()->tx()->get_acked_packet();
-				nic()->tx()->release_packet(acked_packet);
+				unsigned const num = nic()->tx()->get_acked_packets(acked_packets, MAX_ACKS);
+				for (unsigned i = 0; i < num; i++)
+					nic()->tx()->release_packet(acked_packets[i]);
 				block = false;
 			}
 		}
@@ -57,7 +94,13 @@ class Nic_receiver_thread : public Genode::Thread<8192>
 	public:
 
 		Nic_receiver_thread(Nic::Connection *nic, struct netif *netif)
-		: Genode::Thread<8192>("nic-recv"), _nic(nic), _netif(netif) {}
+		:
+			Genode::Thread<8192>("nic-recv"), _nic(nic), _netif(netif),
+			_num_free_rx_pbufs(0)
+		{
+			for (unsigned i = 0; i < MAX_RX_PBUFS; i++)
+				_free_rx_pbufs[_num_free_rx_pbufs++] = &_rx_pbufs[i];
+		}
 
 		void entry();
 		Nic::Connection  *nic() { return _nic; };
@@ -85,6 +128,41 @@ class Nic_receiver_thread : public Genode::Thread<8192>
 
 		char *content(Packet_descriptor packet) {
 			return nic()->tx()->packet_content(packet); }
+
+		/**
+		 * Allocate pbuf for referring to the current rx packet
+		 *
+		 * \return  0 if too many rx packets are held by lwIP
+		 */
+		Rx_pbuf *alloc_rx_pbuf()
+		{
+			Genode::Lock::Guard lock_guard(_rx_lock);
+
+			if (!_num_free_rx_pbufs)
+				return 0;
+
+			Rx_pbuf *rx_pbuf = _free_rx_pbufs[--_num_free_rx_pbufs];
+			rx_pbuf->packet = _rx_packet;
+			rx_pbuf->thread = this;
+			return rx_pbuf;
+		}
+
+		/**
+		 * Acknowledge rx packet and release pbuf referring to it
+		 */
+		void free_rx_pbuf(Rx_pbuf *rx_pbuf)
+		{
+			Genode::Lock::Guard lock_guard(_rx_lock);
+
+			_nic->rx()->acknowledge_packet(rx_pbuf->packet);
+			_free_rx_pbufs[_num_free_rx_pbufs++] = rx_pbuf;
+		}
+
+		void ack_rx_packet(Packet_descriptor packet)
+		{
+			Genode::Lock::Guard lock_guard(_rx_lock);
+			_nic->rx()->acknowledge_packet(packet);
+		}
 };
 
 
@@ -120,17 +198,13 @@ extern "C" {
 		pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
 #endif
 		Packet_descriptor tx_packet = th->alloc_tx_packet(p->tot_len);
-		char *tx_content            = th->content(tx_packet);
 
 		/*
-		 * Iterate through all pbufs and
-		 * copy payload into packet's payload
+		 * Copy payload of the pbuf chain into packet's payload. lwIP keeps
+		 * TCP segments in its own memory until they are acknowledged by the
+		 * peer, hence the segments cannot be sent from the packet buffer.
 		 */
-		for(struct pbuf *q = p; q != NULL; q = q->next) {
-			char *src = (char*) q->payload;
-			Genode::memcpy(tx_content, src, q->len);
-			tx_content += q->len;
-		}
+		pbuf_copy_partial(p, th->content(tx_packet), p->tot_len, 0);
 
 		/* Submit packet */
 		th->submit_tx_packet(tx_packet);
@@ -143,10 +217,23 @@ extern "C" {
 	}
 
 
+	/**
+	 * Custom free function of rx pbufs, acknowledges the referenced packet
+	 */
+	static void rx_pbuf_free(struct pbuf *p)
+	{
+		Rx_pbuf *rx_pbuf = reinterpret_cast<Rx_pbuf *>(p);
+		rx_pbuf->thread->free_rx_pbuf(rx_pbuf);
+	}
+
+
 	/**
 	 * Should allocate a pbuf and transfer the bytes of the incoming
 	 * packet from the interface into the pbuf.
 	 *
+	 * The pbuf refers to the packet in the rx buffer if possible. In this
+	 * case, the packet gets acknowledged when lwIP frees the pbuf.
+	 *
 	 * @param netif the lwip network interface structure for this genode_netif
 	 * @return a pbuf filled with the received packet (including MAC header)
 	 *         NULL on memory error
@@ -160,6 +247,20 @@ extern "C" {
 		char *rx_content        = nic->rx()->packet_content(rx_packet);
 		u16_t len               = rx_packet.size();
 
+		/*
+		 * Refer to the packet in the rx buffer. This is not possible with
+		 * Ethernet padding, which would have to precede the packet.
+		 */
+#if !ETH_PAD_SIZE
+		if (Rx_pbuf *rx_pbuf = th->alloc_rx_pbuf()) {
+			rx_pbuf->p.custom_free_function = rx_pbuf_free;
+
+			LINK_STATS_INC(link.recv);
+			return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rx_pbuf->p,
+			                           rx_content, len);
+		}
+#endif
+
 #if ETH_PAD_SIZE
 		len += ETH_PAD_SIZE; /* allow room for Ethernet padding */
 #endif
@@ -171,15 +272,7 @@ extern "C" {
 			pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
-			/*
-			 * We iterate over the pbuf chain until we have read the entire
-			 * packet into the pbuf.
-			 */
-			for(struct pbuf *q = p; q != 0; q = q->next) {
-				char *dst = (char*)q->payload;
-				Genode::memcpy(dst, rx_content, q->len);
-				rx_content += q->len;
-			}
+			pbuf_take(p, rx_content, rx_packet.size());
 
 #if ETH_PAD_SIZE
 			pbuf_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
@@ -191,7 +284,7 @@ extern "C" {
 		}
 
 		/* Acknowledge the packet */
-		nic->rx()->acknowledge_packet(rx_packet);
+		th->ack_rx_packet(rx_packet);
 		return p;
 	}
 
@@ -293,13 +386,19 @@ extern "C" {
 
 void Nic_receiver_thread::entry()
 {
+	enum { MAX_BATCH = 32 };
+	Packet_descriptor packets[MAX_BATCH];
+
 	while(true)
 	{
 		/*
-		 * Block until we receive a packet,
-		 * then call input function.
+		 * Block until we receive packets,
+		 * then call input function for each packet.
 		 */
-		_rx_packet = _nic->rx()->get_packet();
-		genode_netif_input(_netif);
+		unsigned const num = _nic->rx()->get_packets(packets, MAX_BATCH);
+		for (unsigned i = 0; i < num; i++) {
+			_rx_packet = packets[i];
+			genode_netif_input(_netif);
+		}
 	}
 }
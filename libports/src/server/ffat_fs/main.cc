@@ -219,11 +219,13 @@ namespace File_system {
 			/**
 			 * Constructor
 			 */
-			Session_component(size_t tx_buf_size, Rpc_entrypoint &ep,
+			Session_component(size_t tx_buf_size, unsigned tx_queue_size,
+			                  Rpc_entrypoint &ep,
 			                  Signal_receiver &sig_rec,
 			                  Directory &root, bool writable)
 			:
-				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep),
+				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep,
+				                   tx_queue_size),
 				_root(root),
 				_writable(writable),
 				_process_packet_dispatcher(sig_rec, *this,
@@ -895,6 +897,13 @@ namespace File_system {
 				}
 
 			}
+
+			/**
+			 * The file content resides on the block device, so the client
+			 * has to use packets
+			 */
+			Dataspace_capability dataspace(File_handle, file_size_t, bool) {
+				return Dataspace_capability(); }
 	};
 
 
@@ -1002,6 +1011,9 @@ namespace File_system {
 					Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 				size_t tx_buf_size =
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
 
 				/*
 				 * Check if donated ram quota suffices for session data,
@@ -1014,7 +1026,7 @@ namespace File_system {
 					throw Root::Quota_exceeded();
 				}
 				return new (md_alloc())
-					Session_component(tx_buf_size, _channel_ep, _sig_rec,
+					Session_component(tx_buf_size, tx_queue_size, _channel_ep, _sig_rec,
 					                  *session_root_dir, writeable);
 			}
 
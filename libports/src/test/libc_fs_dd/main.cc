@@ -0,0 +1,125 @@
+/*
+ * \brief  Sequential-throughput benchmark for the libc_fs plugin
+ * \author Genode Labs
+ * \date   2013-03-09
+ *
+ * Like 'dd', the benchmark writes a file block by block and reads it back.
+ * The content is verified while reading.
+ *
+ * Configuration:
+ *
+ * :<dd> node: 'file' (default "/dd"), 'size' of the file (default 16M),
+ *             block size 'bs' (default 64K)
+ * :<libc_fs> node: tunables of the libc_fs plugin
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <os/config.h>
+#include <timer_session/connection.h>
+
+/* libc includes */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void fill(char *block, size_t bs, unsigned long n)
+{
+	for (size_t i = 0; i + sizeof(n) <= bs; i += sizeof(n))
+		memcpy(block + i, &n, sizeof(n));
+}
+
+
+static void report(char const *phase, size_t bytes, unsigned long ms)
+{
+	ms = ms ? ms : 1;
+	printf("%-5s %zu KiB in %lu ms, %lu KiB/s\n", phase, bytes / 1024, ms,
+	       (unsigned long)((unsigned long long)bytes*1000/1024/ms));
+}
+
+
+int main(int argc, char *argv[])
+{
+	printf("--- libc_fs dd benchmark ---\n");
+
+	char                    file[64]   = "/dd";
+	Genode::Number_of_bytes size_arg   = 16*1024*1024;
+	Genode::Number_of_bytes bs_arg     = 64*1024;
+
+	try {
+		Genode::Xml_node dd = Genode::config()->xml_node().sub_node("dd");
+
+		try { dd.attribute("file").value(file, sizeof(file)); } catch (...) { }
+		try { dd.attribute("size").value(&size_arg);          } catch (...) { }
+		try { dd.attribute("bs").value(&bs_arg);              } catch (...) { }
+	} catch (...) { }
+
+	size_t const bs    = bs_arg;
+	size_t const count = bs ? size_arg / bs : 0;
+
+	char *block    = (char *)malloc(bs);
+	char *expected = (char *)malloc(bs);
+	if (!block || !expected) {
+		printf("Error: could not allocate block buffers\n");
+		return -1;
+	}
+
+	static Timer::Connection timer;
+
+	int fd = open(file, O_CREAT | O_RDWR | O_TRUNC);
+	if (fd < 0) {
+		printf("Error: could not create '%s'\n", file);
+		return -1;
+	}
+
+	unsigned long t = timer.elapsed_ms();
+	for (size_t i = 0; i < count; i++) {
+		fill(block, bs, i);
+		if (write(fd, block, bs) != (ssize_t)bs) {
+			printf("Error: write of block %zu failed\n", i);
+			return -1;
+		}
+	}
+	close(fd);
+	report("write", count*bs, timer.elapsed_ms() - t);
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0) {
+		printf("Error: could not open '%s'\n", file);
+		return -1;
+	}
+
+	t = timer.elapsed_ms();
+	for (size_t i = 0; i < count; i++) {
+		if (read(fd, block, bs) != (ssize_t)bs) {
+			printf("Error: read of block %zu failed\n", i);
+			return -1;
+		}
+
+		fill(expected, bs, i);
+		if (memcmp(block, expected, bs) != 0) {
+			printf("Error: block %zu has unexpected content\n", i);
+			return -1;
+		}
+	}
+	report("read", count*bs, timer.elapsed_ms() - t);
+
+	/* the file ends after the last block */
+	if (read(fd, block, bs) != 0) {
+		printf("Error: read beyond the end of the file\n");
+		return -1;
+	}
+	close(fd);
+
+	printf("--- end of libc_fs dd benchmark ---\n");
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * \brief  Test for memory-mapping files via the libc_fs plugin
+ * \author Genode Labs
+ * \date   2013-03-10
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* libc includes */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+enum { SIZE = 256*1024 };
+
+
+static char pattern(size_t i) { return 'a' + i % 26; }
+
+
+static int check(char const *what, char const *buf, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		if (buf[i] != pattern(i)) {
+			printf("Error: %s: unexpected content at offset %zu\n", what, i);
+			return -1;
+		}
+	return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+	printf("--- libc_fs mmap test ---\n");
+
+	static char buf[SIZE];
+	for (size_t i = 0; i < SIZE; i++)
+		buf[i] = pattern(i);
+
+	int fd = open("/mmap", O_CREAT | O_RDWR);
+	if (fd < 0 || write(fd, buf, SIZE) != SIZE) {
+		printf("Error: could not create file\n");
+		return -1;
+	}
+
+	/* read-only mapping of the whole file */
+	char *map = (char *)mmap(0, SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED || check("read-only mapping", map, SIZE))
+		return -1;
+	munmap(map, SIZE);
+
+	/* read-only mapping at an offset */
+	map = (char *)mmap(0, 4096, PROT_READ, MAP_PRIVATE, fd, 8192);
+	if (map == MAP_FAILED || check("mapping at offset", map, 4096))
+		return -1;
+	munmap(map, 4096);
+
+	/* modify the file via a shared mapping, which outlives the fd */
+	map = (char *)mmap(0, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		printf("Error: could not map file writeable\n");
+		return -1;
+	}
+	close(fd);
+
+	for (size_t i = 0; i < SIZE; i += 4096)
+		map[i] = 'X';
+	munmap(map, SIZE);
+
+	fd = open("/mmap", O_RDONLY);
+	if (fd < 0 || read(fd, buf, SIZE) != SIZE) {
+		printf("Error: could not read file\n");
+		return -1;
+	}
+	close(fd);
+
+	for (size_t i = 0; i < SIZE; i++)
+		if (buf[i] != ((i % 4096) ? pattern(i) : 'X')) {
+			printf("Error: modification via mapping lost at offset %zu\n", i);
+			return -1;
+		}
+
+	printf("--- test succeeded ---\n");
+	return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * \brief  TCP throughput test in the style of iperf
+ * \author Genode Labs
+ * \date   2013-03-06
+ *
+ * The test runs twice, as server and as client. The client connects to the
+ * server and sends data as fast as possible. Both report the throughput.
+ *
+ * Configuration:
+ *
+ * :role:    'server' or 'client'
+ * :ip:      static IP address
+ * :netmask: network mask (default 255.255.255.0)
+ * :server:  IP address of the server, used by the client
+ * :port:    TCP port (default 5001)
+ * :bytes:   number of bytes sent by the client (default 64 MiB)
+ * :chunk:   number of bytes per send call (default 64 KiB)
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+/* LwIP includes */
+extern "C" {
+#include <lwip/sockets.h>
+#include <lwip/api.h>
+}
+
+#include <lwip/genode.h>
+
+using namespace Genode;
+
+
+enum { MAX_CHUNK = 64*1024 };
+
+
+struct Iperf_config
+{
+	bool          server;
+	char          ip[16];
+	char          netmask[16];
+	char          server_ip[16];
+	unsigned      port;
+	unsigned long bytes;
+	size_t        chunk;
+
+	Iperf_config()
+	: server(true), port(5001), bytes(64*1024*1024), chunk(MAX_CHUNK)
+	{
+		strncpy(ip,        "10.0.2.1",      sizeof(ip));
+		strncpy(netmask,   "255.255.255.0", sizeof(netmask));
+		strncpy(server_ip, "10.0.2.1",      sizeof(server_ip));
+
+		try {
+			Xml_node config = Genode::config()->xml_node();
+
+			try { server = !config.attribute("role").has_value("client");         } catch (...) { }
+			try { config.attribute("ip").value(ip, sizeof(ip));                   } catch (...) { }
+			try { config.attribute("netmask").value(netmask, sizeof(netmask));    } catch (...) { }
+			try { config.attribute("server").value(server_ip, sizeof(server_ip)); } catch (...) { }
+			try { config.attribute("port").value(&port);                          } catch (...) { }
+			try { config.attribute("bytes").value(&bytes);                        } catch (...) { }
+			try { config.attribute("chunk").value(&chunk);                        } catch (...) { }
+		} catch (...) { }
+
+		chunk = max((size_t)1, min(chunk, (size_t)MAX_CHUNK));
+	}
+};
+
+
+static char buf[MAX_CHUNK];
+
+
+static void report(char const *role, unsigned long long bytes, unsigned long ms)
+{
+	ms = max(1UL, ms);
+	printf("%s: %llu bytes in %lu ms, %lu KiB/s\n", role, bytes, ms,
+	       (unsigned long)(bytes*1000/1024/ms));
+}
+
+
+static int server(Iperf_config const &cfg, Timer::Session &timer)
+{
+	int s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+	if (s < 0) {
+		PERR("no socket available");
+		return -1;
+	}
+
+	struct sockaddr_in in_addr;
+	in_addr.sin_family      = AF_INET;
+	in_addr.sin_port        = htons(cfg.port);
+	in_addr.sin_addr.s_addr = INADDR_ANY;
+	if (lwip_bind(s, (struct sockaddr *)&in_addr, sizeof(in_addr))
+	 || lwip_listen(s, 1)) {
+		PERR("could not listen on port %u", cfg.port);
+		return -1;
+	}
+
+	struct sockaddr addr;
+	socklen_t len = sizeof(addr);
+	int client = lwip_accept(s, &addr, &len);
+	if (client < 0) {
+		PERR("accept failed");
+		return -1;
+	}
+
+	unsigned long long received = 0;
+	unsigned long start_ms = 0;
+
+	for (int n; (n = lwip_recv(client, buf, sizeof(buf), 0)) > 0; ) {
+		if (!received)
+			start_ms = timer.elapsed_ms();
+		received += n;
+	}
+
+	report("server", received, timer.elapsed_ms() - start_ms);
+
+	lwip_close(client);
+	lwip_close(s);
+	return 0;
+}
+
+
+static int client(Iperf_config const &cfg, Timer::Session &timer)
+{
+	struct sockaddr_in addr;
+	addr.sin_family      = AF_INET;
+	addr.sin_port        = htons(cfg.port);
+	addr.sin_addr.s_addr = inet_addr(cfg.server_ip);
+
+	/* the server may not listen yet */
+	int s;
+	for (;;) {
+		s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+		if (s < 0) {
+			PERR("no socket available");
+			return -1;
+		}
+
+		if (lwip_connect(s, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+			break;
+
+		lwip_close(s);
+		timer.msleep(100);
+	}
+
+	memset(buf, 0x55, sizeof(buf));
+
+	unsigned long long sent = 0;
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	while (sent < cfg.bytes) {
+		size_t const n = min((unsigned long long)cfg.chunk, cfg.bytes - sent);
+
+		int const ret = lwip_send(s, buf, n, 0);
+		if (ret <= 0) {
+			PERR("send failed after %llu bytes", sent);
+			break;
+		}
+		sent += ret;
+	}
+
+	report("client", sent, timer.elapsed_ms() - start_ms);
+
+	lwip_close(s);
+	return 0;
+}
+
+
+int main()
+{
+	Iperf_config cfg;
+
+	static Timer::Connection timer;
+
+	lwip_tcpip_init();
+
+	if (lwip_nic_init(inet_addr(cfg.ip), inet_addr(cfg.netmask), 0)) {
+		PERR("could not initialize network interface");
+		return -1;
+	}
+
+	printf("--- lwIP throughput test (%s %s) ---\n",
+	       cfg.server ? "server" : "client", cfg.ip);
+
+	int const ret = cfg.server ? server(cfg, timer) : client(cfg, timer);
+
+	printf("--- end of lwIP throughput test ---\n");
+	sleep_forever();
+	return ret;
+}
@@ -0,0 +1,5 @@
+TARGET   = test-lwip_iperf
+LIBS     = cxx env lwip libc libc_log
+SRC_CC   = main.cc
+
+INC_DIR += $(REP_DIR)/src/lib/lwip/include
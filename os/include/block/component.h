@@ -15,124 +15,341 @@
 #define _INCLUDE__BLOCK__COMPONENT_H_
 
 #include <root/component.h>
+#include <base/semaphore.h>
 #include <block_session/rpc_object.h>
 
 #include <block/driver.h>
+#include <block/request_scheduler.h>
 
 
 namespace Block {
 
 	using namespace Genode;
 
-	class Session_component : public Session_rpc_object
+	class Session_component : public Session_rpc_object,
+	                          public Driver::Completion
 	{
 		private:
 
-			enum { RQ_STACK_SIZE = 8192 };
+			enum {
+				RQ_STACK_SIZE   = 8192,
+				MAX_OUTSTANDING = 32,       /* batches in flight at async drivers */
+				MAX_BATCH_SIZE  = 1 << 20,  /* bytes processed by one driver call */
+				FETCH_SIZE      = 16,       /* packets taken from the queue at once */
+			};
+
 			class Rq_thread : public Thread<RQ_STACK_SIZE>
 			{
 				private:
 
-					Tx::Sink *_sink;
-					Driver   &_driver;
-					addr_t    _rq_phys; /* physical addr. of rq_ds */
+					Session_component &_session;
 
 				public:
 
-					Rq_thread(Tx::Sink *sink, Driver &driver, addr_t rq_phys)
-					:
-						Thread<RQ_STACK_SIZE>("rq"),
-						_sink(sink), _driver(driver), _rq_phys(rq_phys)
-					{ start(); }
-
-					void entry()
-					{
-						/* handle requests */
-						while (true) {
-
-							/* blocking-get packet from client */
-							Packet_descriptor packet = _sink->get_packet();
-							if (!packet.valid()) {
-								PWRN("received invalid packet");
-								continue;
-							}
-
-							packet.succeeded(true);
-
-							switch (packet.operation()) {
-
-								case Block::Packet_descriptor::READ:
-
-									try {
-										if (_driver.dma_enabled())
-											_driver.read_dma(packet.block_number(), packet.block_count(),
-											                 _rq_phys + packet.offset());
-										else
-											_driver.read(packet.block_number(), packet.block_count(),
-											             _sink->packet_content(packet));
-									} catch (Driver::Io_error) {
-										packet.succeeded(false);
-									}
-									break;
-
-								case Block::Packet_descriptor::WRITE:
-									try {
-										if (_driver.dma_enabled())
-											_driver.write_dma(packet.block_number(), packet.block_count(),
-											                  _rq_phys + packet.offset());
-										else
-											_driver.write(packet.block_number(), packet.block_count(),
-											              _sink->packet_content(packet));
-									} catch (Driver::Io_error) {
-										packet.succeeded(false);
-									}
-									break;
-
-								default:
-
-									PWRN("received invalid packet");
-									packet.succeeded(false);
-									continue;
-							}
-
-							/* acknowledge packet to the client */
-							if (!_sink->ready_to_ack())
-								PDBG("need to wait until ready-for-ack");
-
-							_sink->acknowledge_packet(packet);
-						}
-					}
+					Rq_thread(Session_component &session)
+					: Thread<RQ_STACK_SIZE>("rq"), _session(session) { }
+
+					void entry() { _session._process_requests(); }
 			};
 
+			typedef Request_scheduler::Batch Batch;
+
+			Allocator            &_md_alloc;
 			Driver_factory       &_driver_factory;
 			Driver               &_driver;
 			Dataspace_capability  _rq_ds;
+			addr_t                _rq_phys;   /* physical addr. of rq_ds */
+			Request_scheduler     _scheduler;
+			Packet_descriptor     _fetched[FETCH_SIZE];
+			Batch                 _batch;     /* used for synchronous drivers */
+
+			/*
+			 * Batches submitted to an asynchronous driver, indexed by tag
+			 *
+			 * The array is allocated from the quota donated by the client.
+			 * A slot is in use as long as its 'num' is not 0.
+			 */
+			unsigned const        _max_outstanding;
+			Batch * const         _outstanding;
+			Lock                  _outstanding_lock;
+			Semaphore             _outstanding_sem;  /* free slots */
+
+			/*
+			 * The thread of an asynchronous driver acknowledges too. While
+			 * the acknowledgement queue is full, the acknowledging thread
+			 * waits for the ready-to-ack signal of the client.
+			 */
+			Lock                  _ack_lock;
+			Signal_receiver       _ack_rec;
+			Signal_context        _ready_to_ack_ctx;
+			Signal_context_capability const _ready_to_ack_cap;
+
+			/* the request thread waits for client requests or its stop */
+			Signal_receiver       _sig_rec;
+			Signal_context        _client_ctx;
+			Signal_context        _stop_ctx;
+			bool volatile         _stop;
+
 			Rq_thread             _rq_thread;
 
+			/**
+			 * Return number of batches kept in flight at the driver
+			 *
+			 * \param quota  quota donated for the outstanding batches
+			 */
+			static unsigned _num_outstanding(Driver &driver, size_t quota)
+			{
+				return min(min(driver.max_outstanding(), (unsigned)MAX_OUTSTANDING),
+				           (unsigned)(quota / sizeof(Batch)));
+			}
+
+			Batch *_alloc_outstanding()
+			{
+				return _max_outstanding ? new (&_md_alloc) Batch[_max_outstanding] : 0;
+			}
+
+			/**
+			 * Pass completed packets back to the client
+			 *
+			 * Once the session is closed, the client does not take
+			 * acknowledgements anymore. Hence, the remaining packets are
+			 * dropped instead of blocking for a free queue slot.
+			 */
+			void _acknowledge(Packet_descriptor const *packets, unsigned num)
+			{
+				Lock::Guard guard(_ack_lock);
+
+				for (;;) {
+					unsigned const n = tx_sink()->try_acknowledge_packets(packets, num);
+					packets += n;
+					num     -= n;
+
+					if (!num || _stop)
+						return;
+
+					_ack_rec.wait_for_signal();
+				}
+			}
+
+			void _acknowledge(Batch &batch, bool success)
+			{
+				for (unsigned i = 0; i < batch.num; i++)
+					batch.packets[i].succeeded(success);
+
+				_acknowledge(batch.packets, batch.num);
+			}
+
+			/**
+			 * Pass requests of the client to the scheduler
+			 */
+			void _fetch()
+			{
+				Tx::Sink *sink = tx_sink();
+
+				while (_scheduler.capacity()) {
+
+					unsigned const num = sink->try_get_packets(_fetched,
+					                                           min(_scheduler.capacity(),
+					                                               (unsigned)FETCH_SIZE));
+					if (!num)
+						return;
+
+					for (unsigned i = 0; i < num; i++) {
+
+						Packet_descriptor &p = _fetched[i];
+						if (p.operation() == Packet_descriptor::READ
+						 || p.operation() == Packet_descriptor::WRITE) {
+							_scheduler.add(p);
+							continue;
+						}
+
+						PWRN("received invalid packet");
+						p.succeeded(false);
+						_acknowledge(&p, 1);
+					}
+				}
+			}
+
+			void _execute(Batch &batch)
+			{
+				Packet_descriptor const &first = batch.packets[0];
+				bool success = true;
+
+				try {
+					if (batch.operation() == Packet_descriptor::READ) {
+						if (_driver.dma_enabled())
+							_driver.read_dma(batch.block_number(), batch.block_count,
+							                 _rq_phys + first.offset());
+						else
+							_driver.read(batch.block_number(), batch.block_count,
+							             tx_sink()->packet_content(first));
+					} else {
+						if (_driver.dma_enabled())
+							_driver.write_dma(batch.block_number(), batch.block_count,
+							                  _rq_phys + first.offset());
+						else
+							_driver.write(batch.block_number(), batch.block_count,
+							              tx_sink()->packet_content(first));
+					}
+				} catch (Driver::Io_error) {
+					success = false;
+				}
+
+				_acknowledge(batch, success);
+			}
+
+			/**
+			 * Submit next batch to the asynchronous driver
+			 *
+			 * \return  false if no request is pending
+			 */
+			bool _submit_next()
+			{
+				/*
+				 * The caller holds a free slot of '_outstanding_sem'. The slot
+				 * gets claimed under the lock by filling the batch, which
+				 * prevents 'completed' from observing a half-filled batch.
+				 */
+				unsigned tag = 0;
+				{
+					Lock::Guard guard(_outstanding_lock);
+					while (tag < _max_outstanding && _outstanding[tag].num)
+						tag++;
+
+					if (tag == _max_outstanding) {
+						PERR("no free slot for outstanding batch");
+						return false;
+					}
+
+					if (!_scheduler.next(_outstanding[tag]))
+						return false;
+				}
+
+				Batch &batch = _outstanding[tag];
+
+				try {
+					_driver.submit(batch.operation(), batch.block_number(),
+					               batch.block_count,
+					               tx_sink()->packet_content(batch.packets[0]),
+					               _rq_phys + batch.packets[0].offset(), tag);
+				} catch (Driver::Io_error) {
+					completed(tag, false);
+				}
+				return true;
+			}
+
+			void _process_requests()
+			{
+				while (!_stop) {
+
+					_fetch();
+
+					/* all fetched packets may have been invalid */
+					if (_scheduler.empty()) {
+						_sig_rec.wait_for_signal();
+						continue;
+					}
+
+					if (!_max_outstanding) {
+						_scheduler.next(_batch);
+						_execute(_batch);
+						continue;
+					}
+
+					/* requests keep queuing up while the driver is busy */
+					_outstanding_sem.down();
+					_fetch();
+
+					/* give the slot back if there is nothing to submit */
+					if (_stop || !_submit_next())
+						_outstanding_sem.up();
+				}
+			}
+
 		public:
 
 			/**
 			 * Constructor
+			 *
+			 * \param md_alloc     allocator for the outstanding batches
+			 * \param batch_quota  quota donated for the outstanding batches,
+			 *                     limits the number of batches in flight at
+			 *                     an asynchronous driver
 			 */
-			Session_component(Dataspace_capability  rq_ds,
-			                  Driver_factory       &driver_factory,
-			                  Rpc_entrypoint       &ep)
+			Session_component(Dataspace_capability     rq_ds,
+			                  Driver_factory          &driver_factory,
+			                  Rpc_entrypoint          &ep,
+			                  unsigned                 rq_queue_size,
+			                  Allocator               &md_alloc,
+			                  size_t                   batch_quota,
+			                  Request_scheduler::Policy policy = Request_scheduler::FIFO)
 			:
-				Session_rpc_object(rq_ds, ep),
+				Session_rpc_object(rq_ds, ep, rq_queue_size),
+				_md_alloc(md_alloc),
 				_driver_factory(driver_factory),
 				_driver(*_driver_factory.create()),
 				_rq_ds(rq_ds),
-				_rq_thread(tx_sink(), _driver, Dataspace_client(rq_ds).phys_addr())
-			{ }
+				_rq_phys(Dataspace_client(rq_ds).phys_addr()),
+				_scheduler(policy, _driver.block_size(), MAX_BATCH_SIZE),
+				_max_outstanding(_num_outstanding(_driver, batch_quota)),
+				_outstanding(_alloc_outstanding()),
+				_outstanding_sem(_max_outstanding),
+				_ready_to_ack_cap(_ack_rec.manage(&_ready_to_ack_ctx)),
+				_stop(false),
+				_rq_thread(*this)
+			{
+				if (_max_outstanding)
+					_driver.completion_handler(this);
+
+				_tx.sigh_packet_avail(_sig_rec.manage(&_client_ctx));
+				_tx.sigh_ready_to_ack(_ready_to_ack_cap);
+
+				_rq_thread.start();
+			}
 
 			/**
 			 * Destructor
 			 */
 			~Session_component()
 			{
+				/*
+				 * Stop the request thread, pending requests are dropped. A
+				 * thread that waits for a free slot in the acknowledgement
+				 * queue is woken up and drops its acknowledgements.
+				 */
+				_stop = true;
+				__sync_synchronize();
+				Signal_transmitter(_sig_rec.manage(&_stop_ctx)).submit();
+				Signal_transmitter(_ready_to_ack_cap).submit();
+				_rq_thread.join();
+
+				/* wait until the driver completed all outstanding batches */
+				if (_max_outstanding) {
+					for (unsigned i = 0; i < _max_outstanding; i++)
+						_outstanding_sem.down();
+
+					_driver.completion_handler(0);
+					_md_alloc.free(_outstanding, _max_outstanding*sizeof(Batch));
+				}
+
 				_driver_factory.destroy(&_driver);
 			}
 
+			/**
+			 * Driver::Completion interface
+			 */
+			void completed(unsigned long tag, bool success)
+			{
+				Batch &batch = _outstanding[tag];
+				_acknowledge(batch, success);
+
+				{
+					Lock::Guard guard(_outstanding_lock);
+					batch.num = 0;
+				}
+				_outstanding_sem.up();
+			}
+
 			void info(size_t *blk_count, size_t *blk_size,
 			          Operations *ops)
 			{
@@ -155,8 +372,9 @@ namespace Block {
 	{
 		private:
 
-			Driver_factory &_driver_factory;
-			Rpc_entrypoint &_ep;
+			Driver_factory            &_driver_factory;
+			Rpc_entrypoint            &_ep;
+			Request_scheduler::Policy  _policy;
 
 		protected:
 
@@ -169,6 +387,9 @@ namespace Block {
 					Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 				size_t tx_buf_size =
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
 
 				/* delete ram quota by the memory needed for the session */
 				size_t session_size = max((size_t)4096,
@@ -188,18 +409,30 @@ namespace Block {
 					throw Root::Quota_exceeded();
 				}
 
+				/* the remaining quota covers batches in flight at the driver */
+				size_t const batch_quota = ram_quota - session_size - tx_buf_size;
+
 				return new (md_alloc())
 					Session_component(env()->ram_session()->alloc(tx_buf_size, false),
-					                  _driver_factory, _ep);
+					                  _driver_factory, _ep, tx_queue_size,
+					                  *md_alloc(), batch_quota, _policy);
 			}
 
 		public:
 
+			/**
+			 * Constructor
+			 *
+			 * \param policy  order in which the requests of the client are
+			 *                passed to the driver
+			 */
 			Root(Rpc_entrypoint *session_ep, Allocator *md_alloc,
-			     Driver_factory &driver_factory)
+			     Driver_factory &driver_factory,
+			     Request_scheduler::Policy policy = Request_scheduler::FIFO)
 			:
 				Root_component(session_ep, md_alloc),
-				_driver_factory(driver_factory), _ep(*session_ep)
+				_driver_factory(driver_factory), _ep(*session_ep),
+				_policy(policy)
 			{ }
 	};
 }
@@ -17,6 +17,7 @@
 
 #include <base/exception.h>
 #include <base/stdint.h>
+#include <block_session/block_session.h>
 
 
 namespace Block {
@@ -91,6 +92,69 @@ namespace Block {
 		 * \return  true if DMA is enabled, false otherwise
 		 */
 		virtual bool dma_enabled() = 0;
+
+
+		/*************************************
+		 ** Optional asynchronous interface **
+		 *************************************/
+
+		/**
+		 * Interface for reporting the completion of asynchronous requests
+		 */
+		struct Completion
+		{
+			virtual ~Completion() { }
+
+			/**
+			 * Called by the driver once a submitted request is processed
+			 *
+			 * \param tag      value passed to 'submit'
+			 * \param success  false if the request failed
+			 */
+			virtual void completed(unsigned long tag, bool success) = 0;
+		};
+
+		/**
+		 * Return number of requests the driver can keep outstanding
+		 *
+		 * Drivers that return a value greater than zero implement 'submit'
+		 * and report completions to the handler registered via
+		 * 'completion_handler'. For all other drivers, the synchronous
+		 * functions above are used.
+		 */
+		virtual unsigned max_outstanding() { return 0; }
+
+		/**
+		 * Register handler for the completion of asynchronous requests
+		 *
+		 * The session unregisters its handler by passing 0 once no request
+		 * is outstanding anymore.
+		 */
+		virtual void completion_handler(Completion *) { }
+
+		/**
+		 * Submit asynchronous request
+		 *
+		 * \param op            read or write operation
+		 * \param block_number  number of first block
+		 * \param block_count   number of blocks
+		 * \param buffer        local address of the data buffer
+		 * \param phys          physical address of the data buffer if DMA
+		 *                      is enabled
+		 * \param tag           value passed to the completion handler
+		 *
+		 * \throw Io_error      request could not be submitted, in which
+		 *                      case no completion is reported
+		 */
+		virtual void submit(Packet_descriptor::Opcode op,
+		                    Genode::size_t            block_number,
+		                    Genode::size_t            block_count,
+		                    char                     *buffer,
+		                    Genode::addr_t            phys,
+		                    unsigned long             tag)
+		{
+			throw Io_error();
+		}
 	};
 
 
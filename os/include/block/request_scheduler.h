@@ -0,0 +1,256 @@
+/*
+ * \brief  Ordering and merging of pending block requests
+ * \author Genode Labs
+ * \date   2013-02-18
+ *
+ * The scheduler collects the requests of a block session and selects the
+ * next request to pass to the driver. Requests that access adjacent blocks
+ * and reside at adjacent bulk-buffer locations are merged into one batch,
+ * which is processed by a single driver call. The order of requests is
+ * determined by a policy:
+ *
+ * :fifo:     requests are processed in the order of their arrival
+ * :elevator: requests are processed in ascending block order starting at
+ *            the end of the previous batch (circular scan)
+ * :deadline: like elevator, but a request that was passed over too often
+ *            is processed next
+ *
+ * Regardless of the policy, a request never overtakes an earlier request
+ * that accesses an overlapping block range if one of both is a write.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _INCLUDE__BLOCK__REQUEST_SCHEDULER_H_
+#define _INCLUDE__BLOCK__REQUEST_SCHEDULER_H_
+
+#include <block_session/block_session.h>
+#include <os/config.h>
+#include <util/string.h>
+
+
+namespace Block {
+
+	class Request_scheduler
+	{
+		public:
+
+			enum Policy { FIFO, ELEVATOR, DEADLINE };
+
+			enum {
+				MAX_PENDING     = 64, /* requests considered for scheduling */
+				MAX_MERGE       = 32, /* requests merged into one batch */
+				DEADLINE_ROUNDS = 16, /* batches a request may be passed over */
+			};
+
+			/**
+			 * Requests processed by one driver call
+			 */
+			struct Batch
+			{
+				Packet_descriptor packets[MAX_MERGE];
+				unsigned          num;
+				Genode::size_t    block_count;  /* of all requests */
+
+				Batch() : num(0), block_count(0) { }
+
+				Packet_descriptor::Opcode operation() const {
+					return packets[0].operation(); }
+
+				Genode::size_t block_number() const {
+					return packets[0].block_number(); }
+			};
+
+			/**
+			 * Read policy from the 'scheduler' attribute of the config node
+			 *
+			 * \return  configured policy, or 'FIFO' if not configured
+			 */
+			static Policy policy_from_config()
+			{
+				char buf[16];
+				try {
+					Genode::config()->xml_node().attribute("scheduler").value(buf, sizeof(buf));
+				} catch (...) { return FIFO; }
+
+				if (!Genode::strcmp(buf, "elevator")) return ELEVATOR;
+				if (!Genode::strcmp(buf, "deadline")) return DEADLINE;
+				if (Genode::strcmp(buf, "fifo"))
+					PWRN("unknown scheduler policy '%s', using 'fifo'", buf);
+
+				return FIFO;
+			}
+
+		private:
+
+			struct Entry
+			{
+				Packet_descriptor packet;
+				unsigned          age;   /* number of batches dispatched since arrival */
+			};
+
+			Policy         const _policy;
+			Genode::size_t const _block_size;
+			Genode::size_t const _max_blocks;  /* merge limit per batch */
+
+			Entry          _pending[MAX_PENDING]; /* in order of arrival */
+			unsigned       _num_pending;
+			Genode::size_t _head;                 /* block following the last batch */
+
+			void _remove(unsigned i)
+			{
+				for (_num_pending--; i < _num_pending; i++)
+					_pending[i] = _pending[i + 1];
+			}
+
+			/**
+			 * Return true if the request must not overtake an earlier one
+			 *
+			 * A read must not pass a write to the same blocks and vice versa.
+			 */
+			bool _ordered_after_earlier(unsigned i) const
+			{
+				Packet_descriptor const &p = _pending[i].packet;
+
+				for (unsigned j = 0; j < i; j++) {
+					Packet_descriptor const &q = _pending[j].packet;
+
+					if (p.operation() == Packet_descriptor::READ
+					 && q.operation() == Packet_descriptor::READ)
+						continue;
+
+					if (p.block_number() < q.block_number() + q.block_count()
+					 && q.block_number() < p.block_number() + p.block_count())
+						return true;
+				}
+				return false;
+			}
+
+			/**
+			 * Select first request of the next batch
+			 */
+			unsigned _select() const
+			{
+				if (_policy == FIFO)
+					return 0;
+
+				/* the oldest request is always at the front */
+				if (_policy == DEADLINE && _pending[0].age >= DEADLINE_ROUNDS)
+					return 0;
+
+				/* the oldest request is never ordered after another one */
+				unsigned ahead = MAX_PENDING, lowest = 0;
+				for (unsigned i = 0; i < _num_pending; i++) {
+					Genode::size_t const nr = _pending[i].packet.block_number();
+
+					if (_ordered_after_earlier(i))
+						continue;
+
+					if (nr < _pending[lowest].packet.block_number())
+						lowest = i;
+
+					if (nr >= _head && (ahead == MAX_PENDING
+					 || nr < _pending[ahead].packet.block_number()))
+						ahead = i;
+				}
+				return ahead != MAX_PENDING ? ahead : lowest;
+			}
+
+			/**
+			 * Find pending request that continues the batch
+			 *
+			 * \return  index of request, or 'MAX_PENDING' if there is none
+			 */
+			unsigned _successor(Batch const &batch) const
+			{
+				Packet_descriptor const &last = batch.packets[batch.num - 1];
+
+				Genode::size_t const next_block  = batch.block_number() + batch.block_count;
+				Genode::off_t  const next_offset = last.offset()
+				                                 + last.block_count() * _block_size;
+
+				/* FIFO order permits merging with the next request only */
+				unsigned const num = _policy == FIFO ? Genode::min(_num_pending, 1U)
+				                                     : _num_pending;
+				for (unsigned i = 0; i < num; i++) {
+					Packet_descriptor const &p = _pending[i].packet;
+
+					if (p.operation()    == batch.operation()
+					 && p.block_number() == next_block
+					 && p.offset()       == next_offset
+					 && batch.block_count + p.block_count() <= _max_blocks
+					 && !_ordered_after_earlier(i))
+						return i;
+				}
+				return MAX_PENDING;
+			}
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param block_size      block size of the device
+			 * \param max_batch_size  maximum number of bytes processed by
+			 *                        one driver call
+			 */
+			Request_scheduler(Policy policy, Genode::size_t block_size,
+			                  Genode::size_t max_batch_size)
+			:
+				_policy(policy), _block_size(block_size),
+				_max_blocks(max_batch_size / block_size),
+				_num_pending(0), _head(0)
+			{ }
+
+			bool     empty()    const { return _num_pending == 0; }
+			unsigned capacity() const { return MAX_PENDING - _num_pending; }
+
+			/**
+			 * Add request
+			 *
+			 * The caller must not exceed the capacity of the scheduler.
+			 */
+			void add(Packet_descriptor const &packet)
+			{
+				_pending[_num_pending].packet = packet;
+				_pending[_num_pending].age    = 0;
+				_num_pending++;
+			}
+
+			/**
+			 * Remove next batch of requests
+			 *
+			 * \return  false if no request is pending
+			 */
+			bool next(Batch &batch)
+			{
+				if (empty())
+					return false;
+
+				unsigned i = _select();
+
+				batch.num         = 0;
+				batch.block_count = 0;
+
+				do {
+					batch.packets[batch.num++] = _pending[i].packet;
+					batch.block_count         += _pending[i].packet.block_count();
+					_remove(i);
+				} while (batch.num < MAX_MERGE
+				      && (i = _successor(batch)) != MAX_PENDING);
+
+				for (unsigned j = 0; j < _num_pending; j++)
+					_pending[j].age++;
+
+				_head = batch.block_number() + batch.block_count;
+				return true;
+			}
+	};
+}
+
+#endif /* _INCLUDE__BLOCK__REQUEST_SCHEDULER_H_ */
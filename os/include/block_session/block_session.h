@@ -84,6 +84,12 @@ namespace Block {
 
 	struct Session : public Genode::Session
 	{
+		/**
+		 * Default number of packet-queue slots
+		 *
+		 * The client may request a different power of two via the
+		 * 'tx_queue_size' session argument.
+		 */
 		enum { TX_QUEUE_SIZE = 256 };
 
 
@@ -56,6 +56,11 @@ namespace Block {
 			Tx *tx_channel() { return &_tx; }
 			Tx::Source *tx() { return _tx.source(); }
 
+			/**
+			 * Return number of packet-queue slots chosen by the server
+			 */
+			unsigned tx_queue_size() { return tx()->submit_queue_size(); }
+
 			/*
 			 * Wrapper for alloc_packet, allocates 2KB aligned packets
 			 */
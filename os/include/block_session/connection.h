@@ -22,20 +22,34 @@ namespace Block {
 
 	struct Connection : Genode::Connection<Session>, Session_client
 	{
+		/*
+		 * Quota donated for the session besides the transmission buffer
+		 */
+		enum { SESSION_QUOTA = 3*4096 };
+
 		/**
 		 * Constructor
 		 *
 		 * \param tx_buffer_alloc  allocator used for managing the
 		 *                         transmission buffer
 		 * \param tx_buf_size      size of transmission buffer in bytes
+		 * \param tx_queue_size    number of packet-queue slots, rounded
+		 *                         down to a power of two by the server
+		 * \param batch_quota      additional quota for requests kept in
+		 *                         flight at an asynchronous driver, the
+		 *                         server limits the number of requests in
+		 *                         flight to what this quota covers
 		 */
 		Connection(Genode::Range_allocator *tx_block_alloc,
 		           Genode::size_t           tx_buf_size = 128*1024,
-		           const char              *label = "")
+		           const char              *label = "",
+		           unsigned                 tx_queue_size = TX_QUEUE_SIZE,
+		           Genode::size_t           batch_quota = 0)
 		:
 			Genode::Connection<Session>(
-				session("ram_quota=%zd, tx_buf_size=%zd, label=\"%s\"",
-				        3*4096 + tx_buf_size, tx_buf_size, label)),
+				session("ram_quota=%zd, tx_buf_size=%zd, tx_queue_size=%u, label=\"%s\"",
+				        SESSION_QUOTA + batch_quota + tx_buf_size, tx_buf_size,
+				        tx_queue_size, label)),
 			Session_client(cap(), tx_block_alloc) { }
 	};
 }
@@ -49,6 +49,11 @@ namespace File_system {
 
 			Tx::Source *tx() { return _tx.source(); }
 
+			/**
+			 * Return number of packet-queue slots chosen by the server
+			 */
+			unsigned tx_queue_size() { return tx()->submit_queue_size(); }
+
 			File_handle file(Dir_handle dir, Name const &name, Mode mode, bool create)
 			{
 				return call<Rpc_file>(dir, name, mode, create);
@@ -100,6 +105,12 @@ namespace File_system {
 				call<Rpc_move>(from_dir, from_name, to_dir, to_name);
 			}
 
+			Dataspace_capability dataspace(File_handle file, file_size_t size,
+			                               bool writeable)
+			{
+				return call<Rpc_dataspace>(file, size, writeable);
+			}
+
 	};
 }
 
@@ -28,14 +28,22 @@ namespace File_system {
 		 * \param tx_buffer_alloc  allocator used for managing the
 		 *                         transmission buffer
 		 * \param tx_buf_size      size of transmission buffer in bytes
+		 * \param tx_queue_size    number of packet-queue slots, rounded
+		 *                         down to a power of two by the server
+		 * \param ds_quota         additional quota donated for the
+		 *                         dataspaces of files, which a server may
+		 *                         charge for 'dataspace'
 		 */
 		Connection(Range_allocator &tx_block_alloc,
 		           size_t           tx_buf_size = 128*1024,
-		           const char      *label = "")
+		           const char      *label = "",
+		           unsigned         tx_queue_size = TX_QUEUE_SIZE,
+		           size_t           ds_quota = 0)
 		:
 			Genode::Connection<Session>(
-				session("ram_quota=%zd, tx_buf_size=%zd, label=\"%s\"",
-				        3*4096 + tx_buf_size, tx_buf_size, label)),
+				session("ram_quota=%zd, tx_buf_size=%zd, tx_queue_size=%u, label=\"%s\"",
+				        3*4096 + tx_buf_size + ds_quota, tx_buf_size,
+				        tx_queue_size, label)),
 			Session_client(cap(), tx_block_alloc) { }
 	};
 }
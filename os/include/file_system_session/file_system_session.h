@@ -15,6 +15,7 @@
 #define _INCLUDE__FILE_SYSTEM_SESSION__FILE_SYSTEM_SESSION_H_
 
 #include <base/exception.h>
+#include <dataspace/capability.h>
 #include <os/packet_stream.h>
 #include <packet_stream_tx/packet_stream_tx.h>
 #include <session/session.h>
@@ -187,6 +188,12 @@ namespace File_system {
 
 	struct Session : public Genode::Session
 	{
+		/**
+		 * Default number of packet-queue slots
+		 *
+		 * The client may request a different power of two via the
+		 * 'tx_queue_size' session argument.
+		 */
 		enum { TX_QUEUE_SIZE = 16 };
 
 		typedef Packet_stream_policy<File_system::Packet_descriptor,
@@ -273,6 +280,33 @@ namespace File_system {
 		virtual void move(Dir_handle, Name const &from,
 		                  Dir_handle, Name const &to) = 0;
 
+		/**
+		 * Request dataspace with the content of a file
+		 *
+		 * The dataspace holds the file content starting at dataspace
+		 * offset 0. If the file system hands out its storage, the
+		 * dataspace is shared with other clients of the file and
+		 * modifications of a writeable dataspace are applied to the file
+		 * without further synchronization. The file length is not changed
+		 * by writing to the dataspace.
+		 *
+		 * \param size       number of bytes from the start of the file
+		 *                   that must be covered by the dataspace
+		 * \param writeable  request dataspace for modifying the file
+		 *
+		 * \throw Invalid_handle
+		 * \throw Permission_denied  writeable dataspace of a read-only
+		 *                           file requested
+		 *
+		 * \return  invalid capability if the file system cannot provide
+		 *          the content of the file as dataspace, in which case
+		 *          the client has to use packets
+		 *
+		 * The dataspace remains valid while the file handle is open.
+		 */
+		virtual Dataspace_capability dataspace(File_handle, file_size_t size,
+		                                       bool writeable) = 0;
+
 
 		/*******************
 		 ** RPC interface **
@@ -307,6 +341,9 @@ namespace File_system {
 		GENODE_RPC_THROW(Rpc_move, void, move,
 		                 GENODE_TYPE_LIST(Permission_denied, Invalid_name, Lookup_failed),
 		                 Dir_handle, Name const &, Dir_handle, Name const &);
+		GENODE_RPC_THROW(Rpc_dataspace, Dataspace_capability, dataspace,
+		                 GENODE_TYPE_LIST(Invalid_handle, Permission_denied),
+		                 File_handle, file_size_t, bool);
 
 		/*
 		 * Manual type-list definition, needed because the RPC interface
@@ -324,8 +361,9 @@ namespace File_system {
 		        Meta::Type_tuple<Rpc_unlink,
 		        Meta::Type_tuple<Rpc_truncate,
 		        Meta::Type_tuple<Rpc_move,
+		        Meta::Type_tuple<Rpc_dataspace,
 		                         Meta::Empty>
-		        > > > > > > > > > > Rpc_functions;
+		        > > > > > > > > > > > Rpc_functions;
 	};
 }
 
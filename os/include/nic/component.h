@@ -16,17 +16,17 @@
 
 #include <base/env.h>
 #include <nic_session/rpc_object.h>
-#include <base/allocator_avl.h>
 #include <util/arg_string.h>
 #include <base/rpc_server.h>
 #include <root/component.h>
 #include <nic/driver.h>
+#include <nic/packet_allocator.h>
 
 enum { VERBOSE_RX = false };
 
 namespace Nic {
 
-	class Session_component : public Genode::Allocator_avl,
+	class Session_component : public Nic::Packet_allocator,
 	                          public Session_rpc_object, public Rx_buffer_alloc
 	{
 		private:
@@ -59,26 +59,47 @@ namespace Nic {
 					{
 						using namespace Genode;
 
+						enum { MAX_BATCH = 32 };
+						Packet_descriptor packets[MAX_BATCH];
+						Driver::Tx_packet tx_packets[MAX_BATCH];
+
 						while (true) {
 
-							/* block for packet from client */
-							Packet_descriptor packet = _tx_sink->get_packet();
-							if (!packet.valid()) {
-								PWRN("received invalid packet");
-								continue;
+							/* block for packets from client */
+							unsigned const num = _tx_sink->get_packets(packets, MAX_BATCH);
+
+							unsigned num_valid = 0;
+							for (unsigned i = 0; i < num; i++) {
+								char const *content = _tx_sink->packet_content(packets[i]);
+								if (!content) {
+									PWRN("received invalid packet");
+									continue;
+								}
+
+								tx_packets[num_valid].addr = content;
+								tx_packets[num_valid].size = packets[i].size();
+								packets[num_valid++] = packets[i];
 							}
 
-							_driver.tx(_tx_sink->packet_content(packet),
-							           packet.size());
+							_driver.tx_batch(tx_packets, num_valid);
 
-							/* acknowledge packet to the client */
+							/* acknowledge packets to the client */
 							if (!_tx_sink->ready_to_ack())
 								PDBG("need to wait until ready-for-ack");
-							_tx_sink->acknowledge_packet(packet);
+							_tx_sink->acknowledge_packets(packets, num_valid);
 						}
 					}
 			} _tx_thread;
 
+			/**
+			 * Free the buffers of packets acknowledged by the client
+			 */
+			void _release_acked_packets()
+			{
+				while (_rx.source()->ack_avail())
+					_rx.source()->release_packet(_rx.source()->get_acked_packet());
+			}
+
 			void dump()
 			{
 				using namespace Genode;
@@ -103,16 +124,23 @@ namespace Nic {
 			 * \param rx_buf_size        buffer size for rx channel
 			 * \param rx_block_alloc     rx block allocator
 			 * \param ep                 entry point used for packet stream
+			 * \param tx_queue_size      number of packet-queue slots for tx
+			 *                           channel
+			 * \param rx_queue_size      number of packet-queue slots for rx
+			 *                           channel
 			 */
 			Session_component(Genode::size_t          tx_buf_size,
 			                  Genode::size_t          rx_buf_size,
 			                  Nic::Driver_factory    &driver_factory,
-			                  Genode::Rpc_entrypoint &ep)
+			                  Genode::Rpc_entrypoint &ep,
+			                  unsigned                tx_queue_size,
+			                  unsigned                rx_queue_size)
 			:
-				Genode::Allocator_avl(Genode::env()->heap()),
+				Nic::Packet_allocator(Genode::env()->heap()),
 				Session_rpc_object(Genode::env()->ram_session()->alloc(tx_buf_size),
 				                   Genode::env()->ram_session()->alloc(rx_buf_size),
-				                   static_cast<Genode::Range_allocator *>(this), ep),
+				                   static_cast<Genode::Range_allocator *>(this), ep,
+				                   tx_queue_size, rx_queue_size),
 				_driver_factory(driver_factory),
 				_driver(*driver_factory.create(*this)),
 				_tx_thread(_tx.sink(), _driver)
@@ -133,6 +161,20 @@ namespace Nic {
 
 			void *alloc(Genode::size_t size)
 			{
+				/*
+				 * A driver that drops frames while the buffer is exhausted
+				 * does not call 'submit'. So, the buffer must be replenished
+				 * here.
+				 */
+				_release_acked_packets();
+
+				/* the rx buffer is divided into blocks of the default size */
+				if (size > Packet_allocator::DEFAULT_PACKET_SIZE) {
+					PERR("rx packet of %zd bytes exceeds maximum of %d bytes",
+					     size, (int)Packet_allocator::DEFAULT_PACKET_SIZE);
+					throw Session::Rx::Source::Packet_alloc_failed();
+				}
+
 				/* assign rx packet descriptor */
 				_curr_rx_packet = _rx.source()->alloc_packet(size);
 
@@ -142,12 +184,7 @@ namespace Nic {
 			void submit()
 			{
 				/* check for acknowledgements from the client */
-				while (_rx.source()->ack_avail()) {
-					Packet_descriptor packet = _rx.source()->get_acked_packet();
-
-					/* free packet buffer */
-					_rx.source()->release_packet(packet);
-				}
+				_release_acked_packets();
 
 				dump();
 
@@ -157,6 +194,13 @@ namespace Nic {
 				_curr_rx_packet = Packet_descriptor();
 			}
 
+			void submit(Genode::size_t size)
+			{
+				/* the allocator frees the whole buffer on release */
+				_curr_rx_packet = Packet_descriptor(_curr_rx_packet.offset(), size);
+				submit();
+			}
+
 
 			/****************************
 			 ** Nic::Session interface **
@@ -197,10 +241,17 @@ namespace Nic {
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
 				Genode::size_t rx_buf_size =
 					Arg_string::find_arg(args, "rx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
+				unsigned rx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "rx_queue_size").ulong_value(Session::RX_QUEUE_SIZE));
 
 				/* delete ram quota by the memory needed for the session */
 				Genode::size_t session_size = max((Genode::size_t)4096, sizeof(Session_component)
-				                                  + sizeof(Allocator_avl));
+				                                  + rx_buf_size / Packet_allocator::DEFAULT_PACKET_SIZE
+				                                  * 2*sizeof(unsigned));
 				if (ram_quota < session_size)
 					throw Root::Quota_exceeded();
 
@@ -220,7 +271,9 @@ namespace Nic {
 				return new (md_alloc()) Session_component(tx_buf_size,
 				                                          rx_buf_size,
 				                                          _driver_factory,
-				                                          _ep);
+				                                          _ep,
+				                                          tx_queue_size,
+				                                          rx_queue_size);
 			}
 
 		public:
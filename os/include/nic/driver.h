@@ -33,6 +33,15 @@ namespace Nic {
 		 * Submit packet to client
 		 */
 		virtual void submit() = 0;
+
+		/**
+		 * Submit the first 'size' bytes of the packet buffer to client
+		 *
+		 * Drivers that receive directly into the packet buffer allocate a
+		 * buffer of the maximum frame size before the size of the incoming
+		 * frame is known.
+		 */
+		virtual void submit(Genode::size_t size) = 0;
 	};
 
 
@@ -57,6 +66,28 @@ namespace Nic {
 		 * length (in the worst case, 3 bytes after the packet end).
 		 */
 		virtual void tx(char const *packet, Genode::size_t size) = 0;
+
+		/**
+		 * Packet of a transmit batch
+		 */
+		struct Tx_packet
+		{
+			char const     *addr;
+			Genode::size_t  size;
+		};
+
+		/**
+		 * Transmit batch of packets
+		 *
+		 * Drivers that can hand several packets to the device at once
+		 * override this function. By default, the packets are transmitted
+		 * one by one.
+		 */
+		virtual void tx_batch(Tx_packet const *packets, unsigned num)
+		{
+			for (unsigned i = 0; i < num; i++)
+				tx(packets[i].addr, packets[i].size);
+		}
 	};
 
 
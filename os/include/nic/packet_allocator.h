@@ -1,13 +1,20 @@
 /*
- * \brief  Fast-bitmap allocator for NIC-session packet streams
+ * \brief  Fast packet allocator for NIC-session packet streams
  * \author Sebastian Sumpf
  * \date   2012-07-30
  *
  * This allocator can be used with a nic session. It is *not* required though.
+ *
+ * The bulk buffer is divided into blocks of up to two sizes, a small size
+ * for regular frames and an optional large size, e.g., for jumbo frames or
+ * segmentation offload. The free blocks of each size are kept on a stack of
+ * block indices. Hence, allocation and deallocation take constant time, and
+ * the most recently freed block, which is likely still cached, is allocated
+ * first.
  */
 
 /*
- * Copyright (C) 2012 Genode Labs GmbH
+ * Copyright (C) 2012-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -25,12 +32,97 @@ namespace Nic {
 	{
 		private:
 
+			/**
+			 * Blocks of one size
+			 */
+			struct Size_class
+			{
+				Genode::size_t  block_size;
+				Genode::addr_t  base;      /* address of first block */
+				unsigned        count;     /* number of blocks */
+				unsigned       *free;      /* stack of free block indices */
+				unsigned        num_free;  /* number of stack elements */
+				unsigned       *used;      /* bitmap of allocated blocks */
+
+				bool contains(Genode::addr_t addr) const {
+					return count && addr >= base && addr - base < count*block_size; }
+
+				bool alloc(void **out_addr)
+				{
+					if (!num_free)
+						return false;
+
+					unsigned const i = free[--num_free];
+					used[i / 32] |= 1U << (i % 32);
+
+					*out_addr = reinterpret_cast<void *>(base + i*block_size);
+					return true;
+				}
+
+				void free_block(Genode::addr_t addr)
+				{
+					unsigned const i = (addr - base) / block_size;
+
+					/* ignore double frees */
+					if (!(used[i / 32] & (1U << (i % 32))))
+						return;
+
+					used[i / 32] &= ~(1U << (i % 32));
+					free[num_free++] = i;
+				}
+			};
+
+			enum { SMALL, LARGE, NUM_CLASSES };
+
 			Genode::Allocator *_md_alloc;   /* meta-data allocator */
-			unsigned           _block_size; /* network packet size */
-			Genode::addr_t     _base;       /* allocation base */
-			unsigned          *_free;       /* free list */
-			int                _curr_idx;   /* current index in free list */
-			int                _count;      /* number of elements */
+			Size_class         _classes[NUM_CLASSES];
+			unsigned           _large_share;
+
+			static Genode::size_t _md_size(unsigned count) {
+				return sizeof(unsigned)*(count + (count + 31) / 32); }
+
+			/**
+			 * Set up blocks of one size
+			 *
+			 * \return  false if the meta data could not be allocated
+			 */
+			bool _init_class(Size_class &c, Genode::addr_t base, unsigned count)
+			{
+				c.base     = base;
+				c.count    = 0;
+				c.free     = 0;
+				c.used     = 0;
+				c.num_free = 0;
+
+				if (!count)
+					return true;
+
+				void *md = 0;
+				if (!_md_alloc->alloc(_md_size(count), &md))
+					return false;
+
+				c.count = count;
+				c.free  = (unsigned *)md;
+				c.used  = c.free + count;
+				Genode::memset(c.used, 0, sizeof(unsigned)*((count + 31) / 32));
+
+				/* push in descending order so that the first block is allocated first */
+				for (unsigned i = count; i > 0; i--)
+					c.free[c.num_free++] = i - 1;
+
+				return true;
+			}
+
+			void _destroy_class(Size_class &c)
+			{
+				if (c.free)
+					_md_alloc->free(c.free, _md_size(c.count));
+
+				c.count    = 0;
+				c.free     = 0;
+				c.used     = 0;
+				c.num_free = 0;
+			}
 
 		public:
 
@@ -39,19 +131,37 @@ namespace Nic {
 			/**
 			 * Constructor
 			 *
-			 * \param md_alloc       Meta-data allocator
-			 * \param block_size     Size of network packet in stream
+			 * \param md_alloc          Meta-data allocator
+			 * \param block_size        Size of network packet in stream
+			 * \param large_block_size  Size of large packets, 0 if only
+			 *                          packets of 'block_size' are used
+			 * \param large_share       Percentage of the bulk buffer used
+			 *                          for large packets
+			 *
+			 * Small packets are allocated from large blocks if no small
+			 * block is available.
 			 */
 			Packet_allocator(Genode::Allocator *md_alloc,
-			                 unsigned block_size = DEFAULT_PACKET_SIZE)
-			: _md_alloc(md_alloc), _block_size(block_size), _base(0), _free(0),
-			  _curr_idx(0), _count(0)
-			{}
+			                 unsigned block_size       = DEFAULT_PACKET_SIZE,
+			                 unsigned large_block_size = 0,
+			                 unsigned large_share      = 50)
+			: _md_alloc(md_alloc), _large_share(Genode::min(large_share, 100U))
+			{
+				_classes[SMALL].block_size = block_size;
+				_classes[LARGE].block_size = large_block_size;
+
+				for (unsigned i = 0; i < NUM_CLASSES; i++) {
+					_classes[i].count    = 0;
+					_classes[i].num_free = 0;
+					_classes[i].free     = 0;
+					_classes[i].used     = 0;
+				}
+			}
 
 			~Packet_allocator()
 			{
-				if (_free)
-					_md_alloc->free(_free, sizeof(unsigned) * (_count / 32));
+				for (unsigned i = 0; i < NUM_CLASSES; i++)
+					_destroy_class(_classes[i]);
 			}
 
 
@@ -61,14 +171,25 @@ namespace Nic {
 
 			int add_range(Genode::addr_t base, Genode::size_t size)
 			{
-				if (_count)
+				if (_classes[SMALL].count || _classes[LARGE].count)
 					return -1;
 
-				_base  = base;
-				_count = size / _block_size;
-				_free  = (unsigned *)_md_alloc->alloc(sizeof(unsigned) * (_count / 32));
+				Size_class &small = _classes[SMALL], &large = _classes[LARGE];
+
+				/* large blocks reside at the end of the range */
+				unsigned large_count = 0;
+				if (large.block_size > small.block_size)
+					large_count = (size / 100 * _large_share) / large.block_size;
+
+				Genode::size_t const small_size = size - large_count*large.block_size;
 
-				Genode::memset(_free, 0xff, sizeof(unsigned) * (_count / 32));
+				if (!_init_class(small, base, small_size / small.block_size))
+					return -1;
+
+				if (!_init_class(large, base + small_size, large_count)) {
+					_destroy_class(small);
+					return -1;
+				}
 				return 0;
 			}
 
@@ -77,24 +198,11 @@ namespace Nic {
 				                             : Alloc_return::RANGE_CONFLICT; }
 
 			bool alloc(Genode::size_t size, void **out_addr)
-			{ 
-				int free_cnt = _count / 32;
-
-				for (register int i = 0; i < free_cnt; i++) {
-
-					if (_free[_curr_idx] != 0) {
-						unsigned msb = Genode::log2(_free[_curr_idx]);
-						int elem_idx = (_curr_idx * 32) + msb;
-
-						if (elem_idx < _count) {
-							_free[_curr_idx] ^= (1 << msb);
-							*out_addr = reinterpret_cast<void *>(_base + (_block_size * elem_idx));
-							return true;
-						}
-					}
+			{
+				for (unsigned i = 0; i < NUM_CLASSES; i++)
+					if (size <= _classes[i].block_size && _classes[i].alloc(out_addr))
+						return true;
 
-					_curr_idx = (_curr_idx + 1) % free_cnt;
-				}
 				return false;
 			}
 
@@ -102,16 +210,31 @@ namespace Nic {
 			{
 				Genode::addr_t a = reinterpret_cast<Genode::addr_t>(addr);
 
-				int elem_idx = (a - _base) / _block_size;
-				if (elem_idx >= _count)
-					return;
-
-				_curr_idx = elem_idx / 32;
-				_free[_curr_idx] |= (1 << (elem_idx % 32));
+				for (unsigned i = 0; i < NUM_CLASSES; i++)
+					if (_classes[i].contains(a)) {
+						_classes[i].free_block(a);
+						return;
+					}
 			}
 
 			void free(void *addr, Genode::size_t) { free(addr); }
 
+			Genode::size_t avail()
+			{
+				Genode::size_t result = 0;
+				for (unsigned i = 0; i < NUM_CLASSES; i++)
+					result += _classes[i].num_free*_classes[i].block_size;
+				return result;
+			}
+
+			bool valid_addr(Genode::addr_t addr)
+			{
+				for (unsigned i = 0; i < NUM_CLASSES; i++)
+					if (_classes[i].contains(addr))
+						return true;
+				return false;
+			}
+
 
 			/*********************
 			 ** Dummy functions **
@@ -119,8 +242,6 @@ namespace Nic {
 
 			Genode::size_t overhead(Genode::size_t) {  return 0;}
 			int remove_range(Genode::addr_t, Genode::size_t) { return 0;}
-			Genode::size_t avail() { return 0; }
-			bool valid_addr(Genode::addr_t) { return 0; }
 			Alloc_return alloc_addr(Genode::size_t, Genode::addr_t) {
 				return Alloc_return(Alloc_return::OUT_OF_METADATA); }
 	};
@@ -55,6 +55,12 @@ namespace Nic {
 			Rx *rx_channel() { return &_rx; }
 			Tx::Source *tx() { return _tx.source(); }
 			Rx::Sink   *rx() { return _rx.sink(); }
+
+			/**
+			 * Return numbers of packet-queue slots chosen by the server
+			 */
+			unsigned tx_queue_size() { return tx()->submit_queue_size(); }
+			unsigned rx_queue_size() { return rx()->submit_queue_size(); }
 	};
 }
 
@@ -29,15 +29,24 @@ namespace Nic {
 		 *                         transmission buffer
 		 * \param tx_buf_size      size of transmission buffer in bytes
 		 * \param rx_buf_size      size of reception buffer in bytes
+		 * \param tx_queue_size    number of packet-queue slots of the
+		 *                         transmission packet stream
+		 * \param rx_queue_size    number of packet-queue slots of the
+		 *                         reception packet stream
+		 *
+		 * The queue sizes are rounded down to powers of two by the server.
 		 */
 		Connection(Genode::Range_allocator *tx_block_alloc,
-		           Genode::size_t           tx_buf_size = 64*1024,
-		           Genode::size_t           rx_buf_size = 64*1024)
+		           Genode::size_t           tx_buf_size   = 64*1024,
+		           Genode::size_t           rx_buf_size   = 64*1024,
+		           unsigned                 tx_queue_size = TX_QUEUE_SIZE,
+		           unsigned                 rx_queue_size = RX_QUEUE_SIZE)
 		:
 			Genode::Connection<Session>(
-				session("ram_quota=%zd, tx_buf_size=%zd, rx_buf_size=%zd",
+				session("ram_quota=%zd, tx_buf_size=%zd, rx_buf_size=%zd, "
+				        "tx_queue_size=%u, rx_queue_size=%u",
 				        6*4096 + tx_buf_size + rx_buf_size,
-				        tx_buf_size, rx_buf_size)),
+				        tx_buf_size, rx_buf_size, tx_queue_size, rx_queue_size)),
 			Session_client(cap(), tx_block_alloc)
 		{ }
 	};
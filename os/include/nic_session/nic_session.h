@@ -39,6 +39,12 @@ namespace Nic {
 
 	struct Session : Genode::Session
 	{
+		/**
+		 * Default numbers of packet-queue slots
+		 *
+		 * The client may request different powers of two via the
+		 * 'tx_queue_size' and 'rx_queue_size' session arguments.
+		 */
 		enum { TX_QUEUE_SIZE = 256, RX_QUEUE_SIZE = 256 };
 
 		/*
@@ -39,13 +39,20 @@ namespace Nic {
 			 * \param rx_buffer_alloc  allocator used for managing the communication
 			 *                         buffer of the rx packet stream
 			 * \param ep               entry point used for packet-stream channels
+			 * \param tx_queue_size    number of packet-queue slots of the tx
+			 *                         packet stream
+			 * \param rx_queue_size    number of packet-queue slots of the rx
+			 *                         packet stream
 			 */
 			Session_rpc_object(Genode::Dataspace_capability  tx_ds,
 			                   Genode::Dataspace_capability  rx_ds,
 			                   Genode::Range_allocator      *rx_buffer_alloc,
-			                   Genode::Rpc_entrypoint       &ep)
+			                   Genode::Rpc_entrypoint       &ep,
+			                   unsigned tx_queue_size = TX_QUEUE_SIZE,
+			                   unsigned rx_queue_size = RX_QUEUE_SIZE)
 			:
-				_tx(tx_ds, ep), _rx(rx_ds, rx_buffer_alloc, ep) { }
+				_tx(tx_ds, ep, tx_queue_size),
+				_rx(rx_ds, rx_buffer_alloc, ep, rx_queue_size) { }
 
 			Genode::Capability<Tx> _tx_cap() { return _tx.cap(); }
 			Genode::Capability<Rx> _rx_cap() { return _rx.cap(); }
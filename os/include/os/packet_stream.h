@@ -61,12 +61,25 @@
  * acknowledge buffers using the functions 'packet_avail',
  * 'ready_to_submit', 'ready_to_ack', and 'ack_avail'.
  *
+ * The functions 'submit_packets', 'get_packets', 'acknowledge_packets', and
+ * 'get_acked_packets' transfer batches of packets. A batch is published to
+ * the other side with a single update of the queue index and at most one
+ * signal.
+ *
+ * The number of slots of each queue is a power of two. The side that creates
+ * the packet stream chooses the queue sizes and publishes them at the start of
+ * the communication buffer. The other side adopts them by passing
+ * 'ADOPT_QUEUE_SIZE' to its constructor.
+ *
+ * The queues are not protected by locks. Hence, functions that operate on
+ * the same queue must not be called by multiple threads concurrently.
+ *
  * If bidirectional data exchange between two processes is desired, two pairs
  * of 'Packet_stream_source' and 'Packet_stream_sink' should be instantiated.
  */
 
 /*
- * Copyright (C) 2009-2012 Genode Labs GmbH
+ * Copyright (C) 2009-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -80,6 +93,7 @@
 #include <base/signal.h>
 #include <dataspace/client.h>
 #include <util/string.h>
+#include <util/misc_math.h>
 
 
 /**
@@ -121,19 +135,74 @@ class Packet_descriptor
 };
 
 
+/**
+ * Layout of a packet-descriptor queue within the transport buffer
+ *
+ * This class is private to the packet-stream interface.
+ */
+struct Packet_descriptor_queue_layout
+{
+	enum { CACHE_LINE_SIZE_LOG2 = 6, CACHE_LINE_SIZE = 1 << CACHE_LINE_SIZE_LOG2 };
+
+	/**
+	 * Queue indices preceding the queue slots
+	 *
+	 * The head index is written by the producer only, the tail index is
+	 * written by the consumer only. The indices are placed at distinct
+	 * cache lines to prevent the producer and the consumer from stealing
+	 * the cache line from each other for each packet.
+	 */
+	struct Indices
+	{
+		unsigned volatile head;
+		char              head_padding[CACHE_LINE_SIZE - sizeof(unsigned)];
+		unsigned volatile tail;
+		char              tail_padding[CACHE_LINE_SIZE - sizeof(unsigned)];
+	};
+
+	/**
+	 * Return size of queue in bytes, rounded up to cache-line granularity
+	 */
+	static Genode::size_t bytes(unsigned queue_size, Genode::size_t descriptor_size)
+	{
+		return Genode::align_addr(sizeof(Indices) + queue_size*descriptor_size,
+		                          CACHE_LINE_SIZE_LOG2);
+	}
+};
+
+
 /**
  * Ring buffer shared between source and sink, containing packet descriptors
  *
+ * The queue has exactly one producer and one consumer, which may reside in
+ * different address spaces. Because each index is written by one side only,
+ * the queue is operated without a lock. The number of queue slots is a power
+ * of two. Indices read from the shared memory are masked. So a misbehaving
+ * peer cannot direct accesses outside the queue.
+ *
  * This class is private to the packet-stream interface.
  */
-template <typename PACKET_DESCRIPTOR, int QUEUE_SIZE>
+template <typename PACKET_DESCRIPTOR>
 class Packet_descriptor_queue
 {
 	private:
 
-		int               _head;
-		int               _tail;
-		PACKET_DESCRIPTOR _queue[QUEUE_SIZE];
+		typedef Packet_descriptor_queue_layout::Indices Indices;
+
+		Indices           *_indices;
+		PACKET_DESCRIPTOR *_queue;
+		unsigned           _mask;  /* number of queue slots - 1 */
+
+		unsigned _next(unsigned index, unsigned n = 1) const {
+			return (index + n) & _mask; }
+
+		unsigned _head() const { return _indices->head & _mask; }
+		unsigned _tail() const { return _indices->tail & _mask; }
+
+		/**
+		 * Order the memory accesses of the local and the remote side
+		 */
+		static void _barrier() { __sync_synchronize(); }
 
 	public:
 
@@ -144,67 +213,124 @@ class Packet_descriptor_queue
 		/**
 		 * Constructor
 		 *
-		 * Because the 'Packet_descriptor_queue' is constructed twice (at the
-		 * source and at the sink) inside a shared-memory block, the
-		 * constructor must know the role of the instance to initialize only
-		 * those members that are driven by the respective role.
+		 * \param base  local address of the queue within the transport
+		 *              buffer
+		 * \param size  number of queue slots, must be a power of two
+		 *
+		 * Because the queue is constructed twice (at the source and at the
+		 * sink) inside a shared-memory block, the constructor must know the
+		 * role of the instance to initialize only those members that are
+		 * driven by the respective role.
 		 */
-		Packet_descriptor_queue(Role role)
+		Packet_descriptor_queue(void *base, unsigned size, Role role)
+		:
+			_indices((Indices *)base),
+			_queue((PACKET_DESCRIPTOR *)(_indices + 1)),
+			_mask(size - 1)
 		{
 			if (role == PRODUCER) {
-				_head = 0;
-				Genode::memset(_queue, 0, sizeof(_queue));
+				_indices->head = 0;
+				Genode::memset(_queue, 0, size*sizeof(PACKET_DESCRIPTOR));
 			} else
-				_tail = 0;
+				_indices->tail = 0;
 		}
 
 		/**
-		 * Place packet descriptor into queue
+		 * Return number of queue slots
 		 *
-		 * \return true on success, or
-		 *         false if queue is full
+		 * The queue can hold up to 'size() - 1' packet descriptors.
 		 */
-		bool add(PACKET_DESCRIPTOR packet)
+		unsigned size() const { return _mask + 1; }
+
+		/**
+		 * Place packet descriptors into queue
+		 *
+		 * All descriptors that fit into the queue are published to the
+		 * consumer at once.
+		 *
+		 * \param was_empty  set to true if the consumer may have observed
+		 *                   an empty queue before the descriptors got
+		 *                   published and must be woken up
+		 * \return           number of descriptors placed into the queue,
+		 *                   0 if the queue is full
+		 */
+		unsigned add(PACKET_DESCRIPTOR const *packets, unsigned num,
+		             bool &was_empty)
 		{
-			if (full()) return false;
+			unsigned const head = _head();
+			unsigned const tail = _tail();
+
+			unsigned const n = Genode::min(num, (tail - head - 1) & _mask);
+			if (n == 0)
+				return 0;
+
+			/* do not overwrite slots before the consumer has read them */
+			_barrier();
+
+			for (unsigned i = 0; i < n; i++)
+				_queue[_next(head, i)] = packets[i];
 
-			_queue[_head%QUEUE_SIZE] = packet;
-			_head = (_head + 1)%QUEUE_SIZE;
-			return true;
+			/* publish slots before the head */
+			_barrier();
+			_indices->head = _next(head, n);
+
+			/* observe a consumer that ran out of packets meanwhile */
+			_barrier();
+			was_empty = (_tail() == head);
+			return n;
 		}
 
 		/**
-		 * Take packet descriptor from queue
+		 * Take packet descriptors from queue
 		 *
-		 * \return  packet descriptor
+		 * \param was_full  set to true if the producer may have observed
+		 *                  a full queue before the descriptors got
+		 *                  removed and must be woken up
+		 * \return          number of descriptors stored at 'packets',
+		 *                  0 if the queue is empty
 		 */
-		PACKET_DESCRIPTOR get()
+		unsigned get(PACKET_DESCRIPTOR *packets, unsigned max, bool &was_full)
 		{
-			PACKET_DESCRIPTOR packet = _queue[_tail%QUEUE_SIZE];
-			_tail = (_tail + 1)%QUEUE_SIZE;
-			return packet;
+			unsigned const tail = _tail();
+			unsigned const head = _head();
+
+			unsigned const n = Genode::min(max, (head - tail) & _mask);
+			if (n == 0)
+				return 0;
+
+			/* do not read slots before they got published */
+			_barrier();
+
+			for (unsigned i = 0; i < n; i++)
+				packets[i] = _queue[_next(tail, i)];
+
+			/* finish reading the slots before releasing them */
+			_barrier();
+			_indices->tail = _next(tail, n);
+
+			/* observe a producer that ran out of space meanwhile */
+			_barrier();
+			was_full = (_next(_head()) == tail);
+			return n;
 		}
 
 		/**
 		 * Return true if packet-descriptor queue is empty
 		 */
-		bool empty() { return _tail == _head; }
+		bool empty() const { return _tail() == _head(); }
 
 		/**
 		 * Return true if packet-descriptor queue is full
 		 */
-		bool full() { return (_head + 1)%QUEUE_SIZE == _tail; }
-
-		/**
-		 * Return true if a single element is stored in the queue
-		 */
-		bool single_element() { return (_tail + 1)%QUEUE_SIZE == _head; }
+		bool full() const { return _next(_head()) == _tail(); }
 };
 
 
 /**
  * Transmit packet descriptors with data-flow control
  *
+ * The transmitter must be used by one thread at a time.
+ *
  * This class is private to the packet-stream interface.
  */
 template <typename TX_QUEUE>
@@ -212,6 +338,8 @@ class Packet_descriptor_transmitter
 {
 	private:
 
+		typedef typename TX_QUEUE::Packet_descriptor Packet_descriptor;
+
 		/* facility to receive ready-to-transmit signals */
 		Genode::Signal_receiver           _tx_ready;
 		Genode::Signal_context            _tx_ready_context;
@@ -220,15 +348,14 @@ class Packet_descriptor_transmitter
 		/* facility to send ready-to-receive signals */
 		Genode::Signal_transmitter         _rx_ready;
 
-		Genode::Lock _tx_queue_lock;
-		TX_QUEUE    *_tx_queue;
+		TX_QUEUE _tx_queue;
 
 	public:
 
 		/**
 		 * Constructor
 		 */
-		Packet_descriptor_transmitter(TX_QUEUE *tx_queue)
+		Packet_descriptor_transmitter(TX_QUEUE const &tx_queue)
 		:
 			_tx_ready_cap(_tx_ready.manage(&_tx_ready_context)),
 			_tx_queue(tx_queue)
@@ -246,29 +373,52 @@ class Packet_descriptor_transmitter
 
 		bool ready_for_tx()
 		{
-			Genode::Lock::Guard lock_guard(_tx_queue_lock);
-			return !_tx_queue->full();
+			return !_tx_queue.full();
 		}
 
-		void tx(typename TX_QUEUE::Packet_descriptor packet)
+		void tx(Packet_descriptor packet) { tx(&packet, 1); }
+
+		/**
+		 * Transmit batch of packet descriptors
+		 *
+		 * The receiver is signalled at most once per portion of the batch
+		 * that fits into the queue.
+		 */
+		void tx(Packet_descriptor const *packets, unsigned num)
 		{
-			Genode::Lock::Guard lock_guard(_tx_queue_lock);
+			while (num) {
 
-			do {
-				/* block for signal if tx queue is full */
-				if (_tx_queue->full())
-					_tx_ready.wait_for_signal();
+				unsigned n;
 
 				/*
-				 * It could happen that pending signals do not refer to the
-				 * current queue situation. Therefore, we need to double check
-				 * if the queue insertion succeeds and retry if needed.
+				 * Block for signal if tx queue is full. It could happen that
+				 * pending signals do not refer to the current queue
+				 * situation. Therefore, we need to double check if the queue
+				 * insertion succeeds and retry if needed.
 				 */
+				while ((n = try_tx(packets, num)) == 0)
+					_tx_ready.wait_for_signal();
 
-			} while (_tx_queue->add(packet) == false);
+				packets += n;
+				num     -= n;
+			}
+		}
+
+		/**
+		 * Transmit batch of packet descriptors without blocking
+		 *
+		 * \return  number of packet descriptors placed into the queue,
+		 *          0 if the queue is full
+		 */
+		unsigned try_tx(Packet_descriptor const *packets, unsigned num)
+		{
+			bool           was_empty = false;
+			unsigned const n         = _tx_queue.add(packets, num, was_empty);
 
-			if (_tx_queue->single_element())
+			if (was_empty)
 				_rx_ready.submit();
+
+			return n;
 		}
 };
 
@@ -276,6 +426,8 @@ class Packet_descriptor_transmitter
 /**
  * Receive packet descriptors with data-flow control
  *
+ * The receiver must be used by one thread at a time.
+ *
  * This class is private to the packet-stream interface.
  */
 template <typename RX_QUEUE>
@@ -283,6 +435,8 @@ class Packet_descriptor_receiver
 {
 	private:
 
+		typedef typename RX_QUEUE::Packet_descriptor Packet_descriptor;
+
 		/* facility to receive ready-to-receive signals */
 		Genode::Signal_receiver           _rx_ready;
 		Genode::Signal_context            _rx_ready_context;
@@ -291,15 +445,14 @@ class Packet_descriptor_receiver
 		/* facility to send ready-to-transmit signals */
 		Genode::Signal_transmitter         _tx_ready;
 
-		Genode::Lock _rx_queue_lock;
-		RX_QUEUE    *_rx_queue;
+		RX_QUEUE _rx_queue;
 
 	public:
 
 		/**
 		 * Constructor
 		 */
-		Packet_descriptor_receiver(RX_QUEUE *rx_queue)
+		Packet_descriptor_receiver(RX_QUEUE const &rx_queue)
 		:
 			_rx_ready_cap(_rx_ready.manage(&_rx_ready_context)),
 			_rx_queue(rx_queue)
@@ -317,23 +470,44 @@ class Packet_descriptor_receiver
 
 		bool ready_for_rx()
 		{
-			Genode::Lock::Guard lock_guard(_rx_queue_lock);
-			return !_rx_queue->empty();
+			return !_rx_queue.empty();
 		}
 
-		void rx(typename RX_QUEUE::Packet_descriptor *out_packet)
-		{
-			Genode::Lock::Guard lock_guard(_rx_queue_lock);
+		void rx(Packet_descriptor *out_packet) { rx(out_packet, 1); }
 
-			bool rx_queue_was_full = _rx_queue->full();
+		/**
+		 * Receive batch of packet descriptors
+		 *
+		 * This function blocks until at least one packet descriptor is
+		 * available.
+		 *
+		 * \return  number of packet descriptors stored at 'out_packets'
+		 */
+		unsigned rx(Packet_descriptor *out_packets, unsigned max)
+		{
+			unsigned n;
 
-			while (_rx_queue->empty())
+			while ((n = try_rx(out_packets, max)) == 0)
 				_rx_ready.wait_for_signal();
 
-			*out_packet = _rx_queue->get();
+			return n;
+		}
+
+		/**
+		 * Receive batch of packet descriptors without blocking
+		 *
+		 * \return  number of packet descriptors stored at 'out_packets',
+		 *          0 if the queue is empty
+		 */
+		unsigned try_rx(Packet_descriptor *out_packets, unsigned max)
+		{
+			bool           was_full = false;
+			unsigned const n        = _rx_queue.get(out_packets, max, was_full);
 
-			if (rx_queue_was_full)
+			if (was_full)
 				_tx_ready.submit();
+
+			return n;
 		}
 };
 
@@ -353,11 +527,59 @@ class Packet_stream_base
 		 */
 		class Transport_dataspace_too_small { };
 
+		enum {
+			MIN_QUEUE_SIZE = 2,
+			MAX_QUEUE_SIZE = 1 << 14,
+
+			/**
+			 * Queue size passed by the side of a packet stream that adopts
+			 * the queue sizes chosen by the other side
+			 */
+			ADOPT_QUEUE_SIZE = 0
+		};
+
+		/**
+		 * Return largest valid queue size not exceeding 'size'
+		 *
+		 * Valid queue sizes are powers of two within the range of
+		 * 'MIN_QUEUE_SIZE' and 'MAX_QUEUE_SIZE'. Servers must pass queue
+		 * sizes requested by a client through this function before
+		 * creating the packet stream. Otherwise, a request for 0 slots
+		 * would be taken as 'ADOPT_QUEUE_SIZE'.
+		 */
+		static unsigned normalized_queue_size(unsigned long size)
+		{
+			size = Genode::min((unsigned long)MAX_QUEUE_SIZE,
+			                   Genode::max((unsigned long)MIN_QUEUE_SIZE, size));
+
+			unsigned result = MIN_QUEUE_SIZE;
+			while (result*2 <= size)
+				result *= 2;
+
+			return result;
+		}
+
 	protected:
 
+		/**
+		 * Queue sizes stored at the start of the transport buffer
+		 *
+		 * The side that creates the packet stream publishes the queue
+		 * sizes, the other side adopts them. The creating side never reads
+		 * the values back.
+		 */
+		struct Queue_sizes
+		{
+			unsigned submit;
+			unsigned ack;
+		};
+
 		Genode::Dataspace_capability _ds_cap;
 		void                        *_ds_local_base;
 
+		unsigned _submit_queue_size;
+		unsigned _ack_queue_size;
+
 		Genode::off_t  _submit_queue_offset;
 		Genode::off_t  _ack_queue_offset;
 		Genode::off_t  _bulk_buffer_offset;
@@ -366,24 +588,73 @@ class Packet_stream_base
 		/**
 		 * Constructor
 		 *
-		 * \param submit_queue_size  submit queue size in bytes
-		 * \param ack_queue_size     acknowledgement queue size in bytes
+		 * \param descriptor_size    size of a packet descriptor in bytes
+		 * \param submit_queue_size  number of submit-queue slots, or
+		 *                           'ADOPT_QUEUE_SIZE'
+		 * \param ack_queue_size     number of acknowledgement-queue slots,
+		 *                           or 'ADOPT_QUEUE_SIZE'
 		 * \throw                    'Transport_dataspace_too_small'
+		 *
+		 * Queue sizes that do not fit into the transport dataspace are
+		 * reduced unless they are adopted from the other side.
 		 */
 		Packet_stream_base(Genode::Dataspace_capability transport_ds,
-		                   Genode::size_t submit_queue_size,
-		                   Genode::size_t ack_queue_size)
+		                   Genode::size_t descriptor_size,
+		                   unsigned submit_queue_size,
+		                   unsigned ack_queue_size)
 		:
 			_ds_cap(transport_ds),
 
 			/* map dataspace locally */
-			_ds_local_base(Genode::env()->rm_session()->attach(_ds_cap)),
-			_submit_queue_offset(0),
-			_ack_queue_offset(_submit_queue_offset + submit_queue_size),
-			_bulk_buffer_offset(_ack_queue_offset + ack_queue_size)
+			_ds_local_base(Genode::env()->rm_session()->attach(_ds_cap))
 		{
+			typedef Packet_descriptor_queue_layout Layout;
+
 			Genode::size_t ds_size = Genode::Dataspace_client(_ds_cap).size();
 
+			if (ds_size < Layout::CACHE_LINE_SIZE)
+				throw Transport_dataspace_too_small();
+
+			Queue_sizes *sizes = (Queue_sizes *)_ds_local_base;
+
+			bool const adopt = submit_queue_size == ADOPT_QUEUE_SIZE
+			                || ack_queue_size    == ADOPT_QUEUE_SIZE;
+
+			if (submit_queue_size == ADOPT_QUEUE_SIZE)
+				submit_queue_size = sizes->submit;
+			if (ack_queue_size == ADOPT_QUEUE_SIZE)
+				ack_queue_size = sizes->ack;
+
+			_submit_queue_size = normalized_queue_size(submit_queue_size);
+			_ack_queue_size    = normalized_queue_size(ack_queue_size);
+
+			/*
+			 * The queue sizes chosen by the creating side may stem from a
+			 * session request. Shrink the queues until they leave at least
+			 * half of the transport buffer to the bulk buffer.
+			 */
+			while (!adopt
+			    && Layout::bytes(_submit_queue_size, descriptor_size)
+			     + Layout::bytes(_ack_queue_size,    descriptor_size) > ds_size/2
+			    && (_submit_queue_size > MIN_QUEUE_SIZE
+			     || _ack_queue_size    > MIN_QUEUE_SIZE)) {
+
+				if (_submit_queue_size >= _ack_queue_size)
+					_submit_queue_size /= 2;
+				else
+					_ack_queue_size /= 2;
+			}
+
+			sizes->submit = _submit_queue_size;
+			sizes->ack    = _ack_queue_size;
+
+			/* the queue sizes occupy the first cache line */
+			_submit_queue_offset = Layout::CACHE_LINE_SIZE;
+			_ack_queue_offset    = _submit_queue_offset
+			                     + Layout::bytes(_submit_queue_size, descriptor_size);
+			_bulk_buffer_offset  = _ack_queue_offset
+			                     + Layout::bytes(_ack_queue_size, descriptor_size);
+
 			if ((Genode::size_t)_bulk_buffer_offset >= ds_size)
 				throw Transport_dataspace_too_small();
 
@@ -428,10 +699,13 @@ class Packet_stream_base
 
 /**
  * Policy used by both sides source and sink
+ *
+ * The queue sizes are used unless other sizes are specified when
+ * constructing the packet stream. Queue sizes must be powers of two.
  */
 template <typename PACKET_DESCRIPTOR,
-          unsigned SUBMIT_QUEUE_SIZE,
-          unsigned ACK_QUEUE_SIZE,
+          unsigned DEFAULT_SUBMIT_QUEUE_SIZE,
+          unsigned DEFAULT_ACK_QUEUE_SIZE,
           typename CONTENT_TYPE>
 struct Packet_stream_policy
 {
@@ -439,11 +713,13 @@ struct Packet_stream_policy
 
 	typedef PACKET_DESCRIPTOR Packet_descriptor;
 
-	typedef Packet_descriptor_queue<PACKET_DESCRIPTOR, SUBMIT_QUEUE_SIZE>
-	        Submit_queue;
+	typedef Packet_descriptor_queue<PACKET_DESCRIPTOR> Submit_queue;
+	typedef Packet_descriptor_queue<PACKET_DESCRIPTOR> Ack_queue;
 
-	typedef Packet_descriptor_queue<PACKET_DESCRIPTOR, ACK_QUEUE_SIZE>
-	        Ack_queue;
+	enum {
+		SUBMIT_QUEUE_SIZE = DEFAULT_SUBMIT_QUEUE_SIZE,
+		ACK_QUEUE_SIZE    = DEFAULT_ACK_QUEUE_SIZE
+	};
 };
 
 
@@ -454,17 +730,6 @@ typedef Packet_stream_policy<Packet_descriptor, 64, 64, char>
         Default_packet_stream_policy;
 
 
-/**
- * Placement new operator for constructing packet-descriptor queues
- *
- * The third argument is only there to let the compiler choose this overloaded
- * new operator rather than Genode's new operator.
- *
- * This operator should not be used outside the packet-stream interface.
- */
-inline void *operator new(Genode::size_t size, void *addr, Packet_stream_base *) { return addr; }
-
-
 /**
  * Originator of a packet stream
  */
@@ -504,20 +769,27 @@ class Packet_stream_source : private Packet_stream_base
 		 * The 'packet_alloc' must not be pre-initialized. It will be
 		 * initialized by the constructor using dataspace-relative offsets
 		 * rather than pointers.
+		 *
+		 * The queue sizes are rounded down to powers of two. If the sink
+		 * created the packet stream, the source passes 'ADOPT_QUEUE_SIZE'
+		 * to adopt the queue sizes chosen by the sink.
 		 */
 		Packet_stream_source(Genode::Range_allocator      *packet_alloc,
-		                     Genode::Dataspace_capability  transport_ds_cap)
+		                     Genode::Dataspace_capability  transport_ds_cap,
+		                     unsigned submit_queue_size = POLICY::SUBMIT_QUEUE_SIZE,
+		                     unsigned ack_queue_size    = POLICY::ACK_QUEUE_SIZE)
 		:
-			Packet_stream_base(transport_ds_cap,
-			                   sizeof(Submit_queue),
-			                   sizeof(Ack_queue)),
+			Packet_stream_base(transport_ds_cap, sizeof(Packet_descriptor),
+			                   submit_queue_size, ack_queue_size),
 			_packet_alloc(packet_alloc),
 
 			/* construct packet-descriptor queues */
-			_submit_transmitter(new (_submit_queue_local_base(), this)
-			                    Submit_queue(Submit_queue::PRODUCER)),
-			_ack_receiver(new (_ack_queue_local_base(), this)
-			              Ack_queue(Ack_queue::CONSUMER))
+			_submit_transmitter(Submit_queue(_submit_queue_local_base(),
+			                                 _submit_queue_size,
+			                                 Submit_queue::PRODUCER)),
+			_ack_receiver(Ack_queue(_ack_queue_local_base(),
+			                        _ack_queue_size,
+			                        Ack_queue::CONSUMER))
 		{
 			/* initialize packet allocator */
 			_packet_alloc->add_range(_bulk_buffer_offset,
@@ -529,6 +801,16 @@ class Packet_stream_source : private Packet_stream_base
 		 */
 		Genode::size_t bulk_buffer_size() { return _bulk_buffer_size; }
 
+		/**
+		 * Return number of submit-queue slots
+		 */
+		unsigned submit_queue_size() const { return _submit_queue_size; }
+
+		/**
+		 * Return number of acknowledgement-queue slots
+		 */
+		unsigned ack_queue_size() const { return _ack_queue_size; }
+
 		/**
 		 * Register signal handler for receiving the signal that new packets
 		 * are available in the submit queue.
@@ -612,6 +894,18 @@ class Packet_stream_source : private Packet_stream_base
 			_submit_transmitter.tx(packet);
 		}
 
+		/**
+		 * Tell sink about a batch of packets to process
+		 *
+		 * The packets are published to the sink at once as far as the
+		 * submit queue permits. This function blocks if the submit queue
+		 * is full.
+		 */
+		void submit_packets(Packet_descriptor const *packets, unsigned num)
+		{
+			_submit_transmitter.tx(packets, num);
+		}
+
 		/**
 		 * Returns true if one or more packet acknowledgements are available
 		 */
@@ -627,6 +921,19 @@ class Packet_stream_source : private Packet_stream_base
 			return packet;
 		}
 
+		/**
+		 * Get batch of acknowledged packets
+		 *
+		 * This function blocks if no acknowledgements are available.
+		 *
+		 * \param max  capacity of the 'packets' array
+		 * \return     number of packets stored at 'packets'
+		 */
+		unsigned get_acked_packets(Packet_descriptor *packets, unsigned max)
+		{
+			return _ack_receiver.rx(packets, max);
+		}
+
 		/**
 		 * Release bulk-buffer space consumed by the packet
 		 */
@@ -668,18 +975,37 @@ class Packet_stream_sink : private Packet_stream_base
 		 *
 		 * \param transport_ds  dataspace used for communication buffer shared between
 		 *                      source and sink
+		 *
+		 * The queue sizes are rounded down to powers of two. If the source
+		 * created the packet stream, the sink passes 'ADOPT_QUEUE_SIZE' to
+		 * adopt the queue sizes chosen by the source.
 		 */
-		Packet_stream_sink(Genode::Dataspace_capability transport_ds)
+		Packet_stream_sink(Genode::Dataspace_capability transport_ds,
+		                   unsigned submit_queue_size = POLICY::SUBMIT_QUEUE_SIZE,
+		                   unsigned ack_queue_size    = POLICY::ACK_QUEUE_SIZE)
 		:
-			Packet_stream_base(transport_ds, sizeof(Submit_queue), sizeof(Ack_queue)),
+			Packet_stream_base(transport_ds, sizeof(Packet_descriptor),
+			                   submit_queue_size, ack_queue_size),
 
 			/* construct packet-descriptor queues */
-			_submit_receiver(new (_submit_queue_local_base(), this)
-			                  Submit_queue(Submit_queue::CONSUMER)),
-			_ack_transmitter(new (_ack_queue_local_base(), this)
-			                 Ack_queue(Ack_queue::PRODUCER))
+			_submit_receiver(Submit_queue(_submit_queue_local_base(),
+			                              _submit_queue_size,
+			                              Submit_queue::CONSUMER)),
+			_ack_transmitter(Ack_queue(_ack_queue_local_base(),
+			                           _ack_queue_size,
+			                           Ack_queue::PRODUCER))
 		{ }
 
+		/**
+		 * Return number of submit-queue slots
+		 */
+		unsigned submit_queue_size() const { return _submit_queue_size; }
+
+		/**
+		 * Return number of acknowledgement-queue slots
+		 */
+		unsigned ack_queue_size() const { return _ack_queue_size; }
+
 		/**
 		 * Register signal handler to notify that new acknowledgements
 		 * are available in the ack queue.
@@ -744,6 +1070,56 @@ class Packet_stream_sink : private Packet_stream_base
 			return packet;
 		}
 
+		/**
+		 * Get batch of packets from source
+		 *
+		 * This function blocks if no packets are available. Invalid packets
+		 * are dropped.
+		 *
+		 * \param max  capacity of the 'packets' array
+		 * \return     number of packets stored at 'packets'
+		 */
+		unsigned get_packets(Packet_descriptor *packets, unsigned max)
+		{
+			for (;;) {
+				unsigned const num = _submit_receiver.rx(packets, max);
+
+				unsigned num_valid = 0;
+				for (unsigned i = 0; i < num; i++)
+					if (packet_valid(packets[i]))
+						packets[num_valid++] = packets[i];
+
+				if (num_valid)
+					return num_valid;
+			}
+		}
+
+		/**
+		 * Get batch of packets from source without blocking
+		 *
+		 * In contrast to 'get_packets', this function returns 0 if no
+		 * valid packet is available. It is meant for sinks that wait for
+		 * the packet-avail signal by themselves.
+		 *
+		 * \param max  capacity of the 'packets' array
+		 * \return     number of packets stored at 'packets'
+		 */
+		unsigned try_get_packets(Packet_descriptor *packets, unsigned max)
+		{
+			unsigned num;
+			while ((num = _submit_receiver.try_rx(packets, max))) {
+
+				unsigned num_valid = 0;
+				for (unsigned i = 0; i < num; i++)
+					if (packet_valid(packets[i]))
+						packets[num_valid++] = packets[i];
+
+				if (num_valid)
+					return num_valid;
+			}
+			return 0;
+		}
+
 		/**
 		 * Get pointer to the content of the specified packet
 		 *
@@ -772,6 +1148,32 @@ class Packet_stream_sink : private Packet_stream_base
 			_ack_transmitter.tx(packet);
 		}
 
+		/**
+		 * Tell the source that the processing of a batch of packets is
+		 * completed
+		 *
+		 * This function blocks if the acknowledgement queue is full.
+		 */
+		void acknowledge_packets(Packet_descriptor const *packets, unsigned num)
+		{
+			_ack_transmitter.tx(packets, num);
+		}
+
+		/**
+		 * Tell the source about completed packets without blocking
+		 *
+		 * In contrast to 'acknowledge_packets', this function returns if
+		 * the acknowledgement queue is full. It is meant for sinks that
+		 * wait for the ready-to-ack signal by themselves.
+		 *
+		 * \return  number of acknowledged packets, 0 if the
+		 *          acknowledgement queue is full
+		 */
+		unsigned try_acknowledge_packets(Packet_descriptor const *packets, unsigned num)
+		{
+			return _ack_transmitter.try_tx(packets, num);
+		}
+
 		void debug_print_buffers() {
 			Packet_stream_base::_debug_print_buffers(); }
 
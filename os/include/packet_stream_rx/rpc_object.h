@@ -52,11 +52,17 @@ namespace Packet_stream_rx {
 			 *                      buffer of the receive packet stream
 			 * \param ep            entry point used for serving the channel's RPC
 			 *                      interface
+			 * \param queue_size    number of slots of the submit and
+			 *                      acknowledgement queues
 			 */
 			Rpc_object(Genode::Dataspace_capability  ds,
 			           Genode::Range_allocator      *buffer_alloc,
-			           Genode::Rpc_entrypoint       &ep)
-			: _ep(ep), _cap(_ep.manage(this)), _source(buffer_alloc, ds) { }
+			           Genode::Rpc_entrypoint       &ep,
+			           unsigned queue_size = CHANNEL::Policy::SUBMIT_QUEUE_SIZE)
+			:
+				_ep(ep), _cap(_ep.manage(this)),
+				_source(buffer_alloc, ds, queue_size, queue_size)
+			{ }
 
 			/**
 			 * Destructor
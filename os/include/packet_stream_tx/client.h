@@ -51,7 +51,9 @@ namespace Packet_stream_tx {
 			       Genode::Range_allocator *buffer_alloc)
 			:
 				Genode::Rpc_client<CHANNEL>(channel_cap),
-				_source(buffer_alloc, Base::template call<Rpc_dataspace>())
+				_source(buffer_alloc, Base::template call<Rpc_dataspace>(),
+				        Packet_stream_base::ADOPT_QUEUE_SIZE,
+				        Packet_stream_base::ADOPT_QUEUE_SIZE)
 			{
 				/* wire data-flow signals for the packet transmitter */
 				_source.register_sigh_packet_avail(Base::template call<Rpc_packet_avail>());
@@ -22,6 +22,7 @@ namespace Packet_stream_tx {
 	template <typename PACKET_STREAM_POLICY>
 	struct Channel
 	{
+		typedef PACKET_STREAM_POLICY                       Policy;
 		typedef Packet_stream_source<PACKET_STREAM_POLICY> Source;
 		typedef Packet_stream_sink<PACKET_STREAM_POLICY>   Sink;
 
@@ -40,11 +40,14 @@ namespace Packet_stream_tx {
 			 *            for the transmission packet stream
 			 * \param ep  entry point used for serving the channel's RPC
 			 *            interface
+			 * \param queue_size  number of slots of the submit and
+			 *                    acknowledgement queues
 			 */
 			Rpc_object(Genode::Dataspace_capability ds,
-			           Genode::Rpc_entrypoint &ep)
+			           Genode::Rpc_entrypoint &ep,
+			           unsigned queue_size = CHANNEL::Policy::SUBMIT_QUEUE_SIZE)
 			:
-				_ep(ep), _cap(_ep.manage(this)), _sink(ds),
+				_ep(ep), _cap(_ep.manage(this)), _sink(ds, queue_size, queue_size),
 
 				/* init signal handlers with default handlers of sink */
 				_sigh_ready_to_ack(_sink.sigh_ready_to_ack()),
@@ -3,10 +3,9 @@
  * \author Sebastian Sumpf <Sebastian.Sumpf@genode-labs.com>
  * \date   2011-08-10
  *
- * This driver currently supports only one command slot, one FIS, and one PRD
- * per FIS, thus limiting the request size to 4MB per request. Since the packet
- * interface currently only supports a synchronous mode of operation the above
- * limitations seems reasonable.
+ * This driver currently supports one FIS and one PRD per FIS, thus limiting
+ * the request size to 4MB per request. Up to eight command slots are used to
+ * keep multiple requests outstanding at the HBA.
  */
 
 /*
@@ -235,6 +234,22 @@ class Ahci_port : public Reg_base
 				err(err() & ~(1 << 16));
 		}
 
+		/**
+		 * Restart command processing after an error
+		 *
+		 * Clearing CMD.ST discards all issued commands.
+		 */
+		void recover()
+		{
+			enum { CMD_LIST_RUNNING = 0x8000 };
+
+			cmd(cmd() & ~1);
+			while (cmd() & CMD_LIST_RUNNING) { }
+
+			err(err());
+			hba_enable();
+		}
+
 		/**
 		 * Disable power mgmt. set SCTL.IPM to 3
 		 */
@@ -295,7 +310,7 @@ struct Command_list
 	uint32_t prdbc;            /* PRD byte count */
 	uint32_t cmd_table_base_l; /* Command table base addr (low) */
 	uint32_t cmd_table_base_u;
-	uint32_t reserved[0];
+	uint32_t reserved[4];      /* pad to size of command slot */
 };
 
 
@@ -360,15 +375,54 @@ class Ahci_device
 			AHCI_PORT_BASE      = 0x100,
 		};
 
+		enum {
+			MAX_SLOTS       = 8,   /* command slots used for asynchronous requests */
+			CMD_TABLE_SIZE  = 256, /* command table including one PRD */
+		};
+
+		/**
+		 * Thread that reports completed commands in asynchronous mode
+		 */
+		class Irq_thread : public Thread<8192>
+		{
+			private:
+
+				Ahci_device &_device;
+
+			public:
+
+				Irq_thread(Ahci_device &device)
+				: Thread<8192>("ahci_irq"), _device(device) { }
+
+				void entry()
+				{
+					for (;;) {
+						_device._irq->wait_for_irq();
+						_device._handle_irq();
+					}
+				}
+		};
+
 		Generic_ctrl             *_ctrl;      /* generic host control */
 		Ahci_port                *_port;      /* port base of device */
 		Irq_connection           *_irq;       /* device IRQ */
 		size_t                    _block_cnt; /* number of blocks on device */
 		Command_list             *_cmd_list;  /* pointer to command list */
-		Command_table            *_cmd_table; /* pointer to command table */
+		Command_table            *_cmd_table; /* pointer to command table of slot 0 */
 		Ram_dataspace_capability  _ds;        /* backing-store of internal data structures */
 		Io_mem_session_capability _io_cap;    /* I/O mem cap */
 
+		/* asynchronous mode */
+		unsigned                   _num_slots;
+		uint32_t                   _busy_slots;          /* bit mask */
+		unsigned long              _slot_tag[MAX_SLOTS];
+		Lock                       _slot_lock;
+		Block::Driver::Completion *_completion;
+		Irq_thread                *_irq_thread;
+
+		Command_table *_slot_cmd_table(unsigned slot) {
+			return (Command_table *)((addr_t)_cmd_table + slot*CMD_TABLE_SIZE); }
+
 		/**
 		 * Return next PCI device
 		 */
@@ -449,6 +503,8 @@ class Ahci_device
 			PINF("\tNative command queuing: %s", (caps & 0x40000000) ? "yes" : "no");
 			PINF("\t64 Bit: %s", (caps & 0x80000000) ? "yes" : "no");
 
+			_num_slots = min<unsigned>(_ctrl->cmd_slots(), MAX_SLOTS);
+
 			/* setup up AHCI data structures */
 			_setup_memory();
 
@@ -490,20 +546,23 @@ class Ahci_device
 			/* setup command list (size 1k naturally aligned) */
 			_port->cmd_list_base(phys);
 			_cmd_list = (struct Command_list *)(virt);
-
-			/* for now we transfer one PRD with a FIS size of 5 byte */
-			_cmd_list->prdtl = 1;
-			_cmd_list->cfl   = 5;
 			virt += 1024; phys += 1024;
 
 			/* setup received FIS base (256 byte naturally aligned) */
 			_port->fis_base(phys);
 			virt += 256; phys += 256;
 
-			/* setup command table (128 byte aligned (cache line size)) */
-			_cmd_list->cmd_table_base_l = phys;
-			_cmd_list->cmd_table_base_u = 0;
+			/*
+			 * Setup command tables (128 byte aligned (cache line size)), for
+			 * now we transfer one PRD with a FIS size of 5 byte per slot
+			 */
 			_cmd_table = (struct Command_table *)(virt);
+			for (unsigned slot = 0; slot < MAX_SLOTS; slot++) {
+				_cmd_list[slot].prdtl            = 1;
+				_cmd_list[slot].cfl              = 5;
+				_cmd_list[slot].cmd_table_base_l = phys + slot*CMD_TABLE_SIZE;
+				_cmd_list[slot].cmd_table_base_u = 0;
+			}
 		}
 
 		/**
@@ -581,6 +640,46 @@ class Ahci_device
 			_port->hba_disable();
 		}
 
+		/**
+		 * Report commands completed since the last interrupt
+		 */
+		void _handle_irq()
+		{
+			/* task-file error, host-bus fatal/data error, interface fatal error */
+			enum { INT_ERROR = 0x78000000 };
+
+			uint32_t const status = _port->interrupt_ack();
+			_ctrl->hba_interrupt_ack();
+
+			bool const error = status & INT_ERROR;
+			if (error) {
+				PERR("Error during SATA request (irq state %x)", status);
+
+				/* the commands of all slots are discarded */
+				Lock::Guard guard(_slot_lock);
+				_port->recover();
+			}
+
+			for (unsigned slot = 0; slot < _num_slots; slot++) {
+
+				uint32_t const             mask = 1 << slot;
+				unsigned long              tag;
+				Block::Driver::Completion *completion;
+				{
+					Lock::Guard guard(_slot_lock);
+
+					if (!(_busy_slots & mask) || (_port->cmd_issue() & mask))
+						continue;
+
+					_busy_slots &= ~mask;
+					tag        = _slot_tag[slot];
+					completion = _completion;
+				}
+				if (completion)
+					completion->completed(tag, !error);
+			}
+		}
+
 		static void _disable_msi(::Pci::Device_client &pci)
 		{
 			enum { PM_CAP_OFF = 0x34, MSI_CAP = 0x5, MSI_ENABLED = 0x1 };
@@ -604,10 +703,16 @@ class Ahci_device
 	public:
 
 		Ahci_device(addr_t base, Io_mem_session_capability io_cap)
-		: _ctrl((Generic_ctrl *)base), _io_cap(io_cap) {}
+		:
+			_ctrl((Generic_ctrl *)base), _io_cap(io_cap), _num_slots(1),
+			_busy_slots(0), _completion(0), _irq_thread(0)
+		{ }
 
 		~Ahci_device()
 		{
+			if (_irq_thread)
+				destroy(env()->heap(), _irq_thread);
+
 			/* delete internal data structures */
 			if (_ds.valid()) {
 				env()->rm_session()->detach((void*)_cmd_list);
@@ -711,6 +816,64 @@ class Ahci_device
 			_cmd_table->setup_command(WRITE_DMA_EXT, block_number, block_count, phys);
 			_execute_command();
 		}
+
+		/**
+		 * Number of commands that can be outstanding in asynchronous mode
+		 */
+		unsigned max_outstanding() { return _num_slots; }
+
+		/**
+		 * Switch to asynchronous mode
+		 *
+		 * From now on, requests must be issued via 'submit' only. Passing 0
+		 * unregisters the completion handler, completions are dropped then.
+		 */
+		void enable_async(Block::Driver::Completion *completion)
+		{
+			{
+				Lock::Guard guard(_slot_lock);
+				_completion = completion;
+			}
+
+			if (!completion || _irq_thread)
+				return;
+
+			/* keep command processing enabled */
+			_port->hba_enable();
+
+			_irq_thread = new (env()->heap()) Irq_thread(*this);
+			_irq_thread->start();
+		}
+
+		/**
+		 * Issue read or write command in a free command slot
+		 */
+		void submit(bool write, size_t block_number, size_t block_count,
+		            addr_t phys, unsigned long tag)
+		{
+			Lock::Guard guard(_slot_lock);
+
+			unsigned slot = 0;
+			while (slot < _num_slots && (_busy_slots & (1 << slot)))
+				slot++;
+
+			if (slot == _num_slots) {
+				PERR("no free command slot");
+				throw Block::Driver::Io_error();
+			}
+
+			enum { READ_DMA_EXT = 0x25, WRITE_DMA_EXT = 0x35 };
+			_slot_cmd_table(slot)->setup_command(write ? WRITE_DMA_EXT : READ_DMA_EXT,
+			                                     block_number, block_count, phys);
+			_cmd_list[slot].w     = write;
+			_cmd_list[slot].prdbc = 0;
+
+			_slot_tag[slot]  = tag;
+			_busy_slots     |= 1 << slot;
+
+			/* write CI (command issue), zero bits are ignored by the HBA */
+			_port->cmd_issue(1 << slot);
+		}
 };
 
 
@@ -759,6 +922,21 @@ class Ahci_driver : public Block::Driver
 			_device->write(block_number, block_count, phys);
 		}
 
+		unsigned max_outstanding() {
+			return _device ? _device->max_outstanding() : 0; }
+
+		void completion_handler(Completion *completion) {
+			if (_device) _device->enable_async(completion); }
+
+		void submit(Block::Packet_descriptor::Opcode op,
+		            size_t block_number, size_t block_count,
+		            char *, addr_t phys, unsigned long tag)
+		{
+			_sanity_check(block_number, block_count);
+			_device->submit(op == Block::Packet_descriptor::WRITE,
+			                block_number, block_count, phys, tag);
+		}
+
 		void read(size_t, size_t, char *)
 		{
 			PERR("%s should not be called", __PRETTY_FUNCTION__);
@@ -790,7 +968,8 @@ int main()
 	static Cap_connection cap;
 	static Rpc_entrypoint ep(&cap, STACK_SIZE, "block_ep");
 
-	static Block::Root block_root(&ep, env()->heap(), driver_factory);
+	static Block::Root block_root(&ep, env()->heap(), driver_factory,
+	                              Block::Request_scheduler::policy_from_config());
 	env()->parent()->announce(ep.manage(&block_root));
 
 	sleep_forever();
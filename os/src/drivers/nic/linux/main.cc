@@ -4,15 +4,26 @@
  * \author Christian Helmuth
  * \date   2011-08-08
  *
- * Currently, we connect to tap0 only. Possbile candidates for configuration
- * options are:
+ * Incoming frames are read directly into the packet buffers of the NIC
+ * session. On each wake-up, the receive thread drains all frames pending at
+ * the TAP device. The driver is configured by the following attributes of
+ * its config node:
  *
- * - TAP device to connect to (default is tap0)
- * - MAC address (default is 02-00-00-00-00-01)
+ * :tap:    TAP device to connect to (default is tap0)
+ * :queues: number of TAP queues, each served by a receive thread of its own
+ *          (default is 1). More than one queue requires a TAP device created
+ *          with the 'multi_queue' option. Outgoing frames are distributed
+ *          over the queues by their addresses, so the frames of one flow
+ *          keep their order.
+ *
+ * The TAP device takes exactly one frame per write. Hence, a batch of
+ * outgoing frames still costs one syscall per frame.
+ *
+ * The MAC address is fixed to 02-00-00-00-00-01.
  */
 
 /*
- * Copyright (C) 2011-2012 Genode Labs GmbH
+ * Copyright (C) 2011-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -22,19 +33,30 @@
 #include <base/sleep.h>
 #include <cap_session/connection.h>
 #include <nic/component.h>
+#include <os/config.h>
 
 /* Linux */
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <linux/if_tun.h>
 
+#ifndef IFF_MULTI_QUEUE
+#define IFF_MULTI_QUEUE 0x0100
+#endif
+
 
 class Linux_driver : public Nic::Driver
 {
 	private:
 
+		enum {
+			MAX_FRAME_SIZE = 1514,  /* maximum ethernet packet length */
+			MAX_QUEUES     = 8,
+		};
+
 		struct Rx_thread : Genode::Thread<0x2000>
 		{
 			int          fd;
@@ -54,7 +76,7 @@ class Linux_driver : public Nic::Driver
 					FD_SET(fd, &rfds);
 					do { ret = select(fd + 1, &rfds, 0, 0, 0); } while (ret < 0);
 
-					/* inform driver about incoming packet */
+					/* inform driver about incoming packets */
 					driver.handle_irq(fd);
 				}
 			}
@@ -63,11 +85,43 @@ class Linux_driver : public Nic::Driver
 		Nic::Mac_address      _mac_addr;
 		Nic::Rx_buffer_alloc &_alloc;
 
-		char      _packet_buffer[1514];  /* maximum ethernet packet length */
-		int       _tap_fd;
-		Rx_thread _rx_thread;
+		/*
+		 * The packet stream has a single producer. Hence, the receive
+		 * threads of multiple queues hand over their frames one at a time.
+		 */
+		Genode::Lock _rx_lock;
+		char        *_rx_buffer;                    /* allocated packet buffer */
+		char         _drop_buffer[MAX_FRAME_SIZE];  /* used if buffer is full */
+		bool         _dropping;
+
+		unsigned   _num_queues;
+		int        _tap_fd[MAX_QUEUES];
+		Rx_thread *_rx_thread[MAX_QUEUES];
 
-		int _setup_tap_fd()
+		static unsigned _queues_from_config()
+		{
+			unsigned queues = 1;
+			try {
+				Genode::config()->xml_node().attribute("queues").value(&queues);
+			} catch (...) { }
+
+			return Genode::max(1U, Genode::min(queues, (unsigned)MAX_QUEUES));
+		}
+
+		static void _tap_name_from_config(char *dst, Genode::size_t dst_len)
+		{
+			Genode::strncpy(dst, "tap0", dst_len);
+			try {
+				Genode::config()->xml_node().attribute("tap").value(dst, dst_len);
+			} catch (...) { }
+		}
+
+		/**
+		 * Open queue of TAP device
+		 *
+		 * \return  file descriptor, or a negative value on error
+		 */
+		static int _open_tap_queue(char const *name, bool multi_queue)
 		{
 			/* open TAP device */
 			int ret;
@@ -76,27 +130,98 @@ class Linux_driver : public Nic::Driver
 			int fd = open("/dev/net/tun", O_RDWR);
 			if (fd < 0) {
 				PERR("could not open /dev/net/tun: no virtual network emulation");
-				/* this error is fatal */
-				throw Genode::Exception();
+				return -1;
 			}
 			Genode::memset(&ifr, 0, sizeof(ifr));
-			ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
-			Genode::strncpy(ifr.ifr_name, "tap0", sizeof(ifr.ifr_name));
+			ifr.ifr_flags = IFF_TAP | IFF_NO_PI | (multi_queue ? IFF_MULTI_QUEUE : 0);
+			Genode::strncpy(ifr.ifr_name, name, sizeof(ifr.ifr_name));
 			ret = ioctl(fd, TUNSETIFF, (void *) &ifr);
 			if (ret != 0) {
-				PERR("could not configure /dev/net/tun: no virtual network emulation");
 				close(fd);
+				return -1;
+			}
+
+			/* the receive threads drain the device until no frame is left */
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			return fd;
+		}
+
+		void _setup_tap_fds()
+		{
+			char name[IFNAMSIZ];
+			_tap_name_from_config(name, sizeof(name));
+
+			unsigned const queues = _queues_from_config();
+
+			for (_num_queues = 0; _num_queues < queues; _num_queues++) {
+				int const fd = _open_tap_queue(name, queues > 1);
+				if (fd < 0)
+					break;
+				_tap_fd[_num_queues] = fd;
+			}
+
+			if (_num_queues == queues)
+				return;
+
+			/* fall back to a single queue */
+			if (_num_queues == 0 && queues > 1) {
+				PWRN("%s does not support %u queues, using one queue", name, queues);
+				int const fd = _open_tap_queue(name, false);
+				if (fd >= 0)
+					_tap_fd[_num_queues++] = fd;
+			}
+
+			if (_num_queues == 0) {
+				PERR("could not configure /dev/net/tun: no virtual network emulation");
 				/* this error is fatal */
 				throw Genode::Exception();
 			}
 
-			return fd;
+			if (_num_queues < queues)
+				PWRN("%s: using %u of %u queues", name, _num_queues, queues);
+		}
+
+		/**
+		 * Select queue for transmitting a frame
+		 *
+		 * The hash covers the MAC addresses and, for IPv4, the IP
+		 * addresses of the frame.
+		 */
+		int _tx_fd(char const *frame, Genode::size_t size) const
+		{
+			enum { ETH_ADDRS = 12, ETH_TYPE = 12, IPV4_ADDRS = 26, IPV4_ADDRS_END = 34 };
+
+			if (_num_queues == 1 || size < ETH_ADDRS)
+				return _tap_fd[0];
+
+			unsigned char const *f = (unsigned char const *)frame;
+
+			unsigned hash = 0;
+			for (unsigned i = 0; i < ETH_ADDRS; i++)
+				hash = hash*31 + f[i];
+
+			if (size >= IPV4_ADDRS_END && f[ETH_TYPE] == 0x08 && f[ETH_TYPE + 1] == 0x00)
+				for (unsigned i = IPV4_ADDRS; i < IPV4_ADDRS_END; i++)
+					hash = hash*31 + f[i];
+
+			return _tap_fd[hash % _num_queues];
+		}
+
+		/**
+		 * Wait until the TAP device accepts another frame
+		 */
+		static void _wait_writable(int fd)
+		{
+			fd_set wfds;
+			FD_ZERO(&wfds);
+			FD_SET(fd, &wfds);
+			select(fd + 1, 0, &wfds, 0, 0);
 		}
 
 	public:
 
 		Linux_driver(Nic::Rx_buffer_alloc &alloc)
-		: _alloc(alloc), _tap_fd(_setup_tap_fd()), _rx_thread(_tap_fd, *this)
+		: _alloc(alloc), _rx_buffer(0), _dropping(false), _num_queues(0)
 		{
 			/* fake MAC address (unicast, locally managed) */
 			_mac_addr.addr[0] = 0x02;
@@ -106,7 +231,21 @@ class Linux_driver : public Nic::Driver
 			_mac_addr.addr[4] = 0x00;
 			_mac_addr.addr[5] = 0x01;
 
-			_rx_thread.start();
+			_setup_tap_fds();
+
+			for (unsigned i = 0; i < _num_queues; i++) {
+				_rx_thread[i] = new (Genode::env()->heap())
+				                Rx_thread(_tap_fd[i], *this);
+				_rx_thread[i]->start();
+			}
+		}
+
+		~Linux_driver()
+		{
+			for (unsigned i = 0; i < _num_queues; i++) {
+				Genode::destroy(Genode::env()->heap(), _rx_thread[i]);
+				close(_tap_fd[i]);
+			}
 		}
 
 
@@ -118,10 +257,16 @@ class Linux_driver : public Nic::Driver
 
 		void tx(char const *packet, Genode::size_t size)
 		{
-			int ret;
-
-			/* blocking-write packet to TAP */
-			do { ret = write(_tap_fd, packet, size); } while (ret < 0);
+			int const fd = _tx_fd(packet, size);
+
+			while (write(fd, packet, size) < 0) {
+				if (errno == EAGAIN)
+					_wait_writable(fd);
+				else if (errno != EINTR) {
+					PWRN("dropping frame of %zd bytes (errno=%d)", size, errno);
+					return;
+				}
+			}
 		}
 
 
@@ -129,18 +274,39 @@ class Linux_driver : public Nic::Driver
 		 ** Irq_activation interface **
 		 ******************************/
 
-		void handle_irq(int)
+		void handle_irq(int fd)
 		{
-			int ret;
+			Genode::Lock::Guard lock_guard(_rx_lock);
+
+			for (;;) {
+
+				/*
+				 * Read into a packet buffer of the maximum frame size. If
+				 * no frame is pending, the buffer is kept for the next
+				 * wake-up.
+				 */
+				if (!_rx_buffer) {
+					try { _rx_buffer = (char *)_alloc.alloc(MAX_FRAME_SIZE); }
+					catch (Nic::Session::Rx::Source::Packet_alloc_failed) { }
+				}
+
+				char *dst = _rx_buffer ? _rx_buffer : _drop_buffer;
 
-			/* blocking read incoming packet */
-			do {
-				ret = read(_tap_fd, _packet_buffer, sizeof(_packet_buffer));
-			} while (ret < 0);
+				int const ret = read(fd, dst, MAX_FRAME_SIZE);
+				if (ret <= 0)
+					return;
 
-			void *buffer = _alloc.alloc(ret);
-			Genode::memcpy(buffer, _packet_buffer, ret);
-			_alloc.submit();
+				if (!_rx_buffer) {
+					if (!_dropping)
+						PWRN("rx buffer exhausted, dropping frames");
+					_dropping = true;
+					continue;
+				}
+
+				_dropping = false;
+				_alloc.submit(ret);
+				_rx_buffer = 0;
+			}
 		}
 };
 
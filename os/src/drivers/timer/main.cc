@@ -35,9 +35,10 @@ int main(int argc, char **argv)
 
 	/*
 	 * Use sliced heap to allocate each session component at a separate
-	 * dataspace.
+	 * dataspace. The dataspaces of closed sessions are kept for reuse.
 	 */
-	static Sliced_heap sliced_heap(env()->ram_session(), env()->rm_session());
+	static Sliced_heap sliced_heap(env()->ram_session(), env()->rm_session(),
+	                               64*1024);
 
 	/*
 	 * Create root interface for timer service
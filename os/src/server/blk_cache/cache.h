@@ -0,0 +1,831 @@
+/*
+ * \brief  Cache of a block device
+ * \author Genode Labs
+ * \date   2013-03-07
+ *
+ * The cache keeps the content of the back-end device in lines of 4 KiB. A
+ * line tracks which of its blocks are valid and which are dirty. Lines are
+ * replaced in LRU order. Reads of missing lines and read-ahead are submitted
+ * to the back end asynchronously. A reader waits only for the lines it
+ * actually needs. Dirty lines are written back when replaced, when the share
+ * of dirty lines exceeds its limit, and when the cache is flushed. A block
+ * stays dirty until the back end acknowledged its write successfully.
+ *
+ * All functions are serialized by one lock. The lock is held while waiting
+ * for the back end, which is safe because the back end never waits for the
+ * cache.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <base/allocator_avl.h>
+#include <base/env.h>
+#include <base/lock.h>
+#include <base/printf.h>
+#include <block/driver.h>
+#include <block_session/connection.h>
+#include <util/string.h>
+
+namespace Block_cache {
+
+	using namespace Genode;
+
+	class Cache
+	{
+		public:
+
+			struct Config
+			{
+				size_t   size;           /* bytes of cached content      */
+				size_t   read_ahead;     /* maximum read-ahead in bytes  */
+				unsigned dirty_percent;  /* share of dirty lines allowed */
+				bool     write_through;
+			};
+
+			struct Stats
+			{
+				unsigned long hits;        /* blocks read from the cache    */
+				unsigned long misses;      /* blocks read from the back end */
+				unsigned long ahead;       /* lines fetched by read-ahead   */
+				unsigned long ahead_used;  /* of those, lines read later    */
+				unsigned long written;     /* blocks written to the back end */
+				unsigned long evicted;     /* replaced lines                */
+				unsigned long errors;      /* failed back-end requests      */
+				unsigned long lost;        /* dirty blocks dropped          */
+			};
+
+		private:
+
+			enum {
+				LINE_SIZE       = 4096,
+				MAX_LINE_BLOCKS = 32,           /* bits of the block masks */
+				BACKEND_BUF     = 1024*1024,
+				MAX_FETCHES     = 32,           /* reads in flight */
+				MAX_CHUNK_LINES = 64,
+				MAX_RETRIES     = 2,            /* of a write back on eviction */
+
+				/* leave room in the submit and ack queues of the back end */
+				MAX_IN_FLIGHT   = Block::Session::TX_QUEUE_SIZE / 2,
+			};
+
+			struct Line
+			{
+				size_t    number;     /* first block divided by blocks per line */
+				unsigned  valid;      /* mask of blocks with content   */
+				unsigned  dirty;      /* mask of blocks to write back  */
+				bool      mapped;     /* line caches 'number'          */
+				bool      pending;    /* fetch in flight               */
+				bool      ahead;      /* read ahead, not yet read      */
+				char     *data;
+				Line     *hash_next;
+				Line     *newer, *older;
+			};
+
+			struct Fetch
+			{
+				Block::Packet_descriptor packet;
+				size_t                   first_line;
+				unsigned                 num_lines;
+				bool                     ahead;
+				bool                     busy;
+			};
+
+			Lock                _lock;
+
+			Allocator_avl       _blk_alloc;
+			Block::Connection   _blk;
+			size_t              _block_size;
+			size_t              _block_count;
+
+			Config const        _config;
+			size_t              _line_blocks;   /* blocks per line */
+			size_t              _line_bytes;
+			unsigned            _num_lines;
+			unsigned            _chunk_lines;   /* lines handled at once */
+			unsigned            _max_ahead;     /* read-ahead limit in lines */
+			unsigned            _max_dirty;
+
+			Line               *_lines;
+			Line              **_buckets;
+			unsigned            _bucket_mask;
+			Line               *_newest, *_oldest;
+			unsigned            _num_mapped;
+			unsigned            _num_dirty;
+			unsigned            _num_pending;
+
+			Fetch               _fetches[MAX_FETCHES];
+			unsigned            _in_flight;    /* back-end requests */
+
+			/* writes in flight, which must not be overtaken */
+			Block::Packet_descriptor _writes[MAX_IN_FLIGHT];
+			unsigned                 _num_writes;
+			unsigned long            _failed_writes;
+			bool                     _dropped;      /* since the last flush */
+
+			size_t              _seq_next;   /* block following the last read */
+			unsigned            _ahead;      /* current read-ahead window in lines */
+
+			Stats               _stats;
+
+			static unsigned _mask(size_t first, size_t count) {
+				return count >= 32 ? ~0U : ((1U << count) - 1) << first; }
+
+			static unsigned _bits(unsigned mask)
+			{
+				unsigned n = 0;
+				for (; mask; mask &= mask - 1) n++;
+				return n;
+			}
+
+			/**
+			 * Return number of blocks of line that exist at the device
+			 */
+			size_t _blocks_of(size_t line) const {
+				return min(_line_blocks, _block_count - line*_line_blocks); }
+
+			/**
+			 * Return mask of the blocks of 'line' within the given range
+			 */
+			unsigned _range_mask(size_t line, size_t block, size_t count) const
+			{
+				size_t const first = max(block, line*_line_blocks);
+				size_t const end   = min(block + count, (line + 1)*_line_blocks);
+				return _mask(first - line*_line_blocks, end - first);
+			}
+
+			void _check_range(size_t block, size_t count)
+			{
+				if (block + count > _block_count || block + count < block) {
+					PWRN("requested blocks %zd-%zd out of range!", block, block + count);
+					throw Block::Driver::Io_error();
+				}
+			}
+
+
+			/**************************
+			 ** Lookup and LRU order **
+			 **************************/
+
+			Line *_lookup(size_t number)
+			{
+				Line *l = _buckets[number & _bucket_mask];
+				for (; l && l->number != number; l = l->hash_next);
+				return l;
+			}
+
+			void _unlink(Line *l)
+			{
+				if (l->newer) l->newer->older = l->older; else _newest = l->older;
+				if (l->older) l->older->newer = l->newer; else _oldest = l->newer;
+			}
+
+			void _push_newest(Line *l)
+			{
+				l->newer = 0;
+				l->older = _newest;
+				if (_newest) _newest->newer = l; else _oldest = l;
+				_newest = l;
+			}
+
+			void _touch(Line *l)
+			{
+				if (_newest == l)
+					return;
+
+				_unlink(l);
+				_push_newest(l);
+			}
+
+			void _unmap(Line *l)
+			{
+				Line **p = &_buckets[l->number & _bucket_mask];
+				for (; *p != l; p = &(*p)->hash_next);
+				*p = l->hash_next;
+
+				l->mapped = false;
+				_num_mapped--;
+			}
+
+			/**
+			 * Map line to 'number', replacing the least-recently used line
+			 */
+			Line *_map(size_t number)
+			{
+				Line *l = 0;
+
+				/* lines are replaced once all of them are in use */
+				if (_num_mapped < _num_lines)
+					l = &_lines[_num_mapped];
+				else {
+					/* lines with fetches in flight are not replaced */
+					while (!(l = _oldest_idle()))
+						_process_ack();
+
+					_write_back_for_eviction(l);
+
+					_unmap(l);
+					_unlink(l);
+					_stats.evicted++;
+				}
+
+				l->number  = number;
+				l->valid   = 0;
+				l->dirty   = 0;
+				l->pending = false;
+				l->ahead   = false;
+				l->mapped  = true;
+
+				l->hash_next = _buckets[number & _bucket_mask];
+				_buckets[number & _bucket_mask] = l;
+				_num_mapped++;
+
+				_push_newest(l);
+				return l;
+			}
+
+			Line *_oldest_idle()
+			{
+				Line *l = _oldest;
+				for (; l && l->pending; l = l->newer);
+				return l;
+			}
+
+			/**
+			 * Make sure that the content of the line is at the back end
+			 *
+			 * A failed write marks the blocks dirty again, so the line is
+			 * reused not before its writes are acknowledged. If the back end
+			 * fails repeatedly, the dirty blocks are dropped.
+			 */
+			void _write_back_for_eviction(Line *l)
+			{
+				size_t const block = l->number*_line_blocks;
+
+				for (unsigned retry = 0; ; retry++) {
+					if (l->dirty)
+						_write_back(l);
+
+					_wait_for_writes(block, _blocks_of(l->number));
+
+					if (!l->dirty)
+						return;
+
+					if (retry == MAX_RETRIES)
+						break;
+				}
+
+				PERR("dropping dirty blocks of %zu-%zu",
+				     block, block + _blocks_of(l->number));
+				_stats.lost += _bits(l->dirty);
+				_dropped = true;
+				l->dirty = 0;
+				_num_dirty--;
+			}
+
+
+			/*************************
+			 ** Back-end processing **
+			 *************************/
+
+			Block::Packet_descriptor _alloc_packet(size_t size)
+			{
+				for (;;) {
+					if (_in_flight < MAX_IN_FLIGHT)
+						try { return _blk.tx()->alloc_packet(size); }
+						catch (Block::Session::Tx::Source::Packet_alloc_failed) { }
+
+					/* requests are bounded by the buffer, so acks will free space */
+					_process_ack();
+				}
+			}
+
+			void _submit(Block::Packet_descriptor const &p)
+			{
+				_blk.tx()->submit_packet(p);
+				_in_flight++;
+			}
+
+			/**
+			 * Wait for one acknowledgement of the back end and process it
+			 */
+			void _process_ack()
+			{
+				if (!_in_flight) {
+					PERR("waiting for back end without requests in flight");
+					throw Block::Driver::Io_error();
+				}
+
+				Block::Packet_descriptor p = _blk.tx()->get_acked_packet();
+				_in_flight--;
+
+				if (p.operation() == Block::Packet_descriptor::READ) {
+					for (unsigned i = 0; i < MAX_FETCHES; i++)
+						if (_fetches[i].busy && _fetches[i].packet.offset() == p.offset()) {
+							_fill(_fetches[i], p);
+							_fetches[i].busy = false;
+							break;
+						}
+				} else {
+					for (unsigned i = 0; i < _num_writes; i++)
+						if (_writes[i].offset() == p.offset()) {
+							_writes[i] = _writes[--_num_writes];
+							break;
+						}
+
+					if (p.succeeded())
+						_stats.written += p.block_count();
+					else
+						_write_failed(p);
+				}
+
+				_blk.tx()->release_packet(p);
+			}
+
+			/**
+			 * Mark the blocks of a failed write dirty again
+			 *
+			 * A write never spans lines and the line is not reused before
+			 * its writes are acknowledged. Hence, the line still holds the
+			 * content, or a newer one.
+			 */
+			void _write_failed(Block::Packet_descriptor const &p)
+			{
+				PERR("write back of blocks %zu-%zu failed",
+				     p.block_number(), p.block_number() + p.block_count());
+				_stats.errors++;
+				_failed_writes++;
+
+				size_t const n = p.block_number() / _line_blocks;
+				Line *l = _lookup(n);
+				if (!l)
+					return;
+
+				if (!l->dirty) _num_dirty++;
+				l->dirty |= _range_mask(n, p.block_number(), p.block_count());
+			}
+
+			void _process_available_acks()
+			{
+				while (_in_flight && _blk.tx()->ack_avail())
+					_process_ack();
+			}
+
+			void _wait_for_writes()
+			{
+				while (_num_writes)
+					_process_ack();
+			}
+
+			/**
+			 * Wait until no write of the given blocks is in flight
+			 *
+			 * The back end may reorder requests. So, a read must not be
+			 * submitted before a write of the same blocks is completed, and
+			 * neither must a newer write.
+			 */
+			void _wait_for_writes(size_t block, size_t count)
+			{
+				for (unsigned i = 0; i < _num_writes; ) {
+					Block::Packet_descriptor const &w = _writes[i];
+					if (w.block_number() < block + count
+					 && block < w.block_number() + w.block_count()) {
+						_process_ack();
+						i = 0;
+					} else
+						i++;
+				}
+			}
+
+			/**
+			 * Copy fetched content into the lines, keeping blocks written meanwhile
+			 */
+			void _fill(Fetch const &f, Block::Packet_descriptor const &p)
+			{
+				if (!p.succeeded()) {
+					PERR("read of blocks %zu-%zu failed",
+					     p.block_number(), p.block_number() + p.block_count());
+					_stats.errors++;
+				}
+
+				char const *content = _blk.tx()->packet_content(p);
+
+				for (unsigned i = 0; i < f.num_lines; i++) {
+
+					Line *l = _lookup(f.first_line + i);
+					if (!l)
+						continue;
+
+					l->pending = false;
+					l->ahead   = f.ahead;
+					_num_pending--;
+
+					if (!p.succeeded())
+						continue;
+
+					unsigned const fetched = _mask(0, _blocks_of(l->number));
+					for (unsigned b = 0; b < _line_blocks; b++) {
+						unsigned const bit = 1U << b;
+						if (!(fetched & bit) || (l->valid & bit))
+							continue;
+
+						memcpy(l->data + b*_block_size,
+						       content + i*_line_bytes + b*_block_size, _block_size);
+					}
+					l->valid |= fetched;
+				}
+			}
+
+			/**
+			 * Submit read of consecutive lines, which are marked as pending
+			 */
+			void _fetch(size_t first_line, unsigned num_lines, bool ahead)
+			{
+				size_t const block = first_line*_line_blocks;
+				size_t const count = min(num_lines*_line_blocks, _block_count - block);
+
+				_wait_for_writes(block, count);
+
+				Fetch *f = 0;
+				for (;;) {
+					for (unsigned i = 0; i < MAX_FETCHES && !f; i++)
+						if (!_fetches[i].busy)
+							f = &_fetches[i];
+					if (f)
+						break;
+					_process_ack();
+				}
+
+				f->packet     = Block::Packet_descriptor(_alloc_packet(count*_block_size),
+				                                         Block::Packet_descriptor::READ,
+				                                         block, count);
+				f->first_line = first_line;
+				f->num_lines  = num_lines;
+				f->ahead      = ahead;
+				f->busy       = true;
+
+				_submit(f->packet);
+
+				if (ahead)
+					_stats.ahead += num_lines;
+			}
+
+			void _submit_write(size_t block, size_t count, char const *src)
+			{
+				_wait_for_writes(block, count);
+
+				Block::Packet_descriptor p(_alloc_packet(count*_block_size),
+				                           Block::Packet_descriptor::WRITE,
+				                           block, count);
+				memcpy(_blk.tx()->packet_content(p), src, count*_block_size);
+				_submit(p);
+
+				_writes[_num_writes++] = p;
+			}
+
+			/**
+			 * Submit write of all dirty blocks of the line
+			 *
+			 * The line is clean while the writes are in flight. If a write
+			 * fails, its blocks become dirty again.
+			 */
+			void _write_back(Line *l)
+			{
+				for (unsigned b = 0; b < _line_blocks; ) {
+					if (!(l->dirty & (1U << b))) { b++; continue; }
+
+					unsigned n = 1;
+					for (; b + n < _line_blocks && (l->dirty & (1U << (b + n))); n++);
+
+					_submit_write(l->number*_line_blocks + b, n, l->data + b*_block_size);
+					b += n;
+				}
+
+				l->dirty = 0;
+				_num_dirty--;
+			}
+
+			/**
+			 * Write back the least-recently used dirty lines
+			 */
+			void _write_back_oldest(unsigned max_dirty)
+			{
+				for (Line *l = _oldest; l && _num_dirty > max_dirty; l = l->newer)
+					if (l->dirty)
+						_write_back(l);
+			}
+
+			void _write_back_all()
+			{
+				for (unsigned i = 0; i < _num_lines && _num_dirty; i++)
+					if (_lines[i].mapped && _lines[i].dirty)
+						_write_back(&_lines[i]);
+			}
+
+
+			/*******************
+			 ** Reading lines **
+			 *******************/
+
+			/**
+			 * Make sure that fetches of all lines of the range are submitted
+			 */
+			void _request(size_t block, size_t count)
+			{
+				size_t const last = (block + count - 1) / _line_blocks;
+
+				size_t   run_first = 0;
+				unsigned run       = 0;
+
+				for (size_t n = block / _line_blocks; n <= last; n++) {
+
+					Line *l = _lookup(n);
+					if (l) _touch(l); else l = _map(n);
+
+					unsigned const needed  = _range_mask(n, block, count);
+					unsigned const missing = l->pending ? 0 : needed & ~l->valid;
+
+					_stats.hits   += _bits(needed & ~missing);
+					_stats.misses += _bits(missing);
+
+					if (missing) {
+						l->pending = true;
+						_num_pending++;
+						if (!run++)
+							run_first = n;
+					}
+
+					if (run && (!missing || n == last)) {
+						_fetch(run_first, run, false);
+						run = 0;
+					}
+				}
+			}
+
+			/**
+			 * Start reading the lines following a sequential read
+			 *
+			 * The window grows with each sequential read. Lines are fetched
+			 * not before the missing part of the window is large enough to
+			 * be worth a request.
+			 */
+			void _read_ahead(size_t end)
+			{
+				_ahead = max(1U, min(2*_ahead, _max_ahead));
+
+				size_t const first = (end + _line_blocks - 1) / _line_blocks;
+				size_t const limit = min(first + _ahead,
+				                         (_block_count + _line_blocks - 1) / _line_blocks);
+
+				size_t n = first;
+				for (; n < limit && _lookup(n); n++);
+
+				if (n == limit || (n - first)*2 > _ahead)
+					return;
+
+				/* keep enough idle lines for replacement */
+				if (_num_pending + _ahead > _num_lines / 4)
+					return;
+
+				size_t const run_first = n;
+				for (; n < limit && !_lookup(n); n++) {
+					Line *l = _map(n);
+					l->pending = true;
+					_num_pending++;
+				}
+				_fetch(run_first, n - run_first, true);
+			}
+
+			/**
+			 * Copy range from the cache, waiting for fetches in flight
+			 */
+			void _copy_out(size_t block, size_t count, char *dst)
+			{
+				for (size_t const end = block + count; block < end; ) {
+
+					size_t const n     = block / _line_blocks;
+					size_t const first = block - n*_line_blocks;
+					size_t const num   = min(end - block, _line_blocks - first);
+
+					Line *l = _lookup(n);
+					while (l && l->pending)
+						_process_ack();
+
+					unsigned const needed = _mask(first, num);
+					if (!l || (l->valid & needed) != needed)
+						throw Block::Driver::Io_error();
+
+					if (l->ahead) {
+						_stats.ahead_used++;
+						l->ahead = false;
+					}
+
+					memcpy(dst, l->data + first*_block_size, num*_block_size);
+					dst   += num*_block_size;
+					block += num;
+				}
+			}
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param config  cache parameters, the read-ahead and the
+			 *                number of lines are limited so that the
+			 *                lines of a request are never replaced by
+			 *                the request itself
+			 */
+			Cache(Config const &config)
+			:
+				_blk_alloc(env()->heap()),
+				_blk(&_blk_alloc, BACKEND_BUF),
+				_config(config),
+				_newest(0), _oldest(0), _num_mapped(0), _num_dirty(0), _num_pending(0),
+				_in_flight(0), _num_writes(0), _failed_writes(0), _dropped(false),
+				_seq_next(0), _ahead(0)
+			{
+				Block::Session::Operations ops;
+				_blk.info(&_block_count, &_block_size, &ops);
+
+				_line_blocks = max((size_t)1, min(LINE_SIZE / _block_size,
+				                                  (size_t)MAX_LINE_BLOCKS));
+				_line_bytes  = _line_blocks*_block_size;
+
+				/* lines of one request fit into a quarter of the back-end buffer */
+				_chunk_lines = max((size_t)1, min((size_t)MAX_CHUNK_LINES,
+				                                  BACKEND_BUF / 4 / _line_bytes));
+				_num_lines   = max(config.size / _line_bytes, (size_t)8*_chunk_lines);
+				_max_ahead   = min(config.read_ahead / _line_bytes, (size_t)_chunk_lines);
+				_max_dirty   = max(1U, _num_lines*min(config.dirty_percent, 100U) / 100);
+
+				_lines = new (env()->heap()) Line[_num_lines];
+
+				char *data = env()->rm_session()->attach(
+					env()->ram_session()->alloc(_num_lines*_line_bytes));
+
+				for (unsigned i = 0; i < _num_lines; i++) {
+					_lines[i].data   = data + i*_line_bytes;
+					_lines[i].mapped = false;
+					_lines[i].newer  = _lines[i].older = 0;
+				}
+
+				/* there are at least as many buckets as lines */
+				unsigned num_buckets = 1;
+				for (; num_buckets < _num_lines; num_buckets <<= 1);
+				_bucket_mask = num_buckets - 1;
+
+				_buckets = new (env()->heap()) Line *[num_buckets];
+				for (unsigned i = 0; i < num_buckets; i++)
+					_buckets[i] = 0;
+
+				for (unsigned i = 0; i < MAX_FETCHES; i++)
+					_fetches[i].busy = false;
+
+				memset(&_stats, 0, sizeof(_stats));
+			}
+
+			size_t block_size()  const { return _block_size; }
+			size_t block_count() const { return _block_count; }
+			size_t line_bytes()  const { return _line_bytes; }
+			unsigned num_lines() const { return _num_lines; }
+
+			void read(size_t block, size_t count, char *dst)
+			{
+				Lock::Guard guard(_lock);
+
+				_check_range(block, count);
+				_process_available_acks();
+
+				bool const sequential = block == _seq_next && count;
+				_seq_next = block + count;
+				if (!sequential)
+					_ahead = 0;
+
+				size_t const end = block + count;
+				for (bool first = true; block < end; first = false) {
+
+					size_t const chunk_end = min(end, (block / _line_blocks + _chunk_lines)*_line_blocks);
+					size_t const num       = chunk_end - block;
+
+					_request(block, num);
+
+					/* fetch ahead while the first chunk is read */
+					if (first && sequential && _max_ahead)
+						_read_ahead(end);
+
+					_copy_out(block, num, dst);
+					dst   += num*_block_size;
+					block  = chunk_end;
+				}
+			}
+
+			void write(size_t block, size_t count, char const *src)
+			{
+				Lock::Guard guard(_lock);
+
+				_check_range(block, count);
+				_process_available_acks();
+
+				unsigned long const failed_writes = _failed_writes;
+
+				for (size_t const end = block + count; block < end; ) {
+
+					size_t const n     = block / _line_blocks;
+					size_t const first = block - n*_line_blocks;
+					size_t const num   = min(end - block, _line_blocks - first);
+
+					/* blocks that are written need not be fetched */
+					Line *l = _lookup(n);
+					if (l) _touch(l); else l = _map(n);
+
+					memcpy(l->data + first*_block_size, src, num*_block_size);
+					l->valid |= _mask(first, num);
+
+					if (_config.write_through)
+						_submit_write(block, num, src);
+					else {
+						if (!l->dirty) _num_dirty++;
+						l->dirty |= _mask(first, num);
+					}
+
+					src   += num*_block_size;
+					block += num;
+				}
+
+				if (_config.write_through) {
+					_wait_for_writes();
+
+					/* the failed blocks stay dirty and are written back later */
+					if (_failed_writes != failed_writes)
+						throw Block::Driver::Io_error();
+
+				} else if (_num_dirty > _max_dirty)
+					_write_back_oldest(_max_dirty / 2);
+			}
+
+			/**
+			 * Write back all dirty lines
+			 *
+			 * \param wait  return not before the back end acknowledged
+			 *              all writes, failed writes are retried as long
+			 *              as the back end makes progress
+			 *
+			 * \return  false if dirty blocks were dropped since the last
+			 *          waiting flush or, if 'wait' is set, if blocks could
+			 *          not be written back
+			 */
+			bool flush(bool wait)
+			{
+				Lock::Guard guard(_lock);
+
+				if (!wait) {
+					_write_back_all();
+					_process_available_acks();
+					return !_dropped;
+				}
+
+				for (;;) {
+					unsigned long const written = _stats.written;
+
+					_write_back_all();
+					_wait_for_writes();
+
+					if (!_num_dirty || _stats.written == written)
+						break;
+				}
+
+				bool const ok = !_dropped && !_num_dirty;
+				_dropped = false;
+				return ok;
+			}
+
+			Stats stats()
+			{
+				Lock::Guard guard(_lock);
+				return _stats;
+			}
+
+			void print_stats()
+			{
+				Stats const s = stats();
+
+				unsigned long const reads = s.hits + s.misses;
+				printf("blk_cache: %lu of %lu blocks read from cache (%lu%%), "
+				       "read ahead %lu lines, %lu used, %lu blocks written, "
+				       "%lu lines replaced, %lu errors, %lu blocks lost\n",
+				       s.hits, reads, reads ? s.hits*100/reads : 0,
+				       s.ahead, s.ahead_used, s.written, s.evicted, s.errors,
+				       s.lost);
+			}
+	};
+}
+
+#endif /* _CACHE_H_ */
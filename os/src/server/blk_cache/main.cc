@@ -0,0 +1,162 @@
+/*
+ * \brief  Block cache server
+ * \author Genode Labs
+ * \date   2013-03-07
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <block/component.h>
+#include <cap_session/connection.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+
+#include "cache.h"
+
+using namespace Genode;
+
+
+/**
+ * Driver that serves the requests of the client from the cache
+ *
+ * The cache outlives the sessions. So, a client that reconnects finds the
+ * content it accessed before.
+ */
+class Cache_driver : public Block::Driver
+{
+	private:
+
+		Block_cache::Cache &_cache;
+
+	public:
+
+		Cache_driver(Block_cache::Cache &cache) : _cache(cache) { }
+
+		size_t block_size()  { return _cache.block_size(); }
+		size_t block_count() { return _cache.block_count(); }
+		bool   dma_enabled() { return false; }
+
+		void read(size_t block_number, size_t block_count, char *out_buffer) {
+			_cache.read(block_number, block_count, out_buffer); }
+
+		void write(size_t block_number, size_t block_count, char const *buffer) {
+			_cache.write(block_number, block_count, buffer); }
+
+		void read_dma(size_t, size_t, addr_t)  { throw Io_error(); }
+		void write_dma(size_t, size_t, addr_t) { throw Io_error(); }
+};
+
+
+/**
+ * Thread that writes back dirty lines periodically
+ */
+class Flush_thread : public Thread<8192>
+{
+	private:
+
+		Block_cache::Cache &_cache;
+		Timer::Connection   _timer;
+		unsigned const      _period_ms;
+		bool const          _verbose;
+
+	public:
+
+		Flush_thread(Block_cache::Cache &cache, unsigned period_ms, bool verbose)
+		:
+			Thread<8192>("flush"), _cache(cache),
+			_period_ms(period_ms), _verbose(verbose)
+		{ }
+
+		void entry()
+		{
+			for (;;) {
+				_timer.msleep(_period_ms);
+				_cache.flush(false);
+
+				if (_verbose)
+					_cache.print_stats();
+			}
+		}
+};
+
+
+int main(int argc, char **argv)
+{
+	printf("--- block cache started ---\n");
+
+	Block_cache::Cache::Config cfg;
+	Number_of_bytes size       = 4*1024*1024;
+	Number_of_bytes read_ahead = 128*1024;
+	unsigned        flush_ms   = 1000;
+	bool            verbose    = false;
+
+	cfg.dirty_percent = 50;
+	cfg.write_through = false;
+
+	try {
+		Xml_node config = Genode::config()->xml_node();
+
+		try { config.attribute("size").value(&size);                        } catch (...) { }
+		try { config.attribute("read_ahead").value(&read_ahead);            } catch (...) { }
+		try { config.attribute("dirty_percent").value(&cfg.dirty_percent); } catch (...) { }
+		try { config.attribute("flush_ms").value(&flush_ms);                } catch (...) { }
+		try { cfg.write_through = config.attribute("write_through").has_value("yes"); } catch (...) { }
+		try { verbose = config.attribute("verbose").has_value("yes");         } catch (...) { }
+	} catch (...) { }
+
+	cfg.size       = size;
+	cfg.read_ahead = read_ahead;
+
+	static Block_cache::Cache cache(cfg);
+
+	printf("%u lines of %zu bytes, %zu blocks of %zu bytes at back end\n",
+	       cache.num_lines(), cache.line_bytes(), cache.block_count(),
+	       cache.block_size());
+
+	if (flush_ms && !cfg.write_through) {
+		static Flush_thread flush_thread(cache, flush_ms, verbose);
+		flush_thread.start();
+	}
+
+	struct Cache_driver_factory : Block::Driver_factory
+	{
+		Block_cache::Cache &cache;
+
+		Cache_driver_factory(Block_cache::Cache &cache) : cache(cache) { }
+
+		Block::Driver *create() {
+			return new (env()->heap()) Cache_driver(cache); }
+
+		/**
+		 * The content written by a client is at the back end once its
+		 * session is closed.
+		 */
+		void destroy(Block::Driver *driver)
+		{
+			if (!cache.flush(true))
+				PERR("not all content written by the client is at the back end");
+
+			cache.print_stats();
+			Genode::destroy(env()->heap(), static_cast<Cache_driver *>(driver));
+		}
+
+	} driver_factory(cache);
+
+	enum { STACK_SIZE = 8192 };
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "blk_cache_ep");
+
+	static Block::Root block_root(&ep, env()->heap(), driver_factory,
+	                              Block::Request_scheduler::policy_from_config());
+	env()->parent()->announce(ep.manage(&block_root));
+
+	sleep_forever();
+	return 0;
+}
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -19,6 +19,10 @@
 /**
  * Let the client a receive a network packet.
  *
+ * If the client does not keep up with processing its packets, the packet
+ * is dropped. Otherwise, the handler would stall the forwarding of other
+ * clients' packets.
+ *
  * \param addr  start address network packet.
  * \param size  size of network packet.
  */
@@ -29,20 +33,29 @@ void Net::Address_node<LEN>::receive_packet(void *addr, Genode::size_t size)
 
 	Nic::Session::Rx::Source *source = _component->rx_source();
 
-	while (true) {
-		/* flush remaining acknowledgements */
-		while (source->ack_avail())
-			source->release_packet(source->get_acked_packet());
+	/* flush remaining acknowledgements */
+	enum { MAX_ACKS = 32 };
+	Packet_descriptor acked[MAX_ACKS];
+	while (source->ack_avail()) {
+		unsigned const num = source->get_acked_packets(acked, MAX_ACKS);
+		for (unsigned i = 0; i < num; i++)
+			source->release_packet(acked[i]);
+	}
+
+	if (!source->ready_to_submit()) {
+		_component->rx_dropped();
+		return;
+	}
 
-		try {
-			/* allocate packet in rx channel */
-			Packet_descriptor rx_packet = source->alloc_packet(size);
+	try {
+		/* allocate packet in rx channel */
+		Packet_descriptor rx_packet = source->alloc_packet(size);
 
-			Genode::memcpy((void*)source->packet_content(rx_packet),
-			               (void*)addr, size);
-			source->submit_packet(rx_packet);
-			return;
-		} catch (Nic::Session::Rx::Source::Packet_alloc_failed) { }
+		Genode::memcpy((void*)source->packet_content(rx_packet),
+		               (void*)addr, size);
+		source->submit_packet(rx_packet);
+	} catch (Nic::Session::Rx::Source::Packet_alloc_failed) {
+		_component->rx_dropped();
 	}
 }
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -15,7 +15,6 @@
 #define _ADDRESS_NODE_H_
 
 /* Genode */
-#include <util/avl_tree.h>
 #include <util/list.h>
 #include <nic_session/nic_session.h>
 #include <net/netaddress.h>
@@ -24,18 +23,18 @@
 
 namespace Net {
 
-	/* Forward declaration */
+	/* Forward declarations */
 	class Session_component;
+	template <typename> class Address_table;
 
 
 	/**
 	 * An Address_node encapsulates a session-component and can be hold in
-	 * a list and/or avl-tree, whereby the network-address (MAC or IP)
+	 * a list and/or address table, whereby the network-address (MAC or IP)
 	 * acts as a key.
 	 */
 	template <unsigned LEN>
-	class Address_node : public Genode::Avl_node<Address_node<LEN> >,
-	                     public Genode::List<Address_node<LEN> >::Element
+	class Address_node : public Genode::List<Address_node<LEN> >::Element
 	{
 		public:
 
@@ -43,19 +42,24 @@ namespace Net {
 
 		private:
 
+			friend class Address_table<Address_node>;
+
 			Address            _addr;       /* MAC or IP address  */
 			Session_component *_component;  /* client's component */
 
+			Address_node * volatile _bucket_next; /* used by 'Address_table' */
+			Address_node * volatile _table_next;
+
 		public:
 
 			/**
 			 * Constructor
 			 *
-			 * \param addr  Network address acting as sorting criteria.
+			 * \param addr  Network address acting as key.
 			 * \param component  pointer to client's session component.
 			 */
 			Address_node(Address addr, Session_component *component)
-			: _addr(addr), _component(component) { }
+			: _addr(addr), _component(component), _bucket_next(0), _table_next(0) { }
 
 
 			/***************
@@ -72,35 +76,6 @@ namespace Net {
 			 * \param size  size of network packet
 			 */
 			void receive_packet(void *addr, Genode::size_t size);
-
-
-			/************************
-			 ** Avl node interface **
-			 ************************/
-
-			bool higher(Address_node *c)
-			{
-				using namespace Genode;
-
-				return (memcmp(&c->_addr.addr, &_addr.addr,
-				               sizeof(_addr.addr)) > 0);
-			}
-
-			/**
-			 * Find by address
-			 */
-			Address_node *find_by_address(Address addr)
-			{
-				using namespace Genode;
-
-				if (addr == _addr)
-					return this;
-
-				bool side = memcmp(&addr.addr, _addr.addr,
-				                   sizeof(_addr.addr)) > 0;
-				Address_node *c = Avl_node<Address_node>::child(side);
-				return c ? c->find_by_address(addr) : 0;
-			}
 	};
 
 
@@ -0,0 +1,131 @@
+/*
+ * \brief  Hash table of address nodes
+ * \author Genode Labs
+ * \date   2013-03-07
+ *
+ * The table is read-mostly. It is modified when a session is created or
+ * destroyed and when a client gets an IP address, but looked up for each
+ * forwarded frame. Therefore, lookups do not take a lock. Modifications
+ * are serialized by a lock and publish a node only after it is fully
+ * linked. A removed node must not be freed before all lookups that may
+ * have found it are finished (see 'Vlan::Reader').
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _ADDRESS_TABLE_H_
+#define _ADDRESS_TABLE_H_
+
+/* Genode */
+#include <base/lock.h>
+
+namespace Net {
+
+	template <typename NT>
+	class Address_table
+	{
+		public:
+
+			typedef typename NT::Address Address;
+
+		private:
+
+			enum { NUM_BUCKETS = 64 };
+
+			Genode::Lock  _lock;                 /* serializes modifications */
+			NT * volatile _buckets[NUM_BUCKETS];
+			NT * volatile _first;                /* all nodes */
+
+			static void _barrier() { __sync_synchronize(); }
+
+			static unsigned _hash(Address const &addr)
+			{
+				unsigned h = 2166136261U;
+				for (unsigned i = 0; i < sizeof(addr.addr); i++)
+					h = (h ^ addr.addr[i]) * 16777619U;
+				return h % NUM_BUCKETS;
+			}
+
+			/**
+			 * Unlink node from singly-linked chain
+			 */
+			static void _unlink(NT * volatile *head, NT *node,
+			                    NT * volatile NT::*next)
+			{
+				for (NT * volatile *p = head; *p; p = &((*p)->*next))
+					if (*p == node) {
+						*p = node->*next;
+						return;
+					}
+			}
+
+		public:
+
+			Address_table() : _first(0)
+			{
+				for (unsigned i = 0; i < NUM_BUCKETS; i++)
+					_buckets[i] = 0;
+			}
+
+			void insert(NT *node)
+			{
+				Genode::Lock::Guard lock_guard(_lock);
+
+				NT * volatile &bucket = _buckets[_hash(node->addr())];
+
+				node->_bucket_next = bucket;
+				node->_table_next  = _first;
+
+				/* make the node's links visible before the node itself */
+				_barrier();
+
+				bucket = node;
+				_first = node;
+			}
+
+			/**
+			 * Remove node
+			 *
+			 * Concurrent lookups may still find the node. A removed node
+			 * keeps its links, so such lookups continue their traversal.
+			 */
+			void remove(NT *node)
+			{
+				Genode::Lock::Guard lock_guard(_lock);
+
+				_unlink(&_buckets[_hash(node->addr())], node, &NT::_bucket_next);
+				_unlink(&_first, node, &NT::_table_next);
+				_barrier();
+			}
+
+			/**
+			 * Look up node by address
+			 *
+			 * \return  node, or 0 if the address is unknown
+			 */
+			NT *lookup(Address const &addr)
+			{
+				for (NT *n = _buckets[_hash(addr)]; n; n = n->_bucket_next)
+					if (n->addr() == addr)
+						return n;
+				return 0;
+			}
+
+			/**
+			 * Return first node for iterating over all nodes
+			 */
+			NT *first() { return _first; }
+
+			/**
+			 * Return node following 'node' during iteration
+			 */
+			static NT *next(NT *node) { return node->_table_next; }
+	};
+}
+
+#endif /* _ADDRESS_TABLE_H_ */
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -22,28 +22,20 @@
 using namespace Net;
 
 
-void Session_component::Tx_handler::acknowledge_last_one()
-{
-	if (!_tx_packet.valid())
-		return;
-
-	if (!_component->tx_sink()->ready_to_ack())
-		PDBG("need to wait until ready-for-ack");
-	_component->tx_sink()->acknowledge_packet(_tx_packet);
-}
-
-
 void Session_component::Tx_handler::next_packet(void** src, Genode::size_t *size)
 {
+	/* no frame is handled at this point */
+	_component->free_retired_ipv4_nodes();
+
 	while (true) {
 		/* block for a new packet */
-		_tx_packet = _component->tx_sink()->get_packet();
-		if (!_tx_packet.valid()) {
+		Packet_descriptor tx_packet = _tx_batch.next(_component->tx_sink());
+		if (!tx_packet.valid()) {
 			PWRN("received invalid packet");
 			continue;
 		}
-		*src  = _component->tx_sink()->packet_content(_tx_packet);
-		*size = _tx_packet.size();
+		*src  = _component->tx_sink()->packet_content(tx_packet);
+		*size = tx_packet.size();
 		return;
 	}
 }
@@ -55,9 +47,7 @@ bool Session_component::Tx_handler::handle_arp(Ethernet_frame *eth, Genode::size
 		new (eth->data()) Arp_packet(size - sizeof(Ethernet_frame));
 	if (arp->ethernet_ipv4() &&
 		arp->opcode() == Arp_packet::REQUEST) {
-		Ipv4_address_node *node = Vlan::vlan()->ip_tree()->first();
-		if (node)
-			node = node->find_by_address(arp->dst_ip());
+		Ipv4_address_node *node = Vlan::vlan()->ip_table()->lookup(arp->dst_ip());
 		if (!node) {
 			arp->src_mac(_mac);
 		}
@@ -91,9 +81,7 @@ bool Session_component::Tx_handler::handle_ip(Ethernet_frame *eth, Genode::size_
 void Session_component::Tx_handler::finalize_packet(Ethernet_frame *eth,
                                                     Genode::size_t size)
 {
-	Mac_address_node *node = Vlan::vlan()->mac_tree()->first();
-	if (node)
-		node = node->find_by_address(eth->dst());
+	Mac_address_node *node = Vlan::vlan()->mac_table()->lookup(eth->dst());
 	if (node)
 		node->receive_packet((void*) eth, size);
 	else
@@ -101,12 +89,40 @@ void Session_component::Tx_handler::finalize_packet(Ethernet_frame *eth,
 }
 
 
-void Session_component::_free_ipv4_node()
+void Session_component::_free_ipv4_nodes()
 {
-	if (_ipv4_node) {
-		Vlan::vlan()->ip_tree()->remove(_ipv4_node);
-		destroy(this->guarded_allocator(), _ipv4_node);
+	Genode::Lock::Guard lock_guard(_ipv4_lock);
+
+	while (Ipv4_address_node *node = _ipv4_nodes.first()) {
+		_ipv4_nodes.remove(node);
+		destroy(this->guarded_allocator(), node);
 	}
+	_ipv4_retired = false;
+}
+
+
+void Session_component::_free_retired_ipv4_nodes()
+{
+	if (!_ipv4_retired
+	 || !Vlan::vlan()->grace_period_elapsed(_ipv4_retired_epoch))
+		return;
+
+	/* all nodes but the current one are retired */
+	while (Ipv4_address_node *node = _ipv4_nodes.first()->next()) {
+		_ipv4_nodes.remove(node);
+		destroy(this->guarded_allocator(), node);
+	}
+	_ipv4_retired = false;
+}
+
+
+void Session_component::free_retired_ipv4_nodes()
+{
+	if (!_ipv4_retired)
+		return;
+
+	Genode::Lock::Guard lock_guard(_ipv4_lock);
+	_free_retired_ipv4_nodes();
 }
 
 
@@ -116,18 +132,26 @@ Session_component::Session_component(Genode::Allocator          *allocator,
                                      Genode::size_t              rx_buf_size,
                                      Ethernet_frame::Mac_address vmac,
                                      Nic::Connection            *session,
-                                     Genode::Rpc_entrypoint     &ep)
+                                     Genode::Rpc_entrypoint     &ep,
+                                     unsigned                    tx_queue_size,
+                                     unsigned                    rx_queue_size)
 : Guarded_range_allocator(allocator, amount),
   Tx_rx_communication_buffers(tx_buf_size, rx_buf_size),
   Session_rpc_object(Tx_rx_communication_buffers::tx_ds(),
                      Tx_rx_communication_buffers::rx_ds(),
-                     this->range_allocator(), ep),
+                     this->range_allocator(), ep,
+                     tx_queue_size, rx_queue_size),
   _tx_handler(session, this),
   _mac_node(vmac, this),
-  _ipv4_node(0)
+  _ipv4_retired(false), _ipv4_retired_epoch(0), _rx_dropped(0)
 {
-	Vlan::vlan()->mac_tree()->insert(&_mac_node);
-	Vlan::vlan()->mac_list()->insert(&_mac_node);
+	/* the meta data of the rx packet allocator is accounted to the client */
+	if (!range_allocator()->avail()) {
+		PERR("insufficient 'ram_quota' for rx packet allocator");
+		throw Genode::Root::Quota_exceeded();
+	}
+
+	Vlan::vlan()->mac_table()->insert(&_mac_node);
 
 	/* start handler */
 	_tx_handler.start();
@@ -136,16 +160,44 @@ Session_component::Session_component(Genode::Allocator          *allocator,
 
 
 Session_component::~Session_component() {
-	Vlan::vlan()->mac_tree()->remove(&_mac_node);
-	Vlan::vlan()->mac_list()->remove(&_mac_node);
-	_free_ipv4_node();
+	Vlan::vlan()->mac_table()->remove(&_mac_node);
+
+	/* once no handler finds the session, its IPv4 address stays */
+	Vlan::vlan()->wait_for_readers();
+
+	if (_ipv4_nodes.first()) {
+		Vlan::vlan()->ip_table()->remove(_ipv4_nodes.first());
+
+		/* the nodes may still be in use by other sessions' handlers */
+		Vlan::vlan()->wait_for_readers();
+	}
+	_free_ipv4_nodes();
 }
 
 
 void Session_component::set_ipv4_address(Ipv4_packet::Ipv4_address ip_addr)
 {
-	_free_ipv4_node();
-	_ipv4_node = new (this->guarded_allocator())
+	Genode::Lock::Guard lock_guard(_ipv4_lock);
+
+	Ipv4_address_node *old_node = _ipv4_nodes.first();
+	if (old_node && old_node->addr() == ip_addr)
+		return;
+
+	/* the frame being handled started after earlier removals */
+	_free_retired_ipv4_nodes();
+
+	Ipv4_address_node *node = new (this->guarded_allocator())
 		Ipv4_address_node(ip_addr, this);
-	Vlan::vlan()->ip_tree()->insert(_ipv4_node);
+	Vlan::vlan()->ip_table()->insert(node);
+
+	/*
+	 * This function is called while handling a frame, which may refer to
+	 * the old node. Hence, the old node is freed after a grace period.
+	 */
+	if (old_node) {
+		Vlan::vlan()->ip_table()->remove(old_node);
+		_ipv4_retired_epoch = Vlan::vlan()->retire();
+		_ipv4_retired       = true;
+	}
+	_ipv4_nodes.insert(node);
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -104,10 +104,9 @@ namespace Net {
 			{
 				private:
 
-					Packet_descriptor  _tx_packet;
-					Session_component *_component;
+					Packet_batch<Nic::Session::Tx::Sink> _tx_batch;
+					Session_component                   *_component;
 
-					void acknowledge_last_one();
 					void next_packet(void** src, Genode::size_t *size);
 					bool handle_arp(Ethernet_frame *eth, Genode::size_t size);
 					bool handle_ip(Ethernet_frame *eth, Genode::size_t size);
@@ -121,12 +120,17 @@ namespace Net {
 			};
 
 
-			Tx_handler         _tx_handler;
-			Mac_address_node   _mac_node;
-			Ipv4_address_node *_ipv4_node;
-			Genode::Lock       _rx_lock;
+			Tx_handler                      _tx_handler;
+			Mac_address_node                _mac_node;
+			Genode::List<Ipv4_address_node> _ipv4_nodes;  /* current node first */
+			Genode::Lock                    _ipv4_lock;
+			bool volatile                   _ipv4_retired;        /* former nodes exist */
+			unsigned long                   _ipv4_retired_epoch;  /* of latest removal */
+			Genode::Lock                    _rx_lock;
+			unsigned long                   _rx_dropped;  /* guarded by '_rx_lock' */
 
-			void _free_ipv4_node();
+			void _free_ipv4_nodes();
+			void _free_retired_ipv4_nodes();
 
 		public:
 
@@ -139,6 +143,8 @@ namespace Net {
 			 * \param rx_buf_size  buffer size for rx channel
 			 * \param vmac         virtual mac address
 			 * \param ep           entry point used for packet stream
+			 * \param tx_queue_size  number of packet-queue slots for tx channel
+			 * \param rx_queue_size  number of packet-queue slots for rx channel
 			 */
 			Session_component(Genode::Allocator          *allocator,
 			                  Genode::size_t              amount,
@@ -146,7 +152,9 @@ namespace Net {
 			                  Genode::size_t              rx_buf_size,
 			                  Ethernet_frame::Mac_address vmac,
 			                  Nic::Connection            *session,
-			                  Genode::Rpc_entrypoint     &ep);
+			                  Genode::Rpc_entrypoint     &ep,
+			                  unsigned                    tx_queue_size,
+			                  unsigned                    rx_queue_size);
 
 			~Session_component();
 
@@ -154,6 +162,19 @@ namespace Net {
 			Nic::Session::Rx::Source* rx_source() { return _rx.source(); }
 			Genode::Lock*             rx_lock()   { return &_rx_lock;    }
 
+			/**
+			 * Account frame that could not be passed to the client
+			 *
+			 * Must be called with the rx lock held. A warning is printed
+			 * for the first and every 1024th dropped frame.
+			 */
+			void rx_dropped()
+			{
+				if (_rx_dropped++ % 1024 == 0)
+					PWRN("client does not keep up with receiving, %lu frames dropped",
+					     _rx_dropped);
+			}
+
 			Nic::Mac_address mac_address()
 			{
 				Nic::Mac_address m;
@@ -163,6 +184,13 @@ namespace Net {
 			}
 
 			void set_ipv4_address(Ipv4_packet::Ipv4_address ip_addr);
+
+			/**
+			 * Free former IPv4 nodes no reader may refer to anymore
+			 *
+			 * Must not be called by a reader.
+			 */
+			void free_retired_ipv4_nodes();
 	};
 
 
@@ -189,6 +217,12 @@ namespace Net {
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
 				size_t rx_buf_size =
 					Arg_string::find_arg(args, "rx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Nic::Session::TX_QUEUE_SIZE));
+				unsigned rx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "rx_queue_size").ulong_value(Nic::Session::RX_QUEUE_SIZE));
 
 				/* delete ram quota by the memory needed for the session */
 				size_t session_size = max((size_t)4096, sizeof(Session_component));
@@ -208,17 +242,26 @@ namespace Net {
 					throw Root::Quota_exceeded();
 				}
 
+				Ethernet_frame::Mac_address mac;
+				try { mac = _mac_alloc.alloc(); }
+				catch(Mac_allocator::Alloc_failed) {
+					PWRN("Mac address allocation failed!");
+					return (Session_component*) 0;
+				}
+
 				try {
 					return new (md_alloc()) Session_component(env()->heap(),
 					                                          ram_quota - session_size,
 					                                          tx_buf_size,
 					                                          rx_buf_size,
-					                                          _mac_alloc.alloc(),
+					                                          mac,
 					                                          _session,
-					                                          _ep);
-				} catch(Mac_allocator::Alloc_failed) {
-					PWRN("Mac address allocation failed!");
-					return (Session_component*) 0;
+					                                          _ep,
+					                                          tx_queue_size,
+					                                          rx_queue_size);
+				} catch (Root::Quota_exceeded) {
+					_mac_alloc.free(mac);
+					throw;
 				}
 			}
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -32,14 +32,10 @@ void Packet_handler::broadcast_to_clients(Ethernet_frame *eth, Genode::size_t si
 {
 	/* check whether it's really a broadcast packet */
 	if (eth->dst() == Ethernet_frame::BROADCAST) {
-		/* iterate through the list of clients */
-		Mac_address_node *node =
-			Vlan::vlan()->mac_list()->first();
-		while (node) {
-			/* deliver packet */
+		/* iterate through all clients */
+		Mac_address_node *node = Vlan::vlan()->mac_table()->first();
+		for (; node; node = Vlan::Mac_address_table::next(node))
 			node->receive_packet((void*) eth, size);
-			node = node->next();
-		}
 	}
 }
 
@@ -48,12 +44,15 @@ void Packet_handler::send_to_nic(Ethernet_frame *eth, Genode::size_t  size)
 {
 	Genode::Lock::Guard lock_guard(_nic_lock);
 
+	enum { MAX_ACKS = 32 };
+	Packet_descriptor acked[MAX_ACKS];
+
 	while (true) {
 		/* check for acknowledgements */
 		while (_session->tx()->ack_avail()) {
-			Packet_descriptor p =
-				_session->tx()->get_acked_packet();
-			_session->tx()->release_packet(p);
+			unsigned const num = _session->tx()->get_acked_packets(acked, MAX_ACKS);
+			for (unsigned i = 0; i < num; i++)
+				_session->tx()->release_packet(acked[i]);
 		}
 
 		try {
@@ -83,10 +82,12 @@ void Packet_handler::entry()
 
 	/* loop for new packets */
 	while (true) {
-		try {
-			acknowledge_last_one();
-			next_packet(&src, &eth_sz);
+		next_packet(&src, &eth_sz);
+
+		/* the clients found while handling the frame stay valid */
+		Vlan::Reader reader(_reader_state);
 
+		try {
 			/* parse ethernet frame header */
 			Ethernet_frame *eth = new (src) Ethernet_frame(eth_sz);
 			switch (eth->type()) {
@@ -125,18 +126,11 @@ void Packet_handler::entry()
 }
 
 
-void Rx_handler::acknowledge_last_one() {
-	/* acknowledge packet to NIC driver */
-	if(_rx_packet.valid())
-		_session->rx()->acknowledge_packet(_rx_packet);
-}
-
-
 void Rx_handler::next_packet(void** src, Genode::size_t *size) {
 	/* get next packet from NIC driver */
-	_rx_packet = _session->rx()->get_packet();
-	*src       = _session->rx()->packet_content(_rx_packet);
-	*size      = _rx_packet.size();
+	Packet_descriptor rx_packet = _rx_batch.next(_session->rx());
+	*src  = _session->rx()->packet_content(rx_packet);
+	*size = rx_packet.size();
 }
 
 
@@ -149,9 +143,7 @@ bool Rx_handler::handle_arp(Ethernet_frame *eth, Genode::size_t size) {
 		return true;
 
 	/* look whether the IP address is one of our client's */
-	Ipv4_address_node *node = Vlan::vlan()->ip_tree()->first();
-	if (node)
-		node = node->find_by_address(arp->dst_ip());
+	Ipv4_address_node *node = Vlan::vlan()->ip_table()->lookup(arp->dst_ip());
 	if (node) {
 		if (arp->opcode() == Arp_packet::REQUEST) {
 			/*
@@ -205,9 +197,7 @@ bool Rx_handler::handle_ip(Ethernet_frame *eth, Genode::size_t size) {
 					Genode::uint8_t *msg_type =	(Genode::uint8_t*) ext->value();
 					if (*msg_type == Dhcp_packet::DHCP_ACK) {
 						Mac_address_node *node =
-							Vlan::vlan()->mac_tree()->first();
-						if (node)
-							node = node->find_by_address(dhcp->client_mac());
+							Vlan::vlan()->mac_table()->lookup(dhcp->client_mac());
 						if (node)
 							node->component()->set_ipv4_address(dhcp->yiaddr());
 					}
@@ -218,17 +208,14 @@ bool Rx_handler::handle_ip(Ethernet_frame *eth, Genode::size_t size) {
 
 	/* is it an unicast message to one of our clients ? */
 	if (eth->dst() == _mac) {
-		Ipv4_address_node *node = Vlan::vlan()->ip_tree()->first();
+		Ipv4_address_node *node = Vlan::vlan()->ip_table()->lookup(ip->dst());
 		if (node) {
-			node = node->find_by_address(ip->dst());
-			if (node) {
-				/* overwrite destination MAC */
-				eth->dst(node->component()->mac_address().addr);
-
-				/* deliver the packet to the client */
-				node->receive_packet((void*) eth, size);
-				return false;
-			}
+			/* overwrite destination MAC */
+			eth->dst(node->component()->mac_address().addr);
+
+			/* deliver the packet to the client */
+			node->receive_packet((void*) eth, size);
+			return false;
 		}
 	}
 	return true;
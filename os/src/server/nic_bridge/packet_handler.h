@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -21,8 +21,46 @@
 #include <net/ethernet.h>
 #include <net/ipv4.h>
 
+#include "vlan.h"
+
 namespace Net {
 
+	/**
+	 * Packets fetched from a packet-stream sink at once
+	 *
+	 * The packets of a batch are acknowledged together before the next
+	 * batch is fetched.
+	 */
+	template <typename SINK>
+	class Packet_batch
+	{
+		private:
+
+			enum { MAX_PACKETS = 32 };
+
+			Packet_descriptor _packets[MAX_PACKETS];
+			unsigned          _num;
+			unsigned          _pos;
+
+		public:
+
+			Packet_batch() : _num(0), _pos(0) { }
+
+			/**
+			 * Return next packet, block if no packet is available
+			 */
+			Packet_descriptor next(SINK *sink)
+			{
+				if (_pos == _num) {
+					sink->acknowledge_packets(_packets, _num);
+					_num = sink->get_packets(_packets, MAX_PACKETS);
+					_pos = 0;
+				}
+				return _packets[_pos++];
+			}
+	};
+
+
 	/**
 	 * Generic thread-implementation used as base for
 	 * global receiver thread and client's transmit-threads.
@@ -31,7 +69,8 @@ namespace Net {
 	{
 		private:
 
-			Genode::Semaphore _startup_sem;       /* thread startup sync */
+			Genode::Semaphore  _startup_sem;      /* thread startup sync */
+			Vlan::Reader_state _reader_state;     /* epoch of current frame */
 
 		protected:
 
@@ -56,13 +95,10 @@ namespace Net {
 			 */
 			void send_to_nic(Ethernet_frame *eth, Genode::size_t size);
 
-			/**
-			 * Acknowledge the last processed packet.
-			 */
-			virtual void acknowledge_last_one()            = 0;
-
 			/**
 			 * Block for the next packet to process.
+			 *
+			 * The previously processed packets may be acknowledged.
 			 */
 			virtual void next_packet(void** src,
 			                         Genode::size_t *size) = 0;
@@ -97,7 +133,8 @@ namespace Net {
 		public:
 
 			Packet_handler(Nic::Connection *session)
-			: _session(session), _mac(session->mac_address().addr) {}
+			: _reader_state(*Vlan::vlan()), _session(session),
+			  _mac(session->mac_address().addr) {}
 
 			/*
 			 * Thread's entry code.
@@ -118,12 +155,7 @@ namespace Net {
 	{
 		private:
 
-			Packet_descriptor _rx_packet; /* actual processed packet */
-
-			/**
-			 * Acknowledge the last processed packet.
-			 */
-			void acknowledge_last_one();
+			Packet_batch<Nic::Session::Rx::Sink> _rx_batch;
 
 			/**
 			 * Block for the next packet to process.
@@ -5,14 +5,95 @@
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
  */
 
+/* Genode */
+#include <base/lock.h>
+#include <cpu/atomic.h>
+
 #include "vlan.h"
 
+
+Net::Vlan::Reader_state::Reader_state(Vlan &vlan) : _vlan(vlan), _epoch(0)
+{
+	Genode::Lock::Guard lock_guard(_vlan._reader_states_lock);
+	_vlan._reader_states.insert(this);
+}
+
+
+Net::Vlan::Reader_state::~Reader_state()
+{
+	Genode::Lock::Guard lock_guard(_vlan._reader_states_lock);
+	_vlan._reader_states.remove(this);
+}
+
+
+void Net::Vlan::_enter(Reader_state &state)
+{
+	state._epoch = _epoch;
+
+	/* publish the epoch before looking up nodes */
+	__sync_synchronize();
+}
+
+
+void Net::Vlan::_leave(Reader_state &state)
+{
+	/* finish using nodes before becoming quiescent */
+	__sync_synchronize();
+	state._epoch = 0;
+	__sync_synchronize();
+
+	if (_remover_waiting)
+		_quiescent.up();
+}
+
+
+unsigned long Net::Vlan::retire()
+{
+	/* readers that enter after the increment cannot find removed nodes */
+	return __sync_add_and_fetch(&_epoch, 1);
+}
+
+
+bool Net::Vlan::grace_period_elapsed(unsigned long epoch)
+{
+	Genode::Lock::Guard lock_guard(_reader_states_lock);
+
+	for (Reader_state *s = _reader_states.first(); s; s = s->next()) {
+		unsigned long const reader_epoch = s->_epoch;
+		if (reader_epoch && reader_epoch < epoch)
+			return false;
+	}
+	return true;
+}
+
+
+void Net::Vlan::wait_for_readers()
+{
+	/* removers are rare, serialize them */
+	static Genode::Lock lock;
+	Genode::Lock::Guard lock_guard(lock);
+
+	unsigned long const epoch = retire();
+
+	Genode::cmpxchg(&_remover_waiting, 0, 1);
+
+	/*
+	 * A reader that leaves after setting '_remover_waiting' wakes us up.
+	 * Wake-ups of earlier removals merely cause another check.
+	 */
+	while (!grace_period_elapsed(epoch))
+		_quiescent.down();
+
+	Genode::cmpxchg(&_remover_waiting, 1, 0);
+}
+
+
 Net::Vlan* Net::Vlan::vlan()
 {
 	static Net::Vlan vlan;
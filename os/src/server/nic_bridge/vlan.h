@@ -3,11 +3,11 @@
  * \author Stefan Kalkowski
  * \date   2010-08-18
  *
- * A database containing all clients sorted by IP and MAC addresses.
+ * A database containing all clients hashed by IP and MAC addresses.
  */
 
 /*
- * Copyright (C) 2010-2012 Genode Labs GmbH
+ * Copyright (C) 2010-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -16,37 +16,114 @@
 #ifndef _VLAN_H_
 #define _VLAN_H_
 
+/* Genode */
+#include <base/lock.h>
+#include <base/semaphore.h>
+#include <util/list.h>
+
 #include "address_node.h"
-#include "avl_safe.h"
-#include "list_safe.h"
+#include "address_table.h"
 
 namespace Net {
 
 	/*
 	 * The Vlan is a database containing all clients
-	 * sorted by IP and MAC addresses.
+	 * hashed by IP and MAC addresses.
+	 *
+	 * Lookups do not take a lock (see 'Address_table'). Removed nodes are
+	 * reclaimed by epochs: Each packet handler records the epoch of the
+	 * vlan when it starts handling a frame. A node removed in epoch E may
+	 * be freed as soon as no handler is handling a frame started before E.
+	 * Handlers that keep handling frames pick up the new epoch with each
+	 * frame, so removers do not depend on all handlers being idle at once.
 	 */
 	class Vlan
 	{
 		public:
 
-			typedef Avl_tree_safe<Mac_address_node>  Mac_address_tree;
-			typedef Avl_tree_safe<Ipv4_address_node> Ipv4_address_tree;
-			typedef List_safe<Mac_address_node>      Mac_address_list;
+			typedef Address_table<Mac_address_node>  Mac_address_table;
+			typedef Address_table<Ipv4_address_node> Ipv4_address_table;
+
+			/**
+			 * Epoch of a thread that looks up address nodes
+			 */
+			class Reader_state : public Genode::List<Reader_state>::Element
+			{
+				private:
+
+					friend class Vlan;
+
+					Vlan                   &_vlan;
+					unsigned long volatile  _epoch;  /* 0 if not reading */
+
+				public:
+
+					Reader_state(Vlan &vlan);
+					~Reader_state();
+			};
+
+			/**
+			 * Guard for looking up and using address nodes
+			 *
+			 * A node found by a lookup stays valid as long as the
+			 * reader exists.
+			 */
+			class Reader
+			{
+				private:
+
+					Reader_state &_state;
+
+				public:
+
+					Reader(Reader_state &state) : _state(state) {
+						_state._vlan._enter(_state); }
+
+					~Reader() { _state._vlan._leave(_state); }
+			};
 
 		private:
 
-			Mac_address_tree  _mac_tree;
-			Mac_address_list  _mac_list;
-			Ipv4_address_tree _ip_tree;
+			Mac_address_table  _mac_table;
+			Ipv4_address_table _ip_table;
+
+			unsigned long volatile     _epoch;
+			Genode::Lock               _reader_states_lock;
+			Genode::List<Reader_state> _reader_states;
+
+			volatile int      _remover_waiting;
+			Genode::Semaphore _quiescent;    /* woken if a reader leaves */
 
-			Vlan() {}
+			void _enter(Reader_state &state);
+			void _leave(Reader_state &state);
+
+			Vlan() : _epoch(1), _remover_waiting(0) {}
 
 		public:
 
-			Mac_address_tree  *mac_tree() { return &_mac_tree; }
-			Mac_address_list  *mac_list() { return &_mac_list; }
-			Ipv4_address_tree *ip_tree()  { return &_ip_tree;  }
+			Mac_address_table  *mac_table() { return &_mac_table; }
+			Ipv4_address_table *ip_table()  { return &_ip_table;  }
+
+			/**
+			 * Start grace period for nodes removed from a table
+			 *
+			 * \return  epoch to be passed to 'grace_period_elapsed'
+			 */
+			unsigned long retire();
+
+			/**
+			 * Return true if no reader may refer to nodes retired in 'epoch'
+			 */
+			bool grace_period_elapsed(unsigned long epoch);
+
+			/**
+			 * Wait until no reader may refer to removed nodes
+			 *
+			 * This function must be called after removing a node from a
+			 * table and before freeing it. It must not be called by a
+			 * reader.
+			 */
+			void wait_for_readers();
 
 			static Vlan *vlan();
 	};
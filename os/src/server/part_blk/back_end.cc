@@ -17,18 +17,16 @@
 
 using namespace Genode;
 
-/**
- * Used to block until a packet has been freed
- */
-static Semaphore _alloc_sem(0);
-
 namespace Partition {
 
+	enum { MAX_BACKEND_REQUESTS = 128, /* back-end requests in flight */
+	       MAX_BATCH            = 16   /* parts submitted at once */ };
+
 	size_t _blk_cnt;
 	size_t _blk_size;
 
 	Allocator_avl        _block_alloc(env()->heap());
-	Block::Connection    _blk(&_block_alloc, 4 * MAX_PACKET_SIZE);
+	Block::Connection    _blk(&_block_alloc, 8 * MAX_PACKET_SIZE);
 
 	Partition           *_part_list[MAX_PARTITIONS]; /* contains pointers to valid partittions or 0 */
 
@@ -72,56 +70,44 @@ namespace Partition {
 	} __attribute__((packed));
 
 
+	/**
+	 * Synchronous access to the back end, used for parsing the partition table
+	 *
+	 * Sectors must not be used once the acknowledgement thread is started.
+	 */
 	class Sector
 	{
 		private:
 
 			Block::Packet_descriptor _p;
 
-		protected:
-
-			static Lock _lock;
-
 		public:
 
 			Sector(unsigned long blk_nr, unsigned long count, bool write = false)
 			{
-				using namespace Block;
-				Lock::Guard guard(_lock);
 				Block::Packet_descriptor::Opcode op = write ? Block::Packet_descriptor::WRITE
 				                                            : Block::Packet_descriptor::READ;
-					_p = Block::Packet_descriptor(_blk.dma_alloc_packet(_blk_size * count),
-					                              op,  blk_nr, count);
+				_p = Block::Packet_descriptor(_blk.dma_alloc_packet(_blk_size * count),
+				                              op,  blk_nr, count);
 			}
 
 			void submit_request()
 			{
-				Lock::Guard guard(_lock);
 				_blk.tx()->submit_packet(_p);
 				_p = _blk.tx()->get_acked_packet();
 
-				/* unblock clients that possibly wait for packet stream allocations */
-				if (_alloc_sem.cnt() < 0)
-					_alloc_sem.up();
-
 				if (!_p.succeeded()) {
 					PERR("Could not access block %zu", _p.block_number());
 					throw Io_error();
 				}
 			}
 
-			~Sector()
-			{
-				Lock::Guard guard(_lock);
-				_blk.tx()->release_packet(_p);
-			}
+			~Sector() { _blk.tx()->release_packet(_p); }
 
 			template <typename T>
 			T addr() { return reinterpret_cast<T>(_blk.tx()->packet_content(_p)); }
 	};
 
-	Lock Sector::_lock;
-
 
 	void parse_extented(Partition_record *record)
 	{
@@ -179,6 +165,166 @@ namespace Partition {
 	}
 
 
+	/**
+	 * Back-end request in flight
+	 *
+	 * Back-end packets are tagged by their offset within the bulk buffer,
+	 * which is unique as long as the packet is allocated.
+	 */
+	struct Backend_request
+	{
+		Block::Packet_descriptor  packet;
+		Request                  *request;  /* 0 if unused */
+		char                     *buf;      /* part of client buffer */
+
+		Backend_request() : request(0), buf(0) { }
+	};
+
+	static Backend_request _backend_requests[MAX_BACKEND_REQUESTS];
+
+	static Lock      _alloc_lock;          /* bulk buffer and back-end requests */
+	static Lock      _submit_lock;         /* submitters of back-end packets */
+	static Lock      _pending_lock;        /* 'Request::_pending' counters */
+	static Semaphore _alloc_sem(0);        /* used to block until a packet is freed */
+	static unsigned  _num_alloc_waiters;
+
+
+	/**
+	 * Allocate back-end request including its bulk-buffer space
+	 *
+	 * \return  back-end request, or 0 if the back end is saturated. In the
+	 *          latter case, the caller is registered as waiter and must
+	 *          block on '_alloc_sem'.
+	 */
+	static Backend_request *_alloc_backend_request(Request *request, char *buf,
+	                                               unsigned long lba,
+	                                               unsigned long count, bool write)
+	{
+		Lock::Guard guard(_alloc_lock);
+
+		for (unsigned i = 0; i < MAX_BACKEND_REQUESTS; i++) {
+			Backend_request &r = _backend_requests[i];
+			if (r.request)
+				continue;
+
+			try {
+				Block::Packet_descriptor::Opcode op = write ? Block::Packet_descriptor::WRITE
+				                                            : Block::Packet_descriptor::READ;
+				r.packet  = Block::Packet_descriptor(_blk.dma_alloc_packet(_blk_size * count),
+				                                     op, lba, count);
+				r.request = request;
+				r.buf     = buf;
+				return &r;
+			} catch (Block::Session::Tx::Source::Packet_alloc_failed) { break; }
+		}
+
+		_num_alloc_waiters++;
+		return 0;
+	}
+
+
+	static void _release_backend_request(Backend_request *r)
+	{
+		Lock::Guard guard(_alloc_lock);
+
+		_blk.tx()->release_packet(r->packet);
+		r->request = 0;
+
+		/* unblock clients that wait for packet stream allocations */
+		if (_num_alloc_waiters) {
+			_num_alloc_waiters--;
+			_alloc_sem.up();
+		}
+	}
+
+
+	static Backend_request *_lookup_backend_request(Block::Packet_descriptor const &p)
+	{
+		Lock::Guard guard(_alloc_lock);
+
+		for (unsigned i = 0; i < MAX_BACKEND_REQUESTS; i++)
+			if (_backend_requests[i].request
+			 && _backend_requests[i].packet.offset() == p.offset())
+				return &_backend_requests[i];
+
+		return 0;
+	}
+
+
+	static void _submit_backend_packets(Block::Packet_descriptor const *packets,
+	                                    unsigned num)
+	{
+		if (!num)
+			return;
+
+		Lock::Guard guard(_submit_lock);
+		_blk.tx()->submit_packets(packets, num);
+	}
+
+
+	/**
+	 * Account the completion of one part of a client request
+	 */
+	static void _complete_part(Request *request, bool succeeded)
+	{
+		{
+			Lock::Guard guard(_pending_lock);
+
+			if (!succeeded)
+				request->succeeded = false;
+
+			if (--request->_pending)
+				return;
+		}
+
+		request->handler->completed(request);
+	}
+
+
+	/**
+	 * Thread that dispatches acknowledgements of the back-end driver
+	 */
+	class Ack_thread : public Thread<8192>
+	{
+		private:
+
+			void _complete(Block::Packet_descriptor const &packet)
+			{
+				Backend_request *r = _lookup_backend_request(packet);
+				if (!r) {
+					PWRN("spurious acknowledgement of block %zu", packet.block_number());
+					return;
+				}
+
+				Request *request = r->request;
+
+				if (!packet.succeeded())
+					PERR("Could not access block %zu", packet.block_number());
+				else if (packet.operation() == Block::Packet_descriptor::READ)
+					memcpy(r->buf, _blk.tx()->packet_content(packet),
+					       packet.block_count() * _blk_size);
+
+				_release_backend_request(r);
+				_complete_part(request, packet.succeeded());
+			}
+
+		public:
+
+			Ack_thread() : Thread<8192>("part_ack") { }
+
+			void entry()
+			{
+				Block::Packet_descriptor packets[MAX_BATCH];
+
+				for (;;) {
+					unsigned const num = _blk.tx()->get_acked_packets(packets, MAX_BATCH);
+					for (unsigned i = 0; i < num; i++)
+						_complete(packets[i]);
+				}
+			}
+	};
+
+
 	void init()
 	{
 		Block::Session::Operations ops;
@@ -190,36 +336,59 @@ namespace Partition {
 		Sector s(0, 1);
 		s.submit_request();
 		parse_mbr(s.addr<Mbr *>());
+
+		/* from now on, the back end is accessed asynchronously */
+		static Ack_thread ack_thread;
+		ack_thread.start();
 	}
 
 
-	void _io(unsigned long lba, unsigned long count, uint8_t *buf, bool write)
+	void Partition::submit(Request *request)
 	{
-		unsigned long bytes;
+		Block::Packet_descriptor const &p = request->packet;
+
+		if (p.block_number() + p.block_count() > _sectors)
+			throw Io_error();
+
+		bool const    write = p.operation() == Block::Packet_descriptor::WRITE;
+		unsigned long lba   = _lba + p.block_number();
+		unsigned long count = p.block_count();
+		char         *buf   = request->buf;
+
+		/* hold back the completion until all parts are submitted */
+		request->succeeded = true;
+		request->_pending  = 1;
+
+		Block::Packet_descriptor batch[MAX_BATCH];
+		unsigned                 num = 0;
 
 		while (count) {
 
-			unsigned long curr_count = min<unsigned long>(count, max_packets());
-			bytes                    = curr_count * _blk_size;
-			bool alloc = false;
-			while (!alloc) {
-				try {
-					Sector sec(lba, curr_count, write);
-		
-					if (!write) {
-						sec.submit_request();
-						memcpy(buf, sec.addr<void *>(), bytes);
-					}
-					else {
-						memcpy(sec.addr<void *>(), buf, bytes);
-						sec.submit_request();
-					}
-
-					alloc = true;
-				} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
-					/* block */
-					_alloc_sem.down();
-				}
+			unsigned long const curr_count = min<unsigned long>(count, max_packets());
+			size_t        const bytes      = curr_count * _blk_size;
+
+			Backend_request *r = _alloc_backend_request(request, buf, lba,
+			                                            curr_count, write);
+			if (!r) {
+				/* pass on parts that occupy the back end before blocking */
+				_submit_backend_packets(batch, num);
+				num = 0;
+				_alloc_sem.down();
+				continue;
+			}
+
+			if (write)
+				memcpy(_blk.tx()->packet_content(r->packet), buf, bytes);
+
+			{
+				Lock::Guard guard(_pending_lock);
+				request->_pending++;
+			}
+
+			batch[num++] = r->packet;
+			if (num == MAX_BATCH) {
+				_submit_backend_packets(batch, num);
+				num = 0;
 			}
 
 			lba   += curr_count;
@@ -227,18 +396,7 @@ namespace Partition {
 			buf   += bytes;
 		}
 
-		/* zero out rest of page */
-		bytes = (count * _blk_size) % 4096;
-		if (bytes)
-			memset(buf, 0, bytes);
-	}
-
-
-	void Partition::io(unsigned long block_nr, unsigned long count, void *buf, bool write)
-	{
-		if (block_nr + count > _sectors)
-			throw Io_error();
-
-		_io(_lba + block_nr, count, (uint8_t *)buf, write);
+		_submit_backend_packets(batch, num);
+		_complete_part(request, true);
 	}
 }
@@ -11,6 +11,7 @@
  * under the terms of the GNU General Public License version 2.
  */
 
+#include <base/semaphore.h>
 #include <base/sleep.h>
 #include <block_session/rpc_object.h>
 #include <cap_session/connection.h>
@@ -46,10 +47,20 @@ namespace Block {
 	}
 
 
-	class Session_component : public Session_rpc_object
+	class Session_component : public Session_rpc_object,
+	                          public Partition::Completion_handler
 	{
 		private:
 
+			enum { MAX_REQUESTS = 32 }; /* requests in flight per client */
+
+			/**
+			 * Thread that passes client packets to the back end and
+			 * acknowledges completed requests
+			 *
+			 * The thread never blocks on the client. It gets woken up by
+			 * signals of the client and by completions of the back end.
+			 */
 			class Tx_thread : public Genode::Thread<8192>
 			{
 				private:
@@ -61,74 +72,189 @@ namespace Block {
 					Tx_thread(Session_component *session)
 					: _session(session) { }
 
-					void entry()
+					void entry() { _session->_process(); }
+			};
+
+			struct Partition::Partition  *_partition; /* partition belonging to this session */
+			Genode::Dataspace_capability  _tx_ds;     /* buffer for tx channel */
+
+			Genode::Signal_receiver       _sig_rec;
+			Genode::Signal_context        _client_ctx;
+			Genode::Signal_context        _completed_ctx;
+			Genode::Signal_context        _stop_ctx;
+			Genode::Signal_transmitter    _completed_transmitter;
+
+			Partition::Request            _requests[MAX_REQUESTS];
+			Partition::Request           *_free[MAX_REQUESTS];
+			unsigned                      _num_free;
+
+			/* requests completed by the back end, not yet acknowledged */
+			Genode::Lock                  _completed_lock;
+			Partition::Request           *_completed[MAX_REQUESTS];
+			unsigned                      _num_completed;
+
+			/*
+			 * Requests taken from the client but not completed yet,
+			 * protected by '_completed_lock'
+			 */
+			unsigned                      _num_in_flight;
+			bool                          _draining;
+			Genode::Semaphore             _drained;
+
+			Tx_thread                     _tx_thread;
+
+			void _acknowledge_completed()
+			{
+				Tx::Sink *sink = tx_sink();
+
+				/* never block on a client that does not pick up its acks */
+				while (sink->ready_to_ack()) {
+
+					Partition::Request *r;
 					{
-						using namespace Genode;
+						Genode::Lock::Guard guard(_completed_lock);
 
-						Session_component::Tx::Sink *tx_sink = _session->tx_sink();
-						Block::Packet_descriptor packet;
+						if (!_num_completed)
+							return;
 
-						/* handle requests */
-						while (true) {
+						r = _completed[--_num_completed];
+					}
 
-							/* blocking get packet from client */
-							packet = tx_sink->get_packet();
-							if (!packet.valid()) {
-								PWRN("received invalid packet");
-								continue;
-							}
+					r->packet.succeeded(r->succeeded);
+					sink->acknowledge_packet(r->packet);
+					_free[_num_free++] = r;
+				}
+			}
 
-							packet.succeeded(false);
-							bool write = false;
+			void _submit_requests()
+			{
+				Tx::Sink *sink = tx_sink();
+
+				while (_num_free && sink->packet_avail()) {
 
-							switch (packet.operation()) {
+					Block::Packet_descriptor packets[MAX_REQUESTS];
+					unsigned const num = sink->get_packets(packets, _num_free);
 
-							case Block::Packet_descriptor::WRITE:
-								write  = true;
+					for (unsigned i = 0; i < num; i++) {
+
+						Partition::Request *r = _free[--_num_free];
+						{
+							Genode::Lock::Guard guard(_completed_lock);
+							_num_in_flight++;
+						}
 
-							case Block::Packet_descriptor::READ:
+						r->packet    = packets[i];
+						r->buf       = sink->packet_content(packets[i]);
+						r->handler   = this;
+						r->succeeded = false;
 
-								try {
-									_session->partition()->io(packet.block_number(),
-									                          packet.block_count(),
-									                          tx_sink->packet_content(packet),
-									                          write);
-									packet.succeeded(true);
-								}
-								catch (Partition::Io_error) {
-									PWRN("Io error!");
-								}
-								break;
+						switch (packets[i].operation()) {
 
-							default:
-								PWRN("received invalid packet");
+						case Block::Packet_descriptor::READ:
+						case Block::Packet_descriptor::WRITE:
+
+							try {
+								_partition->submit(r);
 								continue;
 							}
+							catch (Partition::Io_error) {
+								PWRN("Io error!");
+							}
+							break;
 
-							/* acknowledge packet to the client */
-							if (!tx_sink->ready_to_ack())
-								PDBG("need to wait until ready-for-ack");
-							tx_sink->acknowledge_packet(packet);
+						default:
+							PWRN("received invalid packet");
 						}
+
+						/* acknowledge failed request */
+						completed(r);
 					}
-			};
+				}
+			}
 
-			struct Partition::Partition  *_partition; /* partition belonging to this session */
-			Genode::Dataspace_capability  _tx_ds;     /* buffer for tx channel */
-			Tx_thread                     _tx_thread;
+			void _process()
+			{
+				for (;;) {
+					Genode::Signal s = _sig_rec.wait_for_signal();
+
+					/* session is about to be destructed */
+					if (s.context() == &_stop_ctx)
+						return;
+
+					_acknowledge_completed();
+					_submit_requests();
+				}
+			}
 
 		public:
 
 			Session_component(Genode::Dataspace_capability tx_ds,
 			                  Partition::Partition        *partition,
-			                  Genode::Rpc_entrypoint      &ep)
+			                  Genode::Rpc_entrypoint      &ep,
+			                  unsigned                     tx_queue_size)
 			:
-				Session_rpc_object(tx_ds, ep),
-				_partition(partition), _tx_ds(tx_ds), _tx_thread(this)
+				Session_rpc_object(tx_ds, ep, tx_queue_size),
+				_partition(partition), _tx_ds(tx_ds),
+				_completed_transmitter(_sig_rec.manage(&_completed_ctx)),
+				_num_free(0), _num_completed(0), _num_in_flight(0),
+				_draining(false), _tx_thread(this)
 			{
+				for (; _num_free < MAX_REQUESTS; _num_free++)
+					_free[_num_free] = &_requests[_num_free];
+
+				Genode::Signal_context_capability client_sigh =
+					_sig_rec.manage(&_client_ctx);
+				_tx.sigh_packet_avail(client_sigh);
+				_tx.sigh_ready_to_ack(client_sigh);
+
 				_tx_thread.start();
 			}
 
+			~Session_component()
+			{
+				/* stop passing client packets to the back end */
+				Genode::Signal_transmitter(_sig_rec.manage(&_stop_ctx)).submit();
+				_tx_thread.join();
+
+				/*
+				 * The back end refers to the requests still in flight and
+				 * calls 'completed' for each of them. Wait until the last
+				 * one is completed before the members are destructed.
+				 */
+				bool wait;
+				{
+					Genode::Lock::Guard guard(_completed_lock);
+					_draining = true;
+					wait      = _num_in_flight > 0;
+				}
+				if (wait)
+					_drained.down();
+			}
+
+			/**
+			 * Completion_handler interface
+			 */
+			void completed(Partition::Request *request)
+			{
+				{
+					Genode::Lock::Guard guard(_completed_lock);
+					_completed[_num_completed++] = request;
+				}
+				_completed_transmitter.submit();
+
+				/*
+				 * Account the completion last because the session may be
+				 * destructed as soon as the last request is completed.
+				 */
+				bool drained;
+				{
+					Genode::Lock::Guard guard(_completed_lock);
+					drained = !--_num_in_flight && _draining;
+				}
+				if (drained)
+					_drained.up();
+			}
+
 			void info(Genode::size_t *blk_count, Genode::size_t *blk_size, Operations *ops)
 			{
 				*blk_count = _partition->_sectors;
@@ -165,6 +291,9 @@ namespace Block {
 					Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 				Genode::size_t tx_buf_size =
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
 
 				/* delete ram quota by the memory needed for the session */
 				Genode::size_t session_size = max((Genode::size_t)4096,
@@ -203,7 +332,8 @@ namespace Block {
 
 				return new (md_alloc())
 				       Session_component(env()->ram_session()->alloc(tx_buf_size),
-				                         Partition::partition(num), _ep);
+				                         Partition::partition(num), _ep,
+				                         tx_queue_size);
 			}
 
 		public:
@@ -16,12 +16,49 @@
 
 #include <base/exception.h>
 #include <base/stdint.h>
+#include <block_session/block_session.h>
 
 namespace Partition {
 
 	enum { MAX_PARTITIONS  = 32,      /* maximum supported paritions */
 	       MAX_PACKET_SIZE = 128*1024 /* see: '<block/connection.h>' */ };
 
+	struct Request;
+
+	/**
+	 * Interface for getting notified about completed requests
+	 */
+	struct Completion_handler
+	{
+		virtual ~Completion_handler() { }
+
+		/**
+		 * Called when all blocks of the request are processed
+		 *
+		 * The function is executed by the acknowledgement thread of the back
+		 * end, or by the submitter if the last part of the request is
+		 * acknowledged before 'submit' returns. It must not block.
+		 */
+		virtual void completed(Request *request) = 0;
+	};
+
+	/**
+	 * Client request
+	 *
+	 * A request may be split into multiple back-end requests. It is completed
+	 * when all of them are acknowledged by the back-end driver.
+	 */
+	struct Request
+	{
+		Block::Packet_descriptor  packet;    /* packet of the client */
+		char                     *buf;       /* content of client packet */
+		Completion_handler       *handler;
+		bool                      succeeded;
+		unsigned                  _pending;  /* back-end requests in flight */
+
+		Request() : buf(0), handler(0), succeeded(false), _pending(0) { }
+	};
+
 	/**
 	 * The partition type
 	 */
@@ -34,16 +71,16 @@ namespace Partition {
 		: _lba(lba), _sectors(sectors) { }
 
 		/**
-		 * Write/read blocks
+		 * Submit read/write request to the back end
+		 *
+		 * The function returns as soon as all parts of the request are
+		 * submitted to the back-end driver. The completion is reported to
+		 * the completion handler of the request. The blocks to access are
+		 * denoted by the client packet, which refers to 'request.buf'.
 		 *
-		 * \param block_nr block number of partition to access
-		 * \param count    number of blocks to read/write
-		 * \param buf      buffer which containing the data to write or which is
-		 *                 filled by reads
-		 * \param write    true for a write operations, false for a read
-		 * \throw Io_error
+		 * \throw Io_error  request exceeds the partition
 		 */
-		void io(unsigned long block_nr, unsigned long count, void *buf, bool write = false);
+		void submit(Request *request);
 	};
 
 	/**
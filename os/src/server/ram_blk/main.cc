@@ -0,0 +1,260 @@
+/*
+ * \brief  Block device backed by RAM
+ * \author Genode Labs
+ * \date   2013-02-20
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <base/semaphore.h>
+#include <block/component.h>
+#include <cap_session/connection.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+using namespace Genode;
+
+
+/**
+ * Driver that serves requests from a RAM dataspace
+ *
+ * With a latency configured, the driver operates asynchronously. Each
+ * request is executed immediately but its completion is reported not
+ * before the latency has passed. This way, the driver behaves like a
+ * device that processes up to 'max_outstanding' requests in parallel.
+ */
+class Ram_driver : public Block::Driver
+{
+	private:
+
+		enum { MAX_OUTSTANDING = 64 };
+
+		/**
+		 * Thread that reports completions once their latency has passed
+		 */
+		class Delay_thread : public Thread<8192>
+		{
+			private:
+
+				struct Entry
+				{
+					unsigned long tag;
+					bool          success;
+					unsigned long due_ms;
+				};
+
+				Ram_driver       &_driver;
+				Timer::Connection _timer;  /* for sleeping of the delay thread */
+				Entry             _entries[MAX_OUTSTANDING + 1];
+				unsigned          _head, _tail;
+				Lock              _lock;
+				Semaphore         _sem;  /* number of entries */
+
+			public:
+
+				Delay_thread(Ram_driver &driver)
+				:
+					Thread<8192>("delay"), _driver(driver),
+					_head(0), _tail(0)
+				{ }
+
+				/**
+				 * Schedule completion
+				 *
+				 * The number of pending entries is bounded by
+				 * 'MAX_OUTSTANDING' because the session never exceeds
+				 * 'max_outstanding' requests in flight.
+				 */
+				void add(unsigned long tag, bool success)
+				{
+					{
+						Lock::Guard guard(_lock);
+
+						Entry &e = _entries[_head];
+						e.tag     = tag;
+						e.success = success;
+						e.due_ms  = _driver._timer->elapsed_ms() + _driver._latency_ms;
+						_head = (_head + 1) % (MAX_OUTSTANDING + 1);
+					}
+					_sem.up();
+				}
+
+				void entry()
+				{
+					for (;;) {
+						_sem.down();
+
+						/* all entries have the same latency, so they are due in order */
+						Entry e = _entries[_tail];
+
+						/*
+						 * The deadlines are stamped by the timer of the
+						 * driver, so the time must be read from the same
+						 * session. The timer of the thread just sleeps.
+						 */
+						unsigned long const now = _driver._timer->elapsed_ms();
+						if (e.due_ms > now)
+							_timer.msleep(e.due_ms - now);
+
+						{
+							Lock::Guard guard(_lock);
+							_tail = (_tail + 1) % (MAX_OUTSTANDING + 1);
+						}
+
+						/*
+						 * The session unregisters its handler not before all
+						 * of its requests are completed.
+						 */
+						Block::Driver::Completion *completion = _driver._completion;
+						if (completion)
+							completion->completed(e.tag, e.success);
+					}
+				}
+		};
+
+		char                      *_base;
+		size_t                     _block_size;
+		size_t                     _block_count;
+		unsigned                   _latency_ms;
+		unsigned                   _max_outstanding;
+		Timer::Connection         *_timer;         /* only with latency */
+		Block::Driver::Completion *_completion;
+		Delay_thread              *_delay_thread;  /* only if asynchronous */
+
+		void _check_range(size_t block_number, size_t count)
+		{
+			if (block_number + count > _block_count || block_number + count < block_number) {
+				PWRN("requested blocks %zd-%zd out of range!",
+				     block_number, block_number + count);
+				throw Io_error();
+			}
+		}
+
+	public:
+
+		Ram_driver(char *base, size_t block_size, size_t block_count,
+		           unsigned latency_ms, unsigned max_outstanding)
+		:
+			_base(base), _block_size(block_size), _block_count(block_count),
+			_latency_ms(latency_ms),
+			_max_outstanding(latency_ms ? min<unsigned>(max_outstanding, MAX_OUTSTANDING) : 0),
+			_timer(0), _completion(0), _delay_thread(0)
+		{
+			if (_latency_ms)
+				_timer = new (env()->heap()) Timer::Connection();
+
+			if (_max_outstanding) {
+				_delay_thread = new (env()->heap()) Delay_thread(*this);
+				_delay_thread->start();
+			}
+		}
+
+		size_t block_size()  { return _block_size; }
+		size_t block_count() { return _block_count; }
+		bool   dma_enabled() { return false; }
+
+		void read(size_t block_number, size_t block_count, char *out_buffer)
+		{
+			_check_range(block_number, block_count);
+			memcpy(out_buffer, _base + block_number*_block_size, block_count*_block_size);
+
+			if (_latency_ms)
+				_timer->msleep(_latency_ms);
+		}
+
+		void write(size_t block_number, size_t block_count, char const *buffer)
+		{
+			_check_range(block_number, block_count);
+			memcpy(_base + block_number*_block_size, buffer, block_count*_block_size);
+
+			if (_latency_ms)
+				_timer->msleep(_latency_ms);
+		}
+
+		void read_dma(size_t, size_t, addr_t)  { throw Io_error(); }
+		void write_dma(size_t, size_t, addr_t) { throw Io_error(); }
+
+		unsigned max_outstanding() { return _max_outstanding; }
+
+		void completion_handler(Completion *completion) {
+			_completion = completion; }
+
+		void submit(Block::Packet_descriptor::Opcode op,
+		            size_t block_number, size_t block_count,
+		            char *buffer, addr_t, unsigned long tag)
+		{
+			_check_range(block_number, block_count);
+
+			size_t const bytes = block_count*_block_size;
+			if (op == Block::Packet_descriptor::READ)
+				memcpy(buffer, _base + block_number*_block_size, bytes);
+			else
+				memcpy(_base + block_number*_block_size, buffer, bytes);
+
+			_delay_thread->add(tag, true);
+		}
+};
+
+
+int main(int argc, char **argv)
+{
+	printf("--- RAM block device started ---\n");
+
+	Number_of_bytes size       = 16*1024*1024;
+	size_t          block_size = 512;
+	unsigned        latency_ms = 0;
+	unsigned        queue_depth = 16;
+
+	try { config()->xml_node().attribute("size").value(&size);                 } catch (...) { }
+	try { config()->xml_node().attribute("block_size").value(&block_size);     } catch (...) { }
+	try { config()->xml_node().attribute("latency_ms").value(&latency_ms);     } catch (...) { }
+	try { config()->xml_node().attribute("queue_depth").value(&queue_depth);   } catch (...) { }
+
+	if (!block_size || size < block_size) {
+		PERR("invalid geometry, size %zu, block size %zu", (size_t)size, block_size);
+		return -1;
+	}
+
+	/* the content of the device survives sessions */
+	static char *base = env()->rm_session()->attach(env()->ram_session()->alloc(size));
+
+	printf("%zu blocks of %zu bytes, latency %u ms\n",
+	       size / block_size, block_size, latency_ms);
+
+	static Ram_driver driver(base, block_size, size / block_size, latency_ms,
+	                         queue_depth);
+
+	struct Ram_driver_factory : Block::Driver_factory
+	{
+		Ram_driver &driver;
+
+		Ram_driver_factory(Ram_driver &driver) : driver(driver) { }
+
+		Block::Driver *create() { return &driver; }
+
+		/**
+		 * The driver and its delay thread outlive the sessions
+		 */
+		void destroy(Block::Driver *) { }
+
+	} driver_factory(driver);
+
+	enum { STACK_SIZE = 8192 };
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "ram_blk_ep");
+
+	static Block::Root block_root(&ep, env()->heap(), driver_factory,
+	                              Block::Request_scheduler::policy_from_config());
+	env()->parent()->announce(ep.manage(&block_root));
+
+	sleep_forever();
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET   = ram_blk
+SRC_CC   = main.cc
+LIBS     = cxx env server signal
@@ -7,6 +7,9 @@
 #ifndef _DIRECTORY_H_
 #define _DIRECTORY_H_
 
+/* Genode includes */
+#include <base/env.h>
+
 /* local includes */
 #include <node.h>
 #include <util.h>
@@ -15,25 +18,121 @@
 
 namespace File_system {
 
+	/**
+	 * Directory node
+	 *
+	 * The entries are indexed by a hash table of their names, which grows
+	 * with the number of entries. Reading the entries in order is served
+	 * by a cursor that remembers the entry read last.
+	 */
 	class Directory : public Node
 	{
 		private:
 
-			List<Node> _entries;
-			size_t     _num_entries;
+			enum { MIN_BUCKETS = 16 };
+
+			List<Node>  _entries;
+			size_t      _num_entries;
+
+			Node      **_buckets;
+			size_t      _num_buckets;    /* power of two */
+
+			Node       *_cursor;         /* entry read last, or 0 */
+			seek_off_t  _cursor_index;
+
+			/**
+			 * Counter of removed entries of all directories
+			 */
+			static unsigned long &_generation()
+			{
+				static unsigned long inst;
+				return inst;
+			}
+
+			void _free_buckets()
+			{
+				if (_buckets)
+					env()->heap()->free(_buckets, _num_buckets*sizeof(Node *));
+			}
+
+			Node **_bucket(unsigned long hash) {
+				return &_buckets[hash & (_num_buckets - 1)]; }
+
+			void _index(Node *node)
+			{
+				Node **bucket = _bucket(node->_name_hash);
+				node->_dir_next = *bucket;
+				*bucket = node;
+			}
+
+			/**
+			 * Resize hash table and index all entries
+			 *
+			 * \return  false if no memory is available, in which case the
+			 *          table keeps its size
+			 */
+			bool _resize(size_t num_buckets)
+			{
+				Node **buckets = 0;
+				if (!env()->heap()->alloc(num_buckets*sizeof(Node *), &buckets))
+					return false;
+
+				_free_buckets();
+
+				_buckets     = buckets;
+				_num_buckets = num_buckets;
+
+				for (size_t i = 0; i < _num_buckets; i++)
+					_buckets[i] = 0;
+
+				for (Node *n = _entries.first(); n; n = n->next())
+					_index(n);
+
+				return true;
+			}
+
+			/**
+			 * Return entry with the first 'len' characters of 'name'
+			 */
+			Node *_lookup(char const *name, size_t len) const
+			{
+				unsigned long const hash = name_hash(name, len);
+
+				/* without a table, all entries are searched */
+				Node *n = _num_buckets ? _buckets[hash & (_num_buckets - 1)]
+				                       : _entries.first();
+
+				for (; n; n = _num_buckets ? n->_dir_next : n->next())
+					if (n->_name_hash == hash && strlen(n->name()) == len
+					 && strcmp(n->name(), name, len) == 0)
+						return n;
+
+				return 0;
+			}
 
 		public:
 
-			Directory(char const *name) : _num_entries(0) { Node::name(name); }
+			Directory(char const *name)
+			:
+				_num_entries(0), _buckets(0), _num_buckets(0), _cursor(0),
+				_cursor_index(0)
+			{
+				Node::name(name);
+			}
+
+			~Directory() { _free_buckets(); }
+
+			/**
+			 * Return number of entries removed from any directory
+			 *
+			 * A node found by a path lookup is valid as long as the
+			 * generation is unchanged.
+			 */
+			static unsigned long generation() { return _generation(); }
 
 			bool has_sub_node_unsynchronized(char const *name) const
 			{
-				Node *sub_node = _entries.first();
-				for (; sub_node; sub_node = sub_node->next())
-					if (strcmp(sub_node->name(), name) == 0)
-						return true;
-
-				return false;
+				return _lookup(name, strlen(name)) != 0;
 			}
 
 			void adopt_unsynchronized(Node *node)
@@ -43,12 +142,29 @@ namespace File_system {
 				 */
 				_entries.insert(node);
 				_num_entries++;
+				_cursor = 0;
+
+				if (_num_entries > _num_buckets
+				 && _resize(max((size_t)MIN_BUCKETS, 2*_num_buckets)))
+					return;
+
+				if (_num_buckets)
+					_index(node);
 			}
 
 			void discard_unsynchronized(Node *node)
 			{
+				if (_num_buckets) {
+					Node **n = _bucket(node->_name_hash);
+					for (; *n && *n != node; n = &(*n)->_dir_next);
+					if (*n)
+						*n = node->_dir_next;
+				}
+
 				_entries.remove(node);
 				_num_entries--;
+				_cursor = 0;
+				_generation()++;
 			}
 
 			Node *lookup_and_lock(char const *path, bool return_parent = false)
@@ -81,12 +197,7 @@ namespace File_system {
 				 */
 
 				/* try to find entry that matches the first path element */
-				Node *sub_node = _entries.first();
-				for (; sub_node; sub_node = sub_node->next())
-					if ((strlen(sub_node->name()) == i) &&
-						(strcmp(sub_node->name(), path, i) == 0))
-						break;
-
+				Node *sub_node = _lookup(path, i);
 				if (!sub_node)
 					throw Lookup_failed();
 
@@ -178,14 +289,24 @@ namespace File_system {
 					return 0;
 				}
 
-				/* find list element */
-				Node *node = _entries.first();
-				for (unsigned i = 0; i < index && node; node = node->next(), i++);
+				/* entries are usually read in order, continue at the cursor */
+				Node *node = 0;
+				if (_cursor && index == _cursor_index)
+					node = _cursor;
+				else if (_cursor && index == _cursor_index + 1)
+					node = _cursor->next();
+				else {
+					node = _entries.first();
+					for (unsigned i = 0; i < index && node; node = node->next(), i++);
+				}
 
 				/* index out of range */
 				if (!node)
 					return 0;
 
+				_cursor       = node;
+				_cursor_index = index;
+
 				Directory_entry *e = (Directory_entry *)(dst);
 
 				if (dynamic_cast<File      *>(node)) e->type = Directory_entry::TYPE_FILE;
@@ -0,0 +1,389 @@
+/*
+ * \brief  Extent-based storage of file content
+ * \author Genode Labs
+ * \date   2013-03-09
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _EXTENT_H_
+#define _EXTENT_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/env.h>
+#include <file_system_session/file_system_session.h>
+#include <util/string.h>
+
+namespace File_system {
+
+	/**
+	 * File content as sorted array of non-overlapping extents
+	 *
+	 * Each extent is a contiguous buffer that stores a range of the file.
+	 * Ranges not covered by any extent are holes. An extent holds valid data
+	 * from its start up to its used size, the remainder reads as zeros.
+	 * Hence, neither holes nor the unused part of an extent must be zeroed
+	 * in advance. Only a write beyond the used size of an extent zeroes the
+	 * gap between the used size and the written range.
+	 *
+	 * A file that is written sequentially gets extents of doubling size.
+	 * Large extents are backed by dedicated RAM dataspaces, small extents
+	 * are allocated from the heap.
+	 *
+	 * For handing out the content as dataspace, the content is moved into
+	 * one extent at offset 0. This extent is pinned, i.e., it is entirely
+	 * valid and stays in place until the map is destructed.
+	 */
+	class Extent_map
+	{
+		public:
+
+			enum {
+				MIN_EXTENT_SIZE = 4096,
+				MAX_EXTENT_SIZE = 8*1024*1024,
+
+				/* extents of at least this size are dataspaces of their own */
+				DATASPACE_THRESHOLD = 64*1024,
+			};
+
+		private:
+
+			struct Extent
+			{
+				seek_off_t                       offset;
+				size_t                           size;  /* capacity */
+				size_t                           used;
+				char                            *data;
+				Genode::Ram_dataspace_capability ds;    /* invalid for heap extents */
+				bool                             pinned;
+
+				seek_off_t end() const { return offset + size; }
+			};
+
+			Allocator &_alloc;        /* meta data and small extents */
+			Extent    *_extents;
+			unsigned   _num_extents;
+			unsigned   _max_extents;
+
+			/**
+			 * Return index of the first extent that ends after 'offset'
+			 *
+			 * If no such extent exists, the number of extents is returned.
+			 */
+			unsigned _find(seek_off_t offset) const
+			{
+				unsigned lo = 0, hi = _num_extents;
+				while (lo < hi) {
+					unsigned const mid = (lo + hi) / 2;
+					if (_extents[mid].end() <= offset)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				return lo;
+			}
+
+			bool _grow_array()
+			{
+				unsigned const max_extents = _max_extents ? 2*_max_extents : 4;
+
+				Extent *extents = 0;
+				if (!_alloc.alloc(max_extents*sizeof(Extent), &extents))
+					return false;
+
+				if (_extents) {
+					memcpy(extents, _extents, _num_extents*sizeof(Extent));
+					_alloc.free(_extents, _max_extents*sizeof(Extent));
+				}
+
+				_extents     = extents;
+				_max_extents = max_extents;
+				return true;
+			}
+
+			static bool _alloc_data(Allocator &alloc, Extent &e, bool dataspace = false)
+			{
+				using namespace Genode;
+
+				if (e.size < DATASPACE_THRESHOLD && !dataspace)
+					return alloc.alloc(e.size, &e.data);
+
+				try {
+					e.ds = env()->ram_session()->alloc(e.size);
+				} catch (...) { return false; }
+
+				try {
+					e.data = env()->rm_session()->attach(e.ds);
+				} catch (...) {
+					env()->ram_session()->free(e.ds);
+					return false;
+				}
+				return true;
+			}
+
+			static void _free_data(Allocator &alloc, Extent &e)
+			{
+				using namespace Genode;
+
+				if (!e.ds.valid()) {
+					alloc.free(e.data, e.size);
+					return;
+				}
+
+				env()->rm_session()->detach(e.data);
+				env()->ram_session()->free(e.ds);
+			}
+
+			/**
+			 * Size of a new extent at 'offset' for a write of 'len' bytes
+			 *
+			 * \param i  index of the extent following the hole at 'offset'
+			 */
+			size_t _new_extent_size(seek_off_t offset, size_t len, unsigned i) const
+			{
+				size_t size = MIN_EXTENT_SIZE;
+
+				/* continue a sequentially written file with a larger extent */
+				if (i > 0 && _extents[i - 1].end() == offset)
+					size = min(2*_extents[i - 1].size, (size_t)MAX_EXTENT_SIZE);
+
+				/* cover the whole write, round up to page granularity */
+				if (len > size)
+					size = min(align_addr(len, 12), (size_t)MAX_EXTENT_SIZE);
+
+				/* do not overlap the next extent */
+				if (i < _num_extents && _extents[i].offset - offset < size)
+					size = _extents[i].offset - offset;
+
+				return size;
+			}
+
+			/**
+			 * Insert new extent at 'offset' before the extent at index 'i'
+			 *
+			 * \return  false if out of memory
+			 */
+			bool _insert(unsigned i, seek_off_t offset, size_t size)
+			{
+				if (_num_extents == _max_extents && !_grow_array())
+					return false;
+
+				Extent e;
+				e.offset = offset;
+				e.size   = size;
+				e.used   = 0;
+				e.data   = 0;
+				e.ds     = Genode::Ram_dataspace_capability();
+				e.pinned = false;
+
+				if (!_alloc_data(_alloc, e))
+					return false;
+
+				memmove(&_extents[i + 1], &_extents[i],
+				        (_num_extents - i)*sizeof(Extent));
+				_extents[i] = e;
+				_num_extents++;
+				return true;
+			}
+
+		public:
+
+			/**
+			 * Properties of an extent, used for inspecting the map
+			 */
+			struct Extent_info
+			{
+				seek_off_t offset;
+				size_t     size;
+				size_t     used;
+				bool       dataspace;  /* false if allocated from the heap */
+			};
+
+			Extent_map(Allocator &alloc)
+			: _alloc(alloc), _extents(0), _num_extents(0), _max_extents(0) { }
+
+			~Extent_map()
+			{
+				for (unsigned i = 0; i < _num_extents; i++)
+					_free_data(_alloc, _extents[i]);
+
+				if (_extents)
+					_alloc.free(_extents, _max_extents*sizeof(Extent));
+			}
+
+			unsigned num_extents() const { return _num_extents; }
+
+			Extent_info extent_info(unsigned i) const
+			{
+				Extent const &e = _extents[i];
+				Extent_info info = { e.offset, e.size, e.used, e.ds.valid() };
+				return info;
+			}
+
+			/**
+			 * Read 'len' bytes at 'offset', holes read as zeros
+			 */
+			void read(char *dst, size_t len, seek_off_t offset) const
+			{
+				while (len) {
+
+					unsigned const i = _find(offset);
+
+					/* hole up to the next extent or to the end of the file */
+					if (i == _num_extents || _extents[i].offset > offset) {
+						size_t n = len;
+						if (i < _num_extents && _extents[i].offset - offset < n)
+							n = _extents[i].offset - offset;
+
+						memset(dst, 0, n);
+						dst += n; offset += n; len -= n;
+						continue;
+					}
+
+					Extent const &e = _extents[i];
+					size_t const  o = offset - e.offset;
+					size_t const  n = min(len, e.size - o);
+
+					/* copy valid part, zero-pad the unused part */
+					size_t const valid = e.used > o ? min(n, e.used - o) : 0;
+					memcpy(dst, e.data + o, valid);
+					memset(dst + valid, 0, n - valid);
+
+					dst += n; offset += n; len -= n;
+				}
+			}
+
+			/**
+			 * Write 'len' bytes at 'offset'
+			 *
+			 * \return  number of bytes written, which is lower than 'len'
+			 *          if the extents could not be allocated
+			 */
+			size_t write(char const *src, size_t len, seek_off_t offset)
+			{
+				size_t written = 0;
+
+				while (written < len) {
+
+					size_t const remaining = len - written;
+					unsigned const i = _find(offset);
+
+					/* allocate extent for a write into a hole */
+					if (i == _num_extents || _extents[i].offset > offset)
+						if (!_insert(i, offset, _new_extent_size(offset, remaining, i)))
+							return written;
+
+					Extent &e = _extents[i];
+					size_t const o = offset - e.offset;
+					size_t const n = min(remaining, e.size - o);
+
+					if (o > e.used)
+						memset(e.data + e.used, 0, o - e.used);
+
+					memcpy(e.data + o, src, n);
+					e.used = max(e.used, o + n);
+
+					src += n; offset += n; written += n;
+				}
+				return written;
+			}
+
+			/**
+			 * Discard content beyond 'size'
+			 */
+			void truncate(file_size_t size)
+			{
+				while (_num_extents && _extents[_num_extents - 1].offset >= size
+				    && !_extents[_num_extents - 1].pinned)
+					_free_data(_alloc, _extents[--_num_extents]);
+
+				if (!_num_extents)
+					return;
+
+				Extent &e = _extents[_num_extents - 1];
+
+				if (!e.pinned) {
+					e.used = min(e.used, (size_t)min((file_size_t)e.size, size - e.offset));
+					return;
+				}
+
+				/* a pinned extent stays valid, so clear the discarded content */
+				if (size < e.end()) {
+					size_t const o = size > e.offset ? size - e.offset : 0;
+					memset(e.data + o, 0, e.size - o);
+				}
+			}
+
+			/**
+			 * Return dataspace that holds the content from offset 0 on
+			 *
+			 * \param size  number of bytes that must be covered, the caller
+			 *              limits it to the file length
+			 *
+			 * \return  invalid capability if the content cannot be moved
+			 *          into one dataspace
+			 */
+			Genode::Ram_dataspace_capability dataspace(file_size_t size)
+			{
+				using namespace Genode;
+
+				size = max((size + MIN_EXTENT_SIZE - 1) & ~(file_size_t)(MIN_EXTENT_SIZE - 1),
+				           (file_size_t)MIN_EXTENT_SIZE);
+
+				if (_num_extents) {
+					Extent &first = _extents[0];
+
+					if (first.offset == 0 && first.ds.valid() && first.size >= size) {
+						if (!first.pinned) {
+							memset(first.data + first.used, 0, first.size - first.used);
+							first.used   = first.size;
+							first.pinned = true;
+						}
+						return first.ds;
+					}
+
+					/* clients may have attached the dataspace of a pinned extent */
+					if (first.pinned)
+						return Ram_dataspace_capability();
+
+					/* cover all content */
+					Extent const &last = _extents[_num_extents - 1];
+					size = max(size, (last.offset + last.used + MIN_EXTENT_SIZE - 1)
+					                 & ~(file_size_t)(MIN_EXTENT_SIZE - 1));
+				}
+
+				if (size > (size_t)~0 || (!_max_extents && !_grow_array()))
+					return Ram_dataspace_capability();
+
+				Extent e;
+				e.offset = 0;
+				e.size   = size;
+				e.data   = 0;
+				e.ds     = Ram_dataspace_capability();
+
+				if (!_alloc_data(_alloc, e, true))
+					return Ram_dataspace_capability();
+
+				/* copy content including holes, replace all extents */
+				read(e.data, e.size, 0);
+
+				for (unsigned i = 0; i < _num_extents; i++)
+					_free_data(_alloc, _extents[i]);
+
+				e.used   = e.size;
+				e.pinned = true;
+
+				_extents[0]  = e;
+				_num_extents = 1;
+				return e.ds;
+			}
+	};
+}
+
+#endif /* _EXTENT_H_ */
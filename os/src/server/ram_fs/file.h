@@ -12,7 +12,7 @@
 
 /* local includes */
 #include <node.h>
-#include <chunk.h>
+#include <extent.h>
 
 namespace File_system {
 
@@ -20,82 +20,69 @@ namespace File_system {
 	{
 		private:
 
-			typedef Chunk<4096>                     Chunk_level_3;
-			typedef Chunk_index<128, Chunk_level_3> Chunk_level_2;
-			typedef Chunk_index<64,  Chunk_level_2> Chunk_level_1;
-			typedef Chunk_index<64,  Chunk_level_1> Chunk_level_0;
-
-			Chunk_level_0 _chunk;
+			Extent_map _extents;
 
 			file_size_t _length;
 
 		public:
 
 			File(Allocator &alloc, char const *name)
-			: _chunk(alloc, 0), _length(0) { Node::name(name); }
+			: _extents(alloc), _length(0) { Node::name(name); }
 
 			size_t read(char *dst, size_t len, seek_off_t seek_offset)
 			{
-				file_size_t const chunk_used_size = _chunk.used_size();
-
 				if (seek_offset >= _length)
 					return 0;
 
-				/*
-				 * Constrain read transaction to available chunk data
-				 *
-				 * Note that 'chunk_used_size' may be lower than '_length'
-				 * because 'Chunk' may have truncated tailing zeros.
-				 */
+				/* constrain read transaction to the file length */
 				if (seek_offset + len >= _length)
 					len = _length - seek_offset;
 
-				file_size_t read_len = len;
-
-				if (seek_offset + read_len > chunk_used_size) {
-					if (chunk_used_size >= seek_offset)
-						read_len = chunk_used_size - seek_offset;
-					else
-						read_len = 0;
-				}
-
-				_chunk.read(dst, read_len, seek_offset);
-
-				/* add zero padding if needed */
-				if (read_len < len)
-					memset(dst + read_len, 0, len - read_len);
-
+				_extents.read(dst, len, seek_offset);
 				return len;
 			}
 
 			size_t write(char const *src, size_t len, seek_off_t seek_offset)
 			{
 				if (seek_offset == (seek_off_t)(~0))
-					seek_offset = _chunk.used_size();
+					seek_offset = _length;
 
-				if (seek_offset + len >= Chunk_level_0::SIZE)
-					throw Size_limit_reached();
-
-				_chunk.write(src, len, (size_t)seek_offset);
+				size_t const written = _extents.write(src, len, seek_offset);
 
 				/*
-				 * Keep track of file length. We cannot use 'chunk.used_size()'
-				 * as file length because trailing zeros may by represented
-				 * by zero chunks, which do not contribute to 'used_size()'.
+				 * Keep track of file length. The extents do not tell the
+				 * length because trailing zeros may be represented by a hole.
 				 */
-				_length = max(_length, seek_offset + len);
-				return 0;
+				if (written)
+					_length = max(_length, seek_offset + written);
+
+				if (written < len)
+					throw Size_limit_reached();
+
+				return written;
 			}
 
 			file_size_t length() const { return _length; }
 
 			void truncate(file_size_t size)
 			{
-				if (size < _chunk.used_size())
-					_chunk.truncate(size);
+				/*
+				 * Also when growing the file, drop content beyond the old
+				 * length, which may have been written via a dataspace.
+				 */
+				_extents.truncate(min(size, _length));
 
 				_length = size;
 			}
+
+			/**
+			 * Return dataspace with the file content from offset 0 on
+			 *
+			 * \param size  number of bytes that must be covered, limited
+			 *              to the file length
+			 */
+			Genode::Ram_dataspace_capability dataspace(file_size_t size) {
+				return _extents.dataspace(min(size, _length)); }
 	};
 }
 
@@ -0,0 +1,98 @@
+/*
+ * \brief  Cache of recently resolved paths
+ * \author Genode Labs
+ * \date   2013-03-08
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _LOOKUP_CACHE_H_
+#define _LOOKUP_CACHE_H_
+
+/* local includes */
+#include <directory.h>
+
+namespace File_system {
+
+	/**
+	 * Direct-mapped cache of path lookups of one session
+	 *
+	 * Adding nodes does not affect the nodes found for other paths. Once a
+	 * node is removed from any directory, which may also be a renamed parent
+	 * directory, all entries become stale. This is detected by comparing the
+	 * generation of the directories with the one of the entry.
+	 */
+	class Lookup_cache
+	{
+		public:
+
+			enum { MAX_ENTRIES = 32, MAX_PATH_LEN = 120 };
+
+		private:
+
+			struct Entry
+			{
+				char           path[MAX_PATH_LEN];
+				Node          *node;
+				unsigned long  generation;
+			};
+
+			Entry    _entries[MAX_ENTRIES];
+			unsigned _num_entries;
+
+			Entry *_entry(char const *path)
+			{
+				if (!_num_entries)
+					return 0;
+
+				return &_entries[name_hash(path, MAX_PATH_LEN) % _num_entries];
+			}
+
+		public:
+
+			/**
+			 * Constructor
+			 *
+			 * \param num_entries  number of entries, 0 disables the cache
+			 */
+			Lookup_cache(unsigned num_entries)
+			: _num_entries(min(num_entries, (unsigned)MAX_ENTRIES))
+			{
+				for (unsigned i = 0; i < _num_entries; i++)
+					_entries[i].node = 0;
+			}
+
+			/**
+			 * Return node of path, or 0 if the path is not cached
+			 */
+			Node *lookup(char const *path)
+			{
+				Entry *e = _entry(path);
+
+				if (!e || !e->node || e->generation != Directory::generation()
+				 || strcmp(e->path, path) != 0)
+					return 0;
+
+				return e->node;
+			}
+
+			void insert(char const *path, Node *node)
+			{
+				Entry *e = _entry(path);
+
+				if (!e || strlen(path) >= MAX_PATH_LEN)
+					return;
+
+				strncpy(e->path, path, sizeof(e->path));
+				e->node       = node;
+				e->generation = Directory::generation();
+			}
+	};
+}
+
+#endif /* _LOOKUP_CACHE_H_ */
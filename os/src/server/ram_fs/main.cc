@@ -23,6 +23,7 @@
 
 /* local includes */
 #include <directory.h>
+#include <lookup_cache.h>
 #include <node_handle_registry.h>
 
 
@@ -86,6 +87,25 @@ namespace File_system {
 			Directory            &_root;
 			Node_handle_registry  _handle_registry;
 			bool                  _writable;
+			Lookup_cache          _lookup_cache;
+
+			enum { MAX_NODE_HANDLES = Node_handle_registry::MAX_NODE_HANDLES };
+
+			/*
+			 * Read-only sessions obtain a private copy of the file content
+			 * instead of the storage of the file. The copies are indexed by
+			 * file handle and paid from the session quota.
+			 */
+			struct Ds_copy
+			{
+				Ram_dataspace_capability ds;
+				size_t                   size;
+
+				Ds_copy() : size(0) { }
+			};
+
+			Ds_copy _ds_copies[MAX_NODE_HANDLES];
+			size_t  _ds_copy_quota;  /* session quota left for copies */
 
 			Signal_dispatcher<Session_component> _process_packet_dispatcher;
 
@@ -189,18 +209,91 @@ namespace File_system {
 				}
 			}
 
+			/**
+			 * Return dataspace with a copy of the file content
+			 */
+			Dataspace_capability _ds_copy(File_handle file_handle, File &file,
+			                              file_size_t size)
+			{
+				Ds_copy &copy = _ds_copies[file_handle.value];
+
+				/* the client may have attached the existing copy */
+				if (copy.ds.valid())
+					return copy.size >= size ? copy.ds : Ram_dataspace_capability();
+
+				size = align_addr(max(min(size, file.length()), (file_size_t)1), 12);
+				if (size > _ds_copy_quota) {
+					PWRN("insufficient 'ram_quota' for the copy of a file");
+					return Dataspace_capability();
+				}
+
+				try {
+					copy.ds = env()->ram_session()->alloc(size);
+				} catch (...) { return Dataspace_capability(); }
+
+				char *dst = env()->rm_session()->attach(copy.ds);
+				file.read(dst, size, 0);
+				env()->rm_session()->detach(dst);
+
+				copy.size       = size;
+				_ds_copy_quota -= size;
+				return copy.ds;
+			}
+
+			void _free_ds_copy(Node_handle handle)
+			{
+				if (handle.value < 0 || handle.value >= MAX_NODE_HANDLES)
+					return;
+
+				Ds_copy &copy = _ds_copies[handle.value];
+				if (!copy.ds.valid())
+					return;
+
+				env()->ram_session()->free(copy.ds);
+				_ds_copy_quota += copy.size;
+				copy.ds   = Ram_dataspace_capability();
+				copy.size = 0;
+			}
+
+			/**
+			 * Lookup node by path relative to the root of the session
+			 *
+			 * \throw Lookup_failed
+			 */
+			Node *_lookup_and_lock(char const *path)
+			{
+				Node *node = _lookup_cache.lookup(path);
+				if (node) {
+					node->lock();
+					return node;
+				}
+
+				node = _root.lookup_and_lock(path);
+				_lookup_cache.insert(path, node);
+				return node;
+			}
+
 		public:
 
 			/**
 			 * Constructor
+			 *
+			 * \param ds_copy_quota  session quota available for copies of
+			 *                       file content handed out as dataspaces
 			 */
-			Session_component(size_t tx_buf_size, Rpc_entrypoint &ep,
+			Session_component(size_t tx_buf_size, unsigned tx_queue_size,
+			                  Rpc_entrypoint &ep,
 			                  Signal_receiver &sig_rec,
-			                  Directory &root, bool writable)
+			                  Directory &root, bool writable,
+			                  unsigned lookup_cache_entries,
+			                  size_t ds_copy_quota)
 			:
-				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep),
+				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep,
+				                   tx_queue_size),
 				_root(root),
 				_writable(writable),
+				_lookup_cache(lookup_cache_entries),
+				_ds_copy_quota(ds_copy_quota),
 				_process_packet_dispatcher(sig_rec, *this,
 				                           &Session_component::_process_packets)
 			{
@@ -217,6 +310,9 @@ namespace File_system {
 			 */
 			~Session_component()
 			{
+				for (int i = 0; i < MAX_NODE_HANDLES; i++)
+					_free_ds_copy(Node_handle(i));
+
 				Dataspace_capability ds = tx_sink()->dataspace();
 				env()->ram_session()->free(static_cap_cast<Ram_dataspace>(ds));
 			}
@@ -324,8 +420,13 @@ namespace File_system {
 					}
 				}
 
-				Directory *dir = _root.lookup_and_lock_dir(path_str);
-				Node_lock_guard guard(*dir);
+				Node *node = _lookup_and_lock(path_str);
+				Node_lock_guard guard(*node);
+
+				Directory *dir = dynamic_cast<Directory *>(node);
+				if (!dir)
+					throw Lookup_failed();
+
 				return _handle_registry.alloc(dir);
 			}
 
@@ -333,7 +434,7 @@ namespace File_system {
 			{
 				_assert_valid_path(path.string());
 
-				Node *node = _root.lookup_and_lock(path.string() + 1);
+				Node *node = _lookup_and_lock(path.string() + 1);
 
 				Node_lock_guard guard(*node);
 				return _handle_registry.alloc(node);
@@ -341,6 +442,7 @@ namespace File_system {
 
 			void close(Node_handle handle)
 			{
+				_free_ds_copy(handle);
 				_handle_registry.free(handle);
 			}
 
@@ -409,6 +511,27 @@ namespace File_system {
 				file->truncate(size);
 			}
 
+			Dataspace_capability dataspace(File_handle file_handle,
+			                               file_size_t size, bool writeable)
+			{
+				if (!_writable && writeable)
+					throw Permission_denied();
+
+				File *file = _handle_registry.lookup_and_lock(file_handle);
+				Node_lock_guard file_guard(*file);
+
+				/*
+				 * The storage of a file is writeable RAM. So it is handed
+				 * out to sessions that may modify the file anyway. Other
+				 * sessions obtain a copy, which leaves the file untouched
+				 * if the client writes to it.
+				 */
+				if (!_writable)
+					return _ds_copy(file_handle, *file, size);
+
+				return file->dataspace(size);
+			}
+
 			void move(Dir_handle from_dir_handle, Name const &from_name,
 			          Dir_handle to_dir_handle,   Name const &to_name)
 			{
@@ -426,14 +549,19 @@ namespace File_system {
 
 				Node *node = from_dir->lookup_and_lock(from_name.string());
 				Node_lock_guard node_guard(*node);
-				node->name(to_name.string());
 
+				/* the node is indexed by its name, so it is renamed while detached */
 				if (!_handle_registry.refer_to_same_node(from_dir_handle, to_dir_handle)) {
 					Directory *to_dir = _handle_registry.lookup_and_lock(to_dir_handle);
 					Node_lock_guard to_dir_guard(*to_dir);
 
 					from_dir->discard_unsynchronized(node);
+					node->name(to_name.string());
 					to_dir->adopt_unsynchronized(node);
+				} else {
+					from_dir->discard_unsynchronized(node);
+					node->name(to_name.string());
+					from_dir->adopt_unsynchronized(node);
 				}
 			}
 	};
@@ -458,6 +586,7 @@ namespace File_system {
 
 				Directory *session_root_dir = 0;
 				bool writeable = false;
+				unsigned lookup_cache_entries = 0;
 
 				enum { ROOT_MAX_LEN = 256 };
 				char root[ROOT_MAX_LEN];
@@ -502,6 +631,13 @@ namespace File_system {
 						writeable = policy.attribute("writeable").has_value("yes");
 					} catch (Xml_node::Nonexistent_attribute) { }
 
+					/*
+					 * Determine number of cached path lookups.
+					 */
+					try {
+						policy.attribute("lookup_cache").value(&lookup_cache_entries);
+					} catch (Xml_node::Nonexistent_attribute) { }
+
 				} catch (Session_policy::No_policy_defined) {
 					PERR("Invalid session request, no matching policy");
 					throw Root::Unavailable();
@@ -511,20 +647,26 @@ namespace File_system {
 					Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 				size_t tx_buf_size =
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
 
 				/*
 				 * Check if donated ram quota suffices for session data,
 				 * and communication buffer.
 				 */
-				size_t session_size = sizeof(Session_component) + tx_buf_size;
-				if (max((size_t)4096, session_size) > ram_quota) {
+				size_t session_size = max((size_t)4096,
+				                          sizeof(Session_component) + tx_buf_size);
+				if (session_size > ram_quota) {
 					PERR("insufficient 'ram_quota', got %zd, need %zd",
 					     ram_quota, session_size);
 					throw Root::Quota_exceeded();
 				}
 				return new (md_alloc())
-					Session_component(tx_buf_size, _channel_ep, _sig_rec,
-					                  *session_root_dir, writeable);
+					Session_component(tx_buf_size, tx_queue_size, _channel_ep, _sig_rec,
+					                  *session_root_dir, writeable,
+					                  lookup_cache_entries,
+					                  ram_quota - session_size);
 			}
 
 		public:
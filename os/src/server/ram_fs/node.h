@@ -11,8 +11,13 @@
 #include <util/list.h>
 #include <base/lock.h>
 
+/* local includes */
+#include <util.h>
+
 namespace File_system {
 
+	class Directory;
+
 	class Node : public List<Node>::Element
 	{
 		public:
@@ -21,11 +26,16 @@ namespace File_system {
 
 		private:
 
+			friend class Directory;
+
 			Lock                _lock;
 			int                 _ref_count;
 			Name                _name;
+			unsigned long       _name_hash;
 			unsigned long const _inode;
 
+			Node               *_dir_next;  /* chain in index of parent */
+
 			/**
 			 * Generate unique inode number
 			 */
@@ -37,7 +47,13 @@ namespace File_system {
 
 		public:
 
-			Node() : _ref_count(0), _inode(_unique_inode()) { _name[0] = 0; }
+			Node()
+			:
+				_ref_count(0), _name_hash(name_hash("", 0)),
+				_inode(_unique_inode()), _dir_next(0)
+			{
+				_name[0] = 0;
+			}
 
 			virtual ~Node() { }
 
@@ -46,8 +62,14 @@ namespace File_system {
 
 			/**
 			 * Assign name
+			 *
+			 * The node must not be indexed by a directory while renamed.
 			 */
-			void name(char const *name) { strncpy(_name, name, sizeof(_name)); }
+			void name(char const *name)
+			{
+				strncpy(_name, name, sizeof(_name));
+				_name_hash = name_hash(_name, sizeof(_name));
+			}
 
 			void lock()   { _lock.lock(); }
 			void unlock() { _lock.unlock(); }
@@ -36,11 +36,13 @@ namespace File_system {
 
 	class Node_handle_registry
 	{
-		private:
+		public:
 
 			/* maximum number of open nodes per session */
 			enum { MAX_NODE_HANDLES = 128U };
 
+		private:
+
 			Lock mutable _lock;
 
 			Node *_nodes[MAX_NODE_HANDLES];
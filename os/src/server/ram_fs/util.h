@@ -60,4 +60,21 @@ static inline bool valid_name(char const *str)
 	return true;
 }
 
+
+/**
+ * Return hash value of the first 'len' characters of 'name'
+ *
+ * The hash ends at the null termination, so the hash value of a path
+ * element equals the one of the corresponding null-terminated name.
+ */
+static inline unsigned long name_hash(char const *name, unsigned long len)
+{
+	unsigned long hash = 2166136261UL;
+
+	for (; len-- && *name; name++)
+		hash = (hash ^ (unsigned char)*name) * 16777619UL;
+
+	return hash;
+}
+
 #endif /* _UTIL_H_ */
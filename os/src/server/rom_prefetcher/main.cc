@@ -134,7 +134,7 @@ int main(int argc, char **argv)
 	} catch (...) { }
 
 	static Sliced_heap sliced_heap(env()->ram_session(),
-	                               env()->rm_session());
+	                               env()->rm_session(), 64*1024);
 
 	/* creation of the entrypoint and the root interface */
 	enum { STACK_SIZE = 8*1024 };
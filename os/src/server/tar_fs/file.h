@@ -15,17 +15,68 @@
 #ifndef _FILE_H_
 #define _FILE_H_
 
+/* Genode includes */
+#include <base/env.h>
+#include <rm_session/connection.h>
+
 /* local includes */
 #include <node.h>
 
 
 namespace File_system {
 
+	extern char                 *_tar_base;
+	extern Dataspace_capability  _tar_ds;
+
 	class File : public Node
 	{
 		public:
 
-			File(Record *record) : Node(record) { }
+			enum {
+				PAGE_SIZE_LOG2 = 12,
+				PAGE_SIZE      = 1 << PAGE_SIZE_LOG2,
+
+				/**
+				 * RAM quota consumed by the dataspace of a file
+				 *
+				 * The managed dataspace costs the quota of an RM session
+				 * (see 'Rm_connection') and a page for the end of the file.
+				 */
+				DATASPACE_QUOTA = 64*1024 + PAGE_SIZE,
+			};
+
+		private:
+
+			/**
+			 * Managed dataspace that contains the file content, created
+			 * on demand
+			 */
+			Rm_connection *_rm;
+
+			/**
+			 * Private copy of the last partial page of the file
+			 *
+			 * The remainder of the page is zero. Mapping the archive
+			 * instead would expose the bytes that follow the file.
+			 */
+			Ram_dataspace_capability _tail_ds;
+
+			void _release_dataspace()
+			{
+				if (_rm)
+					destroy(env()->heap(), _rm);
+				if (_tail_ds.valid())
+					env()->ram_session()->free(_tail_ds);
+
+				_rm      = 0;
+				_tail_ds = Ram_dataspace_capability();
+			}
+
+		public:
+
+			File(Record *record) : Node(record), _rm(0) { }
+
+			~File() { _release_dataspace(); }
 
 			size_t read(char *dst, size_t len, seek_off_t seek_offset)
 			{
@@ -58,6 +109,61 @@ namespace File_system {
 				return -1;
 			}
 
+			/**
+			 * Return true if the dataspace of the file exists
+			 */
+			bool has_dataspace() const { return _rm != 0; }
+
+			/**
+			 * Return dataspace with the file content from offset 0 on
+			 *
+			 * The full pages of the file are handed out from the archive
+			 * without copying. This is possible only if the content of the
+			 * file starts at a page boundary within the archive. The last
+			 * partial page is a zero-padded copy.
+			 *
+			 * \param size  number of bytes that must be covered
+			 */
+			Dataspace_capability dataspace(file_size_t size)
+			{
+				addr_t const offset      = (char *)_record->data() - _tar_base;
+				size_t const file_size   = _record->size();
+				size_t const mapped_size = align_addr(file_size, PAGE_SIZE_LOG2);
+				size_t const full_size   = file_size & ~(PAGE_SIZE - 1);
+
+				if (offset & (PAGE_SIZE - 1)
+				 || !mapped_size || size > mapped_size)
+					return Dataspace_capability();
+
+				if (!_rm) {
+					try {
+						_rm = new (env()->heap()) Rm_connection(0, mapped_size);
+
+						if (full_size)
+							_rm->attach(_tar_ds, full_size, offset,
+							            false, (addr_t)0, false);
+
+						if (full_size < file_size) {
+
+							/* RAM dataspaces are zeroed on allocation */
+							_tail_ds = env()->ram_session()->alloc(PAGE_SIZE);
+
+							char *tail = env()->rm_session()->attach(_tail_ds);
+							memcpy(tail, (char *)_record->data() + full_size,
+							       file_size - full_size);
+							env()->rm_session()->detach(tail);
+
+							_rm->attach(_tail_ds, PAGE_SIZE, 0,
+							            true, (addr_t)full_size, false);
+						}
+					} catch (...) {
+						PWRN("could not create dataspace of file");
+						_release_dataspace();
+						return Dataspace_capability();
+					}
+				}
+				return _rm->dataspace();
+			}
 	};
 }
 
@@ -89,8 +89,9 @@ namespace Genode {
 
 namespace File_system {
 
-	char  *_tar_base;
-	size_t _tar_size;
+	char                 *_tar_base;
+	size_t                _tar_size;
+	Dataspace_capability  _tar_ds;
 
 	class Session_component : public Session_rpc_object
 	{
@@ -99,6 +100,9 @@ namespace File_system {
 			Directory            &_root;
 			Node_handle_registry  _handle_registry;
 
+			/* session quota left for the dataspaces of files */
+			size_t                _dataspace_quota;
+
 			Signal_dispatcher<Session_component> _process_packet_dispatcher;
 
 
@@ -206,12 +210,16 @@ namespace File_system {
 			/**
 			 * Constructor
 			 */
-			Session_component(size_t tx_buf_size, Rpc_entrypoint &ep,
+			Session_component(size_t tx_buf_size, unsigned tx_queue_size,
+			                  Rpc_entrypoint &ep,
 			                  Signal_receiver &sig_rec,
-			                  Directory &root)
+			                  Directory &root,
+			                  size_t dataspace_quota)
 			:
-				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep),
+				Session_rpc_object(env()->ram_session()->alloc(tx_buf_size), ep,
+				                   tx_queue_size),
 				_root(root),
+				_dataspace_quota(dataspace_quota),
 				_process_packet_dispatcher(sig_rec, *this,
 				                           &Session_component::_process_packets)
 			{
@@ -408,6 +416,9 @@ namespace File_system {
 
 				File *file = dynamic_cast<File *>(node);
 				if (file) {
+					if (file->has_dataspace())
+						_dataspace_quota += File::DATASPACE_QUOTA;
+
 					/* free the node */
 					destroy(env()->heap(), file);
 					return;
@@ -466,6 +477,29 @@ namespace File_system {
 
 				throw Permission_denied();
 			}
+
+			Dataspace_capability dataspace(File_handle file_handle,
+			                               file_size_t size, bool writeable)
+			{
+				if (writeable)
+					throw Permission_denied();
+
+				File *file = _handle_registry.lookup(file_handle);
+
+				/* the dataspace of a file is paid from the session quota */
+				bool const charge = !file->has_dataspace();
+				if (charge && _dataspace_quota < File::DATASPACE_QUOTA) {
+					PWRN("insufficient 'ram_quota' for the dataspace of a file");
+					return Dataspace_capability();
+				}
+
+				Dataspace_capability ds = file->dataspace(size);
+
+				if (charge && file->has_dataspace())
+					_dataspace_quota -= File::DATASPACE_QUOTA;
+
+				return ds;
+			}
 	};
 
 
@@ -538,20 +572,26 @@ namespace File_system {
 					Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 				size_t tx_buf_size =
 					Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+				unsigned tx_queue_size =
+					Packet_stream_base::normalized_queue_size(
+						Arg_string::find_arg(args, "tx_queue_size").ulong_value(Session::TX_QUEUE_SIZE));
 
 				/*
 				 * Check if donated ram quota suffices for session data,
 				 * and communication buffer.
 				 */
-				size_t session_size = sizeof(Session_component) + tx_buf_size;
-				if (max((size_t)4096, session_size) > ram_quota) {
+				size_t session_size = max((size_t)4096,
+				                          sizeof(Session_component) + tx_buf_size);
+				if (session_size > ram_quota) {
 					PERR("insufficient 'ram_quota', got %zd, need %zd",
 					     ram_quota, session_size);
 					throw Root::Quota_exceeded();
 				}
+
+				/* the remaining quota pays for the dataspaces of files */
 				return new (md_alloc())
-					Session_component(tx_buf_size, _channel_ep, _sig_rec,
-					                  *session_root_dir);
+					Session_component(tx_buf_size, tx_queue_size, _channel_ep, _sig_rec,
+					                  *session_root_dir, ram_quota - session_size);
 			}
 
 		public:
@@ -603,7 +643,8 @@ int main(int, char **)
 	/* obtain dataspace of tar archive from ROM service */
 	try {
 		static Rom_connection tar_rom(tar_filename);
-		_tar_base = env()->rm_session()->attach(tar_rom.dataspace());
+		_tar_ds   = tar_rom.dataspace();
+		_tar_base = env()->rm_session()->attach(_tar_ds);
 		_tar_size = Dataspace_client(tar_rom.dataspace()).size();
 	} catch (...) {
 		PERR("Could not obtain tar archive from ROM service");
@@ -242,7 +242,7 @@ int main(void)
 
 	/* creation of the entrypoint and the root interface */
 	static Sliced_heap sliced_heap(env()->ram_session(),
-	                               env()->rm_session());
+	                               env()->rm_session(), 64*1024);
 
 	enum { STACK_SIZE = 8*1024 };
 	static Rpc_entrypoint ep(&cap, STACK_SIZE, "tar_rom_ep");
@@ -0,0 +1,306 @@
+/*
+ * \brief  Block-session benchmark
+ * \author Genode Labs
+ * \date   2013-02-18
+ *
+ * The benchmark accesses the block device sequentially and at random
+ * positions while keeping a configurable number of requests in flight. For
+ * both patterns, it reports the throughput, the number of I/O operations
+ * per second, and percentiles of the request latency.
+ *
+ * Configuration:
+ *
+ * :request_size:  number of bytes per request (default 4096)
+ * :queue_depth:   maximum number of requests in flight (default 16)
+ * :requests:      number of requests per pattern (default 4096)
+ * :write_percent: share of write requests (default 0)
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <block_session/connection.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+using namespace Genode;
+
+
+enum {
+	MAX_QUEUE_DEPTH = 128,
+
+	/* packet-queue slots, sufficient for the maximum queue depth */
+	TX_QUEUE_SIZE   = 2*MAX_QUEUE_DEPTH,
+
+	/* quota for the requests kept in flight by an asynchronous driver */
+	BATCH_QUOTA     = 64*1024,
+};
+
+
+struct Bench_config
+{
+	size_t   request_size;
+	unsigned queue_depth;
+	unsigned requests;
+	unsigned write_percent;
+
+	Bench_config()
+	: request_size(4096), queue_depth(16), requests(4096), write_percent(0)
+	{
+		try {
+			Xml_node config = Genode::config()->xml_node();
+
+			try { config.attribute("request_size").value(&request_size);   } catch (...) { }
+			try { config.attribute("queue_depth").value(&queue_depth);     } catch (...) { }
+			try { config.attribute("requests").value(&requests);           } catch (...) { }
+			try { config.attribute("write_percent").value(&write_percent); } catch (...) { }
+		} catch (...) { }
+
+		queue_depth   = max(1U, min(queue_depth, (unsigned)MAX_QUEUE_DEPTH));
+		write_percent = min(write_percent, 100U);
+	}
+};
+
+
+/**
+ * Pseudo-random numbers (xorshift)
+ */
+class Random
+{
+	private:
+
+		unsigned long _seed;
+
+	public:
+
+		Random(unsigned long seed) : _seed(seed) { }
+
+		unsigned long next()
+		{
+			_seed ^= _seed << 13;
+			_seed ^= _seed >> 17;
+			_seed ^= _seed << 5;
+			return _seed;
+		}
+};
+
+
+/**
+ * Generator of block numbers
+ */
+class Pattern
+{
+	private:
+
+		bool   _random;
+		size_t _num_chunks;   /* number of request-sized chunks */
+		size_t _next;
+		Random _rand;
+
+	public:
+
+		Pattern(bool random, size_t num_chunks)
+		: _random(random), _num_chunks(num_chunks), _next(0), _rand(0x2545f491) { }
+
+		/**
+		 * Return index of next request-sized chunk
+		 */
+		size_t next() { return (_random ? _rand.next() : _next++) % _num_chunks; }
+};
+
+
+/**
+ * Latency histogram with a resolution of one millisecond
+ */
+class Latency_histogram
+{
+	private:
+
+		enum { MAX_MS = 1024 };
+
+		unsigned      _count[MAX_MS + 1];  /* last bucket collects outliers */
+		unsigned      _total;
+		unsigned long _max_ms;
+
+	public:
+
+		Latency_histogram() : _total(0), _max_ms(0) {
+			memset(_count, 0, sizeof(_count)); }
+
+		void add(unsigned long ms)
+		{
+			_count[min(ms, (unsigned long)MAX_MS)]++;
+			_total++;
+			_max_ms = max(_max_ms, ms);
+		}
+
+		unsigned long max_ms() const { return _max_ms; }
+
+		/**
+		 * Return latency not exceeded by 'percent' percent of the requests
+		 */
+		unsigned long percentile(unsigned percent) const
+		{
+			unsigned long const limit = ((unsigned long)_total*percent + 99) / 100;
+
+			unsigned long sum = 0;
+			for (unsigned ms = 0; ms <= MAX_MS; ms++)
+				if ((sum += _count[ms]) >= limit && sum)
+					return ms == MAX_MS ? _max_ms : ms;
+
+			return _max_ms;
+		}
+};
+
+
+static void bench(char const *name, Block::Connection &blk, Timer::Session &timer,
+                  Bench_config const &cfg, bool random, size_t blk_cnt, size_t blk_size)
+{
+	typedef Block::Packet_descriptor Packet;
+
+	Block::Session::Tx::Source &source = *blk.tx();
+
+	size_t const count = cfg.request_size / blk_size;
+	Pattern pattern(random, blk_cnt / count);
+	Random  mix(0x9e3779b9);
+
+	/*
+	 * Submission time of the requests in flight, looked up by the offset of
+	 * the packet within the bulk buffer. Packets in flight do not overlap,
+	 * hence their offsets are unique.
+	 */
+	struct In_flight { off_t offset; unsigned long ms; };
+	static In_flight in_flight[MAX_QUEUE_DEPTH];
+	unsigned num_in_flight = 0;
+
+	static Latency_histogram latency;
+	latency = Latency_histogram();
+
+	unsigned submitted = 0, completed = 0, failed = 0;
+
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	while (completed < cfg.requests) {
+
+		/* fill up the queue */
+		Packet   packets[MAX_QUEUE_DEPTH];
+		unsigned num = 0;
+		for (; submitted + num < cfg.requests
+		    && submitted + num - completed < cfg.queue_depth; num++) {
+
+			Packet::Opcode const op = mix.next() % 100 < cfg.write_percent
+			                        ? Packet::WRITE : Packet::READ;
+
+			/* retry after the next acknowledgements if the buffer is full */
+			Packet p;
+			try { p = source.alloc_packet(cfg.request_size); }
+			catch (Block::Session::Tx::Source::Packet_alloc_failed) { break; }
+
+			packets[num] = Packet(p, op, pattern.next()*count, count);
+		}
+
+		if (!num && submitted == completed) {
+			PERR("bulk buffer too small for a request of %zu bytes", cfg.request_size);
+			return;
+		}
+
+		if (num) {
+			unsigned long const now = timer.elapsed_ms();
+			for (unsigned i = 0; i < num; i++) {
+				in_flight[num_in_flight].offset = packets[i].offset();
+				in_flight[num_in_flight].ms     = now;
+				num_in_flight++;
+			}
+
+			source.submit_packets(packets, num);
+			submitted += num;
+		}
+
+		/* collect acknowledgements */
+		num = source.get_acked_packets(packets, MAX_QUEUE_DEPTH);
+
+		unsigned long const now = timer.elapsed_ms();
+		for (unsigned i = 0; i < num; i++) {
+			if (!packets[i].succeeded())
+				failed++;
+
+			for (unsigned j = 0; j < num_in_flight; j++) {
+				if (in_flight[j].offset != packets[i].offset())
+					continue;
+
+				latency.add(now - in_flight[j].ms);
+				in_flight[j] = in_flight[--num_in_flight];
+				break;
+			}
+			source.release_packet(packets[i]);
+		}
+		completed += num;
+	}
+
+	unsigned long const ms = max(1UL, timer.elapsed_ms() - start_ms);
+
+	unsigned long long const bytes = (unsigned long long)completed*cfg.request_size;
+
+	printf("%s: %u requests of %zu bytes in %lu ms\n",
+	       name, completed, cfg.request_size, ms);
+	printf("%s: %lu KiB/s, %lu IOPS\n", name,
+	       (unsigned long)(bytes*1000/1024/ms), completed*1000UL/ms);
+	printf("%s: latency p50 %lu ms, p90 %lu ms, p99 %lu ms, max %lu ms\n", name,
+	       latency.percentile(50), latency.percentile(90),
+	       latency.percentile(99), latency.max_ms());
+	if (failed)
+		printf("%s: %u requests failed\n", name, failed);
+}
+
+
+int main(int, char **)
+{
+	printf("--- block benchmark ---\n");
+
+	Bench_config cfg;
+
+	static Timer::Connection timer;
+	static Allocator_avl     block_alloc(env()->heap());
+
+	/*
+	 * The submit and acknowledgement queues reside in the same dataspace as
+	 * the bulk buffer.
+	 */
+	size_t const queue_bytes = 2*(TX_QUEUE_SIZE*sizeof(Block::Packet_descriptor) + 4096);
+	static Block::Connection blk(&block_alloc,
+	                             queue_bytes + cfg.queue_depth*cfg.request_size + 4096,
+	                             "", TX_QUEUE_SIZE, BATCH_QUOTA);
+
+	size_t blk_cnt = 0, blk_size = 0;
+	Block::Session::Operations ops;
+	blk.info(&blk_cnt, &blk_size, &ops);
+
+	if (!blk_size || cfg.request_size < blk_size || cfg.request_size % blk_size
+	 || cfg.request_size > blk_cnt*blk_size) {
+		PERR("invalid request size %zu for block size %zu", cfg.request_size, blk_size);
+		return -1;
+	}
+
+	if (cfg.write_percent && !ops.supported(Block::Packet_descriptor::WRITE)) {
+		PWRN("block device is read-only, reading only");
+		cfg.write_percent = 0;
+	}
+
+	printf("%zu blocks of %zu bytes, queue depth %u, %u%% writes\n",
+	       blk_cnt, blk_size, cfg.queue_depth, cfg.write_percent);
+
+	bench("sequential", blk, timer, cfg, false, blk_cnt, blk_size);
+	bench("random",     blk, timer, cfg, true,  blk_cnt, blk_size);
+
+	printf("--- end of block benchmark ---\n");
+	sleep_forever();
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET = test-blk_bench
+LIBS   = env cxx signal
+SRC_CC = main.cc
@@ -0,0 +1,277 @@
+/*
+ * \brief  Test for the integrity of the content of the block cache
+ * \author Genode Labs
+ * \date   2013-03-07
+ *
+ * The test is the back end of the block cache and its client at the same
+ * time. It writes patterns through the cache and reads them back. After
+ * closing the session, which makes the cache write back all dirty blocks,
+ * it verifies the patterns at the back end. The back end fails some of the
+ * writes, which the cache has to retry.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <block/component.h>
+#include <block_session/connection.h>
+#include <cap_session/connection.h>
+#include <util/string.h>
+
+using namespace Genode;
+
+
+enum {
+	BLOCK_SIZE  = 512,
+	BLOCK_COUNT = 16*1024,   /* exceeds the minimal size of the cache */
+	MAX_BLOCKS  = 64,        /* per request */
+	ROUNDS      = 4,
+	REQUESTS    = 1024,      /* writes per round */
+	FAIL_EVERY  = 7,         /* fail each n-th write at the back end */
+};
+
+
+/**
+ * Pseudo-random numbers (xorshift)
+ */
+class Random
+{
+	private:
+
+		unsigned long _seed;
+
+	public:
+
+		Random(unsigned long seed) : _seed(seed) { }
+
+		unsigned long next()
+		{
+			_seed ^= _seed << 13;
+			_seed ^= _seed >> 17;
+			_seed ^= _seed << 5;
+			return _seed;
+		}
+};
+
+
+/**
+ * Number of writes of each block, which determines its expected content
+ */
+static unsigned char generation[BLOCK_COUNT];
+
+
+/**
+ * Fill block with the pattern of its current generation
+ *
+ * Blocks that were never written read as zeros.
+ */
+static void fill(char *dst, size_t block)
+{
+	unsigned *words = (unsigned *)dst;
+	for (unsigned i = 0; i < BLOCK_SIZE / sizeof(unsigned); i++)
+		words[i] = generation[block]
+		         ? (block << 8 | generation[block]) ^ (i*0x9e3779b9) : 0;
+}
+
+
+/**
+ * Compare blocks with their expected content
+ *
+ * \return  number of blocks with unexpected content
+ */
+static unsigned verify(char const *name, char const *src, size_t block, size_t count)
+{
+	static char expected[BLOCK_SIZE];
+
+	unsigned mismatches = 0;
+	for (size_t i = 0; i < count; i++) {
+		fill(expected, block + i);
+		if (!memcmp(src + i*BLOCK_SIZE, expected, BLOCK_SIZE))
+			continue;
+
+		if (!mismatches++)
+			PERR("%s: block %zu has unexpected content", name, block + i);
+	}
+	return mismatches;
+}
+
+
+/**
+ * Back end of the cache, failing a write of each block at most once
+ */
+class Back_end : public Block::Driver
+{
+	private:
+
+		char     *_base;
+		unsigned  _writes;
+		bool      _failed[BLOCK_COUNT];
+
+	public:
+
+		Back_end(char *base) : _base(base), _writes(0) {
+			memset(_failed, 0, sizeof(_failed)); }
+
+		size_t block_size()  { return BLOCK_SIZE; }
+		size_t block_count() { return BLOCK_COUNT; }
+		bool   dma_enabled() { return false; }
+
+		void read(size_t block_number, size_t block_count, char *out_buffer)
+		{
+			if (block_number + block_count > BLOCK_COUNT)
+				throw Io_error();
+
+			memcpy(out_buffer, _base + block_number*BLOCK_SIZE, block_count*BLOCK_SIZE);
+		}
+
+		void write(size_t block_number, size_t block_count, char const *buffer)
+		{
+			if (block_number + block_count > BLOCK_COUNT)
+				throw Io_error();
+
+			if (++_writes % FAIL_EVERY == 0 && !_failed[block_number]) {
+				_failed[block_number] = true;
+				throw Io_error();
+			}
+
+			memcpy(_base + block_number*BLOCK_SIZE, buffer, block_count*BLOCK_SIZE);
+		}
+
+		void read_dma(size_t, size_t, addr_t)  { throw Io_error(); }
+		void write_dma(size_t, size_t, addr_t) { throw Io_error(); }
+};
+
+
+/**
+ * Transfer blocks synchronously
+ *
+ * \return  true on success
+ */
+static bool transfer(Block::Connection &blk, Block::Packet_descriptor::Opcode op,
+                     size_t block, size_t count, char *buf)
+{
+	typedef Block::Packet_descriptor Packet;
+
+	Block::Session::Tx::Source &source = *blk.tx();
+	size_t const bytes = count*BLOCK_SIZE;
+
+	Packet p(source.alloc_packet(bytes), op, block, count);
+	if (op == Packet::WRITE)
+		memcpy(source.packet_content(p), buf, bytes);
+
+	source.submit_packet(p);
+	p = source.get_acked_packet();
+
+	bool const success = p.succeeded();
+	if (success && op == Packet::READ)
+		memcpy(buf, source.packet_content(p), bytes);
+
+	source.release_packet(p);
+	return success;
+}
+
+
+int main(int, char **)
+{
+	printf("--- block cache test ---\n");
+
+	static char *base = env()->rm_session()->attach(
+		env()->ram_session()->alloc(BLOCK_COUNT*BLOCK_SIZE));
+
+	struct Back_end_factory : Block::Driver_factory
+	{
+		Block::Driver *create() {
+			return new (env()->heap()) Back_end(base); }
+
+		void destroy(Block::Driver *driver) {
+			Genode::destroy(env()->heap(), static_cast<Back_end *>(driver)); }
+
+	} driver_factory;
+
+	/* serve the cache before connecting to it */
+	enum { STACK_SIZE = 8192 };
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "back_end_ep");
+
+	static Block::Root block_root(&ep, env()->heap(), driver_factory);
+	env()->parent()->announce(ep.manage(&block_root));
+
+	static Allocator_avl block_alloc(env()->heap());
+	Block::Connection *blk = new (env()->heap()) Block::Connection(&block_alloc);
+
+	size_t blk_cnt = 0, blk_size = 0;
+	Block::Session::Operations ops;
+	blk->info(&blk_cnt, &blk_size, &ops);
+
+	if (blk_cnt != BLOCK_COUNT || blk_size != BLOCK_SIZE) {
+		PERR("unexpected geometry, %zu blocks of %zu bytes", blk_cnt, blk_size);
+		return -1;
+	}
+
+	typedef Block::Packet_descriptor Packet;
+
+	static char buf[MAX_BLOCKS*BLOCK_SIZE];
+	Random   rand(0x2545f491);
+	unsigned errors = 0;
+
+	for (unsigned round = 0; round < ROUNDS; round++) {
+
+		/* write at random positions, mixed with reads of written blocks */
+		for (unsigned i = 0; i < REQUESTS; i++) {
+
+			size_t const count = 1 + rand.next() % MAX_BLOCKS;
+			size_t const block = rand.next() % (BLOCK_COUNT - count + 1);
+
+			for (size_t b = block; b < block + count; b++) {
+				generation[b] = generation[b] % 255 + 1;
+				fill(buf + (b - block)*BLOCK_SIZE, b);
+			}
+
+			if (!transfer(*blk, Packet::WRITE, block, count, buf)) {
+				PERR("write of blocks %zu-%zu failed", block, block + count);
+				errors++;
+			}
+
+			if (rand.next() % 4)
+				continue;
+
+			if (!transfer(*blk, Packet::READ, block, count, buf)) {
+				PERR("read of blocks %zu-%zu failed", block, block + count);
+				errors++;
+			} else
+				errors += verify("cache", buf, block, count);
+		}
+
+		/* read back the whole device through the cache */
+		for (size_t block = 0; block < BLOCK_COUNT; block += MAX_BLOCKS) {
+			if (!transfer(*blk, Packet::READ, block, MAX_BLOCKS, buf)) {
+				PERR("read of blocks %zu-%zu failed", block, block + MAX_BLOCKS);
+				errors++;
+			} else
+				errors += verify("cache", buf, block, MAX_BLOCKS);
+		}
+
+		printf("round %u: %u errors\n", round, errors);
+	}
+
+	/* closing the session writes back all dirty blocks */
+	destroy(env()->heap(), blk);
+
+	errors += verify("back end", base, 0, BLOCK_COUNT);
+
+	if (errors) {
+		PERR("%u errors", errors);
+		return -1;
+	}
+
+	printf("--- block cache test finished ---\n");
+	sleep_forever();
+	return 0;
+}
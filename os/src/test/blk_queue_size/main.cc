@@ -0,0 +1,104 @@
+/*
+ * \brief  Test for packet-queue sizes exceeding the session buffer
+ * \author Genode Labs
+ * \date   2013-03-04
+ *
+ * The client requests a block session with a tiny transmission buffer and
+ * the largest possible queue size. The server must reduce the queue size
+ * to fit the buffer instead of failing. Afterwards, the server must still
+ * serve requests.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <block_session/connection.h>
+#include <util/string.h>
+
+using namespace Genode;
+
+
+/**
+ * Write one block and read it back
+ *
+ * \return  true if the block was read back unmodified
+ */
+static bool write_and_read(Block::Connection &blk, size_t blk_size, char pattern)
+{
+	typedef Block::Packet_descriptor Packet;
+
+	Block::Session::Tx::Source &source = *blk.tx();
+
+	Packet p(source.alloc_packet(blk_size), Packet::WRITE, 0, 1);
+	memset(source.packet_content(p), pattern, blk_size);
+	source.submit_packet(p);
+	p = source.get_acked_packet();
+
+	bool ok = p.succeeded();
+	if (ok) {
+		p = Packet(p, Packet::READ, 0, 1);
+		memset(source.packet_content(p), 0, blk_size);
+		source.submit_packet(p);
+		p = source.get_acked_packet();
+
+		char const *content = source.packet_content(p);
+		for (size_t i = 0; ok && i < blk_size; i++)
+			ok = p.succeeded() && content[i] == pattern;
+	}
+	source.release_packet(p);
+	return ok;
+}
+
+
+static bool test_session(char const *name, size_t tx_buf_size, unsigned tx_queue_size,
+                         char pattern)
+{
+	static Allocator_avl block_alloc(env()->heap());
+
+	try {
+		Block::Connection blk(&block_alloc, tx_buf_size, "", tx_queue_size);
+
+		size_t blk_cnt = 0, blk_size = 0;
+		Block::Session::Operations ops;
+		blk.info(&blk_cnt, &blk_size, &ops);
+
+		printf("%s: requested %u queue slots, got %u submit and %u ack slots\n",
+		       name, tx_queue_size, blk.tx()->submit_queue_size(),
+		       blk.tx()->ack_queue_size());
+
+		if (!write_and_read(blk, blk_size, pattern)) {
+			PERR("%s: block content differs", name);
+			return false;
+		}
+	} catch (Parent::Service_denied) {
+		PERR("%s: session request denied", name);
+		return false;
+	}
+	return true;
+}
+
+
+int main(int, char **)
+{
+	printf("--- block queue-size test ---\n");
+
+	enum { TINY_BUF_SIZE = 4096, HUGE_QUEUE_SIZE = 1 << 20 };
+
+	if (!test_session("tiny buffer", TINY_BUF_SIZE, HUGE_QUEUE_SIZE, 0x5a)
+	 || !test_session("zero queue",  128*1024, 0, 0x3c)
+	 || !test_session("default",     128*1024, Block::Session::TX_QUEUE_SIZE, 0xa5)) {
+		PERR("test failed");
+		sleep_forever();
+	}
+
+	printf("--- end of block queue-size test ---\n");
+	sleep_forever();
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET = test-blk_queue_size
+LIBS   = env cxx signal
+SRC_CC = main.cc
@@ -0,0 +1,127 @@
+/*
+ * \brief  Benchmark of RAM dataspace allocation, attachment, and release
+ * \author Genode Labs
+ * \date   2013-03-06
+ *
+ * For each dataspace size, the benchmark repeatedly allocates a batch of RAM
+ * dataspaces, attaches them to the local address space, touches each page,
+ * detaches them, and frees them. It reports the average time of each step
+ * per dataspace.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/env.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+enum {
+	ROUNDS    = 16,
+	MAX_BATCH = 64,
+	BUDGET    = 4*1024*1024,  /* memory used by one batch */
+	MAX_SIZE  = 4*1024*1024,
+};
+
+
+/**
+ * Accumulated duration of one step of the benchmark
+ */
+struct Step
+{
+	char const    *name;
+	unsigned long  ms;
+
+	Step(char const *name) : name(name), ms(0) { }
+
+	void print(unsigned long ops) {
+		printf(" %s %lu us", name, (ms*1000)/ops); }
+};
+
+
+/**
+ * Measure each step for a batch of dataspaces at once
+ *
+ * The timer has a resolution of milliseconds, which exceeds the duration
+ * of a single step for small dataspaces.
+ */
+static void measure(Timer::Session &timer, size_t size)
+{
+	Step alloc("alloc"), attach("attach"), touch("touch"),
+	     detach("detach"), free("free");
+
+	unsigned const num = max(1UL, min((unsigned long)MAX_BATCH,
+	                                  (unsigned long)(BUDGET/size)));
+
+	Ram_dataspace_capability ds[MAX_BATCH];
+	char                    *addr[MAX_BATCH];
+
+	for (unsigned r = 0; r < ROUNDS; r++) {
+
+		unsigned long t = timer.elapsed_ms();
+
+		for (unsigned i = 0; i < num; i++)
+			ds[i] = env()->ram_session()->alloc(size);
+
+		unsigned long const t_alloc = timer.elapsed_ms();
+
+		for (unsigned i = 0; i < num; i++)
+			addr[i] = env()->rm_session()->attach(ds[i]);
+
+		unsigned long const t_attach = timer.elapsed_ms();
+
+		for (unsigned i = 0; i < num; i++)
+			for (size_t offset = 0; offset < size; offset += 4096)
+				addr[i][offset] = 1;
+
+		unsigned long const t_touch = timer.elapsed_ms();
+
+		for (unsigned i = 0; i < num; i++)
+			env()->rm_session()->detach(addr[i]);
+
+		unsigned long const t_detach = timer.elapsed_ms();
+
+		for (unsigned i = 0; i < num; i++)
+			env()->ram_session()->free(ds[i]);
+
+		unsigned long const t_free = timer.elapsed_ms();
+
+		alloc.ms  += t_alloc  - t;
+		attach.ms += t_attach - t_alloc;
+		touch.ms  += t_touch  - t_attach;
+		detach.ms += t_detach - t_touch;
+		free.ms   += t_free   - t_detach;
+	}
+
+	unsigned long const ops = ROUNDS*num;
+
+	printf("%5zd KiB:", size/1024);
+	alloc.print(ops);
+	attach.print(ops);
+	touch.print(ops);
+	detach.print(ops);
+	free.print(ops);
+	printf("\n");
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- dataspace benchmark ---\n");
+
+	static Timer::Connection timer;
+
+	for (size_t size = 4096; size <= MAX_SIZE; size *= 4)
+		measure(timer, size);
+
+	printf("--- finished dataspace benchmark ---\n");
+	return 0;
+}
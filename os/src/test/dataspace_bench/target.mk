@@ -0,0 +1,3 @@
+TARGET = test-dataspace_bench
+SRC_CC = main.cc
+LIBS   = cxx env
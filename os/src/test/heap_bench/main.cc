@@ -0,0 +1,212 @@
+/*
+ * \brief  Allocation benchmark for the heap
+ * \author Genode Labs
+ * \date   2013-02-25
+ *
+ * A number of threads allocate and free blocks at a shared heap. Each thread
+ * keeps a window of live blocks and replaces a randomly chosen block with
+ * each step. The benchmark reports the number of allocations per second for
+ * an increasing number of threads and for several distributions of block
+ * sizes.
+ *
+ * Each configuration is measured twice, with all threads sharing one heap
+ * and with a private heap per thread. The private heaps never contend for
+ * a lock. Hence, the difference of both rates is the cost of contention at
+ * the shared heap, which includes threads that share a cache stripe of the
+ * heap.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/thread.h>
+#include <base/heap.h>
+#include <base/env.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+enum {
+	STACK_SIZE   = 8*1024,
+	MAX_THREADS  = 8,
+	WINDOW       = 64,       /* live blocks per thread */
+	ALLOCS       = 64*1024,  /* allocations per thread */
+};
+
+
+/**
+ * Distribution of block sizes
+ */
+struct Distribution
+{
+	char const *name;
+	size_t      min;
+	size_t      max;
+};
+
+
+static Distribution const distributions[] = {
+	{ "small",  8,    128   },
+	{ "mixed",  8,    2048  },
+	{ "large",  1024, 16384 },
+};
+
+
+struct Worker : Thread<STACK_SIZE>
+{
+	Heap               &heap;
+	Distribution const &dist;
+	Lock               &barrier;
+	unsigned long       seed;
+	bool                failed;
+
+	Worker(Heap &heap, Distribution const &dist, Lock &barrier, unsigned id)
+	:
+		heap(heap), dist(dist), barrier(barrier), seed(id + 1), failed(false)
+	{
+		start();
+	}
+
+	unsigned long random()
+	{
+		seed = seed*1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	size_t random_size() {
+		return dist.min + random() % (dist.max - dist.min + 1); }
+
+	void entry()
+	{
+		void  *blocks[WINDOW];
+		size_t sizes[WINDOW];
+
+		/* wait until all workers are up */
+		barrier.lock();
+		barrier.unlock();
+
+		for (unsigned i = 0; i < WINDOW; i++) {
+			sizes[i] = random_size();
+			if (!heap.alloc(sizes[i], &blocks[i]))
+				failed = true;
+		}
+
+		for (unsigned i = 0; i < ALLOCS - WINDOW && !failed; i++) {
+			unsigned const j = random() % WINDOW;
+
+			heap.free(blocks[j], sizes[j]);
+
+			sizes[j] = random_size();
+			if (!heap.alloc(sizes[j], &blocks[j]))
+				failed = true;
+
+			/* touch the block to detect overlapping allocations */
+			*(unsigned char *)blocks[j] = j;
+		}
+
+		for (unsigned i = 0; i < WINDOW; i++)
+			heap.free(blocks[i], sizes[i]);
+	}
+};
+
+
+/**
+ * Measure allocation rate of 'num_threads' concurrent threads
+ *
+ * \param shared  if true, all threads use one heap, otherwise each thread
+ *                uses a heap of its own
+ * \param ok      set to false if an allocation failed
+ *
+ * \return  allocations per second
+ */
+static unsigned long measure(Timer::Session &timer, Distribution const &dist,
+                             unsigned num_threads, bool shared, bool &ok)
+{
+	Heap *heap[MAX_THREADS];
+
+	for (unsigned i = 0; i < num_threads; i++)
+		heap[i] = (shared && i) ? heap[0] : new (env()->heap())
+			Heap(env()->ram_session(), env()->rm_session());
+
+	Worker *worker[MAX_THREADS];
+
+	Lock barrier(Lock::LOCKED);
+
+	for (unsigned i = 0; i < num_threads; i++)
+		worker[i] = new (env()->heap()) Worker(*heap[i], dist, barrier, i);
+
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	barrier.unlock();
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		worker[i]->join();
+		ok = ok && !worker[i]->failed;
+	}
+
+	unsigned long const duration_ms = timer.elapsed_ms() - start_ms;
+	unsigned long const allocs      = num_threads*ALLOCS;
+	unsigned long const rate        = duration_ms ? (allocs*1000)/duration_ms : 0;
+
+	unsigned const num_heaps = shared ? 1 : num_threads;
+
+	size_t consumed = 0;
+	for (unsigned i = 0; i < num_heaps; i++)
+		consumed += heap[i]->consumed();
+
+	printf("%s (%zd..%zd bytes), threads=%u, %s: %lu allocs in %lu ms -> %lu allocs/s, "
+	       "consumed %zd KiB\n", dist.name, dist.min, dist.max, num_threads,
+	       shared ? "shared heap" : "private heaps", allocs, duration_ms, rate,
+	       consumed/1024);
+
+	/* print size histogram and lock contention if built with 'alloc_stats' */
+	if (shared)
+		heap[0]->dump_stats();
+
+	for (unsigned i = 0; i < num_threads; i++)
+		destroy(env()->heap(), worker[i]);
+
+	for (unsigned i = 0; i < num_heaps; i++)
+		destroy(env()->heap(), heap[i]);
+
+	return rate;
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- heap benchmark ---\n");
+
+	static Timer::Connection timer;
+
+	bool ok = true;
+	for (unsigned i = 0; i < sizeof(distributions)/sizeof(distributions[0]); i++)
+		for (unsigned num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2) {
+
+			Distribution const &dist = distributions[i];
+
+			unsigned long const shared_rate  = measure(timer, dist, num_threads, true,  ok);
+			unsigned long const private_rate = measure(timer, dist, num_threads, false, ok);
+			if (!ok) {
+				PERR("allocation failed");
+				return -1;
+			}
+
+			/* share of the contention-free rate lost at the shared heap */
+			unsigned long const loss = (private_rate > shared_rate)
+			                         ? ((private_rate - shared_rate)*100)/private_rate : 0;
+
+			printf("%s, threads=%u: contention costs %lu%% of the allocation rate\n",
+			       dist.name, num_threads, loss);
+		}
+
+	printf("--- finished heap benchmark ---\n");
+	return 0;
+}
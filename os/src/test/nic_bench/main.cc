@@ -0,0 +1,262 @@
+/*
+ * \brief  NIC-session benchmark
+ * \author Genode Labs
+ * \date   2013-03-06
+ *
+ * The benchmark transmits packets while keeping a configurable number of
+ * packets in flight and reports the packet rate and throughput. When
+ * connected to 'nic_loopback', each packet is expected to come back at the
+ * rx channel. When connected to a NIC driver, only the transmitted packets
+ * are accounted and incoming packets are merely counted.
+ *
+ * With more than one client, the benchmark opens a session per client.
+ * Each client addresses its frames to the MAC address of the next client.
+ * So, when connected to 'nic_bridge', the clients exchange traffic through
+ * the bridge. Echoed frames that do not arrive, e.g., because the bridge
+ * dropped them, are reported as lost.
+ *
+ * Configuration:
+ *
+ * :packet_size: number of bytes per packet, by default, the benchmark is
+ *               run for 64, 512, and 1514 bytes
+ * :packets:     number of packets per run and client (default 100000)
+ * :in_flight:   maximum number of packets in flight per client (default 64)
+ * :echo:        expect packets to come back (default yes)
+ * :clients:     number of sessions (default 1)
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/signal.h>
+#include <base/sleep.h>
+#include <nic_session/connection.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+using namespace Genode;
+
+
+enum {
+	MAX_IN_FLIGHT   = 128,
+	MAX_PACKET_SIZE = 1514,
+	MAX_CLIENTS     = 16,
+	ETH_HEADER_SIZE = 14,
+	ETH_TYPE        = 0x88b5,  /* local experimental ethertype */
+	MAX_IDLE_MS     = 500,     /* time to wait for missing echoes */
+};
+
+
+struct Bench_config
+{
+	size_t   packet_size;  /* 0 if not configured */
+	unsigned packets;
+	unsigned in_flight;
+	bool     echo;
+	unsigned clients;
+
+	Bench_config()
+	: packet_size(0), packets(100000), in_flight(64), echo(true), clients(1)
+	{
+		try {
+			Xml_node config = Genode::config()->xml_node();
+
+			try { config.attribute("packet_size").value(&packet_size); } catch (...) { }
+			try { config.attribute("packets").value(&packets);         } catch (...) { }
+			try { config.attribute("in_flight").value(&in_flight);     } catch (...) { }
+			try { echo = config.attribute("echo").has_value("yes");    } catch (...) { }
+			try { config.attribute("clients").value(&clients);         } catch (...) { }
+		} catch (...) { }
+
+		if (packet_size)
+			packet_size = max((size_t)ETH_HEADER_SIZE,
+			                  min(packet_size, (size_t)MAX_PACKET_SIZE));
+
+		/* stay below the queue sizes of the session */
+		in_flight = max(1U, min(in_flight, (unsigned)MAX_IN_FLIGHT));
+		clients   = max(1U, min(clients,   (unsigned)MAX_CLIENTS));
+	}
+};
+
+
+struct Client
+{
+	Allocator_avl    tx_alloc;
+	Nic::Connection  nic;
+	Nic::Mac_address mac;
+
+	Signal_context tx_ready_to_submit, tx_ack_avail,
+	               rx_ready_to_ack, rx_packet_avail;
+
+	unsigned submitted, acked, received;
+
+	Client(size_t buf_size, Signal_receiver &sig_rec)
+	:
+		tx_alloc(env()->heap()), nic(&tx_alloc, buf_size, buf_size),
+		mac(nic.mac_address())
+	{
+		nic.tx_channel()->sigh_ready_to_submit(sig_rec.manage(&tx_ready_to_submit));
+		nic.tx_channel()->sigh_ack_avail      (sig_rec.manage(&tx_ack_avail));
+		nic.rx_channel()->sigh_ready_to_ack   (sig_rec.manage(&rx_ready_to_ack));
+		nic.rx_channel()->sigh_packet_avail   (sig_rec.manage(&rx_packet_avail));
+	}
+};
+
+
+/**
+ * Write ethernet header addressed from 'src' to 'dst'
+ */
+static void write_header(char *frame, Nic::Mac_address const &dst,
+                         Nic::Mac_address const &src)
+{
+	memcpy(frame,     dst.addr, sizeof(dst.addr));
+	memcpy(frame + 6, src.addr, sizeof(src.addr));
+	frame[12] = ETH_TYPE >> 8;
+	frame[13] = ETH_TYPE & 0xff;
+}
+
+
+static void bench(Client **clients, Signal_receiver &sig_rec,
+                  Timer::Session &timer, Bench_config const &cfg,
+                  size_t packet_size)
+{
+	typedef Packet_descriptor Packet;
+
+	unsigned const num_clients = cfg.clients;
+	unsigned const total       = cfg.packets*num_clients;
+
+	unsigned total_submitted = 0, total_acked = 0, total_received = 0, lost = 0;
+	for (unsigned i = 0; i < num_clients; i++)
+		clients[i]->submitted = clients[i]->acked = clients[i]->received = 0;
+
+	unsigned long idle_ms = 0;
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	while (total_acked < total || (cfg.echo && total_received + lost < total)) {
+
+		bool progress = false;
+
+		for (unsigned i = 0; i < num_clients; i++) {
+
+			Client &c = *clients[i];
+			Nic::Mac_address const &dst = clients[(i + 1) % num_clients]->mac;
+
+			Nic::Session::Tx::Source &tx = *c.nic.tx();
+			Nic::Session::Rx::Sink   &rx = *c.nic.rx();
+
+			Packet   packets[MAX_IN_FLIGHT];
+			unsigned num = 0;
+
+			/*
+			 * A packet is in flight until acknowledged, or echoed. Echoes
+			 * may arrive at another client, hence they are accounted for
+			 * all clients together.
+			 */
+			for (; c.submitted + num < cfg.packets
+			    && c.submitted + num - c.acked < cfg.in_flight
+			    && (!cfg.echo || total_submitted + num - total_received - lost
+			                     < cfg.in_flight*num_clients); num++) {
+				try { packets[num] = tx.alloc_packet(packet_size); }
+				catch (Nic::Session::Tx::Source::Packet_alloc_failed) { break; }
+
+				write_header(tx.packet_content(packets[num]), dst, c.mac);
+			}
+
+			if (num) {
+				tx.submit_packets(packets, num);
+				c.submitted     += num;
+				total_submitted += num;
+				progress = true;
+			}
+
+			/* collect acknowledgements */
+			while (tx.ack_avail()) {
+				unsigned const n = tx.get_acked_packets(packets, MAX_IN_FLIGHT);
+				for (unsigned j = 0; j < n; j++)
+					tx.release_packet(packets[j]);
+				c.acked     += n;
+				total_acked += n;
+				progress = true;
+			}
+
+			/* consume incoming packets */
+			while (rx.packet_avail()) {
+				unsigned const n = rx.get_packets(packets, MAX_IN_FLIGHT);
+				rx.acknowledge_packets(packets, n);
+				c.received     += n;
+				total_received += n;
+				progress = true;
+			}
+		}
+
+		if (progress) {
+			idle_ms = 0;
+			continue;
+		}
+
+		/* acknowledgements are always delivered, echoes may get dropped */
+		if (total_acked < total_submitted) {
+			sig_rec.wait_for_signal();
+			continue;
+		}
+
+		if (idle_ms >= MAX_IDLE_MS) {
+			lost = total_submitted - total_received;
+			continue;
+		}
+
+		timer.msleep(10);
+		idle_ms += 10;
+	}
+
+	unsigned long const ms = max(1UL, timer.elapsed_ms() - start_ms - idle_ms);
+
+	unsigned long long const bytes = (unsigned long long)total_acked*packet_size;
+
+	printf("%zu bytes: %u packets in %lu ms, %u received, %u lost\n",
+	       packet_size, total_acked, ms, total_received, lost);
+	printf("%zu bytes: %lu packets/s, %lu KiB/s\n", packet_size,
+	       (unsigned long)((unsigned long long)total_acked*1000/ms),
+	       (unsigned long)(bytes*1000/1024/ms));
+}
+
+
+int main(int, char **)
+{
+	printf("--- NIC benchmark ---\n");
+
+	Bench_config cfg;
+
+	static Timer::Connection timer;
+	static Signal_receiver   sig_rec;
+
+	/* both communication buffers hold all packets in flight twice */
+	size_t const buf_size = max((size_t)64*1024,
+	                            (size_t)2*cfg.in_flight*(MAX_PACKET_SIZE + 2));
+
+	Client *clients[MAX_CLIENTS];
+	for (unsigned i = 0; i < cfg.clients; i++)
+		clients[i] = new (env()->heap()) Client(buf_size, sig_rec);
+
+	printf("%u clients, %u packets, %u in flight, echo %s\n",
+	       cfg.clients, cfg.packets, cfg.in_flight, cfg.echo ? "yes" : "no");
+
+	if (cfg.packet_size)
+		bench(clients, sig_rec, timer, cfg, cfg.packet_size);
+	else {
+		static size_t const sizes[] = { 64, 512, 1514 };
+		for (unsigned i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+			bench(clients, sig_rec, timer, cfg, sizes[i]);
+	}
+
+	printf("--- end of NIC benchmark ---\n");
+	sleep_forever();
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET = test-nic_bench
+LIBS   = env cxx signal
+SRC_CC = main.cc
@@ -0,0 +1,205 @@
+/*
+ * \brief  Test for the recovery of a NIC session from an exhausted rx buffer
+ * \author Genode Labs
+ * \date   2013-03-06
+ *
+ * A driver generates frames continuously and drops them while the rx buffer
+ * of the session is exhausted, like the Linux NIC driver does. The client
+ * holds all received packets until the driver drops frames. Once the client
+ * acknowledged the held packets, it expects to receive frames again.
+ *
+ * The test serves the NIC session component locally, so no driver and no
+ * routing are involved.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/sleep.h>
+#include <cap_session/connection.h>
+#include <nic/component.h>
+#include <nic_session/client.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+enum {
+	FRAME_SIZE  = 1000,
+	MAX_HELD    = Nic::Session::RX_QUEUE_SIZE,
+	TIMEOUT_MS  = 1000,
+};
+
+
+/**
+ * Driver that generates a frame each millisecond
+ */
+class Generator_driver : public Nic::Driver, Thread<8192>
+{
+	private:
+
+		Nic::Rx_buffer_alloc &_alloc;
+		Timer::Connection     _timer;
+		unsigned long         _seq;
+
+	public:
+
+		unsigned long volatile drops;
+
+		Generator_driver(Nic::Rx_buffer_alloc &alloc)
+		:
+			Thread<8192>("generator"), _alloc(alloc), _seq(0), drops(0)
+		{
+			start();
+		}
+
+		void entry()
+		{
+			for (;; _timer.msleep(1)) {
+
+				char *dst = 0;
+				try { dst = (char *)_alloc.alloc(FRAME_SIZE); }
+				catch (Nic::Session::Rx::Source::Packet_alloc_failed) {
+					drops++;
+					continue;
+				}
+
+				memset(dst, 0, FRAME_SIZE);
+				*(unsigned long *)dst = ++_seq;
+				_alloc.submit();
+			}
+		}
+
+
+		/***************************
+		 ** Nic::Driver interface **
+		 ***************************/
+
+		Nic::Mac_address mac_address()
+		{
+			Nic::Mac_address mac;
+			memset(mac.addr, 0x02, sizeof(mac.addr));
+			return mac;
+		}
+
+		void tx(char const *, size_t) { }
+
+
+		/******************************
+		 ** Irq_activation interface **
+		 ******************************/
+
+		void handle_irq(int) { }
+};
+
+
+static Generator_driver *driver;
+
+
+struct Generator_driver_factory : Nic::Driver_factory
+{
+	Nic::Driver *create(Nic::Rx_buffer_alloc &alloc) {
+		return driver = new (env()->heap()) Generator_driver(alloc); }
+
+	void destroy(Nic::Driver *) { }
+};
+
+
+/**
+ * Receive packets until the driver drops frames and hold them
+ *
+ * \return  number of held packets
+ */
+static unsigned fill_rx_buffer(Nic::Session_client &nic, Timer::Session &timer,
+                               Packet_descriptor *held)
+{
+	unsigned long const drops = driver->drops;
+	unsigned num_held = 0;
+
+	/* once a frame is dropped, all buffers are submitted */
+	while ((driver->drops == drops || nic.rx()->packet_avail())
+	    && num_held < MAX_HELD) {
+
+		while (nic.rx()->packet_avail() && num_held < MAX_HELD)
+			held[num_held++] = nic.rx()->get_packet();
+
+		timer.msleep(10);
+	}
+	return num_held;
+}
+
+
+/**
+ * Wait for packets after acknowledging the held packets
+ *
+ * \return  number of packets received within the timeout
+ */
+static unsigned receive(Nic::Session_client &nic, Timer::Session &timer,
+                        unsigned num_expected)
+{
+	unsigned num = 0;
+
+	for (unsigned ms = 0; ms < TIMEOUT_MS && num < num_expected; ms += 10) {
+
+		while (nic.rx()->packet_avail() && nic.rx()->ready_to_ack()
+		    && num < num_expected) {
+			nic.rx()->acknowledge_packet(nic.rx()->get_packet());
+			num++;
+		}
+
+		timer.msleep(10);
+	}
+	return num;
+}
+
+
+int main(int, char **)
+{
+	printf("--- NIC rx resume test ---\n");
+
+	static Timer::Connection timer;
+
+	enum { STACK_SIZE = 8192 };
+	static Cap_connection cap;
+	static Rpc_entrypoint ep(&cap, STACK_SIZE, "nic_ep");
+
+	static Generator_driver_factory driver_factory;
+
+	enum { BUF_SIZE = 64*1024 };
+	static Nic::Session_component session(BUF_SIZE, BUF_SIZE, driver_factory, ep,
+	                                      Nic::Session::TX_QUEUE_SIZE,
+	                                      Nic::Session::RX_QUEUE_SIZE);
+
+	static Allocator_avl tx_block_alloc(env()->heap());
+	static Nic::Session_client nic(ep.manage(&session), &tx_block_alloc);
+
+	static Packet_descriptor held[MAX_HELD];
+
+	for (unsigned round = 0; round < 3; round++) {
+
+		unsigned const num_held = fill_rx_buffer(nic, timer, held);
+		printf("round %u: holding %u packets, %lu frames dropped\n",
+		       round, num_held, driver->drops);
+
+		for (unsigned i = 0; i < num_held; i++)
+			nic.rx()->acknowledge_packet(held[i]);
+
+		/* the whole buffer must be reusable */
+		unsigned const num = receive(nic, timer, 2*num_held);
+		if (num < 2*num_held) {
+			PERR("received %u of %u packets after acknowledging the held ones",
+			     num, 2*num_held);
+			return -1;
+		}
+	}
+
+	printf("--- NIC rx resume test finished ---\n");
+	sleep_forever();
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET = test-nic_rx_resume
+LIBS   = env cxx server signal
+SRC_CC = main.cc
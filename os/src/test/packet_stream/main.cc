@@ -2,10 +2,13 @@
  * \brief  Test for the packet-streaming interface
  * \author Norman Feske
  * \date   2009-11-11
+ *
+ * Besides testing the flow control, the test measures the packet
+ * throughput for different batch sizes.
  */
 
 /*
- * Copyright (C) 2009-2012 Genode Labs GmbH
+ * Copyright (C) 2009-2013 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU General Public License version 2.
@@ -295,6 +298,148 @@ void test_2_flood_submit(Timer::Session *timer, Source *source, Sink *sink)
 }
 
 
+/**
+ * Source of the throughput test
+ *
+ * The source keeps a fixed set of packets in flight and resubmits each
+ * acknowledged packet. The number of packets in flight stays below the
+ * capacity of the submit and acknowledgement queues.
+ */
+class Bench_source : private Genode::Thread<STACK_SIZE>,
+                     private Genode::Allocator_avl,
+                     public  Packet_stream_source<>
+{
+	public:
+
+		enum { MAX_BATCH = 32, MAX_IN_FLIGHT = 48, PACKET_SIZE = 64 };
+
+	private:
+
+		unsigned      const _batch;
+		unsigned long const _total;
+
+		Packet_descriptor _free[MAX_IN_FLIGHT];
+		unsigned          _num_free;
+
+		void entry()
+		{
+			unsigned long submitted = 0, acked = 0;
+
+			while (acked < _total) {
+
+				unsigned const n = Genode::min((unsigned long)Genode::min(_batch, _num_free),
+				                               _total - submitted);
+				if (n) {
+					submit_packets(&_free[_num_free - n], n);
+					_num_free -= n;
+					submitted += n;
+				}
+
+				/* block for acknowledgements only if no packet can be submitted */
+				if (n && !ack_avail())
+					continue;
+
+				unsigned const num_acked =
+					get_acked_packets(&_free[_num_free], MAX_IN_FLIGHT - _num_free);
+
+				_num_free += num_acked;
+				acked     += num_acked;
+			}
+		}
+
+	public:
+
+		Bench_source(Genode::Dataspace_capability ds_cap,
+		             unsigned batch, unsigned long total)
+		:
+			Genode::Allocator_avl(Genode::env()->heap()),
+			Packet_stream_source<>(this, ds_cap),
+			_batch(batch), _total(total), _num_free(0)
+		{
+			for (; _num_free < MAX_IN_FLIGHT; _num_free++)
+				_free[_num_free] = alloc_packet(PACKET_SIZE);
+		}
+
+		~Bench_source()
+		{
+			for (unsigned i = 0; i < _num_free; i++)
+				release_packet(_free[i]);
+		}
+
+		void run()    { start(); }
+		void finish() { join(); }
+};
+
+
+/**
+ * Sink of the throughput test, acknowledging each packet immediately
+ */
+class Bench_sink : private Genode::Thread<STACK_SIZE>,
+                   public  Packet_stream_sink<>
+{
+	private:
+
+		unsigned      const _batch;
+		unsigned long const _total;
+
+		void entry()
+		{
+			Packet_descriptor packets[Bench_source::MAX_BATCH];
+
+			for (unsigned long received = 0; received < _total; ) {
+				unsigned const n = get_packets(packets, _batch);
+				acknowledge_packets(packets, n);
+				received += n;
+			}
+		}
+
+	public:
+
+		Bench_sink(Genode::Dataspace_capability ds_cap,
+		           unsigned batch, unsigned long total)
+		:
+			Packet_stream_sink<>(ds_cap), _batch(batch), _total(total)
+		{ }
+
+		void run()    { start(); }
+		void finish() { join(); }
+};
+
+
+void test_3_throughput(Timer::Session *timer, unsigned batch)
+{
+	using namespace Genode;
+
+	enum { TRANSPORT_DS_SIZE = 64*1024, PACKETS = 200*1000 };
+	Dataspace_capability ds_cap = env()->ram_session()->alloc(TRANSPORT_DS_SIZE);
+
+	{
+		Bench_source source(ds_cap, batch, PACKETS);
+		Bench_sink   sink(ds_cap, batch, PACKETS);
+
+		source.register_sigh_packet_avail(sink.sigh_packet_avail());
+		source.register_sigh_ready_to_ack(sink.sigh_ready_to_ack());
+		sink.register_sigh_ready_to_submit(source.sigh_ready_to_submit());
+		sink.register_sigh_ack_avail(source.sigh_ack_avail());
+
+		unsigned long const start_ms = timer->elapsed_ms();
+
+		sink.run();
+		source.run();
+		source.finish();
+		sink.finish();
+
+		unsigned long const duration_ms = timer->elapsed_ms() - start_ms;
+
+		printf("batch %2u: %u packets in %lu ms -> %lu packets/s\n",
+		       batch, (unsigned)PACKETS, duration_ms,
+		       duration_ms ? (PACKETS*1000UL)/duration_ms : 0);
+	}
+
+	env()->ram_session()->free(static_cap_cast<Ram_dataspace>(ds_cap));
+}
+
+
 using namespace Genode;
 
 int main(int, char **)
@@ -326,6 +471,11 @@ int main(int, char **)
 	printf("waiting to settle down\n");
 	timer.msleep(2*1000);
 
+	printf("\n-- test 3: throughput --\n");
+	unsigned const batch_sizes[] = { 1, 8, 32 };
+	for (unsigned i = 0; i < sizeof(batch_sizes)/sizeof(batch_sizes[0]); i++)
+		test_3_throughput(&timer, batch_sizes[i]);
+
 	printf("--- end of packet stream test ---\n");
 	return 0;
 }
@@ -0,0 +1,156 @@
+/*
+ * \brief  File-system metadata benchmark
+ * \author Genode Labs
+ * \date   2013-03-08
+ *
+ * The benchmark creates a large number of files in one directory, looks up
+ * the status of each file by its path, reads the directory, and unlinks all
+ * files. Each operation resolves the directory path first, like the libc
+ * back end does for 'open' and 'unlink'.
+ *
+ * Configuration:
+ *
+ * :files: number of files (default 10000)
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <base/allocator_avl.h>
+#include <base/printf.h>
+#include <base/snprintf.h>
+#include <base/sleep.h>
+#include <file_system_session/connection.h>
+#include <os/config.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+using namespace File_system;
+
+
+static char const *dir_path = "/bench";
+
+
+template <typename HANDLE>
+struct Handle_guard
+{
+	File_system::Session &fs;
+	HANDLE                handle;
+
+	Handle_guard(File_system::Session &fs, HANDLE handle) : fs(fs), handle(handle) { }
+
+	~Handle_guard() { fs.close(handle); }
+};
+
+
+struct File_name
+{
+	char buf[32];
+
+	File_name(unsigned i) { snprintf(buf, sizeof(buf), "file-%u", i); }
+};
+
+
+static void create(File_system::Session &fs, unsigned i)
+{
+	Handle_guard<Dir_handle> dir(fs, fs.dir(dir_path, false));
+	fs.close(fs.file(dir.handle, File_name(i).buf, READ_WRITE, true));
+}
+
+
+static void stat(File_system::Session &fs, unsigned i)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "%s/%s", dir_path, File_name(i).buf);
+
+	Handle_guard<Node_handle> node(fs, fs.node(path));
+	fs.status(node.handle);
+}
+
+
+static void unlink(File_system::Session &fs, unsigned i)
+{
+	Handle_guard<Dir_handle> dir(fs, fs.dir(dir_path, false));
+	fs.unlink(dir.handle, File_name(i).buf);
+}
+
+
+/**
+ * Read all entries of the directory
+ *
+ * \return  number of entries
+ */
+static unsigned readdir(File_system::Session &fs)
+{
+	Handle_guard<Dir_handle> dir(fs, fs.dir(dir_path, false));
+
+	File_system::Session::Tx::Source &source = *fs.tx();
+
+	unsigned n = 0;
+	for (;; n++) {
+		typedef File_system::Packet_descriptor Packet;
+
+		Packet p(source.alloc_packet(sizeof(Directory_entry)), 0,
+		         dir.handle, Packet::READ,
+		         sizeof(Directory_entry), n*sizeof(Directory_entry));
+		source.submit_packet(p);
+		p = source.get_acked_packet();
+		source.release_packet(p);
+
+		if (p.length() != sizeof(Directory_entry))
+			return n;
+	}
+}
+
+
+static void report(char const *phase, unsigned ops, unsigned long ms)
+{
+	ms = max(1UL, ms);
+	printf("%-8s %u operations in %lu ms, %lu operations/s\n",
+	       phase, ops, ms, (unsigned long)((unsigned long long)ops*1000/ms));
+}
+
+
+int main(int, char **)
+{
+	printf("--- file-system metadata benchmark ---\n");
+
+	unsigned files = 10000;
+	try { config()->xml_node().attribute("files").value(&files); } catch (...) { }
+
+	static Timer::Connection timer;
+	static Allocator_avl tx_alloc(env()->heap());
+	static File_system::Connection fs(tx_alloc, 64*1024);
+
+	fs.close(fs.dir(dir_path, true));
+
+	unsigned long t = timer.elapsed_ms();
+	for (unsigned i = 0; i < files; i++)
+		create(fs, i);
+	report("create", files, timer.elapsed_ms() - t);
+
+	t = timer.elapsed_ms();
+	for (unsigned i = 0; i < files; i++)
+		stat(fs, i);
+	report("stat", files, timer.elapsed_ms() - t);
+
+	t = timer.elapsed_ms();
+	unsigned const entries = readdir(fs);
+	report("readdir", entries, timer.elapsed_ms() - t);
+
+	if (entries != files)
+		PERR("read %u directory entries, expected %u", entries, files);
+
+	t = timer.elapsed_ms();
+	for (unsigned i = 0; i < files; i++)
+		unlink(fs, i);
+	report("unlink", files, timer.elapsed_ms() - t);
+
+	printf("--- end of file-system metadata benchmark ---\n");
+	sleep_forever();
+	return 0;
+}
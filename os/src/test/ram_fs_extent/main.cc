@@ -0,0 +1,192 @@
+/*
+ * \brief  Unit test for the extent map used by RAM fs
+ * \author Genode Labs
+ * \date   2013-03-09
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/printf.h>
+
+/* local 'ram_fs' include */
+#include <extent.h>
+
+
+namespace Genode {
+
+	struct Allocator_tracer : Allocator
+	{
+		size_t     _sum;
+		Allocator &_wrapped;
+
+		Allocator_tracer(Allocator &wrapped) : _sum(0), _wrapped(wrapped) { }
+
+		size_t sum() const { return _sum; }
+
+		bool alloc(size_t size, void **out_addr)
+		{
+			_sum += size;
+			return _wrapped.alloc(size, out_addr);
+		}
+
+		void free(void *addr, size_t size)
+		{
+			_sum -= size;
+			_wrapped.free(addr, size);
+		}
+
+		size_t overhead(size_t size) { return 0; }
+	};
+};
+
+
+using namespace File_system;
+using namespace Genode;
+
+
+enum { MAX_FILE_SIZE = 256*1024 };
+
+static char read_buf[MAX_FILE_SIZE];
+
+
+/**
+ * File consisting of an extent map and its size
+ */
+struct File
+{
+	Extent_map  map;
+	file_size_t size;
+
+	File(Allocator &alloc) : map(alloc), size(0) { }
+};
+
+
+static void dump_extents(File &file)
+{
+	for (unsigned i = 0; i < file.map.num_extents(); i++) {
+		Extent_map::Extent_info const e = file.map.extent_info(i);
+		printf("  extent at %lu, size %zd, used %zd, %s\n",
+		       (unsigned long)e.offset, e.size, e.used,
+		       e.dataspace ? "dataspace" : "heap");
+	}
+}
+
+
+/**
+ * Print content, zeros are printed as dots, longer runs of zeros as count
+ */
+static void dump(File &file)
+{
+	file.map.read(read_buf, file.size, 0);
+
+	printf("content (size=%zd): \"", (size_t)file.size);
+	for (size_t i = 0; i < file.size; ) {
+
+		size_t zeros = 0;
+		for (; i + zeros < file.size && !read_buf[i + zeros]; zeros++);
+
+		if (zeros > 16) {
+			printf("<%zd zeros>", zeros);
+			i += zeros;
+			continue;
+		}
+
+		char const c = read_buf[i++];
+		if (c)
+			printf("%c", c);
+		else
+			printf(".");
+	}
+	printf("\"\n");
+	dump_extents(file);
+}
+
+
+static void write(File &file, char const *str, seek_off_t seek_offset)
+{
+	printf("write \"%s\" at offset %lu -> ", str, (unsigned long)seek_offset);
+
+	size_t const len = strlen(str);
+	if (file.map.write(str, len, seek_offset) != len)
+		printf("write failed\n");
+
+	file.size = max(file.size, (file_size_t)(seek_offset + len));
+	dump(file);
+}
+
+
+static void truncate(File &file, file_size_t size)
+{
+	printf("trunc(%zd) -> ", (size_t)size);
+	file.map.truncate(size);
+	file.size = size;
+	dump(file);
+}
+
+
+int main(int, char **)
+{
+	printf("--- ram_fs_extent test ---\n");
+
+	static Allocator_tracer alloc(*env()->heap());
+
+	{
+		File file(alloc);
+
+		write(file, "five-o-one", 0);
+
+		/* overwrite part of the file */
+		write(file, "five", 7);
+
+		/* write beyond the used part of the extent */
+		write(file, "Nuance", 17);
+
+		/* write beyond the extent, leaving a hole */
+		write(file, "YM-2149", 8192);
+
+		/* fill part of the hole */
+		write(file, "C64", 5000);
+
+		/* truncated content must not reappear when the file grows */
+		truncate(file, 20);
+		write(file, "SID", 30);
+		truncate(file, 40);
+		truncate(file, 3);
+		write(file, "e", 5);
+	}
+
+	{
+		File file(alloc);
+
+		/* extents of a sequentially written file double in size */
+		printf("write %d KiB sequentially\n", MAX_FILE_SIZE / 1024);
+
+		static char buf[4096];
+		for (file_size_t offset = 0; offset < MAX_FILE_SIZE; offset += sizeof(buf)) {
+			memset(buf, 'a' + (offset / sizeof(buf)) % 26, sizeof(buf));
+			file.map.write(buf, sizeof(buf), offset);
+		}
+		file.size = MAX_FILE_SIZE;
+		dump_extents(file);
+
+		file.map.read(read_buf, MAX_FILE_SIZE, 0);
+
+		bool ok = true;
+		for (size_t i = 0; i < MAX_FILE_SIZE; i++)
+			if (read_buf[i] != 'a' + (char)((i / sizeof(buf)) % 26))
+				ok = false;
+
+		printf("content %s\n", ok ? "ok" : "corrupted");
+	}
+
+	printf("allocator: sum=%zd\n", alloc.sum());
+
+	return 0;
+}
@@ -1,4 +1,4 @@
-TARGET   = test-ram_fs_chunk
+TARGET   = test-ram_fs_extent
 SRC_CC   = main.cc
 INC_DIR += $(REP_DIR)/src/server/ram_fs
 LIBS     = env
@@ -0,0 +1,172 @@
+/*
+ * \brief  Test for the throughput of a multi-threaded RPC entrypoint
+ * \author Genode Labs
+ * \date   2013-02-04
+ *
+ * A number of client threads issue CPU-bound RPC calls to an entrypoint
+ * pool, each client to a separate RPC object. The test reports the overall
+ * number of calls per second for an increasing number of clients, using a
+ * single-threaded pool first and a pool with several threads second.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/thread.h>
+#include <base/rpc_server.h>
+#include <base/rpc_client.h>
+#include <cap_session/connection.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+/***************
+ ** Interface **
+ ***************/
+
+namespace Test {
+
+	struct Work
+	{
+		virtual ~Work() { }
+
+		virtual unsigned long compute(unsigned long seed) = 0;
+
+		GENODE_RPC(Rpc_compute, unsigned long, compute, unsigned long);
+		GENODE_RPC_INTERFACE(Rpc_compute);
+	};
+
+
+	struct Work_client : Rpc_client<Work>
+	{
+		Work_client(Capability<Work> cap) : Rpc_client<Work>(cap) { }
+
+		unsigned long compute(unsigned long seed) {
+			return call<Rpc_compute>(seed); }
+	};
+
+
+	struct Work_component : Rpc_object<Work, Work_component>
+	{
+		enum { ITERATIONS = 20*1000 };
+
+		/**
+		 * Simulate CPU-bound request processing
+		 */
+		static unsigned long work(unsigned long seed)
+		{
+			unsigned long volatile value = seed;
+			for (unsigned i = 0; i < ITERATIONS; i++)
+				value = value*1103515245 + 12345;
+
+			return value;
+		}
+
+		unsigned long compute(unsigned long seed) { return work(seed); }
+	};
+}
+
+
+enum { STACK_SIZE = 8*1024, MAX_CLIENTS = 8, CALLS_PER_CLIENT = 2000 };
+
+
+struct Client : Thread<STACK_SIZE>
+{
+	Test::Work_client  client;
+	Lock              &barrier;
+	bool               failed;
+
+	Client(Capability<Test::Work> cap, Lock &barrier)
+	:
+		client(cap), barrier(barrier), failed(false)
+	{
+		start();
+	}
+
+	void entry()
+	{
+		/* wait until all clients are up */
+		barrier.lock();
+		barrier.unlock();
+
+		for (unsigned long i = 0; i < CALLS_PER_CLIENT; i++)
+			if (client.compute(i) != Test::Work_component::work(i))
+				failed = true;
+
+	}
+};
+
+
+/**
+ * Measure call rate of 'num_clients' concurrent clients
+ *
+ * \return  false if a client observed a wrong result
+ */
+static bool measure(Timer::Session &timer, Rpc_entrypoint_pool &ep,
+                    unsigned num_clients)
+{
+	static Test::Work_component component[MAX_CLIENTS];
+	Client *client[MAX_CLIENTS];
+
+	Lock barrier(Lock::LOCKED);
+
+	for (unsigned i = 0; i < num_clients; i++)
+		client[i] = new (env()->heap())
+			Client(ep.manage(&component[i]), barrier);
+
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	barrier.unlock();
+
+	bool ok = true;
+	for (unsigned i = 0; i < num_clients; i++) {
+		client[i]->join();
+		ok = ok && !client[i]->failed;
+	}
+
+	unsigned long const duration_ms = timer.elapsed_ms() - start_ms;
+	unsigned long const calls       = num_clients*CALLS_PER_CLIENT;
+
+	printf("threads=%u clients=%u: %lu calls in %lu ms -> %lu calls/s\n",
+	       ep.num_threads(), num_clients, calls, duration_ms,
+	       duration_ms ? (calls*1000)/duration_ms : 0);
+
+	for (unsigned i = 0; i < num_clients; i++) {
+		ep.dissolve(&component[i]);
+		destroy(env()->heap(), client[i]);
+	}
+
+	return ok;
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- RPC entrypoint pool test ---\n");
+
+	static Cap_connection    cap;
+	static Timer::Connection timer;
+
+	unsigned const num_threads[] = { 1, 4 };
+
+	for (unsigned i = 0; i < sizeof(num_threads)/sizeof(num_threads[0]); i++) {
+
+		Rpc_entrypoint_pool ep(&cap, STACK_SIZE, "pool_ep", num_threads[i]);
+
+		for (unsigned num_clients = 1; num_clients <= MAX_CLIENTS; num_clients *= 2)
+			if (!measure(timer, ep, num_clients)) {
+				PERR("client received wrong result");
+				return -1;
+			}
+	}
+
+	printf("--- finished RPC entrypoint pool test ---\n");
+	return 0;
+}
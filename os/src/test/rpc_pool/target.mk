@@ -0,0 +1,3 @@
+TARGET = test-rpc_pool
+SRC_CC = main.cc
+LIBS   = cxx env server
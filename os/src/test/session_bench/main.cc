@@ -0,0 +1,113 @@
+/*
+ * \brief  Benchmark for the rate of opening and closing sessions
+ * \author Genode Labs
+ * \date   2013-02-27
+ *
+ * A trivial root interface allocates its session objects from a sliced heap.
+ * The test opens and closes sessions at the root, first with a sliced heap
+ * without cache and second with a sliced heap that keeps the dataspaces of
+ * closed sessions for reuse.
+ */
+
+/*
+ * Copyright (C) 2013 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+/* Genode includes */
+#include <base/printf.h>
+#include <base/heap.h>
+#include <base/rpc_server.h>
+#include <root/component.h>
+#include <root/client.h>
+#include <cap_session/connection.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+
+namespace Test {
+
+	struct Session : Genode::Session
+	{
+		static const char *service_name() { return "Test"; }
+
+		virtual void nop() = 0;
+
+		GENODE_RPC(Rpc_nop, void, nop);
+		GENODE_RPC_INTERFACE(Rpc_nop);
+	};
+
+
+	struct Session_component : Rpc_object<Session>
+	{
+		void nop() { }
+	};
+
+
+	struct Root_component : Genode::Root_component<Session_component>
+	{
+		Session_component *_create_session(const char *) {
+			return new (md_alloc()) Session_component(); }
+
+		Root_component(Rpc_entrypoint *ep, Allocator *md_alloc)
+		: Genode::Root_component<Session_component>(ep, md_alloc) { }
+	};
+}
+
+
+enum { STACK_SIZE = 8*1024, SESSIONS = 1000, OPEN_AT_ONCE = 4 };
+
+
+/**
+ * Measure rate of session creation and destruction
+ */
+static void measure(Timer::Session &timer, Cap_session &cap, char const *name,
+                    size_t cache_limit)
+{
+	Rpc_entrypoint ep(&cap, STACK_SIZE, "bench_ep");
+
+	Sliced_heap            sliced_heap(env()->ram_session(), env()->rm_session(),
+	                                   cache_limit);
+	Test::Root_component   root(&ep, &sliced_heap);
+	Root_client            root_client(ep.manage(&root));
+
+	char const *args = "ram_quota=16K";
+
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	for (unsigned i = 0; i < SESSIONS; i += OPEN_AT_ONCE) {
+
+		Session_capability sessions[OPEN_AT_ONCE];
+
+		for (unsigned j = 0; j < OPEN_AT_ONCE; j++)
+			sessions[j] = root_client.session(args);
+
+		for (unsigned j = 0; j < OPEN_AT_ONCE; j++)
+			root_client.close(sessions[j]);
+	}
+
+	unsigned long const duration_ms = timer.elapsed_ms() - start_ms;
+
+	printf("%s: %u sessions in %lu ms -> %lu sessions/s\n", name, SESSIONS,
+	       duration_ms, duration_ms ? (SESSIONS*1000UL)/duration_ms : 0);
+
+	ep.dissolve(&root);
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- session benchmark ---\n");
+
+	static Cap_connection    cap;
+	static Timer::Connection timer;
+
+	measure(timer, cap, "uncached", 0);
+	measure(timer, cap, "cached",   64*1024);
+
+	printf("--- finished session benchmark ---\n");
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET = test-session_bench
+SRC_CC = main.cc
+LIBS   = cxx env server
@@ -476,6 +476,66 @@ static void lazy_receivers_test()
 }
 
 
+/**
+ * Measure the costs of signal delivery depending on the number of contexts
+ *
+ * All contexts of the receiver are made pending before the signals are
+ * picked up. The costs per signal should not depend on the number of
+ * contexts.
+ */
+static void delivery_cost_test()
+{
+	enum { MAX_CONTEXTS = 512, SIGNALS = 4096 };
+
+	printf("\n");
+	printf("TEST %d: signal-delivery costs with many contexts\n", ++test_cnt);
+	printf("\n");
+
+	static Signal_context     contexts[MAX_CONTEXTS];
+	static Signal_transmitter transmitters[MAX_CONTEXTS];
+
+	unsigned const num_contexts[] = { 1, 16, 128, MAX_CONTEXTS };
+
+	for (unsigned i = 0; i < sizeof(num_contexts)/sizeof(num_contexts[0]); i++) {
+
+		unsigned const n = num_contexts[i];
+
+		Signal_receiver receiver;
+		for (unsigned j = 0; j < n; j++)
+			transmitters[j].context(receiver.manage(&contexts[j]));
+
+		for (int batched = 0; batched < 2; batched++) {
+
+			static Signal signals[MAX_CONTEXTS];
+
+			unsigned long const start_ms = timer.elapsed_ms();
+
+			for (unsigned round = 0; round < SIGNALS / n; round++) {
+				for (unsigned j = 0; j < n; j++)
+					transmitters[j].submit();
+
+				if (batched)
+					for (unsigned j = 0; j < n; )
+						j += receiver.wait_for_signals(signals, MAX_CONTEXTS);
+				else
+					for (unsigned j = 0; j < n; j++)
+						receiver.wait_for_signal();
+			}
+
+			unsigned long const ms = max(1UL, timer.elapsed_ms() - start_ms);
+
+			printf("%3u contexts, %s: %d signals in %lu ms (%lu signals per second)\n",
+			       n, batched ? "batched" : "single ", SIGNALS, ms,
+			       SIGNALS*1000UL/ms);
+		}
+
+		/* the destructor of the receiver dissolves the contexts */
+	}
+
+	printf("TEST %d FINISHED\n", test_cnt);
+}
+
+
 /**
  * Try correct initialization and cleanup of receiver/context
  */
@@ -526,6 +586,7 @@ int main(int, char **)
 	multiple_handlers_test();
 	stress_test();
 	lazy_receivers_test();
+	delivery_cost_test();
 	check_context_management();
 
 	printf("--- signalling test finished ---\n");